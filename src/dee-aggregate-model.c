@@ -0,0 +1,1110 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by:
+ *               agent <agent@local>
+ */
+
+/**
+ * SECTION:dee-aggregate-model
+ * @short_description: A #DeeModel with per group aggregates of another
+ *                     #DeeModel
+ * @include: dee.h
+ *
+ * A #DeeAggregateModel groups the rows of an original model by the value
+ * of one column and holds one row per group. The first column of each row
+ * is the group key, followed by a column for each #DeeAggregate given when
+ * the model was created. For example, to count the rows in each category
+ * and sum up their sizes:
+ * |[
+ *   DeeAggregate aggregates[] = {
+ *     { DEE_AGGREGATE_COUNT, 0 },
+ *     { DEE_AGGREGATE_SUM, SIZE_COLUMN }
+ *   };
+ *
+ *   counts = dee_aggregate_model_new (model, CATEGORY_COLUMN,
+ *                                     aggregates, G_N_ELEMENTS (aggregates));
+ * ]|
+ *
+ * The aggregates are maintained incrementally as rows are added to, removed
+ * from or changed in the original model. Each change costs O(1) for counts
+ * and sums and O(log n) in the size of the group for minimums and maximums,
+ * which are kept in a binary heap per group. The rows of the aggregate model
+ * are in the order the groups first appeared in the original model, and a
+ * row is removed again when the last row of its group goes away.
+ *
+ * The group column must have a basic type and the aggregated columns must
+ * have one of the numeric types 'y', 'n', 'q', 'i', 'u', 'x', 't' or 'd'.
+ * Sums over double columns are updated by adding and subtracting values, so
+ * they may drift slightly from a fresh sum over many changes.
+ *
+ * The aggregate model should be regarded as read only.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h> // strlen(), memcpy()
+
+#include "dee-model.h"
+#include "dee-proxy-model.h"
+#include "dee-sequence-model.h"
+#include "dee-aggregate-model.h"
+#include "trace-log.h"
+
+static void dee_aggregate_model_model_iface_init (DeeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (DeeAggregateModel,
+                         dee_aggregate_model,
+                         DEE_TYPE_PROXY_MODEL,
+                         G_IMPLEMENT_INTERFACE (DEE_TYPE_MODEL,
+                                                dee_aggregate_model_model_iface_init));
+
+#define DEE_AGGREGATE_MODEL_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE(obj, DEE_TYPE_AGGREGATE_MODEL, DeeAggregateModelPrivate))
+
+typedef enum
+{
+  KIND_SIGNED,
+  KIND_UNSIGNED,
+  KIND_DOUBLE
+} ValueKind;
+
+typedef union
+{
+  gint64  i;
+  guint64 u;
+  gdouble d;
+} Value;
+
+typedef struct
+{
+  DeeAggregateFunc func;
+  guint            column;
+  gchar            type;
+  ValueKind        kind;
+} Aggregate;
+
+/* A row in the aggregate model */
+typedef struct
+{
+  GVariant      *key;
+  DeeModelIter  *iter;
+  guint          n_rows;
+
+  /* Indexed like priv->aggregates. Only the entries for sums and heaps for
+   * minimums and maximums are used */
+  guint          n_aggregates;
+  Value         *sums;
+  GPtrArray    **heaps;
+} Group;
+
+/* What we know about a row in orig_model. We need to remember the values
+ * we aggregated, because they are gone once we hear about a change */
+typedef struct
+{
+  Group         *group;
+  Value         *values;
+  guint         *heap_pos;
+} RowState;
+
+/**
+ * DeeAggregateModelPrivate:
+ *
+ * Ignore this structure.
+ **/
+struct _DeeAggregateModelPrivate
+{
+  DeeModel     *orig_model;
+  DeeModel     *back_end;
+
+  guint         group_column;
+  GVariant     *aggregates_spec;
+  Aggregate    *aggregates;
+  guint         n_aggregates;
+
+  /* Map of group keys to Groups */
+  GHashTable   *groups;
+
+  /* Map of orig_model iters to RowStates */
+  GHashTable   *rows;
+
+  /* Set while we build the initial groups. The rows for them are added
+   * in one go when we're done */
+  gboolean      populating;
+
+  gulong        on_orig_row_added_id;
+  gulong        on_orig_row_removed_id;
+  gulong        on_orig_row_changed_id;
+  gulong        on_orig_changeset_started_id;
+  gulong        on_orig_changeset_finished_id;
+};
+
+enum
+{
+  PROP_0,
+  PROP_MODEL,
+  PROP_GROUP_COLUMN,
+  PROP_AGGREGATES
+};
+
+/*
+ * DeeModel forward declarations
+ */
+static void           dee_aggregate_model_set_schema_full (DeeModel           *self,
+                                                           const gchar* const *schema,
+                                                           guint               n_columns);
+
+/*
+ * Callbacks
+ */
+static void        on_orig_model_row_added          (DeeAggregateModel *self,
+                                                     DeeModelIter      *iter);
+
+static void        on_orig_model_row_removed        (DeeAggregateModel *self,
+                                                     DeeModelIter      *iter);
+
+static void        on_orig_model_row_changed        (DeeAggregateModel *self,
+                                                     DeeModelIter      *iter);
+
+static void        on_orig_model_changeset_started  (DeeAggregateModel *self,
+                                                     DeeModel          *model);
+
+static void        on_orig_model_changeset_finished (DeeAggregateModel *self,
+                                                     DeeModel          *model);
+
+/*
+ * Values
+ */
+
+static ValueKind
+_value_kind_for_type (gchar type)
+{
+  switch (type)
+    {
+      case 'n':
+      case 'i':
+      case 'x':
+        return KIND_SIGNED;
+      case 'd':
+        return KIND_DOUBLE;
+      default:
+        return KIND_UNSIGNED;
+    }
+}
+
+static Value
+_value_from_variant (gchar type, GVariant *variant)
+{
+  Value value;
+
+  switch (type)
+    {
+      case 'y': value.u = g_variant_get_byte (variant); break;
+      case 'n': value.i = g_variant_get_int16 (variant); break;
+      case 'q': value.u = g_variant_get_uint16 (variant); break;
+      case 'i': value.i = g_variant_get_int32 (variant); break;
+      case 'u': value.u = g_variant_get_uint32 (variant); break;
+      case 'x': value.i = g_variant_get_int64 (variant); break;
+      case 't': value.u = g_variant_get_uint64 (variant); break;
+      case 'd': value.d = g_variant_get_double (variant); break;
+      default:
+        g_assert_not_reached ();
+    }
+
+  return value;
+}
+
+static GVariant*
+_value_to_variant (gchar type, Value value)
+{
+  switch (type)
+    {
+      case 'y': return g_variant_new_byte ((guchar) value.u);
+      case 'n': return g_variant_new_int16 ((gint16) value.i);
+      case 'q': return g_variant_new_uint16 ((guint16) value.u);
+      case 'i': return g_variant_new_int32 ((gint32) value.i);
+      case 'u': return g_variant_new_uint32 ((guint32) value.u);
+      case 'x': return g_variant_new_int64 (value.i);
+      case 't': return g_variant_new_uint64 (value.u);
+      case 'd': return g_variant_new_double (value.d);
+      default:
+        g_assert_not_reached ();
+    }
+
+  return NULL;
+}
+
+static gint
+_value_cmp (ValueKind kind, Value a, Value b)
+{
+  switch (kind)
+    {
+      case KIND_SIGNED: return a.i < b.i ? -1 : (a.i > b.i);
+      case KIND_UNSIGNED: return a.u < b.u ? -1 : (a.u > b.u);
+      default: return a.d < b.d ? -1 : (a.d > b.d);
+    }
+}
+
+static void
+_value_add (ValueKind kind, Value *sum, Value value, gboolean subtract)
+{
+  switch (kind)
+    {
+      case KIND_SIGNED:
+        sum->i = subtract ? sum->i - value.i : sum->i + value.i;
+        break;
+      case KIND_UNSIGNED:
+        sum->u = subtract ? sum->u - value.u : sum->u + value.u;
+        break;
+      default:
+        sum->d = subtract ? sum->d - value.d : sum->d + value.d;
+        break;
+    }
+}
+
+/*
+ * Heaps of RowStates, ordered by the value of aggregate k. The top of the
+ * heap for a DEE_AGGREGATE_MAX is the largest value
+ */
+
+static gboolean
+_heap_before (Aggregate *agg, guint k, RowState *a, RowState *b)
+{
+  gint cmp = _value_cmp (agg->kind, a->values[k], b->values[k]);
+
+  return agg->func == DEE_AGGREGATE_MAX ? cmp > 0 : cmp < 0;
+}
+
+static void
+_heap_set (GPtrArray *heap, guint k, guint pos, RowState *row)
+{
+  g_ptr_array_index (heap, pos) = row;
+  row->heap_pos[k] = pos;
+}
+
+static void
+_heap_sift_up (GPtrArray *heap, Aggregate *agg, guint k, guint pos)
+{
+  RowState *row, *parent;
+
+  row = g_ptr_array_index (heap, pos);
+  while (pos > 0)
+    {
+      parent = g_ptr_array_index (heap, (pos - 1) / 2);
+      if (!_heap_before (agg, k, row, parent))
+        break;
+      _heap_set (heap, k, pos, parent);
+      pos = (pos - 1) / 2;
+    }
+  _heap_set (heap, k, pos, row);
+}
+
+static void
+_heap_sift_down (GPtrArray *heap, Aggregate *agg, guint k, guint pos)
+{
+  RowState *row, *child;
+  guint     child_pos;
+
+  row = g_ptr_array_index (heap, pos);
+  while ((child_pos = 2 * pos + 1) < heap->len)
+    {
+      if (child_pos + 1 < heap->len &&
+          _heap_before (agg, k, g_ptr_array_index (heap, child_pos + 1),
+                        g_ptr_array_index (heap, child_pos)))
+        child_pos++;
+
+      child = g_ptr_array_index (heap, child_pos);
+      if (!_heap_before (agg, k, child, row))
+        break;
+      _heap_set (heap, k, pos, child);
+      pos = child_pos;
+    }
+  _heap_set (heap, k, pos, row);
+}
+
+static void
+_heap_push (GPtrArray *heap, Aggregate *agg, guint k, RowState *row)
+{
+  g_ptr_array_add (heap, row);
+  _heap_sift_up (heap, agg, k, heap->len - 1);
+}
+
+static void
+_heap_remove (GPtrArray *heap, Aggregate *agg, guint k, RowState *row)
+{
+  RowState *last;
+  guint     pos;
+
+  pos = row->heap_pos[k];
+  last = g_ptr_array_remove_index (heap, heap->len - 1);
+  if (pos == heap->len)
+    return;
+
+  _heap_set (heap, k, pos, last);
+  _heap_sift_up (heap, agg, k, pos);
+  _heap_sift_down (heap, agg, k, last->heap_pos[k]);
+}
+
+/*
+ * Groups and rows
+ */
+
+static Group*
+group_new (DeeAggregateModel *self, GVariant *key)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Group                    *group;
+  guint                     k;
+
+  group = g_slice_new0 (Group);
+  group->key = g_variant_ref (key);
+  group->n_aggregates = priv->n_aggregates;
+  group->sums = g_new0 (Value, priv->n_aggregates);
+  group->heaps = g_new0 (GPtrArray*, priv->n_aggregates);
+
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      if (priv->aggregates[k].func == DEE_AGGREGATE_MIN ||
+          priv->aggregates[k].func == DEE_AGGREGATE_MAX)
+        group->heaps[k] = g_ptr_array_new ();
+    }
+
+  return group;
+}
+
+static void
+group_free (Group *group)
+{
+  guint k;
+
+  g_variant_unref (group->key);
+  for (k = 0; k < group->n_aggregates; k++)
+    {
+      if (group->heaps[k] != NULL)
+        g_ptr_array_free (group->heaps[k], TRUE);
+    }
+
+  g_free (group->sums);
+  g_free (group->heaps);
+  g_slice_free (Group, group);
+}
+
+static void
+row_state_free (RowState *row)
+{
+  g_free (row->values);
+  g_free (row->heap_pos);
+  g_slice_free (RowState, row);
+}
+
+/* Build a row for the aggregate model from group */
+static GVariant**
+group_build_row (DeeAggregateModel *self, Group *group, GVariant **row_buf)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Aggregate                *agg;
+  RowState                 *top;
+  guint                     k;
+
+  row_buf[0] = group->key;
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      agg = &priv->aggregates[k];
+      switch (agg->func)
+        {
+          case DEE_AGGREGATE_COUNT:
+            row_buf[k + 1] = g_variant_new_uint32 (group->n_rows);
+            break;
+          case DEE_AGGREGATE_SUM:
+            if (agg->kind == KIND_SIGNED)
+              row_buf[k + 1] = g_variant_new_int64 (group->sums[k].i);
+            else if (agg->kind == KIND_UNSIGNED)
+              row_buf[k + 1] = g_variant_new_uint64 (group->sums[k].u);
+            else
+              row_buf[k + 1] = g_variant_new_double (group->sums[k].d);
+            break;
+          default:
+            top = g_ptr_array_index (group->heaps[k], 0);
+            row_buf[k + 1] = _value_to_variant (agg->type, top->values[k]);
+            break;
+        }
+    }
+
+  return row_buf;
+}
+
+/* Write the current aggregates of group to the aggregate model, adding or
+ * removing its row as needed */
+static void
+group_flush (DeeAggregateModel *self, Group *group)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  GVariant                **row_buf;
+
+  if (group->n_rows == 0)
+    {
+      if (group->iter != NULL)
+        dee_model_remove (priv->back_end, group->iter);
+      g_hash_table_remove (priv->groups, group->key);
+      return;
+    }
+
+  if (priv->populating)
+    return;
+
+  row_buf = g_alloca (sizeof (GVariant*) * (priv->n_aggregates + 1));
+  group_build_row (self, group, row_buf);
+
+  if (group->iter == NULL)
+    group->iter = dee_model_append_row (priv->back_end, row_buf);
+  else
+    dee_model_set_row (priv->back_end, group->iter, row_buf);
+}
+
+static void
+group_add_row (DeeAggregateModel *self, Group *group, RowState *row)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Aggregate                *agg;
+  guint                     k;
+
+  row->group = group;
+  group->n_rows++;
+
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      agg = &priv->aggregates[k];
+      if (agg->func == DEE_AGGREGATE_SUM)
+        _value_add (agg->kind, &group->sums[k], row->values[k], FALSE);
+      else if (group->heaps[k] != NULL)
+        _heap_push (group->heaps[k], agg, k, row);
+    }
+}
+
+static void
+group_remove_row (DeeAggregateModel *self, Group *group, RowState *row)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Aggregate                *agg;
+  guint                     k;
+
+  row->group = NULL;
+  group->n_rows--;
+
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      agg = &priv->aggregates[k];
+      if (agg->func == DEE_AGGREGATE_SUM)
+        _value_add (agg->kind, &group->sums[k], row->values[k], TRUE);
+      else if (group->heaps[k] != NULL)
+        _heap_remove (group->heaps[k], agg, k, row);
+    }
+}
+
+/* Read the aggregated values of iter into values */
+static void
+read_values (DeeAggregateModel *self, DeeModelIter *iter, Value *values)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Aggregate                *agg;
+  GVariant                 *variant;
+  guint                     k;
+
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      agg = &priv->aggregates[k];
+      if (agg->func == DEE_AGGREGATE_COUNT)
+        {
+          values[k].u = 0;
+          continue;
+        }
+
+      variant = dee_model_peek_value (priv->orig_model, iter, agg->column);
+      values[k] = _value_from_variant (agg->type, variant);
+    }
+}
+
+static Group*
+lookup_group (DeeAggregateModel *self, GVariant *key, GPtrArray *new_groups)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Group                    *group;
+
+  group = g_hash_table_lookup (priv->groups, key);
+  if (group == NULL)
+    {
+      group = group_new (self, key);
+      g_hash_table_insert (priv->groups, group->key, group);
+      if (new_groups != NULL)
+        g_ptr_array_add (new_groups, group);
+    }
+
+  return group;
+}
+
+static void
+add_row (DeeAggregateModel *self, DeeModelIter *iter, GPtrArray *new_groups)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  RowState                 *row;
+  GVariant                 *key;
+  Group                    *group;
+
+  row = g_slice_new (RowState);
+  row->values = g_new (Value, priv->n_aggregates);
+  row->heap_pos = g_new0 (guint, priv->n_aggregates);
+  read_values (self, iter, row->values);
+  g_hash_table_insert (priv->rows, iter, row);
+
+  key = dee_model_peek_value (priv->orig_model, iter, priv->group_column);
+  group = lookup_group (self, key, new_groups);
+
+  group_add_row (self, group, row);
+  group_flush (self, group);
+}
+
+/*
+ * GObject stuff
+ */
+
+static void
+dee_aggregate_model_finalize (GObject *object)
+{
+  DeeAggregateModelPrivate *priv = DEE_AGGREGATE_MODEL (object)->priv;
+
+  if (priv->on_orig_row_added_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_added_id);
+  if (priv->on_orig_row_removed_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_removed_id);
+  if (priv->on_orig_row_changed_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_changed_id);
+  if (priv->on_orig_changeset_started_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_changeset_started_id);
+  if (priv->on_orig_changeset_finished_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_changeset_finished_id);
+
+  priv->on_orig_row_added_id = 0;
+  priv->on_orig_row_removed_id = 0;
+  priv->on_orig_row_changed_id = 0;
+  priv->on_orig_changeset_started_id = 0;
+  priv->on_orig_changeset_finished_id = 0;
+
+  if (priv->rows)
+    {
+      g_hash_table_destroy (priv->rows);
+      priv->rows = NULL;
+    }
+  if (priv->groups)
+    {
+      g_hash_table_destroy (priv->groups);
+      priv->groups = NULL;
+    }
+
+  g_free (priv->aggregates);
+  priv->aggregates = NULL;
+
+  if (priv->aggregates_spec)
+    {
+      g_variant_unref (priv->aggregates_spec);
+      priv->aggregates_spec = NULL;
+    }
+  if (priv->back_end)
+    {
+      g_object_unref (priv->back_end);
+      priv->back_end = NULL;
+    }
+  if (priv->orig_model)
+    {
+      g_object_unref (priv->orig_model);
+      priv->orig_model = NULL;
+    }
+
+  G_OBJECT_CLASS (dee_aggregate_model_parent_class)->finalize (object);
+}
+
+/* Check the aggregates and set up the schema of the back end. Returns
+ * FALSE if the aggregates can't be computed over orig_model */
+static gboolean
+dee_aggregate_model_setup_schema (DeeAggregateModel *self)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  Aggregate                *agg;
+  GVariantIter              iter;
+  const gchar              *schema;
+  const gchar             **out_schema;
+  guint                     func, column, k, n_columns;
+
+  n_columns = dee_model_get_n_columns (priv->orig_model);
+  if (priv->group_column >= n_columns)
+    {
+      g_critical ("Can not group by column %u. The model only has %u columns",
+                  priv->group_column, n_columns);
+      return FALSE;
+    }
+
+  schema = dee_model_get_column_schema (priv->orig_model, priv->group_column);
+  if (!g_variant_type_is_basic (G_VARIANT_TYPE (schema)))
+    {
+      g_critical ("Can not group by column %u with schema '%s'",
+                  priv->group_column, schema);
+      return FALSE;
+    }
+
+  priv->n_aggregates = priv->aggregates_spec ?
+    g_variant_n_children (priv->aggregates_spec) : 0;
+  priv->aggregates = g_new0 (Aggregate, priv->n_aggregates);
+  out_schema = g_alloca (sizeof (gchar*) * (priv->n_aggregates + 1));
+  out_schema[0] = schema;
+
+  k = 0;
+  if (priv->aggregates_spec)
+    {
+      g_variant_iter_init (&iter, priv->aggregates_spec);
+      while (g_variant_iter_next (&iter, "(uu)", &func, &column))
+        {
+          agg = &priv->aggregates[k];
+          agg->func = func;
+          agg->column = column;
+
+          if (func == DEE_AGGREGATE_COUNT)
+            {
+              out_schema[++k] = "u";
+              continue;
+            }
+
+          if (func > DEE_AGGREGATE_MAX || column >= n_columns)
+            {
+              g_critical ("Invalid aggregate %u over column %u", func, column);
+              return FALSE;
+            }
+
+          schema = dee_model_get_column_schema (priv->orig_model, column);
+          if (strlen (schema) != 1 || strchr ("ynqiuxtd", schema[0]) == NULL)
+            {
+              g_critical ("Can not aggregate column %u with schema '%s'",
+                          column, schema);
+              return FALSE;
+            }
+
+          agg->type = schema[0];
+          agg->kind = _value_kind_for_type (agg->type);
+
+          if (func == DEE_AGGREGATE_SUM)
+            out_schema[++k] = agg->kind == KIND_SIGNED ? "x" :
+                                (agg->kind == KIND_UNSIGNED ? "t" : "d");
+          else
+            out_schema[++k] = schema;
+        }
+    }
+
+  dee_model_set_schema_full (priv->back_end, out_schema, priv->n_aggregates + 1);
+
+  return TRUE;
+}
+
+static void
+dee_aggregate_model_constructed (GObject *object)
+{
+  DeeAggregateModel        *self = DEE_AGGREGATE_MODEL (object);
+  DeeAggregateModelPrivate *priv = self->priv;
+  DeeModelIter             *iter, *end;
+  GPtrArray                *new_groups;
+  guint                     i;
+
+  if (G_OBJECT_CLASS (dee_aggregate_model_parent_class)->constructed)
+    G_OBJECT_CLASS (dee_aggregate_model_parent_class)->constructed (object);
+
+  if (priv->orig_model == NULL)
+    {
+      g_critical ("You must set the 'model' property when "
+                  "creating a DeeAggregateModel");
+      return;
+    }
+
+  /* This will return a new reference on back-end */
+  g_object_get (object, "back-end", &(priv->back_end), NULL);
+
+  if (!dee_aggregate_model_setup_schema (self))
+    return;
+
+  /* Build all the groups first and add a row for each of them after that,
+   * instead of updating the rows once for every row in orig_model */
+  new_groups = g_ptr_array_new ();
+  priv->populating = TRUE;
+
+  iter = dee_model_get_first_iter (priv->orig_model);
+  end = dee_model_get_last_iter (priv->orig_model);
+  while (iter != end)
+    {
+      add_row (self, iter, new_groups);
+      iter = dee_model_next (priv->orig_model, iter);
+    }
+
+  priv->populating = FALSE;
+  for (i = 0; i < new_groups->len; i++)
+    group_flush (self, g_ptr_array_index (new_groups, i));
+  g_ptr_array_free (new_groups, TRUE);
+
+  /* Listen for changes to orig_model */
+  priv->on_orig_row_added_id =
+    g_signal_connect_swapped (priv->orig_model, "row-added",
+                              G_CALLBACK (on_orig_model_row_added), object);
+
+  priv->on_orig_row_removed_id =
+    g_signal_connect_swapped (priv->orig_model, "row-removed",
+                              G_CALLBACK (on_orig_model_row_removed), object);
+
+  priv->on_orig_row_changed_id =
+    g_signal_connect_swapped (priv->orig_model, "row-changed",
+                              G_CALLBACK (on_orig_model_row_changed), object);
+
+  priv->on_orig_changeset_started_id =
+    g_signal_connect_swapped (priv->orig_model, "changeset-started",
+                              G_CALLBACK (on_orig_model_changeset_started),
+                              object);
+
+  priv->on_orig_changeset_finished_id =
+    g_signal_connect_swapped (priv->orig_model, "changeset-finished",
+                              G_CALLBACK (on_orig_model_changeset_finished),
+                              object);
+}
+
+static void
+dee_aggregate_model_set_property (GObject       *object,
+                                  guint          id,
+                                  const GValue  *value,
+                                  GParamSpec    *pspec)
+{
+  DeeAggregateModelPrivate *priv = DEE_AGGREGATE_MODEL (object)->priv;
+
+  switch (id)
+    {
+    case PROP_MODEL:
+      priv->orig_model = g_value_dup_object (value);
+      break;
+    case PROP_GROUP_COLUMN:
+      priv->group_column = g_value_get_uint (value);
+      break;
+    case PROP_AGGREGATES:
+      priv->aggregates_spec = g_value_dup_variant (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+    }
+}
+
+static void
+dee_aggregate_model_get_property (GObject     *object,
+                                  guint        id,
+                                  GValue      *value,
+                                  GParamSpec  *pspec)
+{
+  DeeAggregateModelPrivate *priv = DEE_AGGREGATE_MODEL (object)->priv;
+
+  switch (id)
+    {
+    case PROP_MODEL:
+      g_value_set_object (value, priv->orig_model);
+      break;
+    case PROP_GROUP_COLUMN:
+      g_value_set_uint (value, priv->group_column);
+      break;
+    case PROP_AGGREGATES:
+      g_value_set_variant (value, priv->aggregates_spec);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+    }
+}
+
+static void
+dee_aggregate_model_class_init (DeeAggregateModelClass *klass)
+{
+  GParamSpec    *pspec;
+  GObjectClass  *obj_class = G_OBJECT_CLASS (klass);
+
+  obj_class->finalize     = dee_aggregate_model_finalize;
+  obj_class->constructed  = dee_aggregate_model_constructed;
+  obj_class->get_property = dee_aggregate_model_get_property;
+  obj_class->set_property = dee_aggregate_model_set_property;
+
+  /**
+   * DeeAggregateModel:model:
+   *
+   * The model whose rows are grouped and aggregated
+   */
+  pspec = g_param_spec_object ("model", "Model",
+                               "The model to aggregate",
+                               DEE_TYPE_MODEL,
+                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                               | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_MODEL, pspec);
+
+  /**
+   * DeeAggregateModel:group-column:
+   *
+   * The column in #DeeAggregateModel:model to group the rows by
+   */
+  pspec = g_param_spec_uint ("group-column", "Group column",
+                             "Column to group the rows by",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                             | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_GROUP_COLUMN, pspec);
+
+  /**
+   * DeeAggregateModel:aggregates:
+   *
+   * The aggregates to compute for each group, as an array of
+   * (#DeeAggregateFunc, column) pairs
+   */
+  pspec = g_param_spec_variant ("aggregates", "Aggregates",
+                                "Aggregates to compute for each group",
+                                G_VARIANT_TYPE ("a(uu)"), NULL,
+                                G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                                | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_AGGREGATES, pspec);
+
+  /* Add private data */
+  g_type_class_add_private (obj_class, sizeof (DeeAggregateModelPrivate));
+}
+
+static void
+dee_aggregate_model_init (DeeAggregateModel *self)
+{
+  DeeAggregateModelPrivate *priv;
+
+  priv = self->priv = DEE_AGGREGATE_MODEL_GET_PRIVATE (self);
+
+  priv->groups = g_hash_table_new_full (g_variant_hash, g_variant_equal,
+                                        NULL, (GDestroyNotify) group_free);
+  priv->rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, (GDestroyNotify) row_state_free);
+  priv->populating = FALSE;
+
+  priv->on_orig_row_added_id = 0;
+  priv->on_orig_row_removed_id = 0;
+  priv->on_orig_row_changed_id = 0;
+  priv->on_orig_changeset_started_id = 0;
+  priv->on_orig_changeset_finished_id = 0;
+}
+
+static void
+dee_aggregate_model_model_iface_init (DeeModelIface *iface)
+{
+  iface->set_schema_full = dee_aggregate_model_set_schema_full;
+}
+
+/*
+ * Callbacks
+ */
+
+static void
+on_orig_model_row_added (DeeAggregateModel *self,
+                         DeeModelIter      *iter)
+{
+  add_row (self, iter, NULL);
+}
+
+static void
+on_orig_model_row_removed (DeeAggregateModel *self,
+                           DeeModelIter      *iter)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  RowState                 *row;
+  Group                    *group;
+
+  row = g_hash_table_lookup (priv->rows, iter);
+  if (row == NULL)
+    return;
+
+  group = row->group;
+  group_remove_row (self, group, row);
+  g_hash_table_remove (priv->rows, iter);
+  group_flush (self, group);
+}
+
+static void
+on_orig_model_row_changed (DeeAggregateModel *self,
+                           DeeModelIter      *iter)
+{
+  DeeAggregateModelPrivate *priv = self->priv;
+  RowState                 *row;
+  Group                    *old_group, *group;
+  GVariant                 *key;
+  Value                    *values;
+  Aggregate                *agg;
+  guint                     k;
+  gboolean                  changed;
+
+  row = g_hash_table_lookup (priv->rows, iter);
+  if (row == NULL)
+    return;
+
+  old_group = row->group;
+  values = g_alloca (sizeof (Value) * priv->n_aggregates);
+  read_values (self, iter, values);
+
+  key = dee_model_peek_value (priv->orig_model, iter, priv->group_column);
+  if (key != old_group->key && !g_variant_equal (key, old_group->key))
+    {
+      /* The row moved to another group */
+      group_remove_row (self, old_group, row);
+      memcpy (row->values, values, sizeof (Value) * priv->n_aggregates);
+      group = lookup_group (self, key, NULL);
+      group_add_row (self, group, row);
+
+      group_flush (self, old_group);
+      group_flush (self, group);
+      return;
+    }
+
+  /* Update the aggregates in place. Most changes don't touch the
+   * aggregated columns at all */
+  changed = FALSE;
+  for (k = 0; k < priv->n_aggregates; k++)
+    {
+      agg = &priv->aggregates[k];
+      if (agg->func == DEE_AGGREGATE_COUNT ||
+          _value_cmp (agg->kind, values[k], row->values[k]) == 0)
+        continue;
+
+      changed = TRUE;
+      if (agg->func == DEE_AGGREGATE_SUM)
+        {
+          _value_add (agg->kind, &old_group->sums[k], row->values[k], TRUE);
+          _value_add (agg->kind, &old_group->sums[k], values[k], FALSE);
+          row->values[k] = values[k];
+        }
+      else
+        {
+          row->values[k] = values[k];
+          _heap_sift_up (old_group->heaps[k], agg, k, row->heap_pos[k]);
+          _heap_sift_down (old_group->heaps[k], agg, k, row->heap_pos[k]);
+        }
+    }
+
+  if (changed)
+    group_flush (self, old_group);
+}
+
+static void
+on_orig_model_changeset_started (DeeAggregateModel *self,
+                                 DeeModel          *model)
+{
+  g_signal_emit_by_name (self, "changeset-started");
+}
+
+static void
+on_orig_model_changeset_finished (DeeAggregateModel *self,
+                                  DeeModel          *model)
+{
+  g_signal_emit_by_name (self, "changeset-finished");
+}
+
+/*
+ * DeeModel Interface Implementation
+ */
+
+static void
+dee_aggregate_model_set_schema_full (DeeModel *self,
+                                     const gchar* const *schema,
+                                     guint     n_columns)
+{
+  g_return_if_fail (DEE_IS_AGGREGATE_MODEL (self));
+
+  g_critical ("You can not set the schema on a DeeAggregateModel. "
+              "It is derived from the aggregates");
+}
+
+/*
+ * Public API
+ */
+
+/**
+ * dee_aggregate_model_new:
+ * @orig_model: The model to aggregate
+ * @group_column: The column in @orig_model to group the rows by
+ * @aggregates: (array length=n_aggregates): The aggregates to compute for
+ *              each group
+ * @n_aggregates: The number of aggregates
+ *
+ * Create a model with a row for each distinct value in @group_column of
+ * @orig_model. The first column holds the group value and the following
+ * columns the @aggregates, in order.
+ *
+ * Returns: (transfer full) (type DeeAggregateModel): A newly allocated
+ *          #DeeAggregateModel. Free with g_object_unref().
+ */
+DeeModel*
+dee_aggregate_model_new (DeeModel           *orig_model,
+                         guint               group_column,
+                         const DeeAggregate *aggregates,
+                         guint               n_aggregates)
+{
+  GVariantBuilder  builder;
+  DeeModel        *back_end, *self;
+  guint            i;
+
+  g_return_val_if_fail (DEE_IS_MODEL (orig_model), NULL);
+  g_return_val_if_fail (aggregates != NULL || n_aggregates == 0, NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(uu)"));
+  for (i = 0; i < n_aggregates; i++)
+    g_variant_builder_add (&builder, "(uu)",
+                           aggregates[i].func, aggregates[i].column);
+
+  back_end = dee_sequence_model_new ();
+  self = DEE_MODEL (g_object_new (DEE_TYPE_AGGREGATE_MODEL,
+                                  "back-end", back_end,
+                                  "model", orig_model,
+                                  "group-column", group_column,
+                                  "aggregates", g_variant_builder_end (&builder),
+                                  NULL));
+  g_object_unref (back_end);
+
+  return self;
+}
+
+/**
+ * dee_aggregate_model_find_group:
+ * @self: The #DeeAggregateModel to search
+ * @key: The group value to look for. If this is a floating reference it
+ *       will be consumed
+ *
+ * Look up the row for a group in constant time.
+ *
+ * Returns: (transfer none): The row for the group @key or %NULL if no row in
+ *          the original model has that value
+ */
+DeeModelIter*
+dee_aggregate_model_find_group (DeeAggregateModel *self,
+                                GVariant          *key)
+{
+  Group *group;
+
+  g_return_val_if_fail (DEE_IS_AGGREGATE_MODEL (self), NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  g_variant_ref_sink (key);
+  group = g_hash_table_lookup (self->priv->groups, key);
+  g_variant_unref (key);
+
+  return group != NULL ? group->iter : NULL;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by agent <agent@local>
+ */
+
+#if !defined (_DEE_H_INSIDE) && !defined (DEE_COMPILATION)
+#error "Only <dee.h> can be included directly."
+#endif
+
+#ifndef _HAVE_DEE_AGGREGATE_MODEL_H
+#define _HAVE_DEE_AGGREGATE_MODEL_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <dee-model.h>
+#include <dee-proxy-model.h>
+
+G_BEGIN_DECLS
+
+#define DEE_TYPE_AGGREGATE_MODEL (dee_aggregate_model_get_type ())
+
+#define DEE_AGGREGATE_MODEL(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+        DEE_TYPE_AGGREGATE_MODEL, DeeAggregateModel))
+
+#define DEE_AGGREGATE_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), \
+        DEE_TYPE_AGGREGATE_MODEL, DeeAggregateModelClass))
+
+#define DEE_IS_AGGREGATE_MODEL(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+        DEE_TYPE_AGGREGATE_MODEL))
+
+#define DEE_IS_AGGREGATE_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+        DEE_TYPE_AGGREGATE_MODEL))
+
+#define DEE_AGGREGATE_MODEL_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+        DEE_TYPE_AGGREGATE_MODEL, DeeAggregateModelClass))
+
+typedef struct _DeeAggregateModel DeeAggregateModel;
+typedef struct _DeeAggregateModelClass DeeAggregateModelClass;
+typedef struct _DeeAggregateModelPrivate DeeAggregateModelPrivate;
+
+/**
+ * DeeAggregateFunc:
+ * @DEE_AGGREGATE_COUNT: The number of rows in the group. The column is
+ *                       ignored. The result has type 'u'
+ * @DEE_AGGREGATE_SUM: The sum of a numeric column. The result has type 'x'
+ *                     for signed integers, 't' for unsigned integers and
+ *                     'd' for doubles
+ * @DEE_AGGREGATE_MIN: The smallest value of a numeric column. The result has
+ *                     the type of the column
+ * @DEE_AGGREGATE_MAX: The largest value of a numeric column. The result has
+ *                     the type of the column
+ *
+ * The functions a #DeeAggregateModel can compute for each group of rows.
+ */
+typedef enum
+{
+  DEE_AGGREGATE_COUNT,
+  DEE_AGGREGATE_SUM,
+  DEE_AGGREGATE_MIN,
+  DEE_AGGREGATE_MAX
+} DeeAggregateFunc;
+
+/**
+ * DeeAggregate:
+ * @func: The function to compute
+ * @column: The column in the original model to compute it over
+ *
+ * Describes one column of a #DeeAggregateModel.
+ */
+typedef struct
+{
+  DeeAggregateFunc func;
+  guint            column;
+} DeeAggregate;
+
+/**
+ * DeeAggregateModel:
+ *
+ * All fields in the DeeAggregateModel structure are private and should never
+ * be accessed directly
+ */
+struct _DeeAggregateModel
+{
+  /*< private >*/
+  DeeProxyModel             parent;
+
+  DeeAggregateModelPrivate *priv;
+};
+
+struct _DeeAggregateModelClass
+{
+  /*< private >*/
+  DeeProxyModelClass parent_class;
+
+  /*< private >*/
+  void (*_dee_aggregate_model_1) (void);
+  void (*_dee_aggregate_model_2) (void);
+  void (*_dee_aggregate_model_3) (void);
+  void (*_dee_aggregate_model_4) (void);
+};
+
+/**
+ * dee_aggregate_model_get_type:
+ *
+ * The GType of #DeeAggregateModel
+ *
+ * Return value: the #GType of #DeeAggregateModel
+ **/
+GType                 dee_aggregate_model_get_type       (void);
+
+DeeModel*             dee_aggregate_model_new            (DeeModel           *orig_model,
+                                                          guint               group_column,
+                                                          const DeeAggregate *aggregates,
+                                                          guint               n_aggregates);
+
+DeeModelIter*         dee_aggregate_model_find_group     (DeeAggregateModel *self,
+                                                          GVariant          *key);
+
+G_END_DECLS
+
+#endif /* _HAVE_DEE_AGGREGATE_MODEL_H */
@@ -0,0 +1,592 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A bit vector split into fixed size blocks. Inserting or removing a bit
+ * only has to shift the words of a single block, and two Fenwick trees over
+ * the per-block bit counts and set bit counts let rank and select find the
+ * right block in O(log n_blocks).
+ *
+ * Blocks are split in two when they overflow and merged with a neighbour
+ * when the two of them fit in a quarter of a block. Splits and merges
+ * are rare, so the Fenwick trees are just rebuilt lazily when they happen.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h> // memcpy(), memset()
+
+#include "dee-bitmap.h"
+
+#define BLOCK_WORDS 16
+#define BLOCK_BITS  (BLOCK_WORDS * 64)
+
+typedef struct
+{
+  guint   n_bits;
+  guint   n_set;
+  guint64 words[BLOCK_WORDS];
+} Block;
+
+struct _DeeBitmap
+{
+  GArray   *blocks;
+
+  guint     n_bits;
+  guint     n_set;
+
+  /* 1-based Fenwick trees with an entry per block */
+  guint    *fenwick_bits;
+  guint    *fenwick_set;
+  gboolean  fenwick_dirty;
+};
+
+#define BLOCK(self,i) (g_array_index ((self)->blocks, Block*, (i)))
+
+static inline guint
+popcount64 (guint64 w)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll (w);
+#else
+  guint n = 0;
+  while (w != 0) { w &= w - 1; n++; }
+  return n;
+#endif
+}
+
+static inline guint
+ctz64 (guint64 w)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll (w);
+#else
+  guint n = 0;
+  while ((w & 1) == 0) { w >>= 1; n++; }
+  return n;
+#endif
+}
+
+/*
+ * Block operations
+ */
+
+static void
+block_insert (Block *block, guint offset, gboolean value)
+{
+  guint   w, i;
+  guint64 low;
+
+  w = offset / 64;
+  low = (G_GUINT64_CONSTANT (1) << (offset % 64)) - 1;
+
+  for (i = block->n_bits / 64; i > w; i--)
+    block->words[i] = (block->words[i] << 1) | (block->words[i - 1] >> 63);
+
+  block->words[w] = (block->words[w] & low) | ((block->words[w] & ~low) << 1);
+  if (value)
+    {
+      block->words[w] |= G_GUINT64_CONSTANT (1) << (offset % 64);
+      block->n_set++;
+    }
+
+  block->n_bits++;
+}
+
+static gboolean
+block_remove (Block *block, guint offset)
+{
+  guint    w, i, last;
+  guint64  low;
+  gboolean value;
+
+  w = offset / 64;
+  last = (block->n_bits - 1) / 64;
+  low = (G_GUINT64_CONSTANT (1) << (offset % 64)) - 1;
+  value = (block->words[w] >> (offset % 64)) & 1;
+
+  block->words[w] = (block->words[w] & low) | ((block->words[w] >> 1) & ~low);
+  for (i = w; i < last; i++)
+    {
+      block->words[i] |= block->words[i + 1] << 63;
+      block->words[i + 1] >>= 1;
+    }
+
+  block->n_bits--;
+  if (value)
+    block->n_set--;
+
+  return value;
+}
+
+/* Number of set bits in [0, offset) */
+static guint
+block_rank (Block *block, guint offset)
+{
+  guint i, n = 0;
+
+  for (i = 0; i < offset / 64; i++)
+    n += popcount64 (block->words[i]);
+
+  if (offset % 64 != 0)
+    n += popcount64 (block->words[i] &
+                     ((G_GUINT64_CONSTANT (1) << (offset % 64)) - 1));
+
+  return n;
+}
+
+/* Offset of the n'th set bit, counting from 0 */
+static guint
+block_select (Block *block, guint n)
+{
+  guint   i, count;
+  guint64 w;
+
+  for (i = 0; ; i++)
+    {
+      count = popcount64 (block->words[i]);
+      if (n < count)
+        break;
+      n -= count;
+    }
+
+  w = block->words[i];
+  while (n-- > 0)
+    w &= w - 1;
+
+  return i * 64 + ctz64 (w);
+}
+
+/*
+ * Fenwick trees
+ */
+
+static void
+fenwick_rebuild (DeeBitmap *self)
+{
+  guint i, j, n;
+
+  n = self->blocks->len;
+  g_free (self->fenwick_bits);
+  g_free (self->fenwick_set);
+  self->fenwick_bits = g_new0 (guint, n + 1);
+  self->fenwick_set = g_new0 (guint, n + 1);
+
+  for (i = 1; i <= n; i++)
+    {
+      self->fenwick_bits[i] += BLOCK (self, i - 1)->n_bits;
+      self->fenwick_set[i] += BLOCK (self, i - 1)->n_set;
+
+      j = i + (i & -i);
+      if (j <= n)
+        {
+          self->fenwick_bits[j] += self->fenwick_bits[i];
+          self->fenwick_set[j] += self->fenwick_set[i];
+        }
+    }
+
+  self->fenwick_dirty = FALSE;
+}
+
+static inline void
+fenwick_ensure (DeeBitmap *self)
+{
+  if (self->fenwick_dirty)
+    fenwick_rebuild (self);
+}
+
+static void
+fenwick_update (DeeBitmap *self, guint block, gint d_bits, gint d_set)
+{
+  guint j;
+
+  /* Will be rebuilt on next lookup anyway */
+  if (self->fenwick_dirty)
+    return;
+
+  for (j = block + 1; j <= self->blocks->len; j += j & -j)
+    {
+      self->fenwick_bits[j] += d_bits;
+      self->fenwick_set[j] += d_set;
+    }
+}
+
+/* Sum of the entries for the blocks before @block */
+static guint
+fenwick_prefix (const guint *tree, guint block)
+{
+  guint j, sum = 0;
+
+  for (j = block; j > 0; j -= j & -j)
+    sum += tree[j];
+
+  return sum;
+}
+
+/* Find the block containing the element @target (counting from 0). On return
+ * @target holds the offset of the element in that block */
+static guint
+fenwick_search (const guint *tree, guint n, guint *target)
+{
+  guint pos = 0, step = 1;
+
+  while ((step << 1) <= n)
+    step <<= 1;
+
+  for (; step > 0; step >>= 1)
+    {
+      if (pos + step <= n && tree[pos + step] <= *target)
+        {
+          pos += step;
+          *target -= tree[pos];
+        }
+    }
+
+  return pos;
+}
+
+/*
+ * Block management
+ */
+
+static Block*
+insert_block (DeeBitmap *self, guint index)
+{
+  Block *block;
+
+  block = g_slice_new0 (Block);
+  g_array_insert_val (self->blocks, index, block);
+  self->fenwick_dirty = TRUE;
+
+  return block;
+}
+
+static void
+split_block (DeeBitmap *self, guint index)
+{
+  Block *block, *next;
+  guint  i;
+
+  block = BLOCK (self, index);
+  next = insert_block (self, index + 1);
+
+  memcpy (next->words, block->words + BLOCK_WORDS / 2,
+          sizeof (guint64) * (BLOCK_WORDS / 2));
+  memset (block->words + BLOCK_WORDS / 2, 0,
+          sizeof (guint64) * (BLOCK_WORDS / 2));
+
+  for (i = 0; i < BLOCK_WORDS / 2; i++)
+    next->n_set += popcount64 (next->words[i]);
+
+  next->n_bits = block->n_bits - BLOCK_BITS / 2;
+  block->n_bits = BLOCK_BITS / 2;
+  block->n_set -= next->n_set;
+}
+
+/* Append the bits of the block after @index to the block at @index and drop
+ * the former. The combined size must not exceed half a block */
+static void
+merge_blocks (DeeBitmap *self, guint index)
+{
+  Block *block, *next;
+  guint  i, w, shift;
+
+  block = BLOCK (self, index);
+  next = BLOCK (self, index + 1);
+  w = block->n_bits / 64;
+  shift = block->n_bits % 64;
+
+  for (i = 0; i * 64 < next->n_bits; i++)
+    {
+      block->words[w + i] |= next->words[i] << shift;
+      if (shift != 0)
+        block->words[w + i + 1] |= next->words[i] >> (64 - shift);
+    }
+
+  block->n_bits += next->n_bits;
+  block->n_set += next->n_set;
+
+  g_array_remove_index (self->blocks, index + 1);
+  g_slice_free (Block, next);
+  self->fenwick_dirty = TRUE;
+}
+
+/* Find the block holding the existing bit at @pos */
+static guint
+locate (DeeBitmap *self, guint pos, guint *offset)
+{
+  fenwick_ensure (self);
+
+  *offset = pos;
+  return fenwick_search (self->fenwick_bits, self->blocks->len, offset);
+}
+
+/*
+ * Internal API
+ */
+
+DeeBitmap*
+_dee_bitmap_new (void)
+{
+  DeeBitmap *self;
+
+  self = g_slice_new0 (DeeBitmap);
+  self->blocks = g_array_new (FALSE, FALSE, sizeof (Block*));
+  self->fenwick_dirty = TRUE;
+
+  return self;
+}
+
+void
+_dee_bitmap_free (DeeBitmap *self)
+{
+  guint i;
+
+  g_return_if_fail (self != NULL);
+
+  for (i = 0; i < self->blocks->len; i++)
+    g_slice_free (Block, BLOCK (self, i));
+
+  g_array_free (self->blocks, TRUE);
+  g_free (self->fenwick_bits);
+  g_free (self->fenwick_set);
+  g_slice_free (DeeBitmap, self);
+}
+
+guint
+_dee_bitmap_get_n_bits (DeeBitmap *self)
+{
+  return self->n_bits;
+}
+
+guint
+_dee_bitmap_get_n_set (DeeBitmap *self)
+{
+  return self->n_set;
+}
+
+/* Insert a bit at @pos, shifting all bits after it up by one */
+void
+_dee_bitmap_insert (DeeBitmap *self,
+                    guint      pos,
+                    gboolean   value)
+{
+  Block *block;
+  guint  index, offset;
+
+  g_return_if_fail (pos <= self->n_bits);
+
+  if (pos == self->n_bits)
+    {
+      /* Appending. Start a new block rather than splitting a full one so
+       * that models populated from the front stay densely packed */
+      if (self->blocks->len == 0 ||
+          BLOCK (self, self->blocks->len - 1)->n_bits == BLOCK_BITS)
+        insert_block (self, self->blocks->len);
+
+      index = self->blocks->len - 1;
+      offset = BLOCK (self, index)->n_bits;
+    }
+  else
+    {
+      index = locate (self, pos, &offset);
+      if (BLOCK (self, index)->n_bits == BLOCK_BITS)
+        {
+          split_block (self, index);
+          if (offset >= BLOCK_BITS / 2)
+            {
+              index++;
+              offset -= BLOCK_BITS / 2;
+            }
+        }
+    }
+
+  block = BLOCK (self, index);
+  block_insert (block, offset, value);
+
+  self->n_bits++;
+  if (value)
+    self->n_set++;
+
+  fenwick_update (self, index, 1, value ? 1 : 0);
+}
+
+/* Remove the bit at @pos, shifting all bits after it down by one. Returns
+ * the value of the removed bit */
+gboolean
+_dee_bitmap_remove (DeeBitmap *self,
+                    guint      pos)
+{
+  Block    *block;
+  guint     index, offset;
+  gboolean  value;
+
+  g_return_val_if_fail (pos < self->n_bits, FALSE);
+
+  index = locate (self, pos, &offset);
+  block = BLOCK (self, index);
+  value = block_remove (block, offset);
+
+  self->n_bits--;
+  if (value)
+    self->n_set--;
+
+  if (block->n_bits == 0)
+    {
+      g_array_remove_index (self->blocks, index);
+      g_slice_free (Block, block);
+      self->fenwick_dirty = TRUE;
+    }
+  else if (index + 1 < self->blocks->len &&
+           block->n_bits + BLOCK (self, index + 1)->n_bits <= BLOCK_BITS / 4)
+    merge_blocks (self, index);
+  else if (index > 0 &&
+           BLOCK (self, index - 1)->n_bits + block->n_bits <= BLOCK_BITS / 4)
+    merge_blocks (self, index - 1);
+  else
+    fenwick_update (self, index, -1, value ? -1 : 0);
+
+  return value;
+}
+
+gboolean
+_dee_bitmap_get (DeeBitmap *self,
+                 guint      pos)
+{
+  Block *block;
+  guint  index, offset;
+
+  g_return_val_if_fail (pos < self->n_bits, FALSE);
+
+  index = locate (self, pos, &offset);
+  block = BLOCK (self, index);
+
+  return (block->words[offset / 64] >> (offset % 64)) & 1;
+}
+
+/* Set the bit at @pos to @value. Returns the previous value */
+gboolean
+_dee_bitmap_set (DeeBitmap *self,
+                 guint      pos,
+                 gboolean   value)
+{
+  Block    *block;
+  guint     index, offset;
+  guint64   mask;
+  gboolean  old_value;
+
+  g_return_val_if_fail (pos < self->n_bits, FALSE);
+
+  index = locate (self, pos, &offset);
+  block = BLOCK (self, index);
+  mask = G_GUINT64_CONSTANT (1) << (offset % 64);
+  old_value = (block->words[offset / 64] & mask) != 0;
+
+  if (value && !old_value)
+    {
+      block->words[offset / 64] |= mask;
+      block->n_set++;
+      self->n_set++;
+      fenwick_update (self, index, 0, 1);
+    }
+  else if (!value && old_value)
+    {
+      block->words[offset / 64] &= ~mask;
+      block->n_set--;
+      self->n_set--;
+      fenwick_update (self, index, 0, -1);
+    }
+
+  return old_value;
+}
+
+/* Number of set bits in [0, pos). @pos may be equal to the number of bits */
+guint
+_dee_bitmap_rank (DeeBitmap *self,
+                  guint      pos)
+{
+  guint index, offset;
+
+  g_return_val_if_fail (pos <= self->n_bits, 0);
+
+  if (pos == self->n_bits)
+    return self->n_set;
+
+  index = locate (self, pos, &offset);
+
+  return fenwick_prefix (self->fenwick_set, index) +
+         block_rank (BLOCK (self, index), offset);
+}
+
+/* Position of the @n'th set bit, counting from 0. Returns the number of bits
+ * if there are not that many set bits */
+guint
+_dee_bitmap_select (DeeBitmap *self,
+                    guint      n)
+{
+  guint index;
+
+  if (n >= self->n_set)
+    return self->n_bits;
+
+  fenwick_ensure (self);
+  index = fenwick_search (self->fenwick_set, self->blocks->len, &n);
+
+  return fenwick_prefix (self->fenwick_bits, index) +
+         block_select (BLOCK (self, index), n);
+}
+
+/* Position of the first set bit at or after @pos. Returns the number of
+ * bits if there is none. Only the words from @pos up to the next set bit
+ * are scanned, skipping blocks without set bits */
+guint
+_dee_bitmap_next_set (DeeBitmap *self,
+                      guint      pos)
+{
+  Block   *block;
+  guint    index, offset, base, i, bit;
+  guint64  w;
+
+  if (pos >= self->n_bits)
+    return self->n_bits;
+
+  index = locate (self, pos, &offset);
+  base = pos - offset;
+
+  for (; index < self->blocks->len; index++)
+    {
+      block = BLOCK (self, index);
+      for (i = offset / 64; block->n_set > 0 && i * 64 < block->n_bits; i++)
+        {
+          w = block->words[i];
+          if (i == offset / 64)
+            w &= ~G_GUINT64_CONSTANT (0) << (offset % 64);
+          if (w == 0)
+            continue;
+
+          bit = i * 64 + ctz64 (w);
+          if (bit < block->n_bits)
+            return base + bit;
+        }
+
+      base += block->n_bits;
+      offset = 0;
+    }
+
+  return self->n_bits;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DEE_BITMAP_H_
+#define _DEE_BITMAP_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * DeeBitmap is a private growable bit vector supporting insertion and
+ * removal of bits at arbitrary positions, as well as rank and select
+ * queries. It is not part of the public API.
+ */
+typedef struct _DeeBitmap DeeBitmap;
+
+DeeBitmap* _dee_bitmap_new        (void);
+
+void       _dee_bitmap_free       (DeeBitmap *self);
+
+guint      _dee_bitmap_get_n_bits (DeeBitmap *self);
+
+guint      _dee_bitmap_get_n_set  (DeeBitmap *self);
+
+void       _dee_bitmap_insert     (DeeBitmap *self,
+                                   guint      pos,
+                                   gboolean   value);
+
+gboolean   _dee_bitmap_remove     (DeeBitmap *self,
+                                   guint      pos);
+
+gboolean   _dee_bitmap_get        (DeeBitmap *self,
+                                   guint      pos);
+
+gboolean   _dee_bitmap_set        (DeeBitmap *self,
+                                   guint      pos,
+                                   gboolean   value);
+
+guint      _dee_bitmap_rank       (DeeBitmap *self,
+                                   guint      pos);
+
+guint      _dee_bitmap_select     (DeeBitmap *self,
+                                   guint      n);
+
+guint      _dee_bitmap_next_set   (DeeBitmap *self,
+                                   guint      pos);
+
+G_END_DECLS
+
+#endif /* _DEE_BITMAP_H_ */
@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:dee-column-index
+ * @short_description: Fast lookups of rows by the value of a column
+ * @include: dee.h
+ *
+ * A #DeeColumnIndex maps the values of one column in a #DeeModel to the
+ * rows holding them. Unlike a #DeeIndex there is no analysis of the column
+ * data; values are matched as whole #GVariant<!-- -->s with the semantics
+ * of g_variant_equal(), and any column type can be indexed.
+ *
+ * The index keeps itself up to date by listening for changes in the model.
+ * While a column index exists for a model it is also picked up
+ * automatically by dee_model_find_by_value(), dee_filter_new_for_key_column()
+ * and dee_filter_new_for_any_column(), making their cost proportional to
+ * the number of matching rows instead of the size of the model.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "dee-column-index.h"
+#include "dee-result-set.h"
+#include "dee-glist-result-set.h"
+#include "trace-log.h"
+
+G_DEFINE_TYPE (DeeColumnIndex, dee_column_index, G_TYPE_OBJECT);
+
+#define DEE_COLUMN_INDEX_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE(obj, DEE_TYPE_COLUMN_INDEX, DeeColumnIndexPrivate))
+
+/* The column indexes of a model are registered on the model under this key
+ * as a GSList. The list does not hold references on the indexes */
+#define COLUMN_INDEXES_KEY "dee-column-indexes"
+
+/*
+ * FORWARDS
+ */
+static void     on_row_added (DeeColumnIndex *self,
+                              DeeModelIter   *iter,
+                              DeeModel       *model);
+
+static void     on_row_removed (DeeColumnIndex *self,
+                                DeeModelIter   *iter,
+                                DeeModel       *model);
+
+static void     on_row_changed (DeeColumnIndex *self,
+                                DeeModelIter   *iter,
+                                DeeModel       *model);
+
+/*
+ * GOBJECT STUFF
+ */
+
+/**
+ * DeeColumnIndexPrivate:
+ *
+ * Ignore this structure.
+ **/
+struct _DeeColumnIndexPrivate
+{
+  DeeModel   *model;
+  guint       column;
+
+  /* Holds map of GVariant value -> GHashTable<DeeModelIter,NULL> */
+  GHashTable *values;
+
+  /* Holds map of DeeModelIter -> GVariant value. We need this to find
+   * the old value of a row when it changes */
+  GHashTable *row_values;
+
+  gulong      on_row_added_handler;
+  gulong      on_row_removed_handler;
+  gulong      on_row_changed_handler;
+};
+
+enum
+{
+  PROP_0,
+  PROP_MODEL,
+  PROP_COLUMN
+};
+
+/* g_variant_hash() only works for basic types, so hash the serialized data
+ * of containers instead. We use the normal form to make sure that values
+ * which are equal according to g_variant_equal() hash the same */
+static guint
+value_hash (gconstpointer v)
+{
+  GVariant     *value = (GVariant *) v;
+  GVariant     *normal;
+  const guchar *data;
+  gsize         i, size;
+  guint         hash;
+
+  if (g_variant_type_is_basic (g_variant_get_type (value)))
+    return g_variant_hash (value);
+
+  normal = g_variant_get_normal_form (value);
+  data = g_variant_get_data (normal);
+  size = g_variant_get_size (normal);
+
+  hash = g_str_hash (g_variant_get_type_string (normal));
+  for (i = 0; i < size; i++)
+    hash = (hash << 5) - hash + data[i];
+
+  g_variant_unref (normal);
+
+  return hash;
+}
+
+static void
+dee_column_index_finalize (GObject *object)
+{
+  DeeColumnIndexPrivate *priv = DEE_COLUMN_INDEX (object)->priv;
+  GSList                *indexes;
+
+  if (priv->model)
+    {
+      if (priv->on_row_added_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_added_handler);
+      if (priv->on_row_removed_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_removed_handler);
+      if (priv->on_row_changed_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_changed_handler);
+
+      indexes = g_object_get_data (G_OBJECT (priv->model), COLUMN_INDEXES_KEY);
+      indexes = g_slist_remove (indexes, object);
+      g_object_set_data (G_OBJECT (priv->model), COLUMN_INDEXES_KEY, indexes);
+
+      g_object_unref (priv->model);
+      priv->model = NULL;
+    }
+
+  if (priv->values)
+    {
+      g_hash_table_unref (priv->values);
+      priv->values = NULL;
+    }
+  if (priv->row_values)
+    {
+      g_hash_table_unref (priv->row_values);
+      priv->row_values = NULL;
+    }
+
+  G_OBJECT_CLASS (dee_column_index_parent_class)->finalize (object);
+}
+
+static gboolean
+index_existing_row (DeeModel     *model,
+                    DeeModelIter *iter,
+                    gpointer      user_data)
+{
+  on_row_added ((DeeColumnIndex *) user_data, iter, model);
+  return FALSE;
+}
+
+static void
+dee_column_index_constructed (GObject *object)
+{
+  DeeColumnIndexPrivate *priv = DEE_COLUMN_INDEX (object)->priv;
+  DeeColumnIndex        *self = DEE_COLUMN_INDEX (object);
+  GSList                *indexes;
+
+  if (priv->model == NULL)
+    {
+      g_critical ("You must set the 'model' property when "
+                  "creating a DeeColumnIndex");
+      return;
+    }
+
+  if (priv->column >= dee_model_get_n_columns (priv->model))
+    {
+      g_critical ("Can not index column %u. The model only has %u columns",
+                  priv->column, dee_model_get_n_columns (priv->model));
+      return;
+    }
+
+  /* Listen for changes in the model so we automagically pick those up */
+  priv->on_row_added_handler =
+    g_signal_connect_swapped (priv->model, "row-added",
+                              G_CALLBACK (on_row_added), self);
+
+  priv->on_row_removed_handler =
+    g_signal_connect_swapped (priv->model, "row-removed",
+                              G_CALLBACK (on_row_removed), self);
+
+  priv->on_row_changed_handler =
+    g_signal_connect_swapped (priv->model, "row-changed",
+                              G_CALLBACK (on_row_changed), self);
+
+  /* Index existing rows in the model */
+  dee_model_foreach_range (priv->model, NULL, NULL, index_existing_row, self);
+
+  /* Make ourselves known to dee_column_index_find() */
+  indexes = g_object_get_data (G_OBJECT (priv->model), COLUMN_INDEXES_KEY);
+  indexes = g_slist_prepend (indexes, self);
+  g_object_set_data (G_OBJECT (priv->model), COLUMN_INDEXES_KEY, indexes);
+
+  if (G_OBJECT_CLASS (dee_column_index_parent_class)->constructed)
+    G_OBJECT_CLASS (dee_column_index_parent_class)->constructed (object);
+}
+
+static void
+dee_column_index_set_property (GObject       *object,
+                               guint          id,
+                               const GValue  *value,
+                               GParamSpec    *pspec)
+{
+  DeeColumnIndexPrivate *priv = DEE_COLUMN_INDEX (object)->priv;
+
+  switch (id)
+  {
+    case PROP_MODEL:
+      priv->model = DEE_MODEL (g_value_dup_object (value));
+      break;
+    case PROP_COLUMN:
+      priv->column = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+  }
+}
+
+static void
+dee_column_index_get_property (GObject     *object,
+                               guint        id,
+                               GValue      *value,
+                               GParamSpec  *pspec)
+{
+  DeeColumnIndexPrivate *priv = DEE_COLUMN_INDEX (object)->priv;
+
+  switch (id)
+  {
+    case PROP_MODEL:
+      g_value_set_object (value, priv->model);
+      break;
+    case PROP_COLUMN:
+      g_value_set_uint (value, priv->column);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+  }
+}
+
+static void
+dee_column_index_class_init (DeeColumnIndexClass *klass)
+{
+  GParamSpec    *pspec;
+  GObjectClass  *obj_class = G_OBJECT_CLASS (klass);
+
+  obj_class->finalize     = dee_column_index_finalize;
+  obj_class->constructed  = dee_column_index_constructed;
+  obj_class->get_property = dee_column_index_get_property;
+  obj_class->set_property = dee_column_index_set_property;
+
+  /**
+   * DeeColumnIndex:model:
+   *
+   * The #DeeModel being indexed
+   */
+  pspec = g_param_spec_object ("model", "Model",
+                               "The model being indexed",
+                               DEE_TYPE_MODEL,
+                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                               | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_MODEL, pspec);
+
+  /**
+   * DeeColumnIndex:column:
+   *
+   * The index of the column being indexed
+   */
+  pspec = g_param_spec_uint ("column", "Column",
+                             "The column being indexed",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                             | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_COLUMN, pspec);
+
+  /* Add private data */
+  g_type_class_add_private (obj_class, sizeof (DeeColumnIndexPrivate));
+}
+
+static void
+dee_column_index_init (DeeColumnIndex *self)
+{
+  self->priv = DEE_COLUMN_INDEX_GET_PRIVATE (self);
+
+  self->priv->values = g_hash_table_new_full (value_hash, g_variant_equal,
+                                              (GDestroyNotify) g_variant_unref,
+                                              (GDestroyNotify) g_hash_table_unref);
+  self->priv->row_values = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                  NULL,
+                                                  (GDestroyNotify) g_variant_unref);
+}
+
+/*
+ * IMPLEMENTATION
+ */
+
+static void
+on_row_added (DeeColumnIndex *self,
+              DeeModelIter   *iter,
+              DeeModel       *model)
+{
+  DeeColumnIndexPrivate *priv;
+  GVariant              *value;
+  GHashTable            *rows;
+
+  priv = self->priv;
+  value = dee_model_get_value (model, iter, priv->column);
+
+  rows = g_hash_table_lookup (priv->values, value);
+  if (rows == NULL)
+    {
+      rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_hash_table_insert (priv->values, g_variant_ref (value), rows);
+    }
+
+  g_hash_table_insert (rows, iter, NULL);
+
+  /* Transfer our ref on value to row_values */
+  g_hash_table_insert (priv->row_values, iter, value);
+}
+
+static void
+on_row_removed (DeeColumnIndex *self,
+                DeeModelIter   *iter,
+                DeeModel       *model)
+{
+  DeeColumnIndexPrivate *priv;
+  GVariant              *value;
+  GHashTable            *rows;
+
+  priv = self->priv;
+  value = g_hash_table_lookup (priv->row_values, iter);
+
+  if (value == NULL)
+    return;
+
+  rows = g_hash_table_lookup (priv->values, value);
+  if (rows != NULL)
+    {
+      g_hash_table_remove (rows, iter);
+      if (g_hash_table_size (rows) == 0)
+        g_hash_table_remove (priv->values, value);
+    }
+
+  g_hash_table_remove (priv->row_values, iter);
+}
+
+static void
+on_row_changed (DeeColumnIndex *self,
+                DeeModelIter   *iter,
+                DeeModel       *model)
+{
+  DeeColumnIndexPrivate *priv;
+  GVariant              *old_value, *value;
+  gboolean               unchanged;
+
+  priv = self->priv;
+
+  /* Most changes don't touch the indexed column */
+  old_value = g_hash_table_lookup (priv->row_values, iter);
+  if (old_value != NULL)
+    {
+      value = dee_model_peek_value (model, iter, priv->column);
+      /* Interned values of equal strings are the same instance */
+      unchanged = old_value == value || g_variant_equal (old_value, value);
+
+      if (unchanged)
+        return;
+    }
+
+  on_row_removed (self, iter, model);
+  on_row_added (self, iter, model);
+}
+
+/*
+ * API
+ */
+
+/**
+ * dee_column_index_new:
+ * @model: The model to index
+ * @column: The index of the column to index
+ *
+ * Create a new column index. The index registers itself with @model so it
+ * will be used by dee_model_find_by_value() and the filters created with
+ * dee_filter_new_for_key_column() and dee_filter_new_for_any_column() for
+ * as long as it is alive.
+ *
+ * Returns: (transfer full): A newly allocated column index. Free with g_object_unref().
+ */
+DeeColumnIndex*
+dee_column_index_new (DeeModel *model,
+                      guint     column)
+{
+  g_return_val_if_fail (DEE_IS_MODEL (model), NULL);
+
+  return (DeeColumnIndex*) g_object_new (DEE_TYPE_COLUMN_INDEX,
+                                         "model", model,
+                                         "column", column,
+                                         NULL);
+}
+
+/**
+ * dee_column_index_find:
+ * @model: The model to find a column index for
+ * @column: The column the index must cover
+ *
+ * Look up a #DeeColumnIndex previously created for @column in @model.
+ *
+ * Returns: (transfer none) (allow-none): A #DeeColumnIndex or %NULL if
+ *          there is no index for @column in @model
+ */
+DeeColumnIndex*
+dee_column_index_find (DeeModel *model,
+                       guint     column)
+{
+  GSList *iter;
+
+  g_return_val_if_fail (DEE_IS_MODEL (model), NULL);
+
+  for (iter = g_object_get_data (G_OBJECT (model), COLUMN_INDEXES_KEY);
+       iter != NULL;
+       iter = iter->next)
+    {
+      if (DEE_COLUMN_INDEX (iter->data)->priv->column == column)
+        return DEE_COLUMN_INDEX (iter->data);
+    }
+
+  return NULL;
+}
+
+/**
+ * dee_column_index_get_model:
+ * @self: The index to get the model for
+ *
+ * Get the model being indexed by this index
+ *
+ * Returns: (transfer none): The #DeeModel being indexed by this index
+ */
+DeeModel*
+dee_column_index_get_model (DeeColumnIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), NULL);
+
+  return self->priv->model;
+}
+
+/**
+ * dee_column_index_get_column:
+ * @self: The index to get the column for
+ *
+ * Returns: The index of the column being indexed by this index
+ */
+guint
+dee_column_index_get_column (DeeColumnIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), 0);
+
+  return self->priv->column;
+}
+
+/**
+ * dee_column_index_lookup:
+ * @self: The index to perform the lookup in
+ * @value: The value to look up. If @value is floating the index
+ *         will take ownership of it
+ *
+ * Find all rows where the indexed column is equal to @value according to
+ * g_variant_equal(). The rows in the result set are in no particular order.
+ *
+ * Returns: (transfer full): A #DeeResultSet. Free with g_object_unref().
+ */
+DeeResultSet*
+dee_column_index_lookup (DeeColumnIndex *self,
+                         GVariant       *value)
+{
+  DeeColumnIndexPrivate *priv;
+  DeeResultSet          *results;
+  GHashTable            *rows;
+  GObject               *buf_owner;
+  GList                 *buf;
+
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), NULL);
+  g_return_val_if_fail (value != NULL, NULL);
+
+  priv = self->priv;
+
+  g_variant_ref_sink (value);
+  rows = g_hash_table_lookup (priv->values, value);
+  g_variant_unref (value);
+
+  if (rows == NULL)
+    return dee_glist_result_set_new (NULL, /* The empty GList */
+                                     priv->model,
+                                     NULL);
+
+  /* We use a dummy GObject to bolt ref counting onto the GList */
+  buf = g_hash_table_get_keys (rows);
+  buf_owner = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_data_full (buf_owner, "buf", buf, (GDestroyNotify) g_list_free);
+
+  results = dee_glist_result_set_new (buf, priv->model, buf_owner);
+  g_object_unref (buf_owner);
+
+  return results;
+}
+
+/**
+ * dee_column_index_lookup_one:
+ * @self: The index to perform the lookup in
+ * @value: The value to look up. If @value is floating the index
+ *         will take ownership of it
+ *
+ * Find the first row, in the order of the model, where the indexed column
+ * is equal to @value according to g_variant_equal().
+ *
+ * Returns: (transfer none): A #DeeModelIter pointing to the matching row
+ *          or %NULL in case no rows match @value
+ */
+DeeModelIter*
+dee_column_index_lookup_one (DeeColumnIndex *self,
+                             GVariant       *value)
+{
+  DeeColumnIndexPrivate *priv;
+  GHashTable            *rows;
+  GHashTableIter         iter;
+  DeeModelIter          *row, *first;
+  guint                  pos, first_pos;
+
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), NULL);
+  g_return_val_if_fail (value != NULL, NULL);
+
+  priv = self->priv;
+
+  g_variant_ref_sink (value);
+  rows = g_hash_table_lookup (priv->values, value);
+  g_variant_unref (value);
+
+  if (rows == NULL)
+    return NULL;
+
+  first = NULL;
+  first_pos = G_MAXUINT;
+  g_hash_table_iter_init (&iter, rows);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &row, NULL))
+    {
+      pos = dee_model_get_position (priv->model, row);
+      if (pos < first_pos)
+        {
+          first = row;
+          first_pos = pos;
+        }
+    }
+
+  return first;
+}
+
+/**
+ * dee_column_index_get_n_values:
+ * @self: The index to inspect
+ *
+ * Returns: The number of distinct values in the indexed column
+ */
+guint
+dee_column_index_get_n_values (DeeColumnIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), 0);
+
+  return g_hash_table_size (self->priv->values);
+}
+
+/**
+ * dee_column_index_get_n_rows_for_value:
+ * @self: The index to inspect
+ * @value: The value to count the rows for. If @value is floating the index
+ *         will take ownership of it
+ *
+ * Returns: The number of rows where the indexed column is equal to @value
+ */
+guint
+dee_column_index_get_n_rows_for_value (DeeColumnIndex *self,
+                                       GVariant       *value)
+{
+  GHashTable *rows;
+
+  g_return_val_if_fail (DEE_IS_COLUMN_INDEX (self), 0);
+  g_return_val_if_fail (value != NULL, 0);
+
+  g_variant_ref_sink (value);
+  rows = g_hash_table_lookup (self->priv->values, value);
+  g_variant_unref (value);
+
+  return rows == NULL ? 0 : g_hash_table_size (rows);
+}
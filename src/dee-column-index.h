@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (_DEE_H_INSIDE) && !defined (DEE_COMPILATION)
+#error "Only <dee.h> can be included directly."
+#endif
+
+#ifndef _HAVE_DEE_COLUMN_INDEX_H
+#define _HAVE_DEE_COLUMN_INDEX_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee-model.h>
+#include <dee-result-set.h>
+
+G_BEGIN_DECLS
+
+#define DEE_TYPE_COLUMN_INDEX (dee_column_index_get_type ())
+
+#define DEE_COLUMN_INDEX(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+        DEE_TYPE_COLUMN_INDEX, DeeColumnIndex))
+
+#define DEE_COLUMN_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), \
+        DEE_TYPE_COLUMN_INDEX, DeeColumnIndexClass))
+
+#define DEE_IS_COLUMN_INDEX(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+        DEE_TYPE_COLUMN_INDEX))
+
+#define DEE_IS_COLUMN_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+        DEE_TYPE_COLUMN_INDEX))
+
+#define DEE_COLUMN_INDEX_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+        DEE_TYPE_COLUMN_INDEX, DeeColumnIndexClass))
+
+typedef struct _DeeColumnIndexClass DeeColumnIndexClass;
+typedef struct _DeeColumnIndex DeeColumnIndex;
+typedef struct _DeeColumnIndexPrivate DeeColumnIndexPrivate;
+
+/**
+ * DeeColumnIndex:
+ *
+ * All fields in the DeeColumnIndex structure are private and should never be
+ * accessed directly
+ */
+struct _DeeColumnIndex
+{
+  /*< private >*/
+  GObject                parent;
+
+  DeeColumnIndexPrivate *priv;
+};
+
+struct _DeeColumnIndexClass
+{
+  GObjectClass     parent_class;
+};
+
+GType                dee_column_index_get_type     (void);
+
+DeeColumnIndex*      dee_column_index_new          (DeeModel       *model,
+                                                    guint           column);
+
+DeeColumnIndex*      dee_column_index_find         (DeeModel       *model,
+                                                    guint           column);
+
+DeeModel*            dee_column_index_get_model    (DeeColumnIndex *self);
+
+guint                dee_column_index_get_column   (DeeColumnIndex *self);
+
+DeeResultSet*        dee_column_index_lookup       (DeeColumnIndex *self,
+                                                    GVariant       *value);
+
+DeeModelIter*        dee_column_index_lookup_one   (DeeColumnIndex *self,
+                                                    GVariant       *value);
+
+guint                dee_column_index_get_n_values (DeeColumnIndex *self);
+
+guint                dee_column_index_get_n_rows_for_value (DeeColumnIndex *self,
+                                                            GVariant       *value);
+
+G_END_DECLS
+
+#endif /* _HAVE_DEE_COLUMN_INDEX_H */
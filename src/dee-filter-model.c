@@ -61,6 +61,7 @@
 #include "dee-serializable-model.h"
 #include "dee-sequence-model.h"
 #include "dee-marshal.h"
+#include "dee-bitmap.h"
 #include "trace-log.h"
 
 static void dee_filter_model_model_iface_init (DeeModelIface *iface);
@@ -89,14 +90,34 @@ struct _DeeFilterModelPrivate
   
   /* Sequence use to keep track of the sorting of iters from iter_map  */
   GSequence  *iter_list;
+
+  /* Only set for compact filter models. Holds a bit per row in orig_model,
+   * set for the rows included in the filter model. Used instead of
+   * iter_map and iter_list */
+  DeeBitmap  *bitmap;
   
   /* When TRUE signals from orig_model will not be forwarded or checked
    * via the filter->map_notify function */
   gboolean    ignore_orig_signals;
+
+  /* TRUE while the filter populates the model from constructed(). Nobody
+   * can be connected to our signals yet, so we don't emit row-added */
+  gboolean    initial_map;
+
+  /* TRUE while the filter places the rows again after orig_model has been
+   * reordered. The rows were there all along, so we don't emit row-added */
+  gboolean    reordering;
+
+  /* A row of orig_model that moved and is being placed again by the
+   * filter. Including it emits row-moved from moving_pos, not row-added */
+  DeeModelIter *moving_iter;
+  guint         moving_pos;
   
   gulong      on_orig_row_added_id;
   gulong      on_orig_row_removed_id;
   gulong      on_orig_row_changed_id;
+  gulong      on_orig_row_moved_id;
+  gulong      on_orig_rows_reordered_id;
   gulong      on_orig_changeset_started_id;
   gulong      on_orig_changeset_finished_id;
 };
@@ -105,6 +126,7 @@ enum
 {
   PROP_0,
   PROP_FILTER,
+  PROP_COMPACT,
 };
 
 /*
@@ -152,6 +174,12 @@ static gboolean      dee_filter_model_is_first        (DeeModel     *self,
 static guint         dee_filter_model_get_position    (DeeModel     *self,
                                                        DeeModelIter *iter);
 
+static void          dee_filter_model_foreach_range   (DeeModel         *self,
+                                                       DeeModelIter     *start,
+                                                       DeeModelIter     *end,
+                                                       DeeModelIterFunc  func,
+                                                       gpointer          user_data);
+
 /* Private forward declarations */
 static gboolean    dee_filter_model_is_empty     (DeeModel       *self);
 
@@ -164,6 +192,13 @@ static void        on_orig_model_row_removed     (DeeFilterModel *self,
 static void        on_orig_model_row_changed     (DeeFilterModel *self,
                                                   DeeModelIter   *iter);
 
+static void        on_orig_model_row_moved       (DeeFilterModel *self,
+                                                  DeeModelIter   *iter,
+                                                  guint           old_pos);
+
+static void        on_orig_model_rows_reordered  (DeeFilterModel *self,
+                                                  const guint    *new_order);
+
 static void        on_orig_model_changeset_started  (DeeFilterModel *self,
                                                      DeeModel       *iter);
 
@@ -193,6 +228,11 @@ dee_filter_model_finalize (GObject *object)
       g_sequence_free (priv->iter_list);
       priv->iter_list = NULL;
     }
+  if (priv->bitmap)
+    {
+      _dee_bitmap_free (priv->bitmap);
+      priv->bitmap = NULL;
+    }
   
   if (priv->on_orig_row_added_id != 0)
     g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_added_id);
@@ -200,6 +240,10 @@ dee_filter_model_finalize (GObject *object)
     g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_removed_id);
   if (priv->on_orig_row_changed_id != 0)
     g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_changed_id);
+  if (priv->on_orig_row_moved_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_moved_id);
+  if (priv->on_orig_rows_reordered_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_rows_reordered_id);
   if (priv->on_orig_changeset_started_id != 0)
     g_signal_handler_disconnect (priv->orig_model, priv->on_orig_changeset_started_id);
   if (priv->on_orig_changeset_finished_id != 0)
@@ -208,6 +252,8 @@ dee_filter_model_finalize (GObject *object)
   priv->on_orig_row_added_id = 0;
   priv->on_orig_row_removed_id = 0;
   priv->on_orig_row_changed_id = 0;
+  priv->on_orig_row_moved_id = 0;
+  priv->on_orig_rows_reordered_id = 0;
   priv->on_orig_changeset_started_id = 0;
   priv->on_orig_changeset_finished_id = 0;
 
@@ -224,6 +270,7 @@ static void
 dee_filter_model_constructed (GObject *object)
 {
   DeeFilterModelPrivate *priv = DEE_FILTER_MODEL (object)->priv;
+  guint                  i, n_rows;
   
   if (priv->filter == NULL)
     {
@@ -239,9 +286,19 @@ dee_filter_model_constructed (GObject *object)
   g_hash_table_insert (priv->iter_map,
                        dee_model_get_last_iter (priv->orig_model),
                        g_sequence_get_end_iter (priv->iter_list));
+
+  /* Compact filter models start out with all rows excluded */
+  if (priv->bitmap)
+    {
+      n_rows = dee_model_get_n_rows (priv->orig_model);
+      for (i = 0; i < n_rows; i++)
+        _dee_bitmap_insert (priv->bitmap, i, FALSE);
+    }
   
   /* Apply filter to orig_model in order to fill this model */
+  priv->initial_map = TRUE;
   dee_filter_map (priv->filter, priv->orig_model, DEE_FILTER_MODEL (object));
+  priv->initial_map = FALSE;
   
   /* Listen for changes to orig_model */
   priv->on_orig_row_added_id =
@@ -256,6 +313,14 @@ dee_filter_model_constructed (GObject *object)
     g_signal_connect_swapped (priv->orig_model, "row-changed",
                               G_CALLBACK (on_orig_model_row_changed), object);
 
+  priv->on_orig_row_moved_id =
+    g_signal_connect_swapped (priv->orig_model, "row-moved",
+                              G_CALLBACK (on_orig_model_row_moved), object);
+
+  priv->on_orig_rows_reordered_id =
+    g_signal_connect_swapped (priv->orig_model, "rows-reordered",
+                              G_CALLBACK (on_orig_model_rows_reordered), object);
+
   priv->on_orig_changeset_started_id =
     g_signal_connect_swapped (priv->orig_model, "changeset-started",
                               G_CALLBACK (on_orig_model_changeset_started),
@@ -285,6 +350,10 @@ dee_filter_model_set_property (GObject       *object,
       priv->filter = g_new0 (DeeFilter, 1);
       memcpy (priv->filter, g_value_get_pointer (value), sizeof (DeeFilter));
       break;
+    case PROP_COMPACT:
+      if (g_value_get_boolean (value))
+        priv->bitmap = _dee_bitmap_new ();
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
       break;
@@ -302,6 +371,9 @@ dee_filter_model_get_property (GObject     *object,
     case PROP_FILTER:
       g_value_set_pointer (value, DEE_FILTER_MODEL (object)->priv->filter);
       break;
+    case PROP_COMPACT:
+      g_value_set_boolean (value, DEE_FILTER_MODEL (object)->priv->bitmap != NULL);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
       break;
@@ -333,6 +405,20 @@ dee_filter_model_class_init (DeeFilterModelClass *klass)
                                 | G_PARAM_STATIC_STRINGS);
   g_object_class_install_property (obj_class, PROP_FILTER, pspec);
 
+  /**
+   * DeeFilterModel:compact:
+   *
+   * Whether the filter model keeps track of its rows with a bitmap over the
+   * rows of the back end model, rather than with a lookup table and a list
+   * of row iters. See dee_filter_model_new_compact().
+   */
+  pspec = g_param_spec_boolean ("compact", "Compact",
+                                "Track filtered rows with a bitmap",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                                | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_COMPACT, pspec);
+
   /* Add private data */
   g_type_class_add_private (obj_class, sizeof (DeeFilterModelPrivate));
 }
@@ -346,11 +432,17 @@ dee_filter_model_init (DeeFilterModel *self)
   
   priv->iter_map = g_hash_table_new (g_direct_hash, g_direct_equal);
   priv->iter_list = g_sequence_new (NULL);
+  priv->bitmap = NULL;
   
   priv->ignore_orig_signals = FALSE;
+  priv->moving_iter = NULL;
+  priv->moving_pos = 0;
+  priv->reordering = FALSE;
   priv->on_orig_row_added_id = 0;
   priv->on_orig_row_removed_id = 0;
   priv->on_orig_row_changed_id = 0;
+  priv->on_orig_row_moved_id = 0;
+  priv->on_orig_rows_reordered_id = 0;
   priv->on_orig_changeset_started_id = 0;
   priv->on_orig_changeset_finished_id = 0;
 }
@@ -372,6 +464,15 @@ dee_filter_model_model_iface_init (DeeModelIface *iface)
   iface->prev                 = dee_filter_model_prev;
   iface->is_first             = dee_filter_model_is_first;
   iface->get_position         = dee_filter_model_get_position;
+  iface->foreach_range        = dee_filter_model_foreach_range;
+
+  /* Positions in a reordering are relative to us, not orig_model. Leave it
+   * to the generic implementation, which moves rows by iter */
+  iface->reorder              = NULL;
+
+  /* Rows inserted through us are force-included one by one in
+   * dee_filter_model_insert_row_before() */
+  iface->insert_rows_before   = NULL;
 }
 
 /*
@@ -405,6 +506,153 @@ dee_filter_model_new (DeeModel  *orig_model,
   return self;
 }
 
+/**
+ * dee_filter_model_new_compact:
+ * @filter: Structure containing the logic used to create the filter model.
+ *          The filter model will create it's own copy of @filter so unless
+ *          @filter is allocated statically or on the stack you need to free it
+ *          after calling this method.
+ * @orig_model: The back end model. This will be set as the
+ *              #DeeProxyModel:back-end property
+ *
+ * Create a filter model that stores which rows of @orig_model it contains
+ * as a single bit per row of @orig_model. This uses a fraction of the
+ * memory of a filter model created with dee_filter_model_new(), in
+ * particular when many rows are included, but the rows must always be
+ * in the same order as in @orig_model.
+ *
+ * This makes compact filter models suitable only for filters that preserve
+ * the ordering of the back end model, like the ones created by
+ * dee_filter_new_for_key_column(), dee_filter_new_for_any_column() and
+ * dee_filter_new_regex(). Trying to add a row out of order will fail with
+ * a critical.
+ *
+ * Looking up rows is slower than in a regular filter model. Each call to
+ * dee_model_next(), dee_model_prev() or dee_model_get_position() maps
+ * between the two models through a rank or select on the bitmap and a
+ * position lookup in @orig_model, costing O(log n) each.
+ * dee_model_foreach_range() only costs that for the first row and after
+ * long runs of excluded rows, so prefer it for walking the model.
+ *
+ * Returns: (transfer full) (type DeeFilterModel): A newly allocated #DeeFilterModel. Free with g_object_unref().
+ */
+DeeModel*
+dee_filter_model_new_compact (DeeModel  *orig_model,
+                              DeeFilter *filter)
+{
+  DeeModel  *self;
+
+  self = DEE_MODEL (g_object_new (DEE_TYPE_FILTER_MODEL,
+                                  "filter", filter,
+                                  "back-end", orig_model,
+                                  "proxy-signals", FALSE,
+                                  "inherit-seqnums", FALSE,
+                                  "compact", TRUE,
+                                  NULL));
+
+  return self;
+}
+
+/* Bump the seqnum and emit row-added for a row included in the filter
+ * model, unless we are still being constructed */
+static void
+dee_filter_model_emit_row_added (DeeFilterModel *self,
+                                 DeeModelIter   *iter)
+{
+  DeeFilterModelPrivate *priv = self->priv;
+
+  if (priv->reordering)
+    return;
+
+  if (iter == priv->moving_iter)
+    {
+      priv->moving_iter = NULL;
+      if (dee_model_get_position (DEE_MODEL (self), iter) != priv->moving_pos)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-moved", iter, priv->moving_pos);
+        }
+      return;
+    }
+
+  dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+
+  if (!self->priv->initial_map)
+    g_signal_emit_by_name (self, "row-added", iter);
+}
+
+/*
+ * Helpers for compact filter models
+ */
+
+/* Include @iter in a compact filter model. @row is the row the caller
+ * expects @iter to end up at, or -1 if it doesn't care. Since we can only
+ * represent the ordering of orig_model it's an error if the two disagree */
+static DeeModelIter*
+dee_filter_model_compact_include (DeeFilterModel *self,
+                                  DeeModelIter   *iter,
+                                  gint            row)
+{
+  DeeFilterModelPrivate *priv;
+  guint                  pos;
+
+  priv = self->priv;
+  pos = dee_model_get_position (priv->orig_model, iter);
+
+  if (_dee_bitmap_get (priv->bitmap, pos))
+    {
+      g_critical ("Iter already present in DeeFilterModel");
+      return NULL;
+    }
+
+  if (row >= 0 && _dee_bitmap_rank (priv->bitmap, pos) != (guint) row)
+    {
+      g_critical ("Compact DeeFilterModels must keep the rows in the order "
+                  "of the back end model");
+      return NULL;
+    }
+
+  _dee_bitmap_set (priv->bitmap, pos, TRUE);
+
+  dee_filter_model_emit_row_added (self, iter);
+
+  return iter;
+}
+
+/* Returns the orig_model position of @iter if it's included in the compact
+ * filter model, or is the end iter. Otherwise complains and returns -1 */
+static gint
+dee_filter_model_compact_position (DeeFilterModel *self,
+                                   DeeModelIter   *iter)
+{
+  DeeFilterModelPrivate *priv;
+  guint                  pos;
+
+  priv = self->priv;
+  pos = dee_model_get_position (priv->orig_model, iter);
+
+  if (pos < _dee_bitmap_get_n_bits (priv->bitmap) &&
+      !_dee_bitmap_get (priv->bitmap, pos))
+    {
+      g_critical ("Iter not present in DeeFilterModel");
+      return -1;
+    }
+
+  return pos;
+}
+
+/* Map the @row'th row of the compact filter model to an iter of orig_model.
+ * Out of bounds rows yield the end iter */
+static DeeModelIter*
+dee_filter_model_compact_iter_at_row (DeeFilterModel *self,
+                                      guint           row)
+{
+  DeeFilterModelPrivate *priv = self->priv;
+
+  return dee_model_get_iter_at_row (priv->orig_model,
+                                    _dee_bitmap_select (priv->bitmap, row));
+}
+
 /**
  * dee_filter_model_contains:
  * @self: The #DeeFilterModel to check
@@ -418,9 +666,21 @@ gboolean
 dee_filter_model_contains (DeeFilterModel *self,
                            DeeModelIter   *iter)
 {
+  DeeFilterModelPrivate *priv;
+  guint                  pos;
+
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), FALSE);
+
+  priv = self->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_model_get_position (priv->orig_model, iter);
+      return pos < _dee_bitmap_get_n_bits (priv->bitmap) &&
+             _dee_bitmap_get (priv->bitmap, pos);
+    }
   
-  return g_hash_table_lookup (self->priv->iter_map, iter) != NULL;
+  return g_hash_table_lookup (priv->iter_map, iter) != NULL;
 }
 
 /**
@@ -447,6 +707,11 @@ dee_filter_model_append_iter (DeeFilterModel *self,
   g_return_val_if_fail (!dee_model_is_last ((DeeModel*)self, iter), NULL);
   
   priv = self->priv;
+
+  if (priv->bitmap)
+    return dee_filter_model_compact_include (self, iter,
+                                             _dee_bitmap_get_n_set (priv->bitmap));
+
   seq_iter = g_hash_table_lookup (priv->iter_map, iter);
   
   if (seq_iter != NULL)
@@ -458,12 +723,62 @@ dee_filter_model_append_iter (DeeFilterModel *self,
   seq_iter = g_sequence_append (priv->iter_list, iter);
   g_hash_table_insert (priv->iter_map, iter, seq_iter);
 
-  dee_serializable_model_inc_seqnum (DEE_MODEL (self));
-  g_signal_emit_by_name (self, "row-added", iter);
+  dee_filter_model_emit_row_added (self, iter);
   
   return iter;
 }
 
+/**
+ * dee_filter_model_append_iters:
+ * @self: A #DeeFilterModel instance
+ * @iters: (array length=n_iters): Iterators from the back end model
+ * @n_iters: The number of iterators in @iters
+ *
+ * Includes all of @iters from the back end model in the filtered model,
+ * appending them to the end of the filtered rows in the order given.
+ *
+ * This is the preferred way to populate the model from a #DeeFilterMapFunc.
+ * Collect the matching rows, sort them once if needed, and add them all
+ * here. While the #DeeFilterMapFunc runs the filter model is still being
+ * constructed, so no #DeeModel::row-added signals are emitted for the rows
+ * included at that time.
+ */
+void
+dee_filter_model_append_iters (DeeFilterModel  *self,
+                               DeeModelIter   **iters,
+                               guint            n_iters)
+{
+  DeeFilterModelPrivate *priv;
+  GSequenceIter         *seq_iter;
+  guint                  i;
+
+  g_return_if_fail (DEE_IS_FILTER_MODEL (self));
+  g_return_if_fail (iters != NULL || n_iters == 0);
+
+  priv = self->priv;
+
+  for (i = 0; i < n_iters; i++)
+    {
+      if (priv->bitmap)
+        {
+          dee_filter_model_compact_include (self, iters[i],
+                                            _dee_bitmap_get_n_set (priv->bitmap));
+          continue;
+        }
+
+      if (g_hash_table_lookup (priv->iter_map, iters[i]) != NULL)
+        {
+          g_critical ("Iter already present in DeeFilterModel");
+          continue;
+        }
+
+      seq_iter = g_sequence_append (priv->iter_list, iters[i]);
+      g_hash_table_insert (priv->iter_map, iters[i], seq_iter);
+
+      dee_filter_model_emit_row_added (self, iters[i]);
+    }
+}
+
 /**
  * dee_filter_model_prepend_iter:
  * @self:
@@ -487,6 +802,10 @@ dee_filter_model_prepend_iter (DeeFilterModel *self,
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   
   priv = self->priv;
+
+  if (priv->bitmap)
+    return dee_filter_model_compact_include (self, iter, 0);
+
   seq_iter = g_hash_table_lookup (priv->iter_map, iter);
   
   if (seq_iter != NULL)
@@ -498,8 +817,7 @@ dee_filter_model_prepend_iter (DeeFilterModel *self,
   seq_iter = g_sequence_prepend (priv->iter_list, iter);
   g_hash_table_insert (priv->iter_map, iter, seq_iter);
 
-  dee_serializable_model_inc_seqnum (DEE_MODEL (self));
-  g_signal_emit_by_name (self, "row-added", iter);
+  dee_filter_model_emit_row_added (self, iter);
   
   return iter;
 }
@@ -557,6 +875,15 @@ dee_filter_model_insert_iter_before (DeeFilterModel *self,
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   
   priv = self->priv;
+
+  if (priv->bitmap)
+    {
+      if (dee_filter_model_compact_position (self, pos) < 0)
+        return NULL;
+
+      return dee_filter_model_compact_include (self, iter,
+                                               dee_model_get_position (DEE_MODEL (self), pos));
+    }
   
   seq_iter = g_hash_table_lookup (priv->iter_map, iter);
   if (seq_iter != NULL)
@@ -576,12 +903,31 @@ dee_filter_model_insert_iter_before (DeeFilterModel *self,
   seq_iter = g_sequence_insert_before (seq_iter, iter);
   g_hash_table_insert (priv->iter_map, iter, seq_iter);
 
-  dee_serializable_model_inc_seqnum (DEE_MODEL (self));
-  g_signal_emit_by_name (self, "row-added", iter);
+  dee_filter_model_emit_row_added (self, iter);
   
   return iter;
 }
 
+typedef struct
+{
+  DeeModel *orig_model;
+  guint     pos;
+} OrigOrderData;
+
+/* Compare the original position of the row being inserted, which is cached
+ * in @data, with that of a row already in the filter model */
+static gint
+cmp_orig_position (GSequenceIter *seq_iter,
+                   GSequenceIter *needle,
+                   OrigOrderData *data)
+{
+  guint pos;
+
+  pos = dee_model_get_position (data->orig_model, g_sequence_get (seq_iter));
+
+  return pos < data->pos ? -1 : (pos > data->pos ? 1 : 0);
+}
+
 /**
  * dee_filter_model_insert_iter_with_original_order:
  * 
@@ -604,34 +950,89 @@ dee_filter_model_insert_iter_with_original_order (DeeFilterModel *self,
                                                   DeeModelIter   *iter)
 {
   DeeFilterModelPrivate *priv;
-  DeeModel              *orig_model;
-  DeeModelIter          *probe, *end;
+  GSequenceIter         *seq_iter;
+  OrigOrderData          data;
 
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   g_return_val_if_fail (iter != NULL, NULL);
 
   priv = self->priv;
-  orig_model = priv->orig_model;
-
-  /* We find the first row *after* iter which is both in orig_model and the
-   * filter model and insert iter *before* that row  in the filter model.
-   * This should assure the sorting is consistent between the models
-   * (assuming it already was consistent before we started) */
-  probe = dee_model_next (orig_model, iter);
-  end = dee_model_get_last_iter (orig_model);
-  while (probe != end)
+
+  if (priv->bitmap)
+    return dee_filter_model_compact_include (self, iter, -1);
+
+  if (g_hash_table_lookup (priv->iter_map, iter) != NULL)
     {
-      if (dee_filter_model_contains (self, probe))
+      g_critical ("Iter already present in DeeFilterModel");
+      return NULL;
+    }
+
+  /* Since iter_list is ordered like orig_model we can binary search it for
+   * the first row that comes *after* iter in orig_model and insert iter
+   * *before* that row. With a GSequence backed orig_model that is
+   * O(log² n) regardless of how sparse the filter is, instead of a scan
+   * over all the rows of orig_model between iter and the next row in the
+   * filter model */
+  data.orig_model = priv->orig_model;
+  data.pos = dee_model_get_position (priv->orig_model, iter);
+  seq_iter = g_sequence_search_iter (priv->iter_list, NULL,
+                                     (GSequenceIterCompareFunc) cmp_orig_position,
+                                     &data);
+
+  seq_iter = g_sequence_insert_before (seq_iter, iter);
+  g_hash_table_insert (priv->iter_map, iter, seq_iter);
+
+  dee_filter_model_emit_row_added (self, iter);
+
+  return iter;
+}
+
+/**
+ * dee_filter_model_remove_iter:
+ * @self: A #DeeFilterModel instance
+ * @iter: (transfer none): The #DeeModelIter to exclude from @self
+ *
+ * Excludes @iter from the filtered model without touching the back end
+ * model. If @iter is not contained in @self this method does nothing.
+ *
+ * This method is usually called when implementing #DeeFilterMapChanged
+ * methods, for rows that no longer match the filter.
+ */
+void
+dee_filter_model_remove_iter (DeeFilterModel *self,
+                              DeeModelIter   *iter)
+{
+  DeeFilterModelPrivate *priv;
+  GSequenceIter         *seq_iter;
+  guint                  pos;
+
+  g_return_if_fail (DEE_IS_FILTER_MODEL (self));
+  g_return_if_fail (!dee_model_is_last ((DeeModel*)self, iter));
+
+  priv = self->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_model_get_position (priv->orig_model, iter);
+      if (_dee_bitmap_get (priv->bitmap, pos))
         {
-          dee_filter_model_insert_iter_before (self, iter, probe);
-          return iter;
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-removed", iter);
+          _dee_bitmap_set (priv->bitmap, pos, FALSE);
         }
-      probe = dee_model_next (orig_model, probe);
+      return;
     }
 
-  /* We made it to the end without finding a suitable place,
-   * so just append it */
-  return dee_filter_model_append_iter (self, iter);
+  seq_iter = g_hash_table_lookup (priv->iter_map, iter);
+
+  if (seq_iter != NULL)
+    {
+      /* Emit signal before we delete it from our records */
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-removed", iter);
+      g_hash_table_remove (priv->iter_map, iter);
+      g_sequence_remove (seq_iter);
+    }
 }
 
 /*
@@ -646,6 +1047,10 @@ dee_filter_model_is_empty (DeeModel       *self)
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), FALSE);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    return _dee_bitmap_get_n_set (priv->bitmap) == 0;
+
   return g_sequence_get_begin_iter (priv->iter_list) ==
                       g_sequence_get_end_iter (priv->iter_list);
 }
@@ -657,6 +1062,13 @@ on_orig_model_row_added (DeeFilterModel *self,
   DeeFilterModelPrivate *priv;
   
   priv = self->priv;
+
+  /* A compact filter model needs to track every row in orig_model, also
+   * the ones we add ourselves. Those are included straight away */
+  if (priv->bitmap)
+    _dee_bitmap_insert (priv->bitmap,
+                        dee_model_get_position (priv->orig_model, iter),
+                        priv->ignore_orig_signals);
   
   if (priv->ignore_orig_signals)
     return;
@@ -670,23 +1082,27 @@ on_orig_model_row_removed (DeeFilterModel *self,
                            DeeModelIter  *iter)
 {
   DeeFilterModelPrivate *priv;
-  GSequenceIter         *seq_iter;
+  guint                  pos;
   
   priv = self->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_model_get_position (priv->orig_model, iter);
+      if (!priv->ignore_orig_signals && _dee_bitmap_get (priv->bitmap, pos))
+        {
+          /* Emit signal before we delete it from our records */
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-removed", iter);
+        }
+      _dee_bitmap_remove (priv->bitmap, pos);
+      return;
+    }
   
   if (priv->ignore_orig_signals)
     return;
   
-  seq_iter = g_hash_table_lookup (priv->iter_map, iter);
-  
-  if (seq_iter != NULL)
-    {
-      /* Emit signal before we delete it from our records */
-      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
-      g_signal_emit_by_name (self, "row-removed", iter);
-      g_hash_table_remove (priv->iter_map, iter);
-      g_sequence_remove (seq_iter);
-    }
+  dee_filter_model_remove_iter (self, iter);
 }
 
 static void
@@ -694,19 +1110,219 @@ on_orig_model_row_changed (DeeFilterModel *self,
                            DeeModelIter  *iter)
 {
   DeeFilterModelPrivate *priv;
+  guint64                seqnum;
   
   priv = self->priv;
   
   if (priv->ignore_orig_signals)
     return;
   
-  if (dee_filter_model_contains (self, iter))
+  /* The filter re-evaluates the row and adds, removes or moves it as needed.
+   * Any such change bumps our seqnum and emits its own signals, so we only
+   * emit row-changed for rows the filter left in place */
+  seqnum = dee_serializable_model_get_seqnum (DEE_MODEL (self));
+
+  if (dee_filter_notify_changed (priv->filter, iter, priv->orig_model, self) &&
+      seqnum == dee_serializable_model_get_seqnum (DEE_MODEL (self)))
     {
       dee_serializable_model_inc_seqnum (DEE_MODEL (self));
       g_signal_emit_by_name (self, "row-changed", iter);
     }
 }
 
+static void
+on_orig_model_row_moved (DeeFilterModel *self,
+                         DeeModelIter   *iter,
+                         guint           old_pos)
+{
+  DeeFilterModelPrivate *priv;
+  GSequenceIter         *seq_iter;
+  guint                  old_rank;
+  gboolean               included;
+
+  priv = self->priv;
+
+  /* A compact filter model follows the order of orig_model, so the row
+   * moves along with its bit */
+  if (priv->bitmap)
+    {
+      old_rank = _dee_bitmap_rank (priv->bitmap, old_pos);
+      included = _dee_bitmap_remove (priv->bitmap, old_pos);
+      _dee_bitmap_insert (priv->bitmap,
+                          dee_model_get_position (priv->orig_model, iter),
+                          included);
+
+      if (included && !priv->ignore_orig_signals)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-moved", iter, old_rank);
+        }
+      return;
+    }
+
+  if (priv->ignore_orig_signals)
+    return;
+
+  /* Otherwise the order is up to the filter, so let it place the row
+   * again. We take the row out quietly, and dee_filter_model_emit_row_added()
+   * turns including it again into a row-moved */
+  seq_iter = g_hash_table_lookup (priv->iter_map, iter);
+  if (seq_iter == NULL)
+    return;
+
+  priv->moving_iter = iter;
+  priv->moving_pos = g_sequence_iter_get_position (seq_iter);
+  g_hash_table_remove (priv->iter_map, iter);
+  g_sequence_remove (seq_iter);
+
+  dee_filter_notify (priv->filter, iter, priv->orig_model, self);
+
+  /* The filter dropped the row. Put it back so we can signal the removal
+   * while it is still there */
+  if (priv->moving_iter != NULL)
+    {
+      priv->moving_iter = NULL;
+      seq_iter = g_sequence_get_iter_at_pos (priv->iter_list, priv->moving_pos);
+      seq_iter = g_sequence_insert_before (seq_iter, iter);
+      g_hash_table_insert (priv->iter_map, iter, seq_iter);
+      dee_filter_model_remove_iter (self, iter);
+    }
+}
+
+static void
+on_orig_model_rows_reordered (DeeFilterModel *self,
+                              const guint    *new_order)
+{
+  DeeFilterModelPrivate *priv;
+  DeeModelIter          *iter;
+  DeeBitmap             *bitmap;
+  GSequenceIter         *seq_iter, *next_seq_iter;
+  GHashTable            *old_rows;
+  GHashTableIter         hash_iter;
+  GSList                *dropped, *l;
+  gpointer               old_pos;
+  guint                 *old_rank, *filtered_order;
+  guint                  n_bits, n_set, n_rows, pos, i;
+  gboolean               included, reordered;
+
+  priv = self->priv;
+
+  /* A compact filter model follows the order of orig_model. Permute the
+   * bitmap and signal the order of the included rows */
+  if (priv->bitmap)
+    {
+      n_bits = _dee_bitmap_get_n_bits (priv->bitmap);
+
+      old_rank = g_new (guint, n_bits);
+      for (pos = 0, n_set = 0; pos < n_bits; pos++)
+        {
+          old_rank[pos] = n_set;
+          if (_dee_bitmap_get (priv->bitmap, pos))
+            n_set++;
+        }
+
+      bitmap = _dee_bitmap_new ();
+      filtered_order = g_new (guint, MAX (n_set, 1));
+      reordered = FALSE;
+      for (pos = 0, i = 0; pos < n_bits; pos++)
+        {
+          included = _dee_bitmap_get (priv->bitmap, new_order[pos]);
+          _dee_bitmap_insert (bitmap, pos, included);
+          if (included)
+            {
+              filtered_order[i] = old_rank[new_order[pos]];
+              reordered |= filtered_order[i] != i;
+              i++;
+            }
+        }
+
+      _dee_bitmap_free (priv->bitmap);
+      priv->bitmap = bitmap;
+
+      if (reordered && !priv->ignore_orig_signals)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "rows-reordered", filtered_order);
+        }
+
+      g_free (filtered_order);
+      g_free (old_rank);
+      return;
+    }
+
+  if (priv->ignore_orig_signals)
+    return;
+
+  /* Otherwise the order is up to the filter. Take our rows out quietly,
+   * remembering where they were, and let the filter place them again in
+   * their new order, like on_orig_model_row_moved() does */
+  n_rows = g_sequence_get_length (priv->iter_list);
+  if (n_rows < 2)
+    return;
+
+  old_rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+  seq_iter = g_sequence_get_begin_iter (priv->iter_list);
+  for (i = 0; i < n_rows; i++)
+    {
+      iter = g_sequence_get (seq_iter);
+      next_seq_iter = g_sequence_iter_next (seq_iter);
+      g_hash_table_insert (old_rows, iter, GUINT_TO_POINTER (i + 1));
+      g_hash_table_remove (priv->iter_map, iter);
+      g_sequence_remove (seq_iter);
+      seq_iter = next_seq_iter;
+    }
+
+  priv->reordering = TRUE;
+  iter = dee_model_get_first_iter (priv->orig_model);
+  while (!dee_model_is_last (priv->orig_model, iter))
+    {
+      if (g_hash_table_lookup (old_rows, iter) != NULL)
+        dee_filter_notify (priv->filter, iter, priv->orig_model, self);
+      iter = dee_model_next (priv->orig_model, iter);
+    }
+  priv->reordering = FALSE;
+
+  /* Rows the filter didn't take back go last, so we can signal their
+   * removal after the reordering */
+  filtered_order = g_new (guint, n_rows);
+  dropped = NULL;
+  reordered = FALSE;
+  seq_iter = g_sequence_get_begin_iter (priv->iter_list);
+  for (i = 0; !g_sequence_iter_is_end (seq_iter); i++)
+    {
+      iter = g_sequence_get (seq_iter);
+      filtered_order[i] = GPOINTER_TO_UINT (g_hash_table_lookup (old_rows,
+                                                                 iter)) - 1;
+      reordered |= filtered_order[i] != i;
+      g_hash_table_remove (old_rows, iter);
+      seq_iter = g_sequence_iter_next (seq_iter);
+    }
+
+  g_hash_table_iter_init (&hash_iter, old_rows);
+  while (g_hash_table_iter_next (&hash_iter, (gpointer *) &iter, &old_pos))
+    {
+      filtered_order[i] = GPOINTER_TO_UINT (old_pos) - 1;
+      reordered |= filtered_order[i] != i;
+      seq_iter = g_sequence_append (priv->iter_list, iter);
+      g_hash_table_insert (priv->iter_map, iter, seq_iter);
+      dropped = g_slist_prepend (dropped, iter);
+      i++;
+    }
+
+  if (reordered)
+    {
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "rows-reordered", filtered_order);
+    }
+
+  for (l = dropped; l != NULL; l = l->next)
+    dee_filter_model_remove_iter (self, l->data);
+
+  g_slist_free (dropped);
+  g_free (filtered_order);
+  g_hash_table_destroy (old_rows);
+}
+
 static void
 on_orig_model_changeset_started (DeeFilterModel *self,
                                  DeeModel *model)
@@ -766,6 +1382,10 @@ dee_filter_model_get_n_rows (DeeModel *self)
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), 0);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    return _dee_bitmap_get_n_set (priv->bitmap);
+
   return g_hash_table_size (priv->iter_map) - 1;
 }
 
@@ -802,8 +1422,12 @@ dee_filter_model_prepend_row (DeeModel *self,
       priv->ignore_orig_signals = FALSE;
     }
   
-  seq_iter = g_sequence_prepend (priv->iter_list, iter);
-  g_hash_table_insert (priv->iter_map, iter, seq_iter);
+  /* Compact filter models have already included the row */
+  if (priv->bitmap == NULL)
+    {
+      seq_iter = g_sequence_prepend (priv->iter_list, iter);
+      g_hash_table_insert (priv->iter_map, iter, seq_iter);
+    }
 
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-added", iter);
@@ -839,8 +1463,11 @@ dee_filter_model_append_row (DeeModel  *self,
     }
   priv->ignore_orig_signals = FALSE;
   
-  seq_iter = g_sequence_append (priv->iter_list, iter);
-  g_hash_table_insert (priv->iter_map, iter, seq_iter);
+  if (priv->bitmap == NULL)
+    {
+      seq_iter = g_sequence_append (priv->iter_list, iter);
+      g_hash_table_insert (priv->iter_map, iter, seq_iter);
+    }
 
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-added", iter);
@@ -863,19 +1490,31 @@ dee_filter_model_insert_row_before (DeeModel      *self,
   
   priv = DEE_FILTER_MODEL (self)->priv;
   
-  seq_iter = g_hash_table_lookup (priv->iter_map, iter);
-  if (seq_iter == NULL)
+  seq_iter = NULL;
+  if (priv->bitmap)
     {
-      g_critical ("DeeFilterModel can not insert before unknown iter");
-      return NULL;
+      if (dee_filter_model_compact_position (DEE_FILTER_MODEL (self), iter) < 0)
+        return NULL;
+    }
+  else
+    {
+      seq_iter = g_hash_table_lookup (priv->iter_map, iter);
+      if (seq_iter == NULL)
+        {
+          g_critical ("DeeFilterModel can not insert before unknown iter");
+          return NULL;
+        }
     }
   
   priv->ignore_orig_signals = TRUE;
   new_iter = dee_model_insert_row_before (priv->orig_model, iter, row_members);
   priv->ignore_orig_signals = FALSE;
   
-  seq_iter = g_sequence_insert_before (seq_iter, new_iter);
-  g_hash_table_insert (priv->iter_map, new_iter, seq_iter);
+  if (priv->bitmap == NULL)
+    {
+      seq_iter = g_sequence_insert_before (seq_iter, new_iter);
+      g_hash_table_insert (priv->iter_map, new_iter, seq_iter);
+    }
 
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-added", new_iter);
@@ -896,14 +1535,46 @@ _dispatch_cmp_func (DeeModelIter *iter,
                     GVariant **row_spec,
                     CmpDispatchData *data)
 {
-  gint result, i;
+  dee_model_peek_row (data->model, iter, data->row_buf);
 
-  dee_model_get_row (data->model, iter, data->row_buf);
-  result = data->cmp (data->row_buf, row_spec, data->user_data);
+  return data->cmp (data->row_buf, row_spec, data->user_data);
+}
+
+/* Compact filter models have no GSequence to search, so bisect the rows
+ * directly. Like g_sequence_search() this finds the row after the last
+ * one comparing equal to @row_spec */
+static DeeModelIter*
+dee_filter_model_compact_find_row_sorted (DeeFilterModel  *self,
+                                          GVariant       **row_spec,
+                                          CmpDispatchData *data,
+                                          gboolean        *out_was_found)
+{
+  DeeModelIter *iter;
+  guint         lo, hi, mid;
+
+  lo = 0;
+  hi = _dee_bitmap_get_n_set (self->priv->bitmap);
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      iter = dee_filter_model_compact_iter_at_row (self, mid);
+      if (_dispatch_cmp_func (iter, row_spec, data) <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
 
-  for (i = 0; i < data->n_cols; i++) g_variant_unref (data->row_buf[i]);
+  if (lo > 0)
+    {
+      iter = dee_filter_model_compact_iter_at_row (self, lo - 1);
+      if (_dispatch_cmp_func (iter, row_spec, data) == 0)
+        {
+          if (out_was_found != NULL) *out_was_found = TRUE;
+          return iter;
+        }
+    }
 
-  return result;
+  return dee_filter_model_compact_iter_at_row (self, lo);
 }
 
 static DeeModelIter*
@@ -916,7 +1587,7 @@ dee_filter_model_find_row_sorted   (DeeModel           *self,
   DeeFilterModelPrivate *priv;
   GSequenceIter         *iter;
   CmpDispatchData        data;
-  guint                  row_size, n_cols, i;
+  guint                  row_size, n_cols;
 
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   g_return_val_if_fail (row_spec != NULL, NULL);
@@ -935,6 +1606,11 @@ dee_filter_model_find_row_sorted   (DeeModel           *self,
   data.row_buf = g_alloca (row_size);
   data.model = self;
 
+  if (priv->bitmap)
+    return dee_filter_model_compact_find_row_sorted (DEE_FILTER_MODEL (self),
+                                                     row_spec, &data,
+                                                     out_was_found);
+
   iter = g_sequence_search (priv->iter_list, row_spec,
                             (GCompareDataFunc)_dispatch_cmp_func, &data);
 
@@ -945,15 +1621,13 @@ dee_filter_model_find_row_sorted   (DeeModel           *self,
     {
       GSequenceIter *jter = g_sequence_iter_prev (iter);
 
-      dee_model_get_row (self, g_sequence_get (jter), data.row_buf);
+      dee_model_peek_row (self, g_sequence_get (jter), data.row_buf);
 
       if (cmp_func (data.row_buf, row_spec, user_data) == 0)
         {
           if (out_was_found != NULL) *out_was_found = TRUE;
           iter = jter;
         }
-
-      for (i = 0; i < n_cols; i++) g_variant_unref (data.row_buf[i]);
     }
 
   if (g_sequence_iter_is_end (iter))
@@ -972,15 +1646,28 @@ dee_filter_model_remove (DeeModel     *self,
   g_return_if_fail (DEE_IS_FILTER_MODEL (self));
   
   priv = DEE_FILTER_MODEL (self)->priv;
-  seq_iter = g_hash_table_lookup (priv->iter_map, iter);
-  if (seq_iter == NULL)
+
+  if (priv->bitmap)
     {
-      g_critical ("Can not remove unknown iter from DeeFilterModel");
-      return;
+      /* The bit is dropped in on_orig_model_row_removed() */
+      if (!dee_filter_model_contains (DEE_FILTER_MODEL (self), iter))
+        {
+          g_critical ("Can not remove unknown iter from DeeFilterModel");
+          return;
+        }
+    }
+  else
+    {
+      seq_iter = g_hash_table_lookup (priv->iter_map, iter);
+      if (seq_iter == NULL)
+        {
+          g_critical ("Can not remove unknown iter from DeeFilterModel");
+          return;
+        }
+
+      g_hash_table_remove (priv->iter_map, iter);
+      g_sequence_remove (seq_iter);
     }
-  
-  g_hash_table_remove (priv->iter_map, iter);
-  g_sequence_remove (seq_iter);
   
   priv->ignore_orig_signals = TRUE;
   dee_model_remove (priv->orig_model, iter);
@@ -1025,6 +1712,9 @@ dee_filter_model_get_first_iter (DeeModel *self)
   
   if (dee_filter_model_is_empty (self))
     return dee_model_get_last_iter (priv->orig_model);
+
+  if (priv->bitmap)
+    return dee_filter_model_compact_iter_at_row (DEE_FILTER_MODEL (self), 0);
   
   seq_iter = g_sequence_get_begin_iter (priv->iter_list);
   return (DeeModelIter*) g_sequence_get (seq_iter);
@@ -1041,6 +1731,10 @@ dee_filter_model_get_iter_at_row (DeeModel *self, guint row)
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    return dee_filter_model_compact_iter_at_row (DEE_FILTER_MODEL (self), row);
+
   seq_iter = g_sequence_get_iter_at_pos (priv->iter_list, row);
   
   /* On out of bounds we return the end iter of the orig model */
@@ -1056,11 +1750,22 @@ dee_filter_model_next (DeeModel     *self,
 {
   DeeFilterModelPrivate *priv;
   GSequenceIter         *seq_iter;
+  gint                   pos;
   
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   g_return_val_if_fail (!dee_model_is_last (self, iter), NULL);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_filter_model_compact_position (DEE_FILTER_MODEL (self), iter);
+      if (pos < 0)
+        return NULL;
+
+      return dee_filter_model_compact_iter_at_row (DEE_FILTER_MODEL (self),
+                                                   _dee_bitmap_rank (priv->bitmap, pos) + 1);
+    }
   
   seq_iter = (GSequenceIter*) g_hash_table_lookup (priv->iter_map, iter);
   
@@ -1084,11 +1789,23 @@ dee_filter_model_prev (DeeModel     *self,
 {
   DeeFilterModelPrivate *priv;
   GSequenceIter         *seq_iter;
+  gint                   pos;
   
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), NULL);
   g_return_val_if_fail (!dee_model_is_first (self, iter), NULL);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_filter_model_compact_position (DEE_FILTER_MODEL (self), iter);
+      if (pos < 0)
+        return NULL;
+
+      return dee_filter_model_compact_iter_at_row (DEE_FILTER_MODEL (self),
+                                                   _dee_bitmap_rank (priv->bitmap, pos) - 1);
+    }
+
   seq_iter = (GSequenceIter*) g_hash_table_lookup (priv->iter_map, iter);
   
   if (seq_iter == NULL)
@@ -1114,6 +1831,9 @@ dee_filter_model_is_first (DeeModel *self, DeeModelIter *iter)
   
   if (dee_filter_model_is_empty (self))
     return iter == dee_model_get_last_iter (priv->orig_model);
+
+  if (priv->bitmap)
+    return iter == dee_filter_model_compact_iter_at_row (DEE_FILTER_MODEL (self), 0);
     
   seq_iter = g_sequence_get_begin_iter (priv->iter_list);
   return g_sequence_get (seq_iter) == iter;
@@ -1127,10 +1847,21 @@ dee_filter_model_get_position (DeeModel     *self,
 {
   DeeFilterModelPrivate *priv;
   GSequenceIter         *seq_iter;
+  gint                   pos;
   
   g_return_val_if_fail (DEE_IS_FILTER_MODEL (self), 0);
   
   priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (priv->bitmap)
+    {
+      pos = dee_filter_model_compact_position (DEE_FILTER_MODEL (self), iter);
+      if (pos < 0)
+        return 0;
+
+      return _dee_bitmap_rank (priv->bitmap, pos);
+    }
+
   seq_iter = (GSequenceIter*) g_hash_table_lookup (priv->iter_map, iter);
   
   if (seq_iter == NULL)
@@ -1142,3 +1873,91 @@ dee_filter_model_get_position (DeeModel     *self,
   return (guint) ABS(g_sequence_iter_get_position (seq_iter));
 }
 
+/* Gaps between included rows of a compact filter model up to this many
+ * rows are stepped over with dee_model_next(), longer ones are jumped over
+ * with dee_model_get_iter_at_row() */
+#define COMPACT_FOREACH_MAX_STEPS 16
+
+/* Walk the set bits of the bitmap, only mapping them to iters of
+ * orig_model when we get to them */
+static void
+dee_filter_model_compact_foreach (DeeFilterModel   *self,
+                                  DeeModelIter     *start,
+                                  DeeModelIter     *end,
+                                  DeeModelIterFunc  func,
+                                  gpointer          user_data)
+{
+  DeeFilterModelPrivate *priv = self->priv;
+  DeeModelIter          *iter;
+  guint                  pos, iter_pos, end_pos;
+
+  iter = start;
+  iter_pos = dee_model_get_position (priv->orig_model, start);
+  if (dee_model_is_last (priv->orig_model, end))
+    end_pos = _dee_bitmap_get_n_bits (priv->bitmap);
+  else
+    end_pos = dee_model_get_position (priv->orig_model, end);
+
+  for (pos = _dee_bitmap_next_set (priv->bitmap, iter_pos);
+       pos < end_pos;
+       pos = _dee_bitmap_next_set (priv->bitmap, pos + 1))
+    {
+      if (pos - iter_pos <= COMPACT_FOREACH_MAX_STEPS)
+        {
+          for (; iter_pos < pos; iter_pos++)
+            iter = dee_model_next (priv->orig_model, iter);
+        }
+      else
+        {
+          iter = dee_model_get_iter_at_row (priv->orig_model, pos);
+          iter_pos = pos;
+        }
+
+      if (func (DEE_MODEL (self), iter, user_data))
+        break;
+    }
+}
+
+static void
+dee_filter_model_foreach_range (DeeModel         *self,
+                                DeeModelIter     *start,
+                                DeeModelIter     *end,
+                                DeeModelIterFunc  func,
+                                gpointer          user_data)
+{
+  DeeFilterModelPrivate *priv;
+  GSequenceIter         *seq_iter, *seq_end;
+
+  g_return_if_fail (DEE_IS_FILTER_MODEL (self));
+
+  priv = DEE_FILTER_MODEL (self)->priv;
+
+  if (dee_model_is_last (priv->orig_model, start))
+    return;
+
+  if (priv->bitmap)
+    {
+      dee_filter_model_compact_foreach (DEE_FILTER_MODEL (self), start, end,
+                                        func, user_data);
+      return;
+    }
+
+  /* Only the end points are looked up in the iter map. An unknown @end,
+   * such as the end iter of the original model, walks to the end */
+  seq_iter = (GSequenceIter*) g_hash_table_lookup (priv->iter_map, start);
+  if (seq_iter == NULL)
+    {
+      g_critical ("Can not walk from unknown iter");
+      return;
+    }
+  seq_end = (GSequenceIter*) g_hash_table_lookup (priv->iter_map, end);
+
+  for (;
+       seq_iter != seq_end && !g_sequence_iter_is_end (seq_iter);
+       seq_iter = g_sequence_iter_next (seq_iter))
+    {
+      if (func (self, g_sequence_get (seq_iter), user_data))
+        break;
+    }
+}
+
@@ -94,12 +94,19 @@ GType                 dee_filter_model_get_type        (void);
 DeeModel*             dee_filter_model_new             (DeeModel  *orig_model,
                                                         DeeFilter *filter);
 
+DeeModel*             dee_filter_model_new_compact     (DeeModel  *orig_model,
+                                                        DeeFilter *filter);
+
 gboolean              dee_filter_model_contains        (DeeFilterModel *self,
                                                         DeeModelIter   *iter);
 
 DeeModelIter*         dee_filter_model_append_iter     (DeeFilterModel *self,
                                                         DeeModelIter   *iter);
 
+void                  dee_filter_model_append_iters    (DeeFilterModel  *self,
+                                                        DeeModelIter   **iters,
+                                                        guint            n_iters);
+
 DeeModelIter*         dee_filter_model_prepend_iter     (DeeFilterModel *self,
                                                          DeeModelIter   *iter);
 
@@ -114,6 +121,9 @@ DeeModelIter*         dee_filter_model_insert_iter_before (DeeFilterModel *self,
 DeeModelIter*         dee_filter_model_insert_iter_with_original_order (DeeFilterModel *self,
                                                                         DeeModelIter   *iter);
 
+void                  dee_filter_model_remove_iter     (DeeFilterModel *self,
+                                                        DeeModelIter   *iter);
+
 G_END_DECLS
 
 #endif /* _HAVE_DEE_FILTER_MODEL_H */
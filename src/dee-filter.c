@@ -56,6 +56,8 @@
 
 #include "dee-filter-model.h"
 #include "dee-filter.h"
+#include "dee-column-index.h"
+#include "dee-trigram-index.h"
 #include "trace-log.h"
 
 typedef struct {
@@ -66,10 +68,16 @@ typedef struct {
   GVariant        **row_buf;
 } SortFilter;
 
-/* The CollatorFilter stores collation keys for the columns in a DeeModelTag */
+/* The CollatorFilter keeps binary sort keys for a column in a hash table
+ * mapping the iters of the original model to their keys. Despite the name
+ * it handles numeric columns too */
 typedef struct {
   guint        column;
-  DeeModelTag *collation_key_tag;
+  gboolean     descending;
+  gchar        type;
+  DeeModel    *orig_model;
+  GHashTable  *keys;
+  gulong       on_orig_row_removed_id;
 } CollatorFilter;
 
 typedef struct {
@@ -80,13 +88,45 @@ typedef struct {
 typedef struct {
   guint        column;
   GRegex      *regex;
+  gchar      **literals;
 } RegexFilter;
 
+typedef struct {
+  guint        column;
+  gchar       *needle;
+} SubstringFilter;
+
 typedef struct {
   guint        column;
   GVariant    *value;
 } ValueFilter;
 
+typedef enum {
+  PREDICATE_KEY,
+  PREDICATE_VALUE,
+  PREDICATE_REGEX,
+  PREDICATE_ALL,
+  PREDICATE_ANY
+} PredicateType;
+
+struct _DeeFilterPredicate {
+  PredicateType  type;
+  guint          column;
+  gchar         *key;
+  GVariant      *value;
+  GRegex        *regex;
+  GPtrArray     *children;
+
+  /* Estimates for a single row, calculated when the filter is mapped */
+  gdouble        cost;
+  gdouble        selectivity;
+};
+
+typedef struct {
+  DeeFilterPredicate *predicate;
+  SortFilter         *sort;
+} PredicateFilter;
+
 /*
  * Private impl
  */
@@ -99,14 +139,15 @@ _dee_filter_sort_map_notify (DeeModel *orig_model,
 {
   DeeModelIter   *pos_iter;
   SortFilter     *filter;
-  guint           i;
   gboolean        was_found;
 
   g_return_val_if_fail (user_data != NULL, FALSE);
 
   filter = (SortFilter *) user_data;
 
-  dee_model_get_row (orig_model, orig_iter, filter->row_buf);
+  /* The row is only borrowed, so we must be done with it before
+   * inserting it emits any signals */
+  dee_model_peek_row (orig_model, orig_iter, filter->row_buf);
 
   pos_iter = dee_model_find_row_sorted (DEE_MODEL (filter_model),
                                         filter->row_buf,
@@ -116,18 +157,135 @@ _dee_filter_sort_map_notify (DeeModel *orig_model,
 
   dee_filter_model_insert_iter_before (filter_model, orig_iter, pos_iter);
 
-  for (i = 0; i < filter->n_cols; i++) g_variant_unref (filter->row_buf[i]);
-
   return was_found;
 }
 
+/* Compare the row in filter->row_buf with the row at @iter in @filter_model */
+static gint
+_dee_filter_sort_cmp_iter (SortFilter     *filter,
+                           DeeFilterModel *filter_model,
+                           DeeModelIter   *iter)
+{
+  GVariant **row_buf;
+
+  row_buf = g_alloca (sizeof (GVariant*) * filter->n_cols);
+  dee_model_peek_row (DEE_MODEL (filter_model), iter, row_buf);
+
+  return filter->cmp (filter->row_buf, row_buf, filter->user_data);
+}
+
+static gboolean
+_dee_filter_sort_map_changed (DeeModel *orig_model,
+                              DeeModelIter *orig_iter,
+                              DeeFilterModel *filter_model,
+                              gpointer user_data)
+{
+  DeeModel       *model;
+  DeeModelIter   *prev, *next, *pos_iter;
+  SortFilter     *filter;
+  gboolean        in_order;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (SortFilter *) user_data;
+  model = DEE_MODEL (filter_model);
+
+  if (!dee_filter_model_contains (filter_model, orig_iter))
+    {
+      _dee_filter_sort_map_notify (orig_model, orig_iter, filter_model, filter);
+      return TRUE;
+    }
+
+  dee_model_peek_row (orig_model, orig_iter, filter->row_buf);
+
+  /* The row is still sorted correctly if it doesn't compare less than its
+   * predecessor or greater than its successor. This is by far the most
+   * common case and needs no sequence manipulation at all */
+  in_order = TRUE;
+  if (!dee_model_is_first (model, orig_iter))
+    {
+      prev = dee_model_prev (model, orig_iter);
+      in_order = _dee_filter_sort_cmp_iter (filter, filter_model, prev) >= 0;
+    }
+  next = dee_model_next (model, orig_iter);
+  if (in_order && !dee_model_is_last (model, next))
+    {
+      in_order = _dee_filter_sort_cmp_iter (filter, filter_model, next) <= 0;
+    }
+
+  if (!in_order)
+    {
+      /* Take the row out before searching for its new position, the binary
+       * search can't cope with a row that is out of order */
+      dee_filter_model_remove_iter (filter_model, orig_iter);
+      pos_iter = dee_model_find_row_sorted (model,
+                                            filter->row_buf,
+                                            filter->cmp,
+                                            filter->user_data,
+                                            NULL);
+      dee_filter_model_insert_iter_before (filter_model, orig_iter, pos_iter);
+    }
+
+  return TRUE;
+}
+
+/* A row collected while mapping a filter. The position in the original
+ * model is only set when the rows are not collected in order */
+typedef struct {
+  guint          pos;
+  DeeModelIter  *iter;
+  GVariant     **row;
+} MatchedRow;
+
+static gint
+_cmp_matched_row_pos (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  guint pos1 = ((const MatchedRow *) a)->pos;
+  guint pos2 = ((const MatchedRow *) b)->pos;
+
+  return pos1 < pos2 ? -1 : (pos1 > pos2 ? 1 : 0);
+}
+
+static gint
+_cmp_matched_row_sorted (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  SortFilter *sort = (SortFilter *) user_data;
+
+  return sort->cmp (((const MatchedRow *) a)->row,
+                    ((const MatchedRow *) b)->row,
+                    sort->user_data);
+}
+
+typedef struct {
+  MatchedRow *rows;
+  guint       n_rows;
+} CollectData;
+
+static gboolean
+_dee_filter_collect_row (DeeModel     *orig_model,
+                         DeeModelIter *iter,
+                         gpointer      user_data)
+{
+  CollectData *collect = (CollectData *) user_data;
+  MatchedRow  *m = &collect->rows[collect->n_rows];
+
+  m->iter = iter;
+  m->pos = collect->n_rows++;
+  m->row = dee_model_peek_row (orig_model, iter, NULL);
+
+  return FALSE;
+}
+
 static void
 _dee_filter_sort_map_func (DeeModel *orig_model,
                            DeeFilterModel *filter_model,
                            gpointer user_data)
 {
-  DeeModelIter   *iter, *end;
+  DeeModelIter  **iters;
   SortFilter     *filter;
+  MatchedRow     *rows;
+  CollectData     collect;
+  guint           i, n_rows;
 
   g_return_if_fail (user_data != NULL);
 
@@ -135,31 +293,586 @@ _dee_filter_sort_map_func (DeeModel *orig_model,
   filter->n_cols = dee_model_get_n_columns (orig_model);
   filter->row_buf = g_new0(GVariant*, filter->n_cols);
 
+  /* Sorting all rows at once is much cheaper than a binary search and
+   * insertion into the filter model for each row. g_qsort_with_data() is
+   * stable so rows that compare equal keep the order of the original model */
+  n_rows = dee_model_get_n_rows (orig_model);
+  rows = g_new (MatchedRow, n_rows);
+
+  collect.rows = rows;
+  collect.n_rows = 0;
+  dee_model_foreach_range (orig_model, NULL, NULL,
+                           _dee_filter_collect_row, &collect);
+
+  g_qsort_with_data (rows, n_rows, sizeof (MatchedRow),
+                     _cmp_matched_row_sorted, filter);
+
+  iters = g_new (DeeModelIter*, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      iters[i] = rows[i].iter;
+      g_free (rows[i].row);
+    }
+
+  dee_filter_model_append_iters (filter_model, iters, n_rows);
+
+  g_free (iters);
+  g_free (rows);
+}
+
+/*
+ * Column sort filters
+ */
+
+/* A binary sort key. The key bytes follow the struct in memory and two keys
+ * are ordered like their bytes compared with memcmp() */
+typedef struct {
+  gsize len;
+} SortKey;
+
+#define SORT_KEY_DATA(key) ((guchar *) ((key) + 1))
+
+static SortKey*
+_sort_key_new (gsize len)
+{
+  SortKey *key;
+
+  key = g_malloc (sizeof (SortKey) + len);
+  key->len = len;
+
+  return key;
+}
+
+/* Store the len lowest bytes of val big endian, so memcmp() orders
+ * them numerically */
+static SortKey*
+_sort_key_new_for_uint (guint64 val, gsize len)
+{
+  SortKey *key;
+  guchar  *data;
+  gsize    i;
+
+  key = _sort_key_new (len);
+  data = SORT_KEY_DATA (key);
+  for (i = 0; i < len; i++)
+    data[i] = (val >> (8 * (len - i - 1))) & 0xff;
+
+  return key;
+}
+
+/* Flipping the sign bit of a two's complement integer makes it order
+ * like an unsigned one */
+static SortKey*
+_sort_key_new_for_int (gint64 val, gsize len)
+{
+  return _sort_key_new_for_uint (((guint64) val) ^
+                                 (G_GUINT64_CONSTANT (1) << (8 * len - 1)),
+                                 len);
+}
+
+static SortKey*
+_sort_key_new_for_double (gdouble val)
+{
+  union { gdouble d; guint64 u; } bits;
+
+  /* Positive doubles order like their bit patterns once the sign bit is
+   * set. Negative doubles order in reverse, so flip all their bits */
+  bits.d = val;
+  if (bits.u & (G_GUINT64_CONSTANT (1) << 63))
+    bits.u = ~bits.u;
+  else
+    bits.u |= G_GUINT64_CONSTANT (1) << 63;
+
+  return _sort_key_new_for_uint (bits.u, 8);
+}
+
+static SortKey*
+_sort_key_new_for_string (const gchar *str)
+{
+  SortKey *key;
+  gchar   *collate_key;
+  gsize    len;
+
+  /* Comparing collation keys with strcmp() orders them like comparing the
+   * strings with g_utf8_collate(). Leaving out the terminating nul and
+   * ordering shorter keys first when one is a prefix of the other makes
+   * memcmp() do the same */
+  collate_key = g_utf8_collate_key (str, -1);
+  len = strlen (collate_key);
+  key = _sort_key_new (len);
+  memcpy (SORT_KEY_DATA (key), collate_key, len);
+  g_free (collate_key);
+
+  return key;
+}
+
+static gint
+_sort_key_cmp (const SortKey *key1, const SortKey *key2)
+{
+  gint result;
+
+  result = memcmp (SORT_KEY_DATA (key1), SORT_KEY_DATA (key2),
+                   MIN (key1->len, key2->len));
+  if (result != 0)
+    return result;
+
+  return key1->len < key2->len ? -1 : (key1->len > key2->len ? 1 : 0);
+}
+
+static SortKey*
+_dee_filter_column_sort_build_key (CollatorFilter *filter,
+                                   DeeModel       *orig_model,
+                                   DeeModelIter   *orig_iter)
+{
+  GVariant *val;
+  SortKey  *key;
+
+  val = dee_model_peek_value (orig_model, orig_iter, filter->column);
+
+  switch (filter->type)
+    {
+      case 's':
+        key = _sort_key_new_for_string (g_variant_get_string (val, NULL));
+        break;
+      case 'b':
+        key = _sort_key_new_for_uint (g_variant_get_boolean (val) ? 1 : 0, 1);
+        break;
+      case 'y':
+        key = _sort_key_new_for_uint (g_variant_get_byte (val), 1);
+        break;
+      case 'n':
+        key = _sort_key_new_for_int (g_variant_get_int16 (val), 2);
+        break;
+      case 'q':
+        key = _sort_key_new_for_uint (g_variant_get_uint16 (val), 2);
+        break;
+      case 'i':
+        key = _sort_key_new_for_int (g_variant_get_int32 (val), 4);
+        break;
+      case 'u':
+        key = _sort_key_new_for_uint (g_variant_get_uint32 (val), 4);
+        break;
+      case 'x':
+        key = _sort_key_new_for_int (g_variant_get_int64 (val), 8);
+        break;
+      case 't':
+        key = _sort_key_new_for_uint (g_variant_get_uint64 (val), 8);
+        break;
+      case 'd':
+        key = _sort_key_new_for_double (g_variant_get_double (val));
+        break;
+      default:
+        /* Unsupported types all compare equal, leaving the rows in the
+         * order of the original model. We complained in the map func */
+        key = _sort_key_new (0);
+        break;
+    }
+
+  return key;
+}
+
+static gint
+_dee_filter_column_sort_cmp (CollatorFilter *filter,
+                             const SortKey  *key1,
+                             const SortKey  *key2)
+{
+  return filter->descending ? - _sort_key_cmp (key1, key2) :
+                              _sort_key_cmp (key1, key2);
+}
+
+/* Find the position in filter_model after all rows that sort before or
+ * equal to key. Rows with equal keys thus stay in the order they were
+ * added in */
+static DeeModelIter*
+_dee_filter_column_sort_find (CollatorFilter *filter,
+                              DeeFilterModel *filter_model,
+                              const SortKey  *key)
+{
+  DeeModel      *model;
+  DeeModelIter  *iter;
+  const SortKey *other;
+  guint          lo, hi, mid;
+
+  model = DEE_MODEL (filter_model);
+  lo = 0;
+  hi = dee_model_get_n_rows (model);
+
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      iter = dee_model_get_iter_at_row (model, mid);
+      other = g_hash_table_lookup (filter->keys, iter);
+
+      if (_dee_filter_column_sort_cmp (filter, other, key) <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return dee_model_get_iter_at_row (model, lo);
+}
+
+static gint
+_cmp_sort_key_ptr (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  return _dee_filter_column_sort_cmp ((CollatorFilter *) user_data,
+                                      ((SortKey * const *) a)[1],
+                                      ((SortKey * const *) b)[1]);
+}
+
+static void
+_dee_filter_column_sort_on_row_removed (DeeModel     *orig_model,
+                                        DeeModelIter *orig_iter,
+                                        gpointer      user_data)
+{
+  CollatorFilter *filter = (CollatorFilter *) user_data;
+
+  g_hash_table_remove (filter->keys, orig_iter);
+}
+
+static void
+_dee_filter_column_sort_map_func (DeeModel *orig_model,
+                                  DeeFilterModel *filter_model,
+                                  gpointer user_data)
+{
+  CollatorFilter *filter;
+  DeeModelIter   *iter, *end;
+  gpointer       *rows;
+  const gchar    *schema;
+  guint           i, n_rows;
+
+  g_return_if_fail (user_data != NULL);
+
+  filter = (CollatorFilter *) user_data;
+  filter->orig_model = orig_model;
+  filter->on_orig_row_removed_id =
+    g_signal_connect (orig_model, "row-removed",
+                      G_CALLBACK (_dee_filter_column_sort_on_row_removed),
+                      filter);
+
+  schema = dee_model_get_column_schema (orig_model, filter->column);
+  filter->type = schema[0];
+  if (strlen (schema) != 1 || strchr ("sbynqiuxtd", filter->type) == NULL)
+    {
+      g_critical ("Can not sort on column %u with schema '%s'",
+                  filter->column, schema);
+    }
+
+  /* Build all the keys up front and sort them in one go. The rows array
+   * holds pairs of (iter, key). The sort is stable so rows with equal
+   * keys keep the order of the original model */
+  n_rows = dee_model_get_n_rows (orig_model);
+  rows = g_new (gpointer, 2 * n_rows);
+
+  i = 0;
   iter = dee_model_get_first_iter (orig_model);
   end = dee_model_get_last_iter (orig_model);
   while (iter != end)
     {
-      _dee_filter_sort_map_notify (orig_model, iter, filter_model, filter);
+      rows[2*i] = iter;
+      rows[2*i + 1] = _dee_filter_column_sort_build_key (filter,
+                                                         orig_model, iter);
+      g_hash_table_insert (filter->keys, iter, rows[2*i + 1]);
       iter = dee_model_next (orig_model, iter);
+      i++;
     }
+
+  g_qsort_with_data (rows, n_rows, 2 * sizeof (gpointer),
+                     _cmp_sort_key_ptr, filter);
+
+  /* Compact the sorted iters to the front of the array */
+  for (i = 0; i < n_rows; i++)
+    rows[i] = rows[2*i];
+
+  dee_filter_model_append_iters (filter_model, (DeeModelIter **) rows, n_rows);
+
+  g_free (rows);
 }
 
-static gint
-_cmp_collate_asc (GVariant **row1, GVariant **row2, gpointer user_data)
+static gboolean
+_dee_filter_column_sort_map_notify (DeeModel *orig_model,
+                                    DeeModelIter *orig_iter,
+                                    DeeFilterModel *filter_model,
+                                    gpointer user_data)
 {
-  guint col = GPOINTER_TO_UINT (user_data);
+  CollatorFilter *filter;
+  SortKey        *key;
+  DeeModelIter   *pos_iter;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
 
-  return g_utf8_collate (g_variant_get_string (row1[col], NULL),
-                         g_variant_get_string (row2[col], NULL));
+  filter = (CollatorFilter *) user_data;
+
+  key = _dee_filter_column_sort_build_key (filter, orig_model, orig_iter);
+  g_hash_table_insert (filter->keys, orig_iter, key);
+
+  pos_iter = _dee_filter_column_sort_find (filter, filter_model, key);
+  dee_filter_model_insert_iter_before (filter_model, orig_iter, pos_iter);
+
+  return TRUE;
+}
+
+static gboolean
+_dee_filter_column_sort_map_changed (DeeModel *orig_model,
+                                     DeeModelIter *orig_iter,
+                                     DeeFilterModel *filter_model,
+                                     gpointer user_data)
+{
+  CollatorFilter *filter;
+  DeeModel       *model;
+  DeeModelIter   *prev, *next, *pos_iter;
+  SortKey        *key, *old_key, *other;
+  gboolean        in_order;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (CollatorFilter *) user_data;
+  model = DEE_MODEL (filter_model);
+
+  if (!dee_filter_model_contains (filter_model, orig_iter))
+    return _dee_filter_column_sort_map_notify (orig_model, orig_iter,
+                                               filter_model, filter);
+
+  /* Most changes don't touch the sort column */
+  key = _dee_filter_column_sort_build_key (filter, orig_model, orig_iter);
+  old_key = g_hash_table_lookup (filter->keys, orig_iter);
+  if (old_key != NULL && _sort_key_cmp (key, old_key) == 0)
+    {
+      g_free (key);
+      return TRUE;
+    }
+
+  g_hash_table_insert (filter->keys, orig_iter, key);
+
+  in_order = TRUE;
+  if (!dee_model_is_first (model, orig_iter))
+    {
+      prev = dee_model_prev (model, orig_iter);
+      other = g_hash_table_lookup (filter->keys, prev);
+      in_order = _dee_filter_column_sort_cmp (filter, other, key) <= 0;
+    }
+  next = dee_model_next (model, orig_iter);
+  if (in_order && !dee_model_is_last (model, next))
+    {
+      other = g_hash_table_lookup (filter->keys, next);
+      in_order = _dee_filter_column_sort_cmp (filter, key, other) <= 0;
+    }
+
+  if (!in_order)
+    {
+      dee_filter_model_remove_iter (filter_model, orig_iter);
+      pos_iter = _dee_filter_column_sort_find (filter, filter_model, key);
+      dee_filter_model_insert_iter_before (filter_model, orig_iter, pos_iter);
+    }
+
+  return TRUE;
 }
 
+/* Shared map_changed logic for the filters that keep the ordering of the
+ * original model. Since a change never moves a row in the original model
+ * such rows can only enter or leave the filter model, never move */
+static gboolean
+_dee_filter_update_membership (DeeModelIter   *orig_iter,
+                               DeeFilterModel *filter_model,
+                               gboolean        matches)
+{
+  gboolean contained;
+
+  contained = dee_filter_model_contains (filter_model, orig_iter);
+
+  if (matches && !contained)
+    dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  else if (!matches && contained)
+    dee_filter_model_remove_iter (filter_model, orig_iter);
+
+  return matches;
+}
+
+/* A row matched through a DeeColumnIndex, along with its offset in the
+ * original model so we can restore the original ordering */
+typedef struct {
+  guint         pos;
+  DeeModelIter *iter;
+} IndexedRow;
+
 static gint
-_cmp_collate_desc (GVariant **row1, GVariant **row2, gpointer user_data)
+_cmp_indexed_row (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  guint pos1 = ((const IndexedRow *) a)->pos;
+  guint pos2 = ((const IndexedRow *) b)->pos;
+
+  return pos1 < pos2 ? -1 : (pos1 > pos2 ? 1 : 0);
+}
+
+/* Used to verify the candidate rows returned from an index */
+typedef gboolean (*RowMatchFunc) (DeeModel     *orig_model,
+                                  DeeModelIter *orig_iter,
+                                  gpointer      user_data);
+
+/* Append the rows in results for which match returns TRUE to filter_model,
+ * in the order of orig_model. If match is NULL all rows are appended */
+static void
+_dee_filter_append_results (DeeModel       *orig_model,
+                            DeeFilterModel *filter_model,
+                            DeeResultSet   *results,
+                            RowMatchFunc    match,
+                            gpointer        match_data)
+{
+  IndexedRow     *rows;
+  DeeModelIter   *iter, **iters;
+  guint           i, n_rows;
+
+  rows = g_new (IndexedRow, dee_result_set_get_n_rows (results));
+  n_rows = 0;
+
+  while (dee_result_set_has_next (results))
+    {
+      iter = dee_result_set_next (results);
+      if (match != NULL && !match (orig_model, iter, match_data))
+        continue;
+
+      rows[n_rows].iter = iter;
+      rows[n_rows].pos = dee_model_get_position (orig_model, iter);
+      n_rows++;
+    }
+
+  g_qsort_with_data (rows, n_rows, sizeof (IndexedRow),
+                     _cmp_indexed_row, NULL);
+
+  iters = g_new (DeeModelIter*, n_rows);
+  for (i = 0; i < n_rows; i++)
+    iters[i] = rows[i].iter;
+
+  dee_filter_model_append_iters (filter_model, iters, n_rows);
+
+  g_free (iters);
+  g_free (rows);
+}
+
+/* If there is a DeeColumnIndex for the column in orig_model, append all rows
+ * matching value to filter_model in the order of orig_model and return TRUE.
+ * This only costs in the order of the number of matches. If there is no
+ * index we return FALSE and the caller must do a full scan instead */
+static gboolean
+_dee_filter_map_from_index (DeeModel       *orig_model,
+                            DeeFilterModel *filter_model,
+                            guint           column,
+                            GVariant       *value)
+{
+  DeeColumnIndex *index;
+  DeeResultSet   *results;
+
+  index = dee_column_index_find (orig_model, column);
+  if (index == NULL)
+    return FALSE;
+
+  results = dee_column_index_lookup (index, value);
+  _dee_filter_append_results (orig_model, filter_model, results, NULL, NULL);
+  g_object_unref (results);
+
+  return TRUE;
+}
+
+/* Like _dee_filter_map_from_index(), but using a DeeTrigramIndex to find
+ * the rows containing texts. The candidates are verified with match */
+static gboolean
+_dee_filter_map_from_trigrams (DeeModel       *orig_model,
+                               DeeFilterModel *filter_model,
+                               guint           column,
+                               const gchar   **texts,
+                               RowMatchFunc    match,
+                               gpointer        match_data)
+{
+  DeeTrigramIndex *index;
+  DeeResultSet    *results;
+
+  if (texts == NULL)
+    return FALSE;
+
+  index = dee_trigram_index_find (orig_model, column);
+  if (index == NULL)
+    return FALSE;
+
+  /* Texts too short to contain any trigrams */
+  results = dee_trigram_index_lookup_strv (index, texts);
+  if (results == NULL)
+    return FALSE;
+
+  _dee_filter_append_results (orig_model, filter_model, results,
+                              match, match_data);
+  g_object_unref (results);
+
+  return TRUE;
+}
+
+typedef struct {
+  RowMatchFunc  match;
+  gpointer      match_data;
+  GPtrArray    *matches;
+} ScanData;
+
+static gboolean
+_dee_filter_scan_chunk (DeeModel      *orig_model,
+                        DeeModelIter **iters,
+                        guint          n_iters,
+                        gpointer       user_data)
 {
-  guint col = GPOINTER_TO_UINT (user_data);
+  ScanData *scan = (ScanData *) user_data;
+  guint     i;
 
-  return  - g_utf8_collate (g_variant_get_string (row1[col], NULL),
-                            g_variant_get_string (row2[col], NULL));
+  for (i = 0; i < n_iters; i++)
+    {
+      if (scan->match (orig_model, iters[i], scan->match_data))
+        g_ptr_array_add (scan->matches, iters[i]);
+    }
+
+  return FALSE;
+}
+
+/* Return all rows of orig_model for which match returns TRUE, in the order
+ * of orig_model. This is the full scan we fall back to without an index.
+ * Free the returned array with g_ptr_array_free() */
+static GPtrArray*
+_dee_filter_scan (DeeModel     *orig_model,
+                  RowMatchFunc  match,
+                  gpointer      match_data)
+{
+  ScanData scan;
+
+  scan.match = match;
+  scan.match_data = match_data;
+  scan.matches = g_ptr_array_new ();
+  dee_model_foreach_range_chunked (orig_model, NULL, NULL,
+                                   _dee_filter_scan_chunk, &scan);
+
+  return scan.matches;
+}
+
+/* Append all rows of orig_model for which match returns TRUE to
+ * filter_model, in the order of orig_model */
+static void
+_dee_filter_map_matching (DeeModel       *orig_model,
+                          DeeFilterModel *filter_model,
+                          RowMatchFunc    match,
+                          gpointer        match_data)
+{
+  GPtrArray *matches;
+
+  matches = _dee_filter_scan (orig_model, match, match_data);
+  dee_filter_model_append_iters (filter_model,
+                                 (DeeModelIter **) matches->pdata,
+                                 matches->len);
+  g_ptr_array_free (matches, TRUE);
+}
+
+static gboolean
+_dee_filter_key_match_row (DeeModel     *orig_model,
+                           DeeModelIter *orig_iter,
+                           KeyFilter    *filter)
+{
+  return g_strcmp0 (filter->key,
+                    dee_model_get_string (orig_model, orig_iter,
+                                          filter->column)) == 0;
 }
 
 static void
@@ -167,28 +880,24 @@ _dee_filter_key_map_func (DeeModel *orig_model,
                           DeeFilterModel *filter_model,
                           gpointer user_data)
 {
-  DeeModelIter   *iter, *end;
   KeyFilter      *filter;
-  guint           column;
-  const gchar    *key, *val;
+  GVariant       *key;
+  gboolean        indexed;
 
   g_return_if_fail (user_data != NULL);
 
   filter = (KeyFilter *) user_data;
-  key = filter->key;
-  column = filter->column;
 
-  iter = dee_model_get_first_iter (orig_model);
-  end = dee_model_get_last_iter (orig_model);
-  while (iter != end)
-    {
-      val = dee_model_get_string (orig_model, iter, column);
-      if (g_strcmp0 (key, val) == 0)
-        {
-          dee_filter_model_append_iter (filter_model, iter);
-        }
-      iter = dee_model_next (orig_model, iter);
-    }
+  key = g_variant_ref_sink (g_variant_new_string (filter->key));
+  indexed = _dee_filter_map_from_index (orig_model, filter_model,
+                                        filter->column, key);
+  g_variant_unref (key);
+
+  if (indexed)
+    return;
+
+  _dee_filter_map_matching (orig_model, filter_model,
+                            (RowMatchFunc) _dee_filter_key_match_row, filter);
 }
 
 static gboolean
@@ -205,114 +914,860 @@ _dee_filter_key_map_notify (DeeModel *orig_model,
   filter = (KeyFilter *) user_data;
   val = dee_model_get_string (orig_model, orig_iter, filter->column);
 
-  /* Ignore rows that don't match the key */
-  if (g_strcmp0 (filter->key, val) != 0)
-    return FALSE;
+  /* Ignore rows that don't match the key */
+  if (g_strcmp0 (filter->key, val) != 0)
+    return FALSE;
+
+  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  return TRUE;
+}
+
+static gboolean
+_dee_filter_key_map_changed (DeeModel *orig_model,
+                             DeeModelIter *orig_iter,
+                             DeeFilterModel *filter_model,
+                             gpointer user_data)
+{
+  KeyFilter      *filter;
+  const gchar    *val;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (KeyFilter *) user_data;
+  val = dee_model_get_string (orig_model, orig_iter, filter->column);
+
+  return _dee_filter_update_membership (orig_iter, filter_model,
+                                        g_strcmp0 (filter->key, val) == 0);
+}
+
+static gboolean
+_dee_filter_value_match_row (DeeModel     *orig_model,
+                             DeeModelIter *orig_iter,
+                             ValueFilter  *filter)
+{
+  return g_variant_equal (filter->value,
+                          dee_model_peek_value (orig_model, orig_iter,
+                                                filter->column));
+}
+
+static void
+_dee_filter_value_map_func (DeeModel *orig_model,
+                            DeeFilterModel *filter_model,
+                            gpointer user_data)
+{
+  ValueFilter    *filter;
+
+  g_return_if_fail (user_data != NULL);
+
+  filter = (ValueFilter *) user_data;
+
+  if (_dee_filter_map_from_index (orig_model, filter_model,
+                                  filter->column, filter->value))
+    return;
+
+  _dee_filter_map_matching (orig_model, filter_model,
+                            (RowMatchFunc) _dee_filter_value_match_row,
+                            filter);
+}
+
+static gboolean
+_dee_filter_value_map_notify (DeeModel *orig_model,
+                              DeeModelIter *orig_iter,
+                              DeeFilterModel *filter_model,
+                              gpointer user_data)
+{
+  ValueFilter    *filter;
+  GVariant       *val;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (ValueFilter *) user_data;
+  val = dee_model_peek_value (orig_model, orig_iter, filter->column);
+
+  /* Ignore rows that don't match the value */
+  if (!g_variant_equal (filter->value, val))
+    return FALSE;
+
+  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  return TRUE;
+}
+
+static gboolean
+_dee_filter_value_map_changed (DeeModel *orig_model,
+                               DeeModelIter *orig_iter,
+                               DeeFilterModel *filter_model,
+                               gpointer user_data)
+{
+  ValueFilter    *filter;
+  GVariant       *val;
+  gboolean        matches;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (ValueFilter *) user_data;
+  val = dee_model_peek_value (orig_model, orig_iter, filter->column);
+  matches = g_variant_equal (filter->value, val);
+
+  return _dee_filter_update_membership (orig_iter, filter_model, matches);
+}
+
+/* Move the current run of literal characters to literals if it is long
+ * enough to contain a trigram */
+static void
+_flush_literal (GString *run, GPtrArray *literals)
+{
+  if (g_utf8_strlen (run->str, -1) >= 3)
+    g_ptr_array_add (literals, g_strdup (run->str));
+
+  g_string_truncate (run, 0);
+}
+
+/* Skip to the closing delimiter of an escape operand like the one in
+ * \x{263a}. Returns the end of the pattern if it isn't closed */
+static const gchar*
+_skip_regex_delimited (const gchar *p, gchar close)
+{
+  while (*p != '\0' && *p != close)
+    p++;
+
+  return *p == close ? p + 1 : p;
+}
+
+/* Return a pointer just past the escape sequence starting at p, which
+ * must point at a backslash followed by a non-nul character */
+static const gchar*
+_skip_regex_escape (const gchar *p)
+{
+  gchar c = p[1];
+
+  p += 2;
+  switch (c)
+    {
+      case 'x':
+        if (*p == '{')
+          return _skip_regex_delimited (p + 1, '}');
+        if (g_ascii_isxdigit (*p))
+          p++;
+        if (g_ascii_isxdigit (*p))
+          p++;
+        return p;
+      case 'p':
+      case 'P':
+        if (*p == '{')
+          return _skip_regex_delimited (p + 1, '}');
+        return *p != '\0' ? g_utf8_next_char (p) : p;
+      case 'N':
+      case 'o':
+        if (*p == '{')
+          return _skip_regex_delimited (p + 1, '}');
+        return p;
+      case 'c':
+        return *p != '\0' ? g_utf8_next_char (p) : p;
+      case 'g':
+      case 'k':
+        if (*p == '{')
+          return _skip_regex_delimited (p + 1, '}');
+        if (*p == '<')
+          return _skip_regex_delimited (p + 1, '>');
+        if (*p == '\'')
+          return _skip_regex_delimited (p + 1, '\'');
+        if (*p == '-' || *p == '+')
+          p++;
+        while (g_ascii_isdigit (*p))
+          p++;
+        return p;
+      case 'Q':
+        /* Quoted text runs until \E or the end of the pattern */
+        while (*p != '\0' && !(p[0] == '\\' && p[1] == 'E'))
+          p++;
+        return *p != '\0' ? p + 2 : p;
+      default:
+        /* Octal escapes and back references */
+        if (g_ascii_isdigit (c))
+          {
+            while (g_ascii_isdigit (*p))
+              p++;
+            return p;
+          }
+        /* p - 1 is the escaped character, which may be multibyte */
+        return g_utf8_next_char (p - 1);
+    }
+}
+
+/* Extract literal strings any match of a regular expression must contain.
+ * This is conservative; we give up on alternations at the top level and
+ * ignore everything inside groups and character classes. Literals shorter
+ * than three characters are dropped since they can't be looked up in a
+ * DeeTrigramIndex. Returns a NULL terminated array or NULL if no usable
+ * literals were found. Free with g_strfreev() */
+static gchar**
+_dee_filter_regex_literals (const gchar *pattern)
+{
+  GPtrArray   *literals;
+  GString     *run;
+  const gchar *p, *q, *next;
+  gsize        last_len;
+  guint        depth;
+
+  literals = g_ptr_array_new ();
+  run = g_string_new ("");
+  last_len = 0;
+  depth = 0;
+  p = pattern;
+
+  while (*p != '\0')
+    {
+      /* Skip escapes and character classes inside groups too, so their
+       * parentheses don't throw off the nesting depth */
+      if (*p == '\\')
+        {
+          if (p[1] == '\0')
+            break;
+
+          if (depth == 0 && !g_ascii_isalnum (p[1]) && (guchar) p[1] < 0x80)
+            {
+              /* An escaped metacharacter is a literal */
+              g_string_append_c (run, p[1]);
+              last_len = 1;
+            }
+          else
+            {
+              /* \d, \b, \1 and friends. Their operands must not be read
+               * as literal text, so skip to the end of the escape */
+              if (depth == 0)
+                _flush_literal (run, literals);
+              p = _skip_regex_escape (p);
+              continue;
+            }
+
+          p = g_utf8_next_char (p + 1);
+          continue;
+        }
+      else if (*p == '[')
+        {
+          if (depth == 0)
+            _flush_literal (run, literals);
+
+          p++;
+          if (*p == '^')
+            p++;
+          if (*p == ']')
+            p++;
+          while (*p != '\0' && *p != ']')
+            p += (*p == '\\' && p[1] != '\0') ? 2 : 1;
+          if (*p == ']')
+            p++;
+          continue;
+        }
+      else if (*p == '(')
+        {
+          /* Inline options may turn on extended syntax which would make
+           * whitespace and comments in the pattern insignificant */
+          if (p[1] == '?')
+            {
+              for (q = p + 2; g_ascii_isalpha (*q) || *q == '-'; q++)
+                {
+                  if (*q == 'x')
+                    goto no_literals;
+                }
+            }
+
+          if (depth == 0)
+            _flush_literal (run, literals);
+          depth++;
+          p++;
+          continue;
+        }
+      else if (*p == ')')
+        {
+          if (depth == 0)
+            goto no_literals;
+          depth--;
+          p++;
+          continue;
+        }
+      else if (depth > 0)
+        {
+          p++;
+          continue;
+        }
+
+      switch (*p)
+        {
+          case '|':
+            goto no_literals;
+          case '*':
+          case '?':
+            /* The previous character is optional */
+            g_string_truncate (run, run->len - MIN (last_len, run->len));
+            _flush_literal (run, literals);
+            p++;
+            break;
+          case '+':
+            /* The previous character is required, but may repeat */
+            _flush_literal (run, literals);
+            p++;
+            break;
+          case '{':
+            /* Only a quantifier if it looks like {n}, {n,} or {n,m} */
+            for (q = p + 1; g_ascii_isdigit (*q); q++);
+            if (q > p + 1 && *q == ',')
+              for (q++; g_ascii_isdigit (*q); q++);
+            if (q > p + 1 && *q == '}')
+              {
+                if (g_ascii_strtoull (p + 1, NULL, 10) == 0)
+                  g_string_truncate (run, run->len - MIN (last_len, run->len));
+                _flush_literal (run, literals);
+                p = q + 1;
+                break;
+              }
+            g_string_append_c (run, '{');
+            last_len = 1;
+            p++;
+            break;
+          case '.':
+          case '^':
+          case '$':
+            _flush_literal (run, literals);
+            p++;
+            break;
+          default:
+            next = g_utf8_next_char (p);
+            g_string_append_len (run, p, next - p);
+            last_len = next - p;
+            p = next;
+            break;
+        }
+    }
+
+  _flush_literal (run, literals);
+  g_string_free (run, TRUE);
+
+  if (literals->len == 0)
+    {
+      g_ptr_array_free (literals, TRUE);
+      return NULL;
+    }
+
+  g_ptr_array_add (literals, NULL);
+  return (gchar **) g_ptr_array_free (literals, FALSE);
+
+ no_literals:
+  g_string_free (run, TRUE);
+  g_ptr_array_foreach (literals, (GFunc) g_free, NULL);
+  g_ptr_array_free (literals, TRUE);
+  return NULL;
+}
+
+static gboolean
+_dee_filter_regex_match_row (DeeModel     *orig_model,
+                             DeeModelIter *orig_iter,
+                             RegexFilter  *filter)
+{
+  return g_regex_match (filter->regex,
+                        dee_model_get_string (orig_model, orig_iter,
+                                              filter->column),
+                        0, NULL);
+}
+
+static void
+_dee_filter_regex_map_func (DeeModel *orig_model,
+                            DeeFilterModel *filter_model,
+                            gpointer user_data)
+{
+  RegexFilter    *filter;
+
+  g_return_if_fail (user_data != NULL);
+
+  filter = (RegexFilter *) user_data;
+
+  /* With a trigram index we only need to run the regex on the rows
+   * containing the literal parts of the pattern */
+  if (_dee_filter_map_from_trigrams (orig_model, filter_model, filter->column,
+                                     (const gchar **) filter->literals,
+                                     (RowMatchFunc) _dee_filter_regex_match_row,
+                                     filter))
+    return;
+
+  _dee_filter_map_matching (orig_model, filter_model,
+                            (RowMatchFunc) _dee_filter_regex_match_row,
+                            filter);
+}
+
+static gboolean
+_dee_filter_regex_map_notify (DeeModel *orig_model,
+                              DeeModelIter *orig_iter,
+                              DeeFilterModel *filter_model,
+                              gpointer user_data)
+{
+  RegexFilter    *filter;
+  const gchar    *val;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (RegexFilter *) user_data;
+  val = dee_model_get_string (orig_model, orig_iter, filter->column);
+
+  /* Ignore rows that don't match the key */
+  if (!g_regex_match (filter->regex, val, 0, NULL))
+    return FALSE;
+
+  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  return TRUE;
+}
+
+static gboolean
+_dee_filter_regex_map_changed (DeeModel *orig_model,
+                               DeeModelIter *orig_iter,
+                               DeeFilterModel *filter_model,
+                               gpointer user_data)
+{
+  RegexFilter    *filter;
+  const gchar    *val;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (RegexFilter *) user_data;
+  val = dee_model_get_string (orig_model, orig_iter, filter->column);
+
+  return _dee_filter_update_membership (orig_iter, filter_model,
+                                        g_regex_match (filter->regex, val,
+                                                       0, NULL));
+}
+
+static gboolean
+_dee_filter_substring_match_row (DeeModel        *orig_model,
+                                 DeeModelIter    *orig_iter,
+                                 SubstringFilter *filter)
+{
+  gchar    *folded;
+  gboolean  result;
+
+  folded = g_utf8_casefold (dee_model_get_string (orig_model, orig_iter,
+                                                  filter->column), -1);
+  result = strstr (folded, filter->needle) != NULL;
+  g_free (folded);
+
+  return result;
+}
+
+static void
+_dee_filter_substring_map_func (DeeModel *orig_model,
+                                DeeFilterModel *filter_model,
+                                gpointer user_data)
+{
+  SubstringFilter *filter;
+  const gchar     *texts[2];
+
+  g_return_if_fail (user_data != NULL);
+
+  filter = (SubstringFilter *) user_data;
+  texts[0] = filter->needle;
+  texts[1] = NULL;
+
+  if (_dee_filter_map_from_trigrams (orig_model, filter_model,
+                                     filter->column, texts,
+                                     (RowMatchFunc) _dee_filter_substring_match_row,
+                                     filter))
+    return;
+
+  _dee_filter_map_matching (orig_model, filter_model,
+                            (RowMatchFunc) _dee_filter_substring_match_row,
+                            filter);
+}
+
+static gboolean
+_dee_filter_substring_map_notify (DeeModel *orig_model,
+                                  DeeModelIter *orig_iter,
+                                  DeeFilterModel *filter_model,
+                                  gpointer user_data)
+{
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  if (!_dee_filter_substring_match_row (orig_model, orig_iter,
+                                        (SubstringFilter *) user_data))
+    return FALSE;
+
+  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  return TRUE;
+}
+
+static gboolean
+_dee_filter_substring_map_changed (DeeModel *orig_model,
+                                   DeeModelIter *orig_iter,
+                                   DeeFilterModel *filter_model,
+                                   gpointer user_data)
+{
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  return _dee_filter_update_membership (orig_iter, filter_model,
+              _dee_filter_substring_match_row (orig_model, orig_iter,
+                                               (SubstringFilter *) user_data));
+}
+
+/*
+ * Predicate filters
+ */
+
+/* Rough relative costs of evaluating the leaf predicates on a single row */
+#define PREDICATE_COST_KEY   1.0
+#define PREDICATE_COST_VALUE 2.0
+#define PREDICATE_COST_REGEX 8.0
+
+/* Selectivity guesses for when we have no column index to tell us better */
+#define PREDICATE_SELECTIVITY_EQUAL 0.1
+#define PREDICATE_SELECTIVITY_REGEX 0.5
+
+static gboolean
+_dee_filter_predicate_eval (DeeFilterPredicate *pred,
+                            DeeModel           *model,
+                            DeeModelIter       *iter)
+{
+  GVariant    *val;
+  guint        i;
+
+  switch (pred->type)
+    {
+      case PREDICATE_KEY:
+        return g_strcmp0 (pred->key,
+                          dee_model_get_string (model, iter, pred->column)) == 0;
+      case PREDICATE_VALUE:
+        val = dee_model_peek_value (model, iter, pred->column);
+        return g_variant_equal (pred->value, val);
+      case PREDICATE_REGEX:
+        return g_regex_match (pred->regex,
+                              dee_model_get_string (model, iter, pred->column),
+                              0, NULL);
+      case PREDICATE_ALL:
+        for (i = 0; i < pred->children->len; i++)
+          {
+            if (!_dee_filter_predicate_eval (g_ptr_array_index (pred->children, i),
+                                             model, iter))
+              return FALSE;
+          }
+        return TRUE;
+      case PREDICATE_ANY:
+        for (i = 0; i < pred->children->len; i++)
+          {
+            if (_dee_filter_predicate_eval (g_ptr_array_index (pred->children, i),
+                                            model, iter))
+              return TRUE;
+          }
+        return FALSE;
+      default:
+        g_critical ("Unknown predicate type %i", pred->type);
+        return FALSE;
+    }
+}
+
+static gboolean
+_dee_filter_predicate_match_row (DeeModel           *orig_model,
+                                 DeeModelIter       *orig_iter,
+                                 DeeFilterPredicate *pred)
+{
+  return _dee_filter_predicate_eval (pred, orig_model, orig_iter);
+}
+
+/* Returns the GVariant an equality predicate matches against, or NULL for
+ * any other predicate. Free with g_variant_unref() */
+static GVariant*
+_dee_filter_predicate_dup_match_value (DeeFilterPredicate *pred)
+{
+  if (pred->type == PREDICATE_KEY)
+    return g_variant_ref_sink (g_variant_new_string (pred->key));
+  else if (pred->type == PREDICATE_VALUE)
+    return g_variant_ref (pred->value);
+
+  return NULL;
+}
+
+/* Children of an ALL predicate should be evaluated in order of increasing
+ * cost per row rejected, and children of an ANY predicate in order of
+ * increasing cost per row accepted */
+static gint
+_cmp_predicate_all (gconstpointer a, gconstpointer b)
+{
+  DeeFilterPredicate *p1 = *((DeeFilterPredicate **) a);
+  DeeFilterPredicate *p2 = *((DeeFilterPredicate **) b);
+  gdouble             rank1, rank2;
+
+  rank1 = p1->cost / MAX (1.0 - p1->selectivity, G_MINDOUBLE);
+  rank2 = p2->cost / MAX (1.0 - p2->selectivity, G_MINDOUBLE);
+
+  return rank1 < rank2 ? -1 : (rank1 > rank2 ? 1 : 0);
+}
+
+static gint
+_cmp_predicate_any (gconstpointer a, gconstpointer b)
+{
+  DeeFilterPredicate *p1 = *((DeeFilterPredicate **) a);
+  DeeFilterPredicate *p2 = *((DeeFilterPredicate **) b);
+  gdouble             rank1, rank2;
 
-  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
-  return TRUE;
+  rank1 = p1->cost / MAX (p1->selectivity, G_MINDOUBLE);
+  rank2 = p2->cost / MAX (p2->selectivity, G_MINDOUBLE);
+
+  return rank1 < rank2 ? -1 : (rank1 > rank2 ? 1 : 0);
 }
 
+/* Estimate the cost and selectivity of each predicate in the tree and
+ * reorder the children of ALL and ANY predicates so the cheap and decisive
+ * ones are evaluated first. The estimates for equality predicates are exact
+ * when there is a DeeColumnIndex for the column */
 static void
-_dee_filter_value_map_func (DeeModel *orig_model,
-                            DeeFilterModel *filter_model,
-                            gpointer user_data)
+_dee_filter_predicate_compile (DeeFilterPredicate *pred,
+                               DeeModel           *model)
 {
-  DeeModelIter   *iter, *end;
-  ValueFilter    *filter;
-  GVariant       *val;
+  DeeFilterPredicate *child;
+  DeeColumnIndex     *index;
+  GVariant           *value;
+  gdouble             reach;
+  guint               i, n_rows;
 
-  g_return_if_fail (user_data != NULL);
+  switch (pred->type)
+    {
+      case PREDICATE_KEY:
+      case PREDICATE_VALUE:
+        pred->cost = pred->type == PREDICATE_KEY ?
+          PREDICATE_COST_KEY : PREDICATE_COST_VALUE;
+        pred->selectivity = PREDICATE_SELECTIVITY_EQUAL;
+
+        index = dee_column_index_find (model, pred->column);
+        n_rows = dee_model_get_n_rows (model);
+        if (index != NULL && n_rows > 0)
+          {
+            value = _dee_filter_predicate_dup_match_value (pred);
+            pred->selectivity =
+              dee_column_index_get_n_rows_for_value (index, value) /
+              (gdouble) n_rows;
+            g_variant_unref (value);
+          }
+        break;
+      case PREDICATE_REGEX:
+        pred->cost = PREDICATE_COST_REGEX;
+        pred->selectivity = PREDICATE_SELECTIVITY_REGEX;
+        break;
+      case PREDICATE_ALL:
+      case PREDICATE_ANY:
+        for (i = 0; i < pred->children->len; i++)
+          _dee_filter_predicate_compile (g_ptr_array_index (pred->children, i),
+                                         model);
+
+        g_ptr_array_sort (pred->children, pred->type == PREDICATE_ALL ?
+                                            _cmp_predicate_all :
+                                            _cmp_predicate_any);
+
+        /* reach is the fraction of rows that get as far as evaluating
+         * the current child */
+        pred->cost = 0;
+        reach = 1.0;
+        for (i = 0; i < pred->children->len; i++)
+          {
+            child = g_ptr_array_index (pred->children, i);
+            pred->cost += reach * child->cost;
+            reach *= pred->type == PREDICATE_ALL ?
+              child->selectivity : 1.0 - child->selectivity;
+          }
+        pred->selectivity = pred->type == PREDICATE_ALL ? reach : 1.0 - reach;
+        break;
+      default:
+        g_critical ("Unknown predicate type %i", pred->type);
+        break;
+    }
+}
 
-  filter = (ValueFilter *) user_data;
+/* Find the indexed equality predicate with the fewest matches among the
+ * ones that every matching row must satisfy */
+static DeeFilterPredicate*
+_dee_filter_predicate_find_indexed (DeeFilterPredicate *pred,
+                                    DeeModel           *model,
+                                    guint              *out_n_rows)
+{
+  DeeFilterPredicate *best, *found;
+  DeeColumnIndex     *index;
+  GVariant           *value;
+  guint               i, n_rows, best_n_rows;
 
-  iter = dee_model_get_first_iter (orig_model);
-  end = dee_model_get_last_iter (orig_model);
-  while (iter != end)
+  if (pred->type == PREDICATE_KEY || pred->type == PREDICATE_VALUE)
+    {
+      index = dee_column_index_find (model, pred->column);
+      if (index == NULL)
+        return NULL;
+
+      value = _dee_filter_predicate_dup_match_value (pred);
+      *out_n_rows = dee_column_index_get_n_rows_for_value (index, value);
+      g_variant_unref (value);
+      return pred;
+    }
+  else if (pred->type != PREDICATE_ALL)
+    return NULL;
+
+  best = NULL;
+  best_n_rows = G_MAXUINT;
+  for (i = 0; i < pred->children->len; i++)
     {
-      val = dee_model_get_value (orig_model, iter, filter->column);
-      if (g_variant_equal (filter->value, val))
+      found = _dee_filter_predicate_find_indexed (
+                               g_ptr_array_index (pred->children, i),
+                               model, &n_rows);
+      if (found != NULL && n_rows < best_n_rows)
         {
-          dee_filter_model_append_iter (filter_model, iter);
+          best = found;
+          best_n_rows = n_rows;
         }
-      iter = dee_model_next (orig_model, iter);
     }
+
+  *out_n_rows = best_n_rows;
+  return best;
 }
 
-static gboolean
-_dee_filter_value_map_notify (DeeModel *orig_model,
-                              DeeModelIter *orig_iter,
-                              DeeFilterModel *filter_model,
-                              gpointer user_data)
+static void
+_dee_filter_predicate_map_func (DeeModel *orig_model,
+                                DeeFilterModel *filter_model,
+                                gpointer user_data)
 {
-  ValueFilter    *filter;
-  GVariant       *val;
+  PredicateFilter    *filter;
+  DeeFilterPredicate *driver;
+  DeeColumnIndex     *index;
+  DeeResultSet       *results;
+  DeeModelIter      **iters;
+  GVariant           *value;
+  GPtrArray          *scanned;
+  GArray             *matches;
+  MatchedRow          match;
+  guint               i, n_candidates;
 
-  g_return_val_if_fail (user_data != NULL, FALSE);
+  g_return_if_fail (user_data != NULL);
 
-  filter = (ValueFilter *) user_data;
-  val = dee_model_get_value (orig_model, orig_iter, filter->column);
+  filter = (PredicateFilter *) user_data;
+  _dee_filter_predicate_compile (filter->predicate, orig_model);
 
-  /* Ignore rows that don't match the value */
-  if (!g_variant_equal (filter->value, val))
-    return FALSE;
+  if (filter->sort)
+    {
+      filter->sort->n_cols = dee_model_get_n_columns (orig_model);
+      filter->sort->row_buf = g_new0 (GVariant*, filter->sort->n_cols);
+    }
 
-  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
-  return TRUE;
-}
+  matches = g_array_new (FALSE, FALSE, sizeof (MatchedRow));
+  match.pos = 0;
+  match.row = NULL;
 
-static void
-_dee_filter_regex_map_func (DeeModel *orig_model,
-                            DeeFilterModel *filter_model,
-                            gpointer user_data)
-{
-  DeeModelIter   *iter, *end;
-  RegexFilter    *filter;
-  guint           column;
-  GRegex         *regex;
-  const gchar    *val;
+  /* If some indexed equality must hold for all matches we only need to
+   * look at the rows the index gives us. Otherwise do a single scan */
+  driver = _dee_filter_predicate_find_indexed (filter->predicate,
+                                               orig_model, &n_candidates);
+  if (driver != NULL)
+    {
+      index = dee_column_index_find (orig_model, driver->column);
+      value = _dee_filter_predicate_dup_match_value (driver);
+      results = dee_column_index_lookup (index, value);
+      g_variant_unref (value);
 
-  g_return_if_fail (user_data != NULL);
+      while (dee_result_set_has_next (results))
+        {
+          match.iter = dee_result_set_next (results);
+          if (_dee_filter_predicate_eval (filter->predicate,
+                                          orig_model, match.iter))
+            {
+              match.pos = dee_model_get_position (orig_model, match.iter);
+              g_array_append_val (matches, match);
+            }
+        }
+      g_object_unref (results);
 
-  filter = (RegexFilter *) user_data;
-  regex = filter->regex;
-  column = filter->column;
+      /* Restore the ordering of the original model. This also provides
+       * a stable base for the sort below */
+      g_qsort_with_data (matches->data, matches->len, sizeof (MatchedRow),
+                         _cmp_matched_row_pos, NULL);
+    }
+  else
+    {
+      scanned = _dee_filter_scan (orig_model,
+                                  (RowMatchFunc) _dee_filter_predicate_match_row,
+                                  filter->predicate);
+      for (i = 0; i < scanned->len; i++)
+        {
+          match.iter = g_ptr_array_index (scanned, i);
+          g_array_append_val (matches, match);
+        }
+      g_ptr_array_free (scanned, TRUE);
+    }
 
-  iter = dee_model_get_first_iter (orig_model);
-  end = dee_model_get_last_iter (orig_model);
-  while (iter != end)
+  /* Sort all the matches in one go instead of doing a binary search of
+   * the filter model per row. g_qsort_with_data() is stable so rows that
+   * compare equal keep the order of the original model */
+  if (filter->sort)
     {
-      val = dee_model_get_string (orig_model, iter, column);
-      if (g_regex_match (regex, val, 0, NULL))
+      for (i = 0; i < matches->len; i++)
         {
-          dee_filter_model_append_iter (filter_model, iter);
+          MatchedRow *m = &g_array_index (matches, MatchedRow, i);
+          m->row = dee_model_peek_row (orig_model, m->iter, NULL);
         }
-      iter = dee_model_next (orig_model, iter);
+
+      g_qsort_with_data (matches->data, matches->len, sizeof (MatchedRow),
+                         _cmp_matched_row_sorted, filter->sort);
+    }
+
+  iters = g_new (DeeModelIter*, matches->len);
+  for (i = 0; i < matches->len; i++)
+    {
+      MatchedRow *m = &g_array_index (matches, MatchedRow, i);
+      iters[i] = m->iter;
+
+      g_free (m->row);
     }
+
+  dee_filter_model_append_iters (filter_model, iters, matches->len);
+
+  g_free (iters);
+  g_array_free (matches, TRUE);
 }
 
 static gboolean
-_dee_filter_regex_map_notify (DeeModel *orig_model,
-                              DeeModelIter *orig_iter,
-                              DeeFilterModel *filter_model,
-                              gpointer user_data)
+_dee_filter_predicate_map_notify (DeeModel *orig_model,
+                                  DeeModelIter *orig_iter,
+                                  DeeFilterModel *filter_model,
+                                  gpointer user_data)
 {
-  RegexFilter    *filter;
-  const gchar    *val;
+  PredicateFilter *filter;
 
   g_return_val_if_fail (user_data != NULL, FALSE);
 
-  filter = (RegexFilter *) user_data;
-  val = dee_model_get_string (orig_model, orig_iter, filter->column);
+  filter = (PredicateFilter *) user_data;
 
-  /* Ignore rows that don't match the key */
-  if (!g_regex_match (filter->regex, val, 0, NULL))
+  if (!_dee_filter_predicate_eval (filter->predicate, orig_model, orig_iter))
     return FALSE;
 
-  dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+  if (filter->sort)
+    _dee_filter_sort_map_notify (orig_model, orig_iter,
+                                 filter_model, filter->sort);
+  else
+    dee_filter_model_insert_iter_with_original_order (filter_model, orig_iter);
+
   return TRUE;
 }
 
+static gboolean
+_dee_filter_predicate_map_changed (DeeModel *orig_model,
+                                   DeeModelIter *orig_iter,
+                                   DeeFilterModel *filter_model,
+                                   gpointer user_data)
+{
+  PredicateFilter *filter;
+  gboolean         matches;
+
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  filter = (PredicateFilter *) user_data;
+  matches = _dee_filter_predicate_eval (filter->predicate,
+                                        orig_model, orig_iter);
+
+  if (matches && filter->sort)
+    return _dee_filter_sort_map_changed (orig_model, orig_iter,
+                                         filter_model, filter->sort);
+
+  return _dee_filter_update_membership (orig_iter, filter_model, matches);
+}
+
 static void
 sort_filter_free (SortFilter *filter)
 {
@@ -323,6 +1778,17 @@ sort_filter_free (SortFilter *filter)
   g_free (filter);
 }
 
+static void
+collator_filter_free (CollatorFilter *filter)
+{
+  if (filter->on_orig_row_removed_id != 0)
+    g_signal_handler_disconnect (filter->orig_model,
+                                 filter->on_orig_row_removed_id);
+
+  g_hash_table_destroy (filter->keys);
+  g_free (filter);
+}
+
 static void
 key_filter_free (KeyFilter *filter)
 {
@@ -341,6 +1807,23 @@ static void
 regex_filter_free (RegexFilter *filter)
 {
   g_regex_unref (filter->regex);
+  g_strfreev (filter->literals);
+  g_free (filter);
+}
+
+static void
+substring_filter_free (SubstringFilter *filter)
+{
+  g_free (filter->needle);
+  g_free (filter);
+}
+
+static void
+predicate_filter_free (PredicateFilter *filter)
+{
+  dee_filter_predicate_free (filter->predicate);
+  if (filter->sort)
+    sort_filter_free (filter->sort);
   g_free (filter);
 }
 
@@ -374,6 +1857,37 @@ dee_filter_notify (DeeFilter      *filter,
                              filter_model, filter->userdata);
 }
 
+/**
+ * dee_filter_notify_changed:
+ * @filter: The filter to apply
+ * @orig_iter: The #DeeModelIter changed in @orig_model
+ * @orig_model: The model that is being filtered
+ * @filter_model: The #DeeFilterModel that holds the
+ *                filtered subset of @orig_model
+ *
+ * Call the #DeeFilterMapChanged function of a #DeeFilter. If the filter
+ * has no such function this simply checks if @orig_iter is contained in
+ * @filter_model.
+ * When using a #DeeFilterModel you should not call this method yourself.
+ *
+ * Returns: The return value from the #DeeFilterMapChanged. That is; %TRUE
+ *          if @orig_iter is contained in @filter_model after the change
+ */
+gboolean
+dee_filter_notify_changed (DeeFilter      *filter,
+                           DeeModelIter   *orig_iter,
+                           DeeModel       *orig_model,
+                           DeeFilterModel *filter_model)
+{
+  g_return_val_if_fail (filter != NULL, FALSE);
+
+  if (filter->map_changed == NULL)
+    return dee_filter_model_contains (filter_model, orig_iter);
+
+  return filter->map_changed (orig_model, orig_iter,
+                              filter_model, filter->userdata);
+}
+
 /**
  * dee_filter_map:
  * @filter: The filter to apply
@@ -428,6 +1942,10 @@ dee_filter_destroy (DeeFilter *filter)
  * Create a new #DeeFilter with the given parameters. This call will zero
  * the @out_filter struct.
  *
+ * The @map_changed member of @out_filter is left unset. Assign a
+ * #DeeFilterMapChanged to it if the filter should re-evaluate rows when they
+ * change in the original model. All the filters shipped with Dee do this.
+ *
  */
 void
 dee_filter_new (DeeFilterMapFunc   map_func,
@@ -479,6 +1997,7 @@ dee_filter_new_sort (DeeCompareRowFunc cmp_row,
                   filter,
                   (GDestroyNotify) sort_filter_free,
                   out_filter);
+  out_filter->map_changed = _dee_filter_sort_map_changed;
 }
 
 /**
@@ -496,8 +2015,7 @@ void
 dee_filter_new_collator    (guint      column,
                             DeeFilter *out_filter)
 {
-  dee_filter_new_sort (_cmp_collate_asc, GUINT_TO_POINTER (column),
-                       NULL, out_filter);
+  dee_filter_new_column_sort (column, FALSE, out_filter);
 }
 
 /**
@@ -515,9 +2033,51 @@ void
 dee_filter_new_collator_desc    (guint      column,
                                  DeeFilter *out_filter)
 {
-  dee_filter_new_sort (_cmp_collate_desc, GUINT_TO_POINTER (column),
-                       NULL, out_filter);
-} 
+  dee_filter_new_column_sort (column, TRUE, out_filter);
+}
+
+/**
+ * dee_filter_new_column_sort:
+ * @column: The index of the column to sort after
+ * @descending: Whether to sort in descending order
+ * @out_filter: (out): A pointer to an uninitialized #DeeFilter struct.
+ *                     This struct will zeroed and configured with the filter
+ *                     parameters
+ *
+ * Create a #DeeFilter that builds a #DeeFilterModel with the rows sorted
+ * after the values of a column. Strings are sorted according to the
+ * collation rules of the current locale, like with
+ * dee_filter_new_collator(). Booleans, integers and doubles are sorted
+ * numerically. Other column types are not supported. Rows with equal
+ * values keep the order of the original model.
+ *
+ * Instead of comparing the column values each time, this filter builds a
+ * binary sort key for each row. The keys are cached by the filter itself,
+ * leaving the original model untouched, so this also works on a
+ * #DeeTransaction. For strings the key is the collation key from
+ * g_utf8_collate_key(). The keys are compared with memcmp(), and the
+ * initial sort needs only one key per row.
+ */
+void
+dee_filter_new_column_sort (guint      column,
+                            gboolean   descending,
+                            DeeFilter *out_filter)
+{
+  CollatorFilter *filter;
+
+  filter = g_new0 (CollatorFilter, 1);
+  filter->column = column;
+  filter->descending = descending;
+  filter->keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                        NULL, g_free);
+
+  dee_filter_new (_dee_filter_column_sort_map_func,
+                  _dee_filter_column_sort_map_notify,
+                  filter,
+                  (GDestroyNotify) collator_filter_free,
+                  out_filter);
+  out_filter->map_changed = _dee_filter_column_sort_map_changed;
+}
 
 
 /**
@@ -530,6 +2090,10 @@ dee_filter_new_collator_desc    (guint      column,
  * Create a #DeeFilter that only includes rows from the original model
  * which has an exact match on some string column. A #DeeFilterModel created
  * with this filter will be ordered in accordance with its parent model.
+ *
+ * If a #DeeColumnIndex exists for @column when the filter model is created
+ * it will be used to find the matching rows instead of scanning the whole
+ * original model.
  */
 void
 dee_filter_new_for_key_column    (guint        column,
@@ -549,6 +2113,7 @@ dee_filter_new_for_key_column    (guint        column,
                   key_filter,
                   (GDestroyNotify) key_filter_free,
                   out_filter);
+  out_filter->map_changed = _dee_filter_key_map_changed;
 }
 
 /**
@@ -569,6 +2134,10 @@ dee_filter_new_for_key_column    (guint        column,
  * value comparison is done using g_variant_equal(). This means you can use
  * this filter as a convenient fallback when there is no predefined filter
  * for your column type if raw performance is not paramount.
+ *
+ * If a #DeeColumnIndex exists for @column when the filter model is created
+ * it will be used to find the matching rows instead of scanning the whole
+ * original model.
  */
 void
 dee_filter_new_for_any_column (guint      column,
@@ -588,6 +2157,7 @@ dee_filter_new_for_any_column (guint      column,
                   v_filter,
                   (GDestroyNotify) value_filter_free,
                   out_filter);
+  out_filter->map_changed = _dee_filter_value_map_changed;
 }
 
 /**
@@ -601,6 +2171,12 @@ dee_filter_new_for_any_column (guint      column,
  * Create a #DeeFilter that only includes rows from the original model
  * which match a regular expression on some string column. A #DeeFilterModel
  * created with this filter will be ordered in accordance with its parent model.
+ *
+ * If a #DeeTrigramIndex exists for @column when the filter model is created
+ * the regular expression is only run on the rows containing the literal
+ * parts of the pattern. This requires that the pattern has a literal run of
+ * at least three characters outside of any group and no top level
+ * alternation.
  */
 void
 dee_filter_new_regex (guint      column,
@@ -615,10 +2191,290 @@ dee_filter_new_regex (guint      column,
   r_filter->column = column;
   r_filter->regex = g_regex_ref (regex);
 
+  if ((g_regex_get_compile_flags (regex) & G_REGEX_EXTENDED) == 0)
+    r_filter->literals = _dee_filter_regex_literals (g_regex_get_pattern (regex));
+
   dee_filter_new (_dee_filter_regex_map_func,
                   _dee_filter_regex_map_notify,
                   r_filter,
                   (GDestroyNotify) regex_filter_free,
                   out_filter);
+  out_filter->map_changed = _dee_filter_regex_map_changed;
+}
+
+/**
+ * dee_filter_new_for_substring:
+ * @column: The index of a column containing the string to match
+ * @needle: The string @column must contain
+ * @out_filter: (out): A pointer to an uninitialized #DeeFilter struct.
+ *                     This struct will zeroed and configured with the filter
+ *                     parameters
+ *
+ * Create a #DeeFilter that only includes rows from the original model
+ * where some string column contains @needle, ignoring case. A #DeeFilterModel
+ * created with this filter will be ordered in accordance with its parent model.
+ *
+ * If a #DeeTrigramIndex exists for @column when the filter model is created
+ * and @needle is at least three characters long, only the rows containing
+ * all the trigrams of @needle are examined.
+ */
+void
+dee_filter_new_for_substring (guint        column,
+                              const gchar *needle,
+                              DeeFilter   *out_filter)
+{
+  SubstringFilter *s_filter;
+
+  g_return_if_fail (needle != NULL);
+
+  s_filter = g_new0 (SubstringFilter, 1);
+  s_filter->column = column;
+  s_filter->needle = g_utf8_casefold (needle, -1);
+
+  dee_filter_new (_dee_filter_substring_map_func,
+                  _dee_filter_substring_map_notify,
+                  s_filter,
+                  (GDestroyNotify) substring_filter_free,
+                  out_filter);
+  out_filter->map_changed = _dee_filter_substring_map_changed;
+}
+
+/**
+ * dee_filter_predicate_new_key:
+ * @column: The index of a string column
+ * @key: The string @column must be equal to
+ *
+ * Create a predicate matching rows where a string column is equal to @key.
+ *
+ * Returns: (transfer full): A newly allocated #DeeFilterPredicate. Free with
+ *          dee_filter_predicate_free() or pass it on to a function taking
+ *          ownership of it
+ */
+DeeFilterPredicate*
+dee_filter_predicate_new_key (guint        column,
+                              const gchar *key)
+{
+  DeeFilterPredicate *pred;
+
+  g_return_val_if_fail (key != NULL, NULL);
+
+  pred = g_slice_new0 (DeeFilterPredicate);
+  pred->type = PREDICATE_KEY;
+  pred->column = column;
+  pred->key = g_strdup (key);
+
+  return pred;
+}
+
+/**
+ * dee_filter_predicate_new_value:
+ * @column: The index of a column of any type
+ * @value: The value @column must be equal to according to g_variant_equal().
+ *         If @value is floating the predicate will take ownership of it
+ *
+ * Create a predicate matching rows where a column is equal to @value.
+ *
+ * Returns: (transfer full): A newly allocated #DeeFilterPredicate. Free with
+ *          dee_filter_predicate_free() or pass it on to a function taking
+ *          ownership of it
+ */
+DeeFilterPredicate*
+dee_filter_predicate_new_value (guint     column,
+                                GVariant *value)
+{
+  DeeFilterPredicate *pred;
+
+  g_return_val_if_fail (value != NULL, NULL);
+
+  pred = g_slice_new0 (DeeFilterPredicate);
+  pred->type = PREDICATE_VALUE;
+  pred->column = column;
+  pred->value = g_variant_ref_sink (value);
+
+  return pred;
+}
+
+/**
+ * dee_filter_predicate_new_regex:
+ * @column: The index of a string column
+ * @regex: (transfer none): The regular expression @column must match
+ *
+ * Create a predicate matching rows where a string column matches @regex.
+ *
+ * Returns: (transfer full): A newly allocated #DeeFilterPredicate. Free with
+ *          dee_filter_predicate_free() or pass it on to a function taking
+ *          ownership of it
+ */
+DeeFilterPredicate*
+dee_filter_predicate_new_regex (guint   column,
+                                GRegex *regex)
+{
+  DeeFilterPredicate *pred;
+
+  g_return_val_if_fail (regex != NULL, NULL);
+
+  pred = g_slice_new0 (DeeFilterPredicate);
+  pred->type = PREDICATE_REGEX;
+  pred->column = column;
+  pred->regex = g_regex_ref (regex);
+
+  return pred;
+}
+
+static DeeFilterPredicate*
+_dee_filter_predicate_new_compound (PredicateType       type,
+                                   DeeFilterPredicate *first,
+                                   va_list             args)
+{
+  DeeFilterPredicate *pred, *child;
+
+  pred = g_slice_new0 (DeeFilterPredicate);
+  pred->type = type;
+  pred->children =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) dee_filter_predicate_free);
+
+  for (child = first; child != NULL; child = va_arg (args, DeeFilterPredicate*))
+    g_ptr_array_add (pred->children, child);
+
+  return pred;
+}
+
+/**
+ * dee_filter_predicate_new_all:
+ * @first: (transfer full): The first predicate
+ * @...: A %NULL terminated list of more predicates
+ *
+ * Create a predicate matching rows that match all the given predicates.
+ * The order of the predicates does not matter, they are reordered so the
+ * cheapest and most selective ones are evaluated first.
+ *
+ * Returns: (transfer full): A newly allocated #DeeFilterPredicate owning
+ *          all the given predicates. Free with dee_filter_predicate_free()
+ *          or pass it on to a function taking ownership of it
+ */
+DeeFilterPredicate*
+dee_filter_predicate_new_all (DeeFilterPredicate *first,
+                              ...)
+{
+  DeeFilterPredicate *pred;
+  va_list             args;
+
+  g_return_val_if_fail (first != NULL, NULL);
+
+  va_start (args, first);
+  pred = _dee_filter_predicate_new_compound (PREDICATE_ALL, first, args);
+  va_end (args);
+
+  return pred;
+}
+
+/**
+ * dee_filter_predicate_new_any:
+ * @first: (transfer full): The first predicate
+ * @...: A %NULL terminated list of more predicates
+ *
+ * Create a predicate matching rows that match at least one of the given
+ * predicates. The order of the predicates does not matter, they are
+ * reordered so the cheapest and least selective ones are evaluated first.
+ *
+ * Returns: (transfer full): A newly allocated #DeeFilterPredicate owning
+ *          all the given predicates. Free with dee_filter_predicate_free()
+ *          or pass it on to a function taking ownership of it
+ */
+DeeFilterPredicate*
+dee_filter_predicate_new_any (DeeFilterPredicate *first,
+                              ...)
+{
+  DeeFilterPredicate *pred;
+  va_list             args;
+
+  g_return_val_if_fail (first != NULL, NULL);
+
+  va_start (args, first);
+  pred = _dee_filter_predicate_new_compound (PREDICATE_ANY, first, args);
+  va_end (args);
+
+  return pred;
+}
+
+/**
+ * dee_filter_predicate_free:
+ * @predicate: The predicate to free
+ *
+ * Free a #DeeFilterPredicate along with all the predicates it owns.
+ */
+void
+dee_filter_predicate_free (DeeFilterPredicate *predicate)
+{
+  g_return_if_fail (predicate != NULL);
+
+  g_free (predicate->key);
+  if (predicate->value)
+    g_variant_unref (predicate->value);
+  if (predicate->regex)
+    g_regex_unref (predicate->regex);
+  if (predicate->children)
+    g_ptr_array_unref (predicate->children);
+
+  g_slice_free (DeeFilterPredicate, predicate);
 }
 
+/**
+ * dee_filter_new_for_predicate:
+ * @predicate: (transfer full): The #DeeFilterPredicate rows must match
+ * @cmp_row: (scope notified) (allow-none): A #DeeCompareRowFunc to sort the
+ *           matching rows with, or %NULL to keep the order of the original
+ *           model
+ * @cmp_user_data: (closure): User data passed to @cmp_row
+ * @cmp_destroy: (allow-none): The #GDestroyNotify to call on
+ *                         @cmp_user_data when disposing of the filter
+ * @out_filter: (out): A pointer to an uninitialized #DeeFilter struct.
+ *                     This struct will zeroed and configured with the filter
+ *                     parameters
+ *
+ * Create a #DeeFilter that only includes rows from the original model
+ * which match @predicate, optionally sorted by @cmp_row. Combine predicates
+ * with dee_filter_predicate_new_all() and dee_filter_predicate_new_any() to
+ * express several conditions.
+ *
+ * This does the work of a stack of #DeeFilterModel<!-- -->s, one per
+ * condition, with a single filter model. The original model is scanned
+ * once and every change to it is evaluated once, without the intermediate
+ * models and their signal forwarding.
+ *
+ * When the filter model is created the predicates are reordered so the
+ * cheap and selective ones are evaluated first. If a #DeeColumnIndex exists
+ * for a column matched with dee_filter_predicate_new_key() or
+ * dee_filter_predicate_new_value() it is used to estimate the selectivity
+ * and, if the condition must hold for all rows, to avoid scanning the
+ * whole original model.
+ */
+void
+dee_filter_new_for_predicate (DeeFilterPredicate *predicate,
+                              DeeCompareRowFunc   cmp_row,
+                              gpointer            cmp_user_data,
+                              GDestroyNotify      cmp_destroy,
+                              DeeFilter          *out_filter)
+{
+  PredicateFilter *p_filter;
+
+  g_return_if_fail (predicate != NULL);
+
+  p_filter = g_new0 (PredicateFilter, 1);
+  p_filter->predicate = predicate;
+
+  if (cmp_row != NULL)
+    {
+      p_filter->sort = g_new0 (SortFilter, 1);
+      p_filter->sort->cmp = cmp_row;
+      p_filter->sort->user_data = cmp_user_data;
+      p_filter->sort->destroy = cmp_destroy;
+    }
+
+  dee_filter_new (_dee_filter_predicate_map_func,
+                  _dee_filter_predicate_map_notify,
+                  p_filter,
+                  (GDestroyNotify) predicate_filter_free,
+                  out_filter);
+  out_filter->map_changed = _dee_filter_predicate_map_changed;
+}
@@ -72,6 +72,42 @@ typedef gboolean (*DeeFilterMapNotify) (DeeModel          *orig_model,
                                         DeeFilterModel    *filter_model,
                                         gpointer           user_data);
 
+/**
+ * DeeFilterMapChanged:
+ * @orig_model: The model containing the changed row
+ * @orig_iter: A #DeeModelIter pointing to the changed row in @orig_model
+ * @filter_model: The model that was also passed to the #DeeModelMapFunc
+ *                of the #DeeFilter this functions is a part of
+ * @user_data: (closure): User data for the #DeeFilter
+ *
+ * Callback invoked when a row in @orig_model has changed. The callback must
+ * re-evaluate whether @orig_iter belongs in @filter_model and where. A row
+ * entering the filter should be added with one of the
+ * dee_filter_model_insert_iter() family of methods, a row leaving it should be
+ * dropped with dee_filter_model_remove_iter(), and a row that has to move
+ * should be removed and re-inserted at its new position.
+ *
+ * If the row stays put the callback should not touch @filter_model at all;
+ * the filter model will then emit #DeeModel::row-changed for it.
+ *
+ * Returns: %TRUE if @orig_iter is contained in @filter_model after the change
+ */
+typedef gboolean (*DeeFilterMapChanged) (DeeModel          *orig_model,
+                                         DeeModelIter      *orig_iter,
+                                         DeeFilterModel    *filter_model,
+                                         gpointer           user_data);
+
+/**
+ * DeeFilterPredicate:
+ *
+ * An opaque condition on the rows of a model, used with
+ * dee_filter_new_for_predicate(). Predicates on single columns are created
+ * with dee_filter_predicate_new_key(), dee_filter_predicate_new_value() and
+ * dee_filter_predicate_new_regex() and can be combined with
+ * dee_filter_predicate_new_all() and dee_filter_predicate_new_any().
+ */
+typedef struct _DeeFilterPredicate DeeFilterPredicate;
+
 /**
  * DeeFilter:
  * @map_func: (scope notified): The #DeeModelMapFunc used to construct
@@ -79,7 +115,13 @@ typedef gboolean (*DeeFilterMapNotify) (DeeModel          *orig_model,
  * @map_notify: (scope notified): Callback invoked when the original model changes
  * @destroy: Callback for freeing the @user_data
  * @userdata (closure): Free form user data associated with the filter.
- *                       This pointer will be passed to @map_func and @map_notify
+ *                       This pointer will be passed to @map_func, @map_notify
+ *                       and @map_changed
+ * @map_changed: (scope notified) (allow-none): Callback invoked when a row in
+ *               the original model changes. If this is %NULL rows are never
+ *               added, removed or moved in response to changes, only
+ *               #DeeModel::row-changed is forwarded for rows already in the
+ *               filter model. dee_filter_new() leaves this unset
  *
  * Structure encapsulating the mapping logic used to construct a #DeeFilterModel
  */
@@ -89,9 +131,9 @@ struct _DeeFilter
   DeeFilterMapNotify map_notify;
   GDestroyNotify     destroy;
   gpointer           userdata;
+  DeeFilterMapChanged map_changed;
 
   /*< private >*/
-  gpointer          _padding_1;
   gpointer          _padding_2;
   gpointer          _padding_3;
   gpointer          _padding_4;
@@ -102,6 +144,11 @@ gboolean dee_filter_notify         (DeeFilter      *filter,
                                     DeeModel       *orig_model,
                                     DeeFilterModel *filter_model);
 
+gboolean dee_filter_notify_changed (DeeFilter      *filter,
+                                    DeeModelIter   *orig_iter,
+                                    DeeModel       *orig_model,
+                                    DeeFilterModel *filter_model);
+
 void dee_filter_map                (DeeFilter      *filter,
                                     DeeModel       *orig_model,
                                     DeeFilterModel *filter_model);
@@ -125,6 +172,10 @@ void dee_filter_new_collator       (guint       column,
 void dee_filter_new_collator_desc  (guint       column,
                                     DeeFilter  *out_filter);
 
+void dee_filter_new_column_sort    (guint       column,
+                                    gboolean    descending,
+                                    DeeFilter  *out_filter);
+
 void dee_filter_new_for_key_column (guint        column,
                                     const gchar *key,
                                     DeeFilter   *out_filter);
@@ -137,6 +188,33 @@ void dee_filter_new_regex          (guint        column,
                                     GRegex      *regex,
                                     DeeFilter   *out_filter);
 
+void dee_filter_new_for_substring  (guint        column,
+                                    const gchar *needle,
+                                    DeeFilter   *out_filter);
+
+void dee_filter_new_for_predicate  (DeeFilterPredicate *predicate,
+                                    DeeCompareRowFunc   cmp_row,
+                                    gpointer            cmp_user_data,
+                                    GDestroyNotify      cmp_destroy,
+                                    DeeFilter          *out_filter);
+
+DeeFilterPredicate* dee_filter_predicate_new_key   (guint        column,
+                                                    const gchar *key);
+
+DeeFilterPredicate* dee_filter_predicate_new_value (guint        column,
+                                                    GVariant    *value);
+
+DeeFilterPredicate* dee_filter_predicate_new_regex (guint        column,
+                                                    GRegex      *regex);
+
+DeeFilterPredicate* dee_filter_predicate_new_all   (DeeFilterPredicate *first,
+                                                    ...) G_GNUC_NULL_TERMINATED;
+
+DeeFilterPredicate* dee_filter_predicate_new_any   (DeeFilterPredicate *first,
+                                                    ...) G_GNUC_NULL_TERMINATED;
+
+void                dee_filter_predicate_free      (DeeFilterPredicate *predicate);
+
 G_END_DECLS
 
 #endif /* _HAVE_DEE_FILTERS_H */
@@ -135,13 +135,21 @@ dee_hash_index_finalize (GObject *object)
   G_OBJECT_CLASS (dee_hash_index_parent_class)->finalize (object);
 }
 
+static gboolean
+index_existing_row (DeeModel     *model,
+                    DeeModelIter *iter,
+                    gpointer      user_data)
+{
+  on_row_added ((DeeIndex *) user_data, iter, model);
+  return FALSE;
+}
+
 static void
 dee_hash_index_constructed (GObject *object)
 {
   DeeHashIndexPrivate *priv = DEE_HASH_INDEX (object)->priv;
   DeeIndex            *self = DEE_INDEX (object);
   DeeModel            *model = dee_index_get_model (self);
-  DeeModelIter        *iter;
 
   /* Listen for changes in the model so we automagically pick those up */
   priv->on_row_added_handler = g_signal_connect_swapped (model, "row-added",
@@ -157,12 +165,7 @@ dee_hash_index_constructed (GObject *object)
                                                            self);
 
   /* Index existing rows in the model */
-  iter = dee_model_get_first_iter (model);
-  while (!dee_model_is_last (model, iter))
-    {
-      on_row_added (self, iter, model);
-      iter = dee_model_next (model, iter);
-    }
+  dee_model_foreach_range (model, NULL, NULL, index_existing_row, self);
 }
 
 static void
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DEE_MODEL_SCHEMA_H_
+#define _DEE_MODEL_SCHEMA_H_
+
+#include <glib.h>
+
+#include "dee-model.h"
+
+G_BEGIN_DECLS
+
+/*
+ * DeeModelSchema is the compiled form of a model schema. It is built once
+ * when the schema is set so that the varargs builders and getters can
+ * dispatch on a type code instead of reparsing the type strings for every
+ * cell. It is not part of the public API.
+ */
+typedef struct _DeeColumnDesc  DeeColumnDesc;
+typedef struct _DeeFieldDesc   DeeFieldDesc;
+typedef struct _DeeModelSchema DeeModelSchema;
+
+struct _DeeColumnDesc
+{
+  gchar    *schema;
+  gchar     type_code;  // first character of the type string
+  guint8    fixed_size; // 0 for variable sized types
+  gboolean  is_basic;
+  gboolean  is_vardict;
+};
+
+struct _DeeFieldDesc
+{
+  guint         column;
+  DeeColumnDesc desc;
+};
+
+struct _DeeModelSchema
+{
+  guint          n_columns;
+  DeeColumnDesc *columns;
+
+  /* Field name -> DeeFieldDesc for the fields of vardict columns. Filled
+   * in on lookup and flushed when a vardict schema is registered */
+  GHashTable    *fields;
+};
+
+DeeModelSchema*      _dee_model_get_compiled_schema (DeeModel    *self);
+
+const DeeFieldDesc*  _dee_model_schema_lookup_field (DeeModel       *self,
+                                                     DeeModelSchema *schema,
+                                                     const gchar    *field_name);
+
+gboolean             _dee_column_desc_check_value   (const DeeColumnDesc *desc,
+                                                     GVariant            *value);
+
+G_END_DECLS
+
+#endif /* _DEE_MODEL_SCHEMA_H_ */
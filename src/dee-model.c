@@ -86,6 +86,8 @@
 #include <unistd.h>
 
 #include "dee-model.h"
+#include "dee-model-schema.h"
+#include "dee-column-index.h"
 #include "dee-marshal.h"
 #include "trace-log.h"
 
@@ -98,6 +100,8 @@ enum
   DEE_MODEL_SIGNAL_ROW_ADDED,
   DEE_MODEL_SIGNAL_ROW_REMOVED,
   DEE_MODEL_SIGNAL_ROW_CHANGED,
+  DEE_MODEL_SIGNAL_ROW_MOVED,
+  DEE_MODEL_SIGNAL_ROWS_REORDERED,
   DEE_MODEL_SIGNAL_CHANGESET_STARTED,
   DEE_MODEL_SIGNAL_CHANGESET_FINISHED,
 
@@ -147,6 +151,10 @@ static GVariant**      dee_model_build_row_valist (DeeModel  *self,
                                                    GVariant **out_row_members,
                                                    va_list   *args);
 
+static GQuark          model_schema_quark   (void);
+
+static DeeModelSchema* model_schema_compile (DeeModel *self);
+
 /* 
  * We provide here a couple of DeeModelIter functions, so that they're usable
  * from introspected languages.
@@ -232,6 +240,48 @@ dee_model_default_init (DeeModelInterface *klass)
                   G_TYPE_NONE, 1,
                   DEE_TYPE_MODEL_ITER);
 
+  /**
+   * DeeModel::row-moved:
+   * @self: the #DeeModel on which the signal is emitted
+   * @iter: (transfer none) (type Dee.ModelIter): a #DeeModelIter pointing to the moved row
+   * @old_position: the position the row had before it was moved
+   *
+   * Connect to this signal to be notified when a row is moved with
+   * dee_model_move_before(). The signal is emitted after the move, so @iter
+   * is at its new position. The row itself is unchanged.
+   **/
+  dee_model_signals[DEE_MODEL_SIGNAL_ROW_MOVED] =
+    g_signal_new ("row-moved",
+                  DEE_TYPE_MODEL,
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (DeeModelIface,row_moved),
+                  NULL, NULL,
+                  _dee_marshal_VOID__BOXED_UINT,
+                  G_TYPE_NONE, 2,
+                  DEE_TYPE_MODEL_ITER,
+                  G_TYPE_UINT);
+
+  /**
+   * DeeModel::rows-reordered:
+   * @self: the #DeeModel on which the signal is emitted
+   * @new_order: (type gpointer): an array of dee_model_get_n_rows() positions.
+   *             Element i is the position the row now at position i had
+   *             before the reordering
+   *
+   * Connect to this signal to be notified when the rows of the model have
+   * been rearranged, typically by dee_model_sort(). No rows are added,
+   * removed or changed and all iters stay valid.
+   **/
+  dee_model_signals[DEE_MODEL_SIGNAL_ROWS_REORDERED] =
+    g_signal_new ("rows-reordered",
+                  DEE_TYPE_MODEL,
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (DeeModelIface,rows_reordered),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__POINTER,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_POINTER);
+
   /**
    * DeeModel::changeset-started
    * @self: the #DeeModel on which the signal is emitted
@@ -389,6 +439,10 @@ dee_model_set_schema_full (DeeModel           *self,
   iface = DEE_MODEL_GET_IFACE (self);
 
   (* iface->set_schema_full) (self, column_schemas, num_columns);
+
+  /* Compile the schema up front so we never parse the type strings
+   * again when building rows. This is a no-op if it was rejected */
+  model_schema_compile (self);
 }
 
 void
@@ -611,13 +665,19 @@ dee_model_register_vardict_schema (DeeModel   *self,
                                    guint       column,
                                    GHashTable *schemas)
 {
-  DeeModelIface *iface;
+  DeeModelIface  *iface;
+  DeeModelSchema *schema;
 
   g_return_if_fail (DEE_IS_MODEL (self));
 
   iface = DEE_MODEL_GET_IFACE (self);
 
-  return (* iface->register_vardict_schema) (self, column, schemas);
+  (* iface->register_vardict_schema) (self, column, schemas);
+
+  /* Fields may have been overwritten, so look them up again */
+  schema = g_object_get_qdata (G_OBJECT (self), model_schema_quark ());
+  if (schema != NULL)
+    g_hash_table_remove_all (schema->fields);
 }
 
 /**
@@ -757,32 +817,212 @@ dee_model_end_changeset (DeeModel *self)
     g_signal_emit (self, dee_model_signals[DEE_MODEL_SIGNAL_CHANGESET_FINISHED], 0);
 }
 
-static GVariant*
-collect_variant (const gchar* col_schema, va_list *args)
+/*
+ * Compiled schemas
+ */
+
+static void
+column_desc_init (DeeColumnDesc *desc, const gchar *schema)
 {
-  const gchar *col_string;
-  GVariant    *result;
+  desc->schema = g_strdup (schema);
+  desc->type_code = schema[0];
+  desc->is_basic = g_variant_type_is_basic (G_VARIANT_TYPE (schema));
+  desc->is_vardict = g_variant_type_is_subtype_of (G_VARIANT_TYPE (schema),
+                                                   G_VARIANT_TYPE_VARDICT);
 
-  if (g_variant_type_is_basic (G_VARIANT_TYPE (col_schema)))
+  switch (desc->type_code)
     {
-      switch (col_schema[0])
-        {
-          case 's':
-          case 'o':
-          case 'g':
-            col_string = va_arg (*args, const gchar*);
-            result = g_variant_new (col_schema, col_string ? col_string : "");
-            break;
-          default:
-            result = g_variant_new_va (col_schema, NULL, args);
-        }
+      case 'b':
+      case 'y':
+        desc->fixed_size = 1;
+        break;
+      case 'n':
+      case 'q':
+        desc->fixed_size = 2;
+        break;
+      case 'i':
+      case 'u':
+      case 'h':
+        desc->fixed_size = 4;
+        break;
+      case 'x':
+      case 't':
+      case 'd':
+        desc->fixed_size = 8;
+        break;
+      default:
+        desc->fixed_size = 0;
     }
-  else
-    result = va_arg (*args, GVariant*);
+}
+
+static void
+field_desc_free (DeeFieldDesc *field)
+{
+  g_free (field->desc.schema);
+  g_slice_free (DeeFieldDesc, field);
+}
+
+static void
+model_schema_free (DeeModelSchema *schema)
+{
+  guint i;
+
+  for (i = 0; i < schema->n_columns; i++)
+    g_free (schema->columns[i].schema);
+
+  g_free (schema->columns);
+  g_hash_table_unref (schema->fields);
+  g_slice_free (DeeModelSchema, schema);
+}
+
+static GQuark
+model_schema_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("dee-model-schema");
+
+  return quark;
+}
+
+static DeeModelSchema*
+model_schema_compile (DeeModel *self)
+{
+  DeeModelSchema     *result;
+  const gchar *const *schema;
+  guint               i, n_cols;
+
+  schema = dee_model_get_schema (self, &n_cols);
+  if (schema == NULL)
+    return NULL;
+
+  result = g_slice_new (DeeModelSchema);
+  result->n_columns = n_cols;
+  result->columns = g_new (DeeColumnDesc, n_cols);
+  result->fields = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          (GDestroyNotify) field_desc_free);
+
+  for (i = 0; i < n_cols; i++)
+    column_desc_init (&result->columns[i], schema[i]);
+
+  g_object_set_qdata_full (G_OBJECT (self), model_schema_quark (), result,
+                           (GDestroyNotify) model_schema_free);
 
   return result;
 }
 
+/*
+ * Get the compiled schema of @self, or %NULL if @self has no schema yet.
+ * Models that get their schema from elsewhere, like proxies and filter
+ * models, have it compiled on first use. A schema can only be set once,
+ * so the result is valid for the lifetime of @self.
+ */
+DeeModelSchema*
+_dee_model_get_compiled_schema (DeeModel *self)
+{
+  DeeModelSchema *result;
+
+  result = g_object_get_qdata (G_OBJECT (self), model_schema_quark ());
+  if (G_LIKELY (result != NULL))
+    return result;
+
+  return model_schema_compile (self);
+}
+
+/*
+ * Look up a field of a vardict column registered with
+ * dee_model_register_vardict_schema(). Returns %NULL if there is no such
+ * field.
+ */
+const DeeFieldDesc*
+_dee_model_schema_lookup_field (DeeModel       *self,
+                                DeeModelSchema *schema,
+                                const gchar    *field_name)
+{
+  DeeFieldDesc *field;
+  const gchar  *field_schema;
+  guint         column;
+
+  field = g_hash_table_lookup (schema->fields, field_name);
+  if (field != NULL)
+    return field;
+
+  field_schema = dee_model_get_field_schema (self, field_name, &column);
+  if (field_schema == NULL)
+    return NULL;
+
+  field = g_slice_new (DeeFieldDesc);
+  field->column = column;
+  column_desc_init (&field->desc, field_schema);
+  g_hash_table_insert (schema->fields, g_strdup (field_name), field);
+
+  return field;
+}
+
+/*
+ * Check that @value has the type described by @desc. Cheaper than
+ * g_variant_is_of_type() since we never need to parse the column type.
+ */
+gboolean
+_dee_column_desc_check_value (const DeeColumnDesc *desc,
+                              GVariant            *value)
+{
+  const gchar *type_string;
+
+  type_string = g_variant_get_type_string (value);
+
+  if (desc->is_basic)
+    return type_string[0] == desc->type_code && type_string[1] == '\0';
+
+  return g_str_equal (type_string, desc->schema);
+}
+
+static GVariant*
+collect_variant (const DeeColumnDesc *desc, va_list *args)
+{
+  const gchar *col_string;
+
+  if (!desc->is_basic)
+    return va_arg (*args, GVariant*);
+
+  /* Types smaller than an int are promoted when passed through varargs */
+  switch (desc->type_code)
+    {
+      case 'b':
+        return g_variant_new_boolean (va_arg (*args, gboolean));
+      case 'y':
+        return g_variant_new_byte ((guchar) va_arg (*args, guint));
+      case 'n':
+        return g_variant_new_int16 ((gint16) va_arg (*args, gint));
+      case 'q':
+        return g_variant_new_uint16 ((guint16) va_arg (*args, guint));
+      case 'i':
+        return g_variant_new_int32 (va_arg (*args, gint32));
+      case 'u':
+        return g_variant_new_uint32 (va_arg (*args, guint32));
+      case 'h':
+        return g_variant_new_handle (va_arg (*args, gint32));
+      case 'x':
+        return g_variant_new_int64 (va_arg (*args, gint64));
+      case 't':
+        return g_variant_new_uint64 (va_arg (*args, guint64));
+      case 'd':
+        return g_variant_new_double (va_arg (*args, gdouble));
+      case 's':
+        col_string = va_arg (*args, const gchar*);
+        return g_variant_new_string (col_string ? col_string : "");
+      case 'o':
+        col_string = va_arg (*args, const gchar*);
+        return g_variant_new_object_path (col_string ? col_string : "");
+      case 'g':
+        col_string = va_arg (*args, const gchar*);
+        return g_variant_new_signature (col_string ? col_string : "");
+      default:
+        return g_variant_new_va (desc->schema, NULL, args);
+    }
+}
+
 /**
  * dee_model_build_row:
  * @self: The model to create a row for
@@ -846,22 +1086,20 @@ dee_model_build_row_valist (DeeModel  *self,
                             GVariant **out_row_members,
                             va_list   *args)
 {
-  guint         i, n_cols;
-  const gchar  *col_schema;
-  const gchar  *const *schema;
+  guint           i;
+  DeeModelSchema *schema;
 
   g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
 
-  schema = dee_model_get_schema (self, &n_cols);
+  schema = _dee_model_get_compiled_schema (self);
+  g_return_val_if_fail (schema != NULL, NULL);
 
   if (out_row_members == NULL)
-    out_row_members = g_new0 (GVariant*, n_cols);
+    out_row_members = g_new0 (GVariant*, schema->n_columns);
 
-  for (i = 0; i < n_cols; i++)
+  for (i = 0; i < schema->n_columns; i++)
     {
-      col_schema = schema[i];
-
-      out_row_members[i] = collect_variant (col_schema, args);
+      out_row_members[i] = collect_variant (&schema->columns[i], args);
 
       if (G_UNLIKELY (out_row_members[i] == NULL))
         {
@@ -1041,17 +1279,20 @@ dee_model_build_named_row_valist (DeeModel    *self,
                                   const gchar *first_column_name,
                                   va_list     *args)
 {
-  DeeModelIface    *iface;
-  guint             n_cols, i;
-  gint              col_idx, last_unset_col;
-  gboolean         *variant_set;
-  GVariantBuilder **builders;
-  const gchar      *col_name, *col_schema;
-  const gchar      *const *schema;
+  DeeModelIface      *iface;
+  DeeModelSchema     *schema;
+  const DeeFieldDesc *field;
+  guint               n_cols, i;
+  gint                col_idx, last_unset_col;
+  gboolean           *variant_set;
+  GVariantBuilder   **builders;
+  const gchar        *col_name;
 
   g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
 
-  schema = dee_model_get_schema (self, &n_cols);
+  schema = _dee_model_get_compiled_schema (self);
+  g_return_val_if_fail (schema != NULL, NULL);
+  n_cols = schema->n_columns;
 
   if (out_row_members == NULL)
     out_row_members = g_new0 (GVariant*, n_cols);
@@ -1070,9 +1311,8 @@ dee_model_build_named_row_valist (DeeModel    *self,
       col_idx = (* iface->get_column_index) (self, col_name);
       if (col_idx >= 0)
         {
-          col_schema = schema[col_idx];
-
-          out_row_members[col_idx] = collect_variant (col_schema, args);
+          out_row_members[col_idx] = collect_variant (&schema->columns[col_idx],
+                                                      args);
 
           if (G_UNLIKELY (out_row_members[col_idx] == NULL))
             {
@@ -1089,20 +1329,22 @@ dee_model_build_named_row_valist (DeeModel    *self,
       else
         {
           // check if we have hints
-          col_schema = (* iface->get_field_schema) (self, col_name, (guint*) &col_idx);
-          if (col_schema != NULL)
+          field = _dee_model_schema_lookup_field (self, schema, col_name);
+          if (field != NULL)
             {
               const gchar *key_name;
+              col_idx = field->column;
               if (builders[col_idx] == NULL)
                 {
-                  builders[col_idx] = g_variant_builder_new (G_VARIANT_TYPE (schema[col_idx]));
+                  builders[col_idx] = g_variant_builder_new (G_VARIANT_TYPE_VARDICT);
                 }
 
               key_name = strstr (col_name, "::");
               key_name = key_name != NULL ? key_name + 2 : col_name;
-              g_variant_builder_add (builders[col_idx], "{sv}",
-                                     key_name,
-                                     collect_variant (col_schema, args));
+              g_variant_builder_add_value (builders[col_idx],
+                  g_variant_new_dict_entry (g_variant_new_string (key_name),
+                      g_variant_new_variant (collect_variant (&field->desc,
+                                                              args))));
             }
           else
             {
@@ -1132,12 +1374,10 @@ dee_model_build_named_row_valist (DeeModel    *self,
       if (!variant_set[i])
         {
           /* Create empty a{sv} if needed */
-          if (g_variant_type_is_subtype_of (G_VARIANT_TYPE (schema[i]),
-                                            G_VARIANT_TYPE_VARDICT))
+          if (schema->columns[i].is_vardict)
             {
-              GVariantBuilder builder;
-              g_variant_builder_init (&builder, G_VARIANT_TYPE (schema[i]));
-              out_row_members[i] = g_variant_builder_end (&builder);
+              out_row_members[i] = g_variant_new_array (G_VARIANT_TYPE ("{sv}"),
+                                                        NULL, 0);
               variant_set[i] = TRUE;
             }
           else
@@ -1566,6 +1806,60 @@ dee_model_insert_row_before (DeeModel      *self,
   return (* iface->insert_row_before) (self, iter, row_members);
 }
 
+/**
+ * dee_model_insert_rows_before:
+ * @self: a #DeeModel
+ * @iter: An iter pointing to the row before which to insert the new ones
+ * @rows: (array length=n_rows): An array of @n_rows rows, each an array of
+ *        #GVariants with type signature matching those of the column schemas
+ *        of @self. Floating references will be consumed.
+ * @n_rows: The number of rows in @rows
+ *
+ * Inserts several consecutive rows before @iter in one go, keeping the order
+ * they have in @rows. A #DeeModel::row-added signal is still emitted for
+ * each of them, but models implementing this natively only validate the
+ * schema once and skip the per row dispatch of dee_model_insert_row_before().
+ * Wrap the call in dee_model_begin_changeset() and dee_model_end_changeset()
+ * to let listeners batch their work as well.
+ *
+ * The saving is limited to the insertion itself. A #DeeSharedModel hands
+ * the rows to its back end in one go, but still records and sends one
+ * change per row, since every row in a Commit carries its own seqnum.
+ *
+ * Returns: (transfer none) (type Dee.ModelIter): A #DeeModelIter pointing to
+ *          the first new row, or @iter if @n_rows is 0
+ **/
+DeeModelIter*
+dee_model_insert_rows_before (DeeModel      *self,
+                              DeeModelIter  *iter,
+                              GVariant    ***rows,
+                              guint          n_rows)
+{
+  DeeModelIface *iface;
+  DeeModelIter  *first;
+  guint          i;
+
+  g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
+  g_return_val_if_fail (iter != NULL, NULL);
+  g_return_val_if_fail (rows != NULL || n_rows == 0, NULL);
+
+  CHECK_SCHEMA (self, NULL, return NULL);
+
+  if (n_rows == 0)
+    return iter;
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->insert_rows_before != NULL)
+    return (* iface->insert_rows_before) (self, iter, rows, n_rows);
+
+  first = (* iface->insert_row_before) (self, iter, rows[0]);
+  for (i = 1; i < n_rows; i++)
+    (* iface->insert_row_before) (self, iter, rows[i]);
+
+  return first;
+}
+
 /* Translates DeeCompareRowFunc callback into DeeCompareRowSizedFunc */
 static gint
 dee_model_cmp_func_translate_func (GVariant **row1,
@@ -1861,6 +2155,225 @@ dee_model_remove (DeeModel     *self,
   (* iface->remove) (self, iter);
 }
 
+/**
+ * dee_model_move_before:
+ * @self: a #DeeModel
+ * @iter: a #DeeModelIter pointing to the row to move
+ * @before: a #DeeModelIter pointing to the row @iter should end up in front
+ *          of. Pass the iter returned by dee_model_get_last_iter() to move
+ *          the row to the end of the model
+ *
+ * Moves a row to just before another one. Unlike removing the row and
+ * inserting it again, models implementing this natively keep the row itself,
+ * its tags and @iter, and emit a single #DeeModel::row-moved signal.
+ *
+ * Models that don't implement it fall back to inserting a copy of the row
+ * and removing the original. In that case @iter and any tags set on the row
+ * are lost, so always continue with the returned iter.
+ *
+ * Returns: (transfer none) (type Dee.ModelIter): A #DeeModelIter pointing
+ *          to the row at its new position
+ */
+DeeModelIter*
+dee_model_move_before (DeeModel     *self,
+                       DeeModelIter *iter,
+                       DeeModelIter *before)
+{
+  DeeModelIface  *iface;
+  DeeModelIter   *new_iter;
+  GVariant      **row_members;
+  guint           n_cols, i;
+
+  g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
+  g_return_val_if_fail (iter != NULL, NULL);
+  g_return_val_if_fail (before != NULL, NULL);
+
+  CHECK_SCHEMA (self, &n_cols, return NULL);
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->move_before != NULL)
+    return (* iface->move_before) (self, iter, before);
+
+  /* Moving a row in front of itself or its successor is a no-op */
+  if (iter == before || dee_model_next (self, iter) == before)
+    return iter;
+
+  row_members = dee_model_get_row (self, iter, NULL);
+  new_iter = dee_model_insert_row_before (self, before, row_members);
+  dee_model_remove (self, iter);
+
+  for (i = 0; i < n_cols; i++)
+    g_variant_unref (row_members[i]);
+  g_free (row_members);
+
+  return new_iter;
+}
+
+typedef struct
+{
+  GVariant **row;
+  guint      pos;
+} SortRow;
+
+static gint
+sort_row_cmp (const SortRow *a, const SortRow *b, gpointer *data)
+{
+  DeeCompareRowFunc cmp_func = (DeeCompareRowFunc) data[0];
+
+  return cmp_func (a->row, b->row, data[1]);
+}
+
+/**
+ * dee_model_sort:
+ * @self: The model to sort
+ * @cmp_func: (scope call): Callback used for comparison of rows
+ * @user_data: (closure): Arbitrary pointer passed to @cmp_func
+ *
+ * Sorts the rows of @self in place. The sort is stable, so rows that
+ * compare equal keep their relative order. The rows, their tags and all
+ * iters stay valid, and the reordering is signalled with a single
+ * #DeeModel::rows-reordered signal. See dee_model_reorder() for models that
+ * can't reorder their rows natively.
+ *
+ * @cmp_func is only passed rows of @self and must not modify the model.
+ */
+void
+dee_model_sort (DeeModel          *self,
+                DeeCompareRowFunc  cmp_func,
+                gpointer           user_data)
+{
+  DeeModelIter  *iter;
+  GVariant     **row_members;
+  SortRow       *rows;
+  gpointer       data[2];
+  guint         *new_order;
+  guint          n_cols, n_rows, i;
+  gboolean       reordered;
+
+  g_return_if_fail (DEE_IS_MODEL (self));
+  g_return_if_fail (cmp_func != NULL);
+
+  CHECK_SCHEMA (self, &n_cols, return);
+
+  n_rows = dee_model_get_n_rows (self);
+  if (n_rows < 2)
+    return;
+
+  /* Peek all rows into one block. Nothing modifies the model before we
+   * are done comparing, so the borrowed references stay valid */
+  row_members = g_new (GVariant*, n_rows * n_cols);
+  rows = g_new (SortRow, n_rows);
+  iter = dee_model_get_first_iter (self);
+  for (i = 0; i < n_rows; i++)
+    {
+      rows[i].row = dee_model_peek_row (self, iter, row_members + i * n_cols);
+      rows[i].pos = i;
+      iter = dee_model_next (self, iter);
+    }
+
+  /* g_qsort_with_data() is stable, which is what makes this sort stable */
+  data[0] = cmp_func;
+  data[1] = user_data;
+  g_qsort_with_data (rows, n_rows, sizeof (SortRow),
+                     (GCompareDataFunc) sort_row_cmp, data);
+
+  new_order = g_new (guint, n_rows);
+  reordered = FALSE;
+  for (i = 0; i < n_rows; i++)
+    {
+      new_order[i] = rows[i].pos;
+      reordered |= rows[i].pos != i;
+    }
+
+  g_free (rows);
+  g_free (row_members);
+
+  if (reordered)
+    dee_model_reorder (self, new_order);
+
+  g_free (new_order);
+}
+
+/**
+ * dee_model_reorder:
+ * @self: The model to reorder
+ * @new_order: (array): An array of dee_model_get_n_rows() positions. Element
+ *             i is the current position of the row that should end up at
+ *             position i
+ *
+ * Rearranges the rows of @self. Models implementing this natively keep the
+ * rows, their tags and all iters, and emit a single
+ * #DeeModel::rows-reordered signal with @new_order.
+ *
+ * Models that don't implement it fall back to dee_model_move_before() for
+ * every row that is out of place, emitting a #DeeModel::row-moved signal
+ * for each of them.
+ */
+void
+dee_model_reorder (DeeModel    *self,
+                   const guint *new_order)
+{
+  DeeModelIface  *iface;
+  DeeModelIter  **iters;
+  DeeModelIter   *iter, *anchor;
+  gboolean       *seen;
+  guint           n_rows, i;
+
+  g_return_if_fail (DEE_IS_MODEL (self));
+  g_return_if_fail (new_order != NULL);
+
+  CHECK_SCHEMA (self, NULL, return);
+
+  n_rows = dee_model_get_n_rows (self);
+
+  /* A broken permutation would lose or duplicate rows */
+  seen = g_new0 (gboolean, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      if (new_order[i] >= n_rows || seen[new_order[i]])
+        {
+          g_critical ("Can not reorder %s@%p: the new order is not a "
+                      "permutation of the %u rows of the model",
+                      G_OBJECT_TYPE_NAME (self), self, n_rows);
+          g_free (seen);
+          return;
+        }
+      seen[new_order[i]] = TRUE;
+    }
+  g_free (seen);
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->reorder != NULL)
+    {
+      (* iface->reorder) (self, new_order);
+      return;
+    }
+
+  iters = g_new (DeeModelIter*, n_rows);
+  iter = dee_model_get_first_iter (self);
+  for (i = 0; i < n_rows; i++)
+    {
+      iters[i] = iter;
+      iter = dee_model_next (self, iter);
+    }
+
+  /* Everything before anchor is in its final place. Moving rows in front
+   * of anchor never invalidates it, nor the iters of the rows still to be
+   * placed */
+  anchor = iters[0];
+  for (i = 0; i < n_rows; i++)
+    {
+      if (iters[new_order[i]] == anchor)
+        anchor = dee_model_next (self, anchor);
+      else
+        dee_model_move_before (self, iters[new_order[i]], anchor);
+    }
+
+  g_free (iters);
+}
+
 /**
  * dee_model_clear:
  * @self: a #DeeModel object to clear
@@ -2075,17 +2588,19 @@ dee_model_get_valist (DeeModel       *self,
                       DeeModelIter   *iter,
                       va_list         args)
 {
-  GVariant           *val;
-  const GVariantType *val_t;
-  guint               col, n_cols;
-  gpointer           *col_data;
+  GVariant            *val;
+  DeeModelSchema      *schema;
+  const DeeColumnDesc *desc;
+  guint                col;
+  gpointer            *col_data;
 
   g_return_if_fail (DEE_IS_MODEL (self));
   g_return_if_fail (iter != NULL);
 
-  n_cols = dee_model_get_n_columns (self);
+  schema = _dee_model_get_compiled_schema (self);
+  g_return_if_fail (schema != NULL);
 
-  for (col = 0; col < n_cols; col++)
+  for (col = 0; col < schema->n_columns; col++)
     {
       col_data = va_arg (args, gpointer*);
 
@@ -2095,32 +2610,60 @@ dee_model_get_valist (DeeModel       *self,
           continue;
         }
 
-      val = dee_model_get_value (self, iter, col);
-      val_t = g_variant_get_type (val);
+      val = dee_model_peek_value (self, iter, col);
+      desc = &schema->columns[col];
 
       /* Basic types are passed back unboxed, and non-basic types are passed
        * back wrapped in variants. Strings are special because we pass them
        * back without copying them */
-      if (g_variant_type_is_basic (val_t))
+      if (desc->is_basic)
         {
-          if (g_variant_type_equal (val_t, G_VARIANT_TYPE_SIGNATURE) ||
-              g_variant_type_equal (val_t, G_VARIANT_TYPE_STRING) ||
-              g_variant_type_equal (val_t, G_VARIANT_TYPE_OBJECT_PATH))
+          switch (desc->type_code)
             {
-              /* We need to cast away the constness */
-              *col_data = (gpointer) g_variant_get_string (val, NULL);
+              case 'b':
+                *((gboolean*) col_data) = g_variant_get_boolean (val);
+                break;
+              case 'y':
+                *((guchar*) col_data) = g_variant_get_byte (val);
+                break;
+              case 'n':
+                *((gint16*) col_data) = g_variant_get_int16 (val);
+                break;
+              case 'q':
+                *((guint16*) col_data) = g_variant_get_uint16 (val);
+                break;
+              case 'i':
+                *((gint32*) col_data) = g_variant_get_int32 (val);
+                break;
+              case 'u':
+                *((guint32*) col_data) = g_variant_get_uint32 (val);
+                break;
+              case 'h':
+                *((gint32*) col_data) = g_variant_get_handle (val);
+                break;
+              case 'x':
+                *((gint64*) col_data) = g_variant_get_int64 (val);
+                break;
+              case 't':
+                *((guint64*) col_data) = g_variant_get_uint64 (val);
+                break;
+              case 'd':
+                *((gdouble*) col_data) = g_variant_get_double (val);
+                break;
+              case 's':
+              case 'o':
+              case 'g':
+                /* We need to cast away the constness */
+                *col_data = (gpointer) g_variant_get_string (val, NULL);
+                break;
+              default:
+                g_variant_get (val, desc->schema, col_data);
             }
-          else
-            g_variant_get (val, dee_model_get_column_schema (self, col),
-                           col_data);
-
-          /* dee_model_get_value() returns a ref we need to free */
-          g_variant_unref (val);
         }
       else
         {
-          /* For complex types the ref on val is transfered to the caller */
-          *col_data = val;
+          /* For complex types the caller gets a ref of its own */
+          *col_data = g_variant_ref (val);
         }
     }
 }
@@ -2177,6 +2720,88 @@ dee_model_get_value (DeeModel     *self,
   return (* iface->get_value) (self, iter, column);
 }
 
+/**
+ * dee_model_peek_value:
+ * @self: The #DeeModel to inspect
+ * @iter: a #DeeModelIter pointing to the row to inspect
+ * @column: column number to retrieve the value from
+ *
+ * Like dee_model_get_value(), but returns a borrowed reference. This saves
+ * the reference counting when scanning over many cells.
+ *
+ * The returned value is only valid until @self is modified. Call
+ * g_variant_ref() on it if you need to keep it around for longer.
+ *
+ * Returns: (transfer none): The #GVariant in @column of the row @iter
+ *          points to. Do not unref it
+ */
+GVariant*
+dee_model_peek_value (DeeModel     *self,
+                      DeeModelIter *iter,
+                      guint         column)
+{
+  DeeModelIface *iface;
+  GVariant      *value;
+
+  g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->peek_value)
+    return (* iface->peek_value) (self, iter, column);
+
+  /* Models that don't implement peek_value() still hold a reference on the
+   * values they store, which keeps the value alive after our unref */
+  value = (* iface->get_value) (self, iter, column);
+  if (value != NULL)
+    g_variant_unref (value);
+
+  return value;
+}
+
+/**
+ * dee_model_peek_row:
+ * @self: A #DeeModel to get a row from
+ * @iter: A #DeeModelIter pointing to the row to get
+ * @out_row_members: (array) (out) (allow-none) (default NULL):
+ *                   An array of variants with a length bigger than or equal to
+ *                   the number of columns in @self, or %NULL. If you pass
+ *                   %NULL here a new array will be allocated for you
+ *
+ * Like dee_model_get_row(), but fills @out_row_members with borrowed
+ * references. The variants are only valid until @self is modified, see
+ * dee_model_peek_value().
+ *
+ * Returns: (array zero-terminated=1) (transfer container): @out_row_members
+ *          if it was not %NULL or a newly allocated array otherwise which you
+ *          must free with g_free(). Do not unref the variants in the array
+ */
+GVariant**
+dee_model_peek_row (DeeModel      *self,
+                    DeeModelIter  *iter,
+                    GVariant     **out_row_members)
+{
+  DeeModelIface *iface;
+  guint          col, n_cols;
+
+  g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->peek_row)
+    return (* iface->peek_row) (self, iter, out_row_members);
+
+  n_cols = dee_model_get_n_columns (self);
+
+  if (out_row_members == NULL)
+    out_row_members = g_new0 (GVariant*, n_cols + 1);
+
+  for (col = 0; col < n_cols; col++)
+    out_row_members[col] = dee_model_peek_value (self, iter, col);
+
+  return out_row_members;
+}
+
 /**
  * dee_model_get_value_by_name:
  * @self: The #DeeModel to inspect
@@ -2572,6 +3197,195 @@ dee_model_get_position (DeeModel     *self,
   return (* iface->get_position) (self, iter);
 }
 
+typedef struct
+{
+  guint          column;
+  GVariant      *value;
+  DeeModelIter  *match;
+} FindByValueData;
+
+static gboolean
+find_by_value_cb (DeeModel     *self,
+                  DeeModelIter *iter,
+                  gpointer      user_data)
+{
+  FindByValueData *data = (FindByValueData *) user_data;
+
+  if (!g_variant_equal (dee_model_peek_value (self, iter, data->column),
+                        data->value))
+    return FALSE;
+
+  data->match = iter;
+  return TRUE;
+}
+
+/**
+ * dee_model_find_by_value:
+ * @self: The model to search
+ * @column: The column to match @value against
+ * @value: The value to look for. If @value is floating the model
+ *         will take ownership of it
+ *
+ * Find the first row in @self where @column is equal to @value, according
+ * to g_variant_equal().
+ *
+ * If a #DeeColumnIndex exists for @column in @self it will be used to answer
+ * the query, otherwise this method does a linear scan of the model.
+ *
+ * Returns: (transfer none): A #DeeModelIter pointing to the first matching
+ *          row or %NULL in case no rows match @value
+ */
+DeeModelIter*
+dee_model_find_by_value (DeeModel *self,
+                         guint     column,
+                         GVariant *value)
+{
+  DeeColumnIndex  *index;
+  DeeModelIter    *iter;
+  FindByValueData  data;
+
+  g_return_val_if_fail (DEE_IS_MODEL (self), NULL);
+  g_return_val_if_fail (value != NULL, NULL);
+
+  g_variant_ref_sink (value);
+
+  index = dee_column_index_find (self, column);
+  if (index != NULL)
+    {
+      iter = dee_column_index_lookup_one (index, value);
+      g_variant_unref (value);
+      return iter;
+    }
+
+  data.column = column;
+  data.value = value;
+  data.match = NULL;
+  dee_model_foreach_range (self, NULL, NULL, find_by_value_cb, &data);
+
+  g_variant_unref (value);
+
+  return data.match;
+}
+
+/**
+ * dee_model_foreach_range:
+ * @self: The model to walk
+ * @start: (allow-none): The first row to visit, or %NULL to start at the
+ *         first row of @self
+ * @end: (allow-none): The row to stop at, this row is not visited. Pass
+ *       %NULL to walk to the end of @self
+ * @func: (scope call): Function to call for each row
+ * @user_data: (closure): Data to pass to @func
+ *
+ * Calls @func for each row from @start up to, but not including, @end.
+ * The walk stops early if @func returns %TRUE.
+ *
+ * Models walk their own storage directly when doing this, so this is
+ * considerably cheaper than a loop over dee_model_next() and
+ * dee_model_is_last(). @func must not modify @self.
+ */
+void
+dee_model_foreach_range (DeeModel         *self,
+                         DeeModelIter     *start,
+                         DeeModelIter     *end,
+                         DeeModelIterFunc  func,
+                         gpointer          user_data)
+{
+  DeeModelIface *iface;
+  DeeModelIter  *iter;
+
+  g_return_if_fail (DEE_IS_MODEL (self));
+  g_return_if_fail (func != NULL);
+
+  if (start == NULL)
+    start = dee_model_get_first_iter (self);
+  if (end == NULL)
+    end = dee_model_get_last_iter (self);
+
+  iface = DEE_MODEL_GET_IFACE (self);
+
+  if (iface->foreach_range)
+    {
+      (* iface->foreach_range) (self, start, end, func, user_data);
+      return;
+    }
+
+  for (iter = start;
+       iter != end && !dee_model_is_last (self, iter);
+       iter = dee_model_next (self, iter))
+    {
+      if (func (self, iter, user_data))
+        break;
+    }
+}
+
+/* The number of iters handed to a DeeModelChunkFunc at a time */
+#define FOREACH_CHUNK_SIZE 256
+
+typedef struct
+{
+  DeeModelChunkFunc  func;
+  gpointer           user_data;
+  DeeModelIter      *iters[FOREACH_CHUNK_SIZE];
+  guint              n_iters;
+  gboolean           stopped;
+} ForeachChunkData;
+
+static gboolean
+foreach_chunk_cb (DeeModel     *self,
+                  DeeModelIter *iter,
+                  gpointer      user_data)
+{
+  ForeachChunkData *data = (ForeachChunkData *) user_data;
+
+  data->iters[data->n_iters++] = iter;
+  if (data->n_iters < FOREACH_CHUNK_SIZE)
+    return FALSE;
+
+  data->stopped = data->func (self, data->iters, data->n_iters,
+                              data->user_data);
+  data->n_iters = 0;
+
+  return data->stopped;
+}
+
+/**
+ * dee_model_foreach_range_chunked:
+ * @self: The model to walk
+ * @start: (allow-none): The first row to visit, or %NULL to start at the
+ *         first row of @self
+ * @end: (allow-none): The row to stop at, this row is not visited. Pass
+ *       %NULL to walk to the end of @self
+ * @func: (scope call): Function to call for each chunk of rows
+ * @user_data: (closure): Data to pass to @func
+ *
+ * Like dee_model_foreach_range(), but hands @func the rows in arrays of
+ * up to a few hundred iters at a time. This amortizes the cost of the
+ * callback for tight loops over many rows.
+ */
+void
+dee_model_foreach_range_chunked (DeeModel          *self,
+                                 DeeModelIter      *start,
+                                 DeeModelIter      *end,
+                                 DeeModelChunkFunc  func,
+                                 gpointer           user_data)
+{
+  ForeachChunkData data;
+
+  g_return_if_fail (DEE_IS_MODEL (self));
+  g_return_if_fail (func != NULL);
+
+  data.func = func;
+  data.user_data = user_data;
+  data.n_iters = 0;
+  data.stopped = FALSE;
+
+  dee_model_foreach_range (self, start, end, foreach_chunk_cb, &data);
+
+  if (!data.stopped && data.n_iters > 0)
+    func (self, data.iters, data.n_iters, user_data);
+}
+
 /**
  * dee_model_register_tag:
  * @self: The model to register a tag on
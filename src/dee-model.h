@@ -99,6 +99,39 @@ typedef gint          (*DeeCompareRowSizedFunc) (GVariant** row1,
                                                  guint row2_length,
                                                  gpointer user_data);
 
+/**
+ * DeeModelIterFunc:
+ * @model: The model being walked
+ * @iter: A #DeeModelIter pointing to the current row
+ * @user_data: (closure): User data passed to dee_model_foreach_range()
+ *
+ * Called for each row by dee_model_foreach_range(). It must not modify
+ * @model.
+ *
+ * Returns: %TRUE to stop walking the model, %FALSE to continue
+ */
+typedef gboolean      (*DeeModelIterFunc) (DeeModel     *model,
+                                           DeeModelIter *iter,
+                                           gpointer      user_data);
+
+/**
+ * DeeModelChunkFunc:
+ * @model: The model being walked
+ * @iters: (array length=n_iters): The rows in this chunk
+ * @n_iters: The number of rows in @iters
+ * @user_data: (closure): User data passed to
+ *             dee_model_foreach_range_chunked()
+ *
+ * Called for each chunk of rows by dee_model_foreach_range_chunked(). It
+ * must not modify @model, and @iters is only valid during the call.
+ *
+ * Returns: %TRUE to stop walking the model, %FALSE to continue
+ */
+typedef gboolean      (*DeeModelChunkFunc) (DeeModel      *model,
+                                            DeeModelIter **iters,
+                                            guint          n_iters,
+                                            gpointer       user_data);
+
 struct _DeeModelIface
 {
   GTypeInterface g_iface;
@@ -274,6 +307,39 @@ struct _DeeModelIface
 
   void           (*changeset_finished) (DeeModel    *self);
 
+  GVariant*      (*peek_value)      (DeeModel       *self,
+                                     DeeModelIter   *iter,
+                                     guint           column);
+
+  GVariant**     (*peek_row)        (DeeModel       *self,
+                                     DeeModelIter   *iter,
+                                     GVariant      **out_row_members);
+
+  void           (*foreach_range)   (DeeModel         *self,
+                                     DeeModelIter     *start,
+                                     DeeModelIter     *end,
+                                     DeeModelIterFunc  func,
+                                     gpointer          user_data);
+
+  void           (*row_moved)       (DeeModel     *self,
+                                     DeeModelIter *iter,
+                                     guint         old_position);
+
+  DeeModelIter*  (*move_before)     (DeeModel     *self,
+                                     DeeModelIter *iter,
+                                     DeeModelIter *before);
+
+  void           (*rows_reordered)  (DeeModel     *self,
+                                     const guint  *new_order);
+
+  void           (*reorder)         (DeeModel     *self,
+                                     const guint  *new_order);
+
+  DeeModelIter*  (*insert_rows_before) (DeeModel     *self,
+                                        DeeModelIter *iter,
+                                        GVariant   ***rows,
+                                        guint         n_rows);
+
   /*< private >*/
   void     (*_dee_model_1) (void);
   void     (*_dee_model_2) (void);
@@ -361,6 +427,11 @@ DeeModelIter*   dee_model_insert_row_before (DeeModel     *self,
                                              DeeModelIter *iter,
                                              GVariant    **row_members);
 
+DeeModelIter*   dee_model_insert_rows_before (DeeModel     *self,
+                                              DeeModelIter *iter,
+                                              GVariant   ***rows,
+                                              guint         n_rows);
+
 DeeModelIter*   dee_model_insert_row_sorted (DeeModel           *self,
                                              GVariant          **row_members,
                                              DeeCompareRowFunc   cmp_func,
@@ -397,6 +468,17 @@ DeeModelIter*   dee_model_find_sorted    (DeeModel           *self,
 void            dee_model_remove          (DeeModel     *self,
                                            DeeModelIter *iter);
 
+DeeModelIter*   dee_model_move_before     (DeeModel     *self,
+                                           DeeModelIter *iter,
+                                           DeeModelIter *before);
+
+void            dee_model_sort            (DeeModel          *self,
+                                           DeeCompareRowFunc  cmp_func,
+                                           gpointer           user_data);
+
+void            dee_model_reorder         (DeeModel     *self,
+                                           const guint  *new_order);
+
 void            dee_model_clear           (DeeModel *self);
 
 void            dee_model_set             (DeeModel     *self,
@@ -424,6 +506,14 @@ GVariant*       dee_model_get_value       (DeeModel     *self,
                                            DeeModelIter *iter,
                                            guint         column);
 
+GVariant*       dee_model_peek_value      (DeeModel     *self,
+                                           DeeModelIter *iter,
+                                           guint         column);
+
+GVariant**      dee_model_peek_row        (DeeModel      *self,
+                                           DeeModelIter  *iter,
+                                           GVariant     **out_row_members);
+
 GVariant*       dee_model_get_value_by_name (DeeModel     *self,
                                              DeeModelIter *iter,
                                              const gchar  *column_name);
@@ -482,6 +572,22 @@ gboolean        dee_model_is_last         (DeeModel     *self,
 guint           dee_model_get_position    (DeeModel     *self,
                                            DeeModelIter *iter);
 
+DeeModelIter*   dee_model_find_by_value   (DeeModel     *self,
+                                           guint         column,
+                                           GVariant     *value);
+
+void            dee_model_foreach_range   (DeeModel         *self,
+                                           DeeModelIter     *start,
+                                           DeeModelIter     *end,
+                                           DeeModelIterFunc  func,
+                                           gpointer          user_data);
+
+void            dee_model_foreach_range_chunked (DeeModel          *self,
+                                                 DeeModelIter      *start,
+                                                 DeeModelIter      *end,
+                                                 DeeModelChunkFunc  func,
+                                                 gpointer           user_data);
+
 DeeModelTag*    dee_model_register_tag    (DeeModel       *self,
                                            GDestroyNotify  tag_destroy);
 
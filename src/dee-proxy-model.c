@@ -81,6 +81,8 @@ struct _DeeProxyModelPrivate
   gulong     row_added_handler;
   gulong     row_removed_handler;
   gulong     row_changed_handler;
+  gulong     row_moved_handler;
+  gulong     rows_reordered_handler;
   gulong     changeset_started_handler;
   gulong     changeset_finished_handler;
 };
@@ -156,6 +158,18 @@ static DeeModelIter*  dee_proxy_model_find_row_sorted (DeeModel           *self,
 static void           dee_proxy_model_remove         (DeeModel     *self,
                                                       DeeModelIter *iter);
 
+static DeeModelIter*  dee_proxy_model_move_before    (DeeModel     *self,
+                                                      DeeModelIter *iter,
+                                                      DeeModelIter *before);
+
+static void           dee_proxy_model_reorder        (DeeModel     *self,
+                                                      const guint  *new_order);
+
+static DeeModelIter*  dee_proxy_model_insert_rows_before (DeeModel     *self,
+                                                          DeeModelIter *iter,
+                                                          GVariant   ***rows,
+                                                          guint         n_rows);
+
 static void           dee_proxy_model_set_value      (DeeModel       *self,
                                                       DeeModelIter   *iter,
                                                       guint           column,
@@ -169,6 +183,14 @@ static GVariant*      dee_proxy_model_get_value      (DeeModel     *self,
                                                       DeeModelIter *iter,
                                                       guint          column);
 
+static GVariant*      dee_proxy_model_peek_value     (DeeModel     *self,
+                                                      DeeModelIter *iter,
+                                                      guint          column);
+
+static GVariant**     dee_proxy_model_peek_row       (DeeModel      *self,
+                                                      DeeModelIter  *iter,
+                                                      GVariant     **out_row_members);
+
 static DeeModelIter* dee_proxy_model_get_first_iter  (DeeModel     *self);
 
 static DeeModelIter* dee_proxy_model_get_last_iter   (DeeModel     *self);
@@ -223,6 +245,12 @@ static gboolean       dee_proxy_model_is_last        (DeeModel     *self,
 static guint          dee_proxy_model_get_position   (DeeModel     *self,
                                                       DeeModelIter *iter);
 
+static void           dee_proxy_model_foreach_range  (DeeModel         *self,
+                                                      DeeModelIter     *start,
+                                                      DeeModelIter     *end,
+                                                      DeeModelIterFunc  func,
+                                                      gpointer          user_data);
+
 static DeeModelTag*   dee_proxy_model_register_tag   (DeeModel       *self,
                                                       GDestroyNotify  tag_destroy);
 
@@ -251,6 +279,13 @@ static void           on_back_end_row_removed        (DeeProxyModel *self,
 static void           on_back_end_row_changed        (DeeProxyModel *self,
                                                       DeeModelIter  *iter);
 
+static void           on_back_end_row_moved          (DeeProxyModel *self,
+                                                      DeeModelIter  *iter,
+                                                      guint          old_position);
+
+static void           on_back_end_rows_reordered     (DeeProxyModel *self,
+                                                      const guint   *new_order);
+
 static void           on_back_end_changeset_started  (DeeProxyModel *self,
                                                       DeeModel *model);
 
@@ -282,6 +317,10 @@ dee_proxy_model_finalize (GObject *object)
         g_signal_handler_disconnect (priv->back_end, priv->row_removed_handler);
       if (priv->row_changed_handler != 0)
         g_signal_handler_disconnect (priv->back_end, priv->row_changed_handler);
+      if (priv->row_moved_handler != 0)
+        g_signal_handler_disconnect (priv->back_end, priv->row_moved_handler);
+      if (priv->rows_reordered_handler != 0)
+        g_signal_handler_disconnect (priv->back_end, priv->rows_reordered_handler);
       if (priv->changeset_started_handler != 0)
         g_signal_handler_disconnect (priv->back_end, priv->changeset_started_handler);
       if (priv->changeset_finished_handler != 0)
@@ -318,6 +357,12 @@ dee_proxy_model_constructed (GObject *object)
       priv->row_changed_handler =
         g_signal_connect_swapped (priv->back_end, "row-changed",
                                   G_CALLBACK (on_back_end_row_changed), object);
+      priv->row_moved_handler =
+        g_signal_connect_swapped (priv->back_end, "row-moved",
+                                  G_CALLBACK (on_back_end_row_moved), object);
+      priv->rows_reordered_handler =
+        g_signal_connect_swapped (priv->back_end, "rows-reordered",
+                                  G_CALLBACK (on_back_end_rows_reordered), object);
 
       priv->changeset_started_handler =
         g_signal_connect_swapped (priv->back_end, "changeset-started",
@@ -466,9 +511,14 @@ dee_proxy_model_model_iface_init (DeeModelIface *iface)
   iface->insert_row_sorted     = dee_proxy_model_insert_row_sorted;
   iface->find_row_sorted       = dee_proxy_model_find_row_sorted;
   iface->remove                = dee_proxy_model_remove;
+  iface->move_before           = dee_proxy_model_move_before;
+  iface->reorder               = dee_proxy_model_reorder;
+  iface->insert_rows_before    = dee_proxy_model_insert_rows_before;
   iface->set_value             = dee_proxy_model_set_value;
   iface->set_row               = dee_proxy_model_set_row;
   iface->get_value             = dee_proxy_model_get_value;
+  iface->peek_value            = dee_proxy_model_peek_value;
+  iface->peek_row              = dee_proxy_model_peek_row;
   iface->get_first_iter        = dee_proxy_model_get_first_iter;
   iface->get_last_iter         = dee_proxy_model_get_last_iter;
   iface->get_iter_at_row       = dee_proxy_model_get_iter_at_row;
@@ -485,6 +535,7 @@ dee_proxy_model_model_iface_init (DeeModelIface *iface)
   iface->is_first              = dee_proxy_model_is_first;
   iface->is_last               = dee_proxy_model_is_last;
   iface->get_position          = dee_proxy_model_get_position;
+  iface->foreach_range         = dee_proxy_model_foreach_range;
   iface->register_tag          = dee_proxy_model_register_tag;
   iface->get_tag               = dee_proxy_model_get_tag;
   iface->set_tag               = dee_proxy_model_set_tag;
@@ -507,6 +558,8 @@ dee_proxy_model_init (DeeProxyModel *model)
   priv->row_added_handler = 0;
   priv->row_removed_handler = 0;
   priv->row_changed_handler = 0;
+  priv->row_moved_handler = 0;
+  priv->rows_reordered_handler = 0;
   priv->changeset_started_handler = 0;
   priv->changeset_finished_handler = 0;
 }
@@ -709,6 +762,37 @@ dee_proxy_model_remove (DeeModel     *self,
   dee_model_remove (DEE_PROXY_MODEL_BACK_END (self), iter);
 }
 
+static DeeModelIter*
+dee_proxy_model_move_before (DeeModel     *self,
+                             DeeModelIter *iter,
+                             DeeModelIter *before)
+{
+  g_return_val_if_fail (DEE_IS_PROXY_MODEL (self), NULL);
+
+  return dee_model_move_before (DEE_PROXY_MODEL_BACK_END (self), iter, before);
+}
+
+static void
+dee_proxy_model_reorder (DeeModel    *self,
+                         const guint *new_order)
+{
+  g_return_if_fail (DEE_IS_PROXY_MODEL (self));
+
+  dee_model_reorder (DEE_PROXY_MODEL_BACK_END (self), new_order);
+}
+
+static DeeModelIter*
+dee_proxy_model_insert_rows_before (DeeModel      *self,
+                                    DeeModelIter  *iter,
+                                    GVariant    ***rows,
+                                    guint          n_rows)
+{
+  g_return_val_if_fail (DEE_IS_PROXY_MODEL (self), NULL);
+
+  return dee_model_insert_rows_before (DEE_PROXY_MODEL_BACK_END (self),
+                                       iter, rows, n_rows);
+}
+
 static void
 dee_proxy_model_set_row (DeeModel       *self,
                          DeeModelIter   *iter,
@@ -740,6 +824,27 @@ dee_proxy_model_get_value (DeeModel     *self,
   return dee_model_get_value (DEE_PROXY_MODEL_BACK_END (self), iter, column);
 }
 
+static GVariant*
+dee_proxy_model_peek_value (DeeModel     *self,
+                            DeeModelIter *iter,
+                            guint         column)
+{
+  g_return_val_if_fail (DEE_IS_PROXY_MODEL (self), NULL);
+
+  return dee_model_peek_value (DEE_PROXY_MODEL_BACK_END (self), iter, column);
+}
+
+static GVariant**
+dee_proxy_model_peek_row (DeeModel      *self,
+                          DeeModelIter  *iter,
+                          GVariant     **out_row_members)
+{
+  g_return_val_if_fail (DEE_IS_PROXY_MODEL (self), NULL);
+
+  return dee_model_peek_row (DEE_PROXY_MODEL_BACK_END (self), iter,
+                             out_row_members);
+}
+
 static gboolean
 dee_proxy_model_get_bool (DeeModel      *self,
                           DeeModelIter  *iter,
@@ -891,6 +996,43 @@ dee_proxy_model_get_position (DeeModel     *self,
   return dee_model_get_position (DEE_PROXY_MODEL_BACK_END (self), iter);
 }
 
+typedef struct
+{
+  DeeModel         *self;
+  DeeModelIterFunc  func;
+  gpointer          user_data;
+} ProxyForeachData;
+
+/* Hand the rows of the back end to the callback as our own */
+static gboolean
+proxy_foreach_cb (DeeModel     *back_end,
+                  DeeModelIter *iter,
+                  gpointer      user_data)
+{
+  ProxyForeachData *data = (ProxyForeachData *) user_data;
+
+  return data->func (data->self, iter, data->user_data);
+}
+
+static void
+dee_proxy_model_foreach_range (DeeModel         *self,
+                               DeeModelIter     *start,
+                               DeeModelIter     *end,
+                               DeeModelIterFunc  func,
+                               gpointer          user_data)
+{
+  ProxyForeachData data;
+
+  g_return_if_fail (DEE_IS_PROXY_MODEL (self));
+
+  data.self = self;
+  data.func = func;
+  data.user_data = user_data;
+
+  dee_model_foreach_range (DEE_PROXY_MODEL_BACK_END (self), start, end,
+                           proxy_foreach_cb, &data);
+}
+
 static DeeModelTag*
 dee_proxy_model_register_tag    (DeeModel       *self,
                                  GDestroyNotify  tag_destroy)
@@ -962,6 +1104,21 @@ on_back_end_row_changed (DeeProxyModel *self,
   g_signal_emit_by_name (self, "row-changed", iter);
 }
 
+static void
+on_back_end_row_moved (DeeProxyModel *self,
+                       DeeModelIter  *iter,
+                       guint          old_position)
+{
+  g_signal_emit_by_name (self, "row-moved", iter, old_position);
+}
+
+static void
+on_back_end_rows_reordered (DeeProxyModel *self,
+                            const guint   *new_order)
+{
+  g_signal_emit_by_name (self, "rows-reordered", new_order);
+}
+
 static void
 on_back_end_changeset_started (DeeProxyModel *self,
                                DeeModel *model)
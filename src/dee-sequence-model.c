@@ -32,6 +32,10 @@
  * dee_model_insert_sorted() and dee_model_find_sorted() methods use the
  * underlying tree structure to guarantee a <emphasis>O(log(N))</emphasis>
  * profile.
+ *
+ * Models where many rows repeat the same few strings, like category ids or
+ * mime types, can set the #DeeSequenceModel:intern-strings property. Equal
+ * values in string columns will then share a single #GVariant.
  */
 #ifdef HAVE_CONFIG_H
 #include <config.h>
@@ -44,6 +48,7 @@
 #include "dee-model.h"
 #include "dee-serializable-model.h"
 #include "dee-sequence-model.h"
+#include "dee-model-schema.h"
 #include "dee-marshal.h"
 #include "trace-log.h"
 
@@ -62,6 +67,8 @@ G_DEFINE_TYPE_WITH_CODE (DeeSequenceModel,
 static guint sigid_row_added;
 static guint sigid_row_removed;
 static guint sigid_row_changed;
+static guint sigid_row_moved;
+static guint sigid_rows_reordered;
 
 /**
  * DeeSequenceModelPrivate:
@@ -83,6 +90,27 @@ struct _DeeSequenceModelPrivate
 
   /* Flag marking if we are in a transaction */
   gboolean   setting_many;
+
+  /* The compiled schema. It's owned by the model and looked up on the
+   * first write since the schema can only be set once */
+  DeeModelSchema *schema;
+
+  /* Dictionary of interned string values. Maps a GVariant to the
+   * InternedValue holding it. Created when interning is first enabled */
+  gboolean    intern_strings;
+  GHashTable *strings;
+};
+
+typedef struct
+{
+  GVariant *value;
+  guint     ref_count; // number of cells holding the value
+} InternedValue;
+
+enum
+{
+  PROP_0,
+  PROP_INTERN_STRINGS
 };
 
 /*
@@ -100,6 +128,11 @@ static DeeModelIter*  dee_sequence_model_insert_row_before (DeeModel     *self,
                                                             DeeModelIter *iter,
                                                             GVariant **row_members);
 
+static DeeModelIter*  dee_sequence_model_insert_rows_before (DeeModel     *self,
+                                                             DeeModelIter *iter,
+                                                             GVariant   ***rows,
+                                                             guint         n_rows);
+
 static DeeModelIter*  dee_sequence_model_find_row_sorted (DeeModel           *self,
                                                           GVariant          **row_spec,
                                                           DeeCompareRowFunc   cmp_func,
@@ -109,6 +142,13 @@ static DeeModelIter*  dee_sequence_model_find_row_sorted (DeeModel           *se
 static void           dee_sequence_model_remove         (DeeModel     *self,
                                                          DeeModelIter *iter);
 
+static DeeModelIter*  dee_sequence_model_move_before    (DeeModel     *self,
+                                                         DeeModelIter *iter,
+                                                         DeeModelIter *before);
+
+static void           dee_sequence_model_reorder        (DeeModel     *self,
+                                                         const guint  *new_order);
+
 static void           dee_sequence_model_set_row     (DeeModel       *self,
                                                       DeeModelIter   *iter,
                                                       GVariant      **row_members);
@@ -118,11 +158,11 @@ static void           dee_sequence_model_set_value      (DeeModel       *self,
                                                          guint           column,
                                                          GVariant       *value);
 
-static void           dee_sequence_model_set_value_silently (DeeModel       *self,
-                                                             DeeModelIter   *iter,
-                                                             guint           column,
-                                                             const gchar    *col_schema,
-                                                             GVariant       *value);
+static void           dee_sequence_model_set_value_silently (DeeModel            *self,
+                                                             DeeModelIter        *iter,
+                                                             guint                column,
+                                                             const DeeColumnDesc *desc,
+                                                             GVariant            *value);
 
 
 static GVariant*     dee_sequence_model_get_value      (DeeModel     *self,
@@ -133,6 +173,14 @@ static GVariant**    dee_sequence_model_get_row        (DeeModel     *self,
                                                         DeeModelIter *iter,
                                                         GVariant    **out_row_members);
 
+static GVariant*     dee_sequence_model_peek_value     (DeeModel     *self,
+                                                        DeeModelIter *iter,
+                                                        guint         column);
+
+static GVariant**    dee_sequence_model_peek_row       (DeeModel     *self,
+                                                        DeeModelIter *iter,
+                                                        GVariant    **out_row_members);
+
 static DeeModelIter* dee_sequence_model_get_first_iter  (DeeModel     *self);
 
 static DeeModelIter* dee_sequence_model_get_last_iter   (DeeModel     *self);
@@ -187,6 +235,12 @@ static gboolean       dee_sequence_model_is_last        (DeeModel     *self,
 static guint          dee_sequence_model_get_position   (DeeModel     *self,
                                                          DeeModelIter *iter);
 
+static void           dee_sequence_model_foreach_range  (DeeModel         *self,
+                                                         DeeModelIter     *start,
+                                                         DeeModelIter     *end,
+                                                         DeeModelIterFunc  func,
+                                                         gpointer          user_data);
+
 static DeeModelTag*   dee_sequence_model_register_tag    (DeeModel       *self,
                                                           GDestroyNotify  tag_destroy);
 
@@ -221,6 +275,14 @@ dee_sequence_model_finalize (GObject *object)
   DeeSequenceModelPrivate *priv = self->priv;
   GSequenceIter           *iter, *end;
 
+  /* Drop the dictionary first, the rows hold their own refs on the
+   * interned values so there is no need to release them one by one */
+  if (priv->strings != NULL)
+    {
+      g_hash_table_unref (priv->strings);
+      priv->strings = NULL;
+    }
+
   /* Free row data */
   end = g_sequence_get_end_iter (priv->sequence);
   iter = g_sequence_get_begin_iter (priv->sequence);
@@ -250,6 +312,10 @@ dee_sequence_model_set_property (GObject      *object,
 {
   switch (id)
     {
+    case PROP_INTERN_STRINGS:
+      dee_sequence_model_set_intern_strings (DEE_SEQUENCE_MODEL (object),
+                                             g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
       break;
@@ -264,6 +330,10 @@ dee_sequence_model_get_property (GObject    *object,
 {
   switch (id)
     {
+    case PROP_INTERN_STRINGS:
+      g_value_set_boolean (value,
+                           DEE_SEQUENCE_MODEL (object)->priv->intern_strings);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
       break;
@@ -274,15 +344,31 @@ static void
 dee_sequence_model_class_init (DeeSequenceModelClass *klass)
 {
   GObjectClass  *obj_class = G_OBJECT_CLASS (klass);
+  GParamSpec    *pspec;
 
   obj_class->finalize     = dee_sequence_model_finalize;  
   obj_class->set_property = dee_sequence_model_set_property;
   obj_class->get_property = dee_sequence_model_get_property;
 
+  /**
+   * DeeSequenceModel:intern-strings:
+   *
+   * If %TRUE values in string columns ('s', 'o' and 'g') are interned, so
+   * that equal values share one immutable #GVariant
+   */
+  pspec = g_param_spec_boolean ("intern-strings", "Intern strings",
+                                "Share equal values in string columns",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+                                | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_INTERN_STRINGS, pspec);
+
   /* Find signal ids for the model modification signals */
   sigid_row_added = g_signal_lookup ("row-added", DEE_TYPE_MODEL);
   sigid_row_removed = g_signal_lookup ("row-removed", DEE_TYPE_MODEL);
   sigid_row_changed = g_signal_lookup ("row-changed", DEE_TYPE_MODEL);
+  sigid_row_moved = g_signal_lookup ("row-moved", DEE_TYPE_MODEL);
+  sigid_rows_reordered = g_signal_lookup ("rows-reordered", DEE_TYPE_MODEL);
 
   /* Add private data */
   g_type_class_add_private (obj_class, sizeof (DeeSequenceModelPrivate));
@@ -301,6 +387,8 @@ dee_sequence_model_model_iface_init (DeeModelIface *iface)
   iface->set_value            = dee_sequence_model_set_value;
   iface->get_value            = dee_sequence_model_get_value;
   iface->get_row              = dee_sequence_model_get_row;
+  iface->peek_value           = dee_sequence_model_peek_value;
+  iface->peek_row             = dee_sequence_model_peek_row;
   iface->get_first_iter       = dee_sequence_model_get_first_iter;
   iface->get_last_iter        = dee_sequence_model_get_last_iter;
   iface->get_iter_at_row      = dee_sequence_model_get_iter_at_row;
@@ -317,6 +405,10 @@ dee_sequence_model_model_iface_init (DeeModelIface *iface)
   iface->is_first             = dee_sequence_model_is_first;
   iface->is_last              = dee_sequence_model_is_last;
   iface->get_position         = dee_sequence_model_get_position;
+  iface->foreach_range        = dee_sequence_model_foreach_range;
+  iface->move_before          = dee_sequence_model_move_before;
+  iface->reorder              = dee_sequence_model_reorder;
+  iface->insert_rows_before   = dee_sequence_model_insert_rows_before;
   iface->register_tag         = dee_sequence_model_register_tag;
   iface->get_tag              = dee_sequence_model_get_tag;
   iface->set_tag              = dee_sequence_model_set_tag;
@@ -331,10 +423,77 @@ dee_sequence_model_init (DeeSequenceModel *model)
   priv->sequence = g_sequence_new (NULL);
   priv->tags = NULL;
   priv->setting_many = FALSE;
+  priv->schema = NULL;
+  priv->intern_strings = FALSE;
+  priv->strings = NULL;
 }
 
 /* Private Methods */
 
+static DeeModelSchema*
+dee_sequence_model_get_compiled_schema (DeeSequenceModel *self)
+{
+  DeeSequenceModelPrivate *priv = self->priv;
+
+  if (G_UNLIKELY (priv->schema == NULL))
+    priv->schema = _dee_model_get_compiled_schema (DEE_MODEL (self));
+
+  return priv->schema;
+}
+
+static void
+interned_value_free (InternedValue *interned)
+{
+  g_variant_unref (interned->value);
+  g_slice_free (InternedValue, interned);
+}
+
+#define IS_STRING_COLUMN(desc) ((desc)->type_code == 's' || \
+                                (desc)->type_code == 'o' || \
+                                (desc)->type_code == 'g')
+
+/* Takes ownership of the non-floating @value and returns a reference to the
+ * shared instance of it */
+static GVariant*
+dee_sequence_model_intern (DeeSequenceModel *self,
+                           GVariant         *value)
+{
+  DeeSequenceModelPrivate *priv = self->priv;
+  InternedValue           *interned;
+
+  interned = g_hash_table_lookup (priv->strings, value);
+  if (interned != NULL)
+    {
+      interned->ref_count++;
+      g_variant_unref (value);
+      return g_variant_ref (interned->value);
+    }
+
+  interned = g_slice_new (InternedValue);
+  interned->value = value;
+  interned->ref_count = 1;
+  g_hash_table_insert (priv->strings, value, interned);
+
+  return g_variant_ref (value);
+}
+
+/* Called before a cell drops its reference to @value. Values that were
+ * stored before interning was enabled are not in the dictionary */
+static void
+dee_sequence_model_release (DeeSequenceModel *self,
+                            GVariant         *value)
+{
+  DeeSequenceModelPrivate *priv = self->priv;
+  InternedValue           *interned;
+
+  interned = g_hash_table_lookup (priv->strings, value);
+  if (interned == NULL || interned->value != value)
+    return;
+
+  if (--interned->ref_count == 0)
+    g_hash_table_remove (priv->strings, value);
+}
+
 /*
  * DeeModel Interface Implementation
  */
@@ -429,6 +588,47 @@ dee_sequence_model_insert_row_before (DeeModel      *self,
   return iter;
 }
 
+/* Like dee_sequence_model_insert_row_before(), but the schema is looked up
+ * once for the whole batch */
+static DeeModelIter*
+dee_sequence_model_insert_rows_before (DeeModel      *self,
+                                       DeeModelIter  *iter,
+                                       GVariant    ***rows,
+                                       guint          n_rows)
+{
+  DeeModelSchema          *schema;
+  GSequenceIter           *new_iter, *first;
+  guint                    i, j;
+
+  g_return_val_if_fail (DEE_IS_SEQUENCE_MODEL (self), NULL);
+  g_return_val_if_fail (iter != NULL, NULL);
+  g_return_val_if_fail (rows != NULL, NULL);
+
+  schema = dee_sequence_model_get_compiled_schema (DEE_SEQUENCE_MODEL (self));
+  g_return_val_if_fail (schema != NULL, NULL);
+
+  first = NULL;
+  for (i = 0; i < n_rows; i++)
+    {
+      new_iter = g_sequence_insert_before ((GSequenceIter *) iter,
+                                           dee_sequence_model_create_empty_row (self));
+      for (j = 0; j < schema->n_columns; j++)
+        {
+          dee_sequence_model_set_value_silently (self, (DeeModelIter *) new_iter,
+                                                 j, &schema->columns[j],
+                                                 rows[i][j]);
+        }
+
+      if (first == NULL)
+        first = new_iter;
+
+      dee_serializable_model_inc_seqnum (self);
+      g_signal_emit (self, sigid_row_added, 0, new_iter);
+    }
+
+  return first != NULL ? (DeeModelIter *) first : iter;
+}
+
 /* logN search using the tree structure of GSeq */
 static DeeModelIter*
 dee_sequence_model_find_row_sorted (DeeModel           *self,
@@ -492,6 +692,68 @@ dee_sequence_model_remove (DeeModel     *self,
     }
 }
 
+/* The row, its tags and its iter all stay the same. Only the position of
+ * the node in the sequence changes */
+static DeeModelIter*
+dee_sequence_model_move_before (DeeModel     *self,
+                                DeeModelIter *iter_,
+                                DeeModelIter *before_)
+{
+  GSequenceIter *iter = (GSequenceIter *) iter_;
+  GSequenceIter *before = (GSequenceIter *) before_;
+  guint          old_pos;
+
+  g_return_val_if_fail (DEE_IS_SEQUENCE_MODEL (self), NULL);
+  g_return_val_if_fail (iter != NULL, NULL);
+  g_return_val_if_fail (before != NULL, NULL);
+  g_return_val_if_fail (!g_sequence_iter_is_end (iter), iter_);
+
+  if (iter == before || g_sequence_iter_next (iter) == before)
+    return iter_;
+
+  old_pos = g_sequence_iter_get_position (iter);
+  g_sequence_move (iter, before);
+
+  dee_serializable_model_inc_seqnum (self);
+  g_signal_emit (self, sigid_row_moved, 0, iter_, old_pos);
+
+  return iter_;
+}
+
+/* Relink the nodes of the sequence in their new order. The rows, their
+ * tags and the iters all stay the same */
+static void
+dee_sequence_model_reorder (DeeModel    *self,
+                            const guint *new_order)
+{
+  DeeSequenceModelPrivate  *priv;
+  GSequenceIter           **iters;
+  GSequenceIter            *iter, *end;
+  guint                     n_rows, i;
+
+  g_return_if_fail (DEE_IS_SEQUENCE_MODEL (self));
+
+  priv = DEE_SEQUENCE_MODEL (self)->priv;
+  n_rows = g_sequence_get_length (priv->sequence);
+
+  iters = g_new (GSequenceIter*, n_rows);
+  iter = g_sequence_get_begin_iter (priv->sequence);
+  for (i = 0; i < n_rows; i++)
+    {
+      iters[i] = iter;
+      iter = g_sequence_iter_next (iter);
+    }
+
+  end = g_sequence_get_end_iter (priv->sequence);
+  for (i = 0; i < n_rows; i++)
+    g_sequence_move (iters[new_order[i]], end);
+
+  g_free (iters);
+
+  dee_serializable_model_inc_seqnum (self);
+  g_signal_emit (self, sigid_rows_reordered, 0, new_order);
+}
+
 static void
 dee_sequence_model_set_value (DeeModel      *self,
                               DeeModelIter  *iter,
@@ -509,7 +771,7 @@ dee_sequence_model_set_value (DeeModel      *self,
   priv = _self->priv;
   
   dee_sequence_model_set_value_silently (self, iter, column,
-      dee_model_get_column_schema (self, column), value);
+      &dee_sequence_model_get_compiled_schema (_self)->columns[column], value);
   
   if (priv->setting_many == FALSE)
     {
@@ -525,19 +787,21 @@ dee_sequence_model_set_row (DeeModel      *self,
 {
   DeeSequenceModel        *_self = (DeeSequenceModel *)self;
   DeeSequenceModelPrivate *priv;
-  guint                    i, n_cols;
-  const gchar *const      *schema;
+  DeeModelSchema          *schema;
+  guint                    i;
 
   g_return_if_fail (DEE_IS_SEQUENCE_MODEL (_self));
   g_return_if_fail (iter != NULL);
   g_return_if_fail (row_members != NULL);
 
   priv = _self->priv;
-  schema = dee_model_get_schema (self, &n_cols);
+  schema = dee_sequence_model_get_compiled_schema (_self);
+  g_return_if_fail (schema != NULL);
 
-  for (i = 0; i < n_cols; i++)
+  for (i = 0; i < schema->n_columns; i++)
     {
-      dee_sequence_model_set_value_silently (self, iter, i, schema[i],
+      dee_sequence_model_set_value_silently (self, iter, i,
+                                             &schema->columns[i],
                                              row_members[i]);
     }
 
@@ -549,16 +813,15 @@ dee_sequence_model_set_row (DeeModel      *self,
 }
 
 static void
-dee_sequence_model_set_value_silently (DeeModel      *self,
-                                       DeeModelIter  *iter,
-                                       guint          column,
-                                       const gchar   *col_schema,
-                                       GVariant      *value)
+dee_sequence_model_set_value_silently (DeeModel            *self,
+                                       DeeModelIter        *iter,
+                                       guint                column,
+                                       const DeeColumnDesc *desc,
+                                       GVariant            *value)
 {
   gpointer                *row;
 
-  g_return_if_fail (g_variant_type_equal (g_variant_get_type (value),
-                                          G_VARIANT_TYPE (col_schema)));
+  g_return_if_fail (_dee_column_desc_check_value (desc, value));
 
   row = g_sequence_get ((GSequenceIter *) iter);
 
@@ -570,10 +833,21 @@ dee_sequence_model_set_value_silently (DeeModel      *self,
         return;
       }
 
+  value = g_variant_ref_sink (value);
+
+  if (((DeeSequenceModel *) self)->priv->intern_strings &&
+      IS_STRING_COLUMN (desc))
+    value = dee_sequence_model_intern ((DeeSequenceModel *) self, value);
+
   if (row[column] != NULL)
-    g_variant_unref (row[column]);
+    {
+      if (((DeeSequenceModel *) self)->priv->strings != NULL &&
+          IS_STRING_COLUMN (desc))
+        dee_sequence_model_release ((DeeSequenceModel *) self, row[column]);
+      g_variant_unref (row[column]);
+    }
 
-  row[column] = g_variant_ref_sink (value);
+  row[column] = value;
 }
 
 static GVariant*
@@ -641,6 +915,35 @@ dee_sequence_model_get_row (DeeModel      *self,
   return out_row_members;
 }
 
+static GVariant**
+dee_sequence_model_peek_row (DeeModel      *self,
+                             DeeModelIter  *iter,
+                             GVariant     **out_row_members)
+{
+  gpointer *row;
+  guint     n_cols;
+
+  g_return_val_if_fail (DEE_IS_SEQUENCE_MODEL (self), NULL);
+
+  n_cols = dee_model_get_n_columns (self);
+  row = g_sequence_get ((GSequenceIter *) iter);
+  if (G_UNLIKELY (row == NULL))
+    {
+      g_critical ("Unable to get row. NULL row data in DeeSequenceModel@%p "
+                  "at position %u. The row has probably been removed",
+                  self, dee_model_get_position (self, iter));
+      return NULL;
+    }
+
+  if (out_row_members == NULL)
+    out_row_members = g_new0 (GVariant*, n_cols + 1);
+
+  /* The row data starts with the column values, so we can just copy them */
+  memcpy (out_row_members, row, n_cols * sizeof (GVariant*));
+
+  return out_row_members;
+}
+
 static DeeModelIter*
 dee_sequence_model_get_first_iter (DeeModel     *self)
 {
@@ -868,6 +1171,27 @@ dee_sequence_model_get_position (DeeModel     *self,
   return g_sequence_iter_get_position ((GSequenceIter *)iter);
 }
 
+static void
+dee_sequence_model_foreach_range (DeeModel         *self,
+                                  DeeModelIter     *start,
+                                  DeeModelIter     *end,
+                                  DeeModelIterFunc  func,
+                                  gpointer          user_data)
+{
+  GSequenceIter *iter;
+
+  g_return_if_fail (DEE_IS_SEQUENCE_MODEL (self));
+
+  /* The end check also guards against an @end that comes before @start */
+  for (iter = (GSequenceIter *) start;
+       iter != (GSequenceIter *) end && !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      if (func (self, (DeeModelIter *) iter, user_data))
+        break;
+    }
+}
+
 static DeeModelTag*
 dee_sequence_model_register_tag (DeeModel       *self,
                                  GDestroyNotify  tag_destroy)
@@ -1006,7 +1330,12 @@ dee_sequence_model_free_row (DeeSequenceModel *self,
 
   /* Free the row data */
   for (i = 0; i < n_cols; i++)
-    g_variant_unref (row[i]);
+    {
+      if (priv->strings != NULL &&
+          IS_STRING_COLUMN (&dee_sequence_model_get_compiled_schema (self)->columns[i]))
+        dee_sequence_model_release (self, row[i]);
+      g_variant_unref (row[i]);
+    }
 
   /* Free any row tags */
   row_tag_iter = row[n_cols];
@@ -1131,3 +1460,85 @@ dee_sequence_model_new ()
   self = DEE_MODEL (g_object_new (DEE_TYPE_SEQUENCE_MODEL, NULL));
   return self;
 }
+
+/**
+ * dee_sequence_model_set_intern_strings:
+ * @self: The model to enable or disable interning on
+ * @intern_strings: Whether to intern values in string columns
+ *
+ * Enable or disable interning of the values in string columns. When enabled
+ * all rows in @self that hold equal strings in a column share one immutable
+ * #GVariant. This saves a lot of memory in models where a column only takes
+ * a small set of values. #DeeColumnIndex and #DeeAggregateModel compare the
+ * pointers of values before calling g_variant_equal(), so they also get
+ * cheaper on interned columns. Other comparisons are not affected.
+ *
+ * Rows already in @self are interned when interning is enabled. Disabling it
+ * only affects values set after the call.
+ */
+void
+dee_sequence_model_set_intern_strings (DeeSequenceModel *self,
+                                       gboolean          intern_strings)
+{
+  DeeSequenceModelPrivate *priv;
+  DeeModelSchema          *schema;
+  GSequenceIter           *iter, *end;
+  gpointer                *row;
+  guint                    i;
+
+  g_return_if_fail (DEE_IS_SEQUENCE_MODEL (self));
+
+  priv = self->priv;
+  intern_strings = intern_strings != FALSE;
+
+  if (priv->intern_strings == intern_strings)
+    return;
+
+  priv->intern_strings = intern_strings;
+
+  if (intern_strings)
+    {
+      if (priv->strings == NULL)
+        priv->strings = g_hash_table_new_full (g_variant_hash, g_variant_equal,
+                                               NULL,
+                                               (GDestroyNotify) interned_value_free);
+
+      /* Intern the rows we already have. The values are equal so this is
+       * not a change from the point of view of the model */
+      schema = dee_sequence_model_get_compiled_schema (self);
+      if (schema != NULL)
+        {
+          end = g_sequence_get_end_iter (priv->sequence);
+          for (iter = g_sequence_get_begin_iter (priv->sequence);
+               iter != end; iter = g_sequence_iter_next (iter))
+            {
+              row = g_sequence_get (iter);
+              for (i = 0; i < schema->n_columns; i++)
+                {
+                  if (!IS_STRING_COLUMN (&schema->columns[i]))
+                    continue;
+
+                  dee_sequence_model_release (self, row[i]);
+                  row[i] = dee_sequence_model_intern (self, row[i]);
+                }
+            }
+        }
+    }
+
+  g_object_notify (G_OBJECT (self), "intern-strings");
+}
+
+/**
+ * dee_sequence_model_get_intern_strings:
+ * @self: The model to inspect
+ *
+ * Return value: Whether values in string columns of @self are interned.
+ *               See dee_sequence_model_set_intern_strings()
+ */
+gboolean
+dee_sequence_model_get_intern_strings (DeeSequenceModel *self)
+{
+  g_return_val_if_fail (DEE_IS_SEQUENCE_MODEL (self), FALSE);
+
+  return self->priv->intern_strings;
+}
@@ -97,6 +97,11 @@ GType          dee_sequence_model_get_type               (void);
 
 DeeModel*      dee_sequence_model_new                    ();
 
+void           dee_sequence_model_set_intern_strings     (DeeSequenceModel *self,
+                                                          gboolean          intern_strings);
+
+gboolean       dee_sequence_model_get_intern_strings     (DeeSequenceModel *self);
+
 G_END_DECLS
 
 #endif /* _HAVE_DEE_SEQUENCE_MODEL_H */
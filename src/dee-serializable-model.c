@@ -884,7 +884,7 @@ dee_serializable_model_find_row_sorted   (DeeModel           *self,
   DeeModelIter  *iter, *end, *last_matching;
   GVariant     **row_buf;
   gint           cmp_result;
-  guint          n_cols, i;
+  guint          n_cols;
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), NULL);
   g_return_val_if_fail (row_spec != NULL, NULL);
@@ -894,14 +894,15 @@ dee_serializable_model_find_row_sorted   (DeeModel           *self,
   if (out_was_found != NULL) *out_was_found = FALSE;
   n_cols = dee_model_get_n_columns (self);
 
-  /* Stack allocate the buffer for speed, and so we don't have to free */
+  /* Stack allocate the buffer for speed, and so we don't have to free.
+   * The row values are borrowed, nothing changes the model in here */
   row_buf = g_alloca (n_cols * sizeof (gpointer));
 
   iter = dee_model_get_first_iter (self);
   end = dee_model_get_last_iter (self);
   while (iter != end)
     {
-      dee_model_get_row (self, iter, row_buf);
+      dee_model_peek_row (self, iter, row_buf);
       cmp_result = cmp_func (row_buf, row_spec, user_data);
       /* we're returning last matching row to make ordering
        * of insert_row_sorted stable and fast */
@@ -914,12 +915,10 @@ dee_serializable_model_find_row_sorted   (DeeModel           *self,
               iter = last_matching;
               break;
             }
-          for (i = 0; i < n_cols; i++) g_variant_unref (row_buf[i]);
-          dee_model_get_row (self, iter, row_buf);
+          dee_model_peek_row (self, iter, row_buf);
           cmp_result = cmp_func (row_buf, row_spec, user_data);
         }
 
-      for (i = 0; i < n_cols; i++) g_variant_unref (row_buf[i]);
       /* if we're past the matching row, the loop can be quit */
       if (cmp_result >= 0) break;
       iter = dee_model_next (self, iter);
@@ -983,12 +982,11 @@ dee_serializable_model_get_value_by_name (DeeModel     *self,
       GVariant    *dict, *result;
       const gchar *key_name;
 
-      dict = dee_model_get_value (self, iter, col_index);
+      dict = dee_model_peek_value (self, iter, col_index);
       // handle full "column::field" name
       key_name = strstr(column_name, "::");
       key_name = key_name != NULL ? key_name + 2 : column_name;
       result = g_variant_lookup_value (dict, key_name, NULL);
-      g_variant_unref (dict);
 
       return result;
     }
@@ -1026,7 +1024,7 @@ dee_serializable_model_get_bool (DeeModel     *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), FALSE);
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1037,7 +1035,6 @@ dee_serializable_model_get_bool (DeeModel     *self,
     }
 
   b = g_variant_get_boolean (value);
-  g_variant_unref (value);
 
   return b;
 }
@@ -1052,7 +1049,7 @@ dee_serializable_model_get_uchar (DeeModel      *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), '\0');
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1063,7 +1060,6 @@ dee_serializable_model_get_uchar (DeeModel      *self,
     }
 
   u = g_variant_get_byte(value);
-  g_variant_unref (value);
 
   return u;
 }
@@ -1078,7 +1074,7 @@ dee_serializable_model_get_int32 (DeeModel        *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), 0);
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1089,7 +1085,6 @@ dee_serializable_model_get_int32 (DeeModel        *self,
     }
 
   i = g_variant_get_int32 (value);
-  g_variant_unref (value);
 
   return i;
 }
@@ -1104,7 +1099,7 @@ dee_serializable_model_get_uint32 (DeeModel      *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), 0);
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1115,7 +1110,6 @@ dee_serializable_model_get_uint32 (DeeModel      *self,
     }
 
   u = g_variant_get_uint32 (value);
-  g_variant_unref (value);
 
   return u;
 }
@@ -1132,7 +1126,7 @@ dee_serializable_model_get_int64 (DeeModel      *self,
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self),
                         G_GINT64_CONSTANT (0));
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1143,7 +1137,6 @@ dee_serializable_model_get_int64 (DeeModel      *self,
     }
 
   i = g_variant_get_int64 (value);
-  g_variant_unref (value);
 
   return i;
 }
@@ -1160,7 +1153,7 @@ dee_serializable_model_get_uint64 (DeeModel      *self,
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self),
                         G_GUINT64_CONSTANT (0));
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1171,7 +1164,6 @@ dee_serializable_model_get_uint64 (DeeModel      *self,
     }
 
   u = g_variant_get_uint64 (value);
-  g_variant_unref (value);
 
   return u;
 }
@@ -1186,7 +1178,7 @@ dee_serializable_model_get_double (DeeModel      *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), 0);
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1197,7 +1189,6 @@ dee_serializable_model_get_double (DeeModel      *self,
     }
 
   d = g_variant_get_double (value);
-  g_variant_unref (value);
 
   return d;
 }
@@ -1212,7 +1203,7 @@ dee_serializable_model_get_string (DeeModel      *self,
 
   g_return_val_if_fail (DEE_IS_SERIALIZABLE_MODEL (self), NULL);
 
-  value = dee_model_get_value (self, iter, column);
+  value = dee_model_peek_value (self, iter, column);
 
   if (G_UNLIKELY (value == NULL))
     {
@@ -1223,7 +1214,6 @@ dee_serializable_model_get_string (DeeModel      *self,
     }
 
   s = g_variant_get_string (value, NULL);
-  g_variant_unref (value);
 
   return s;
 }
@@ -1406,14 +1396,48 @@ dee_serializable_model_set_tag (DeeModel       *self,
 }
 
 /* Build a '(sasaavauay(tt))' suitable for sending in a Clone response */
+typedef struct
+{
+  GVariantBuilder  *aav;
+  GVariant        **row_buf;
+  guint             n_columns;
+  guint             n_rows;
+} SerializeData;
+
+static gboolean
+serialize_rows (DeeModel      *self,
+                DeeModelIter **iters,
+                guint          n_iters,
+                gpointer       user_data)
+{
+  SerializeData *data = (SerializeData *) user_data;
+  guint          i, j;
+
+  for (i = 0; i < n_iters; i++)
+    {
+      g_variant_builder_open (data->aav, G_VARIANT_TYPE ("av"));
+      dee_model_peek_row (self, iters[i], data->row_buf);
+      for (j = 0; j < data->n_columns; j++)
+        {
+          g_variant_builder_add_value (
+              data->aav, g_variant_new_variant (data->row_buf[j]));
+        }
+      g_variant_builder_close (data->aav);
+    }
+
+  data->n_rows += n_iters;
+
+  return FALSE;
+}
+
 static GVariant*
 dee_serializable_model_serialize (DeeSerializable *self)
 {
   DeeModel               *_self;
   GVariantBuilder         aav, clone, fields, vardict;
-  GVariant               *val, *tt, *schema, *col_names;
-  DeeModelIter           *iter;
-  guint                   i, j, n_rows, n_columns;
+  GVariant               *tt, *schema, *col_names;
+  SerializeData           data;
+  guint                   i, n_rows, n_columns;
   guint64                 last_seqnum;
   const gchar* const     *column_schemas;
   const gchar           **column_names;
@@ -1427,25 +1451,15 @@ dee_serializable_model_serialize (DeeSerializable *self)
 
   g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
 
-  /* Clone the rows */
-  i = 0;
-  iter = dee_model_get_first_iter (_self);
-  while (!dee_model_is_last (_self, iter))
-    {
-      g_variant_builder_open (&aav, G_VARIANT_TYPE ("av"));
-      for (j = 0; j < n_columns; j++)
-        {
-          val = dee_model_get_value (_self, iter, j);
-          g_variant_builder_add_value (&aav, g_variant_new_variant (val));
-          g_variant_unref (val);
-        }
-      g_variant_builder_close (&aav);
-
-      iter = dee_model_next (_self, iter);
-      i++;
-    }
+  /* Clone the rows. The values are borrowed, g_variant_new_variant()
+   * takes its own reference */
+  data.aav = &aav;
+  data.row_buf = g_alloca (n_columns * sizeof (GVariant*));
+  data.n_columns = n_columns;
+  data.n_rows = 0;
+  dee_model_foreach_range_chunked (_self, NULL, NULL, serialize_rows, &data);
 
-  n_rows = i;
+  n_rows = data.n_rows;
 
   /* Collect the schema */
   column_schemas = dee_model_get_schema(_self, NULL);
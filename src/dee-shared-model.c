@@ -37,22 +37,47 @@
  * you wait for the model to synchronize with its peers. The normal way to do
  * this is to wait for the &quot;notify::synchronized&quot; signal.
  *
+ * Rows moved with dee_model_move_before() are sent to the other peers as
+ * a single move, carrying only the old and the new position of the row.
+ * Likewise dee_model_reorder() and dee_model_sort() send a single
+ * reorder, carrying the old positions of the rows in their new order.
+ *
+ * Peers announce the changes they understand when they clone the leader.
+ * Peers that don't understand moves or reorders, like older versions of
+ * Dee, are sent a removal and an addition of the moved row, or a clear
+ * and an addition of every row, instead. On a bus followers can't know
+ * the features of the other followers, so they always do the latter.
+ *
  */
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
 
+#ifdef HAVE_MEMFD_CREATE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#include <errno.h>
 #include <memory.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <gio/gunixfdlist.h>
 
 #include "dee-peer.h"
+#include "dee-client.h"
+#include "dee-server.h"
 #include "dee-model.h"
 #include "dee-proxy-model.h"
 #include "dee-sequence-model.h"
 #include "dee-shared-model.h"
 #include "dee-serializable-model.h"
 #include "dee-serializable.h"
+#include "dee-resource-manager.h"
 #include "dee-marshal.h"
 #include "trace-log.h"
 #include "com.canonical.Dee.Model-xml.h"
@@ -69,6 +94,27 @@ G_DEFINE_TYPE_WITH_CODE (DeeSharedModel,
                          G_IMPLEMENT_INTERFACE (DEE_TYPE_MODEL,
                                                 dee_shared_model_model_iface_init));
 
+/* Persisted state of a shared model, a thin DeeSerializable box around the
+ * serialized Clone of the model. See dee_shared_model_set_snapshot_manager() */
+typedef struct
+{
+  GObject   parent;
+  GVariant *data;
+} DeeSharedModelSnapshot;
+
+typedef struct
+{
+  GObjectClass parent_class;
+} DeeSharedModelSnapshotClass;
+
+static void dee_shared_model_snapshot_serializable_iface_init (DeeSerializableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (DeeSharedModelSnapshot,
+                         dee_shared_model_snapshot,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (DEE_TYPE_SERIALIZABLE,
+                                                dee_shared_model_snapshot_serializable_iface_init));
+
 #define DEE_SHARED_MODEL_GET_PRIVATE(obj) \
   (G_TYPE_INSTANCE_GET_PRIVATE(obj, DEE_TYPE_SHARED_MODEL, DeeSharedModelPrivate))
 
@@ -76,6 +122,19 @@ G_DEFINE_TYPE_WITH_CODE (DeeSharedModel,
 #define COMMIT_TUPLE_ITEMS    6
 #define CLONE_VARIANT_TYPE    G_VARIANT_TYPE("(sasaavauay(tt)a{sv})")
 #define CLONE_TUPLE_ITEMS     7
+#define COMMITS_VARIANT_TYPE  G_VARIANT_TYPE("(a(sasaavauay(tt)))")
+
+/* Number of flushed Commits the leader keeps around for serving deltas
+ * to warm started followers */
+#define COMMIT_HISTORY_LENGTH 64
+
+/* Seconds to wait after a change before persisting a snapshot, so a burst
+ * of Commits only costs a single write. Every snapshot serializes and
+ * writes the whole model, so larger models wait an extra second per
+ * SNAPSHOT_ROWS_PER_SECOND rows, up to SNAPSHOT_MAX_DELAY */
+#define SNAPSHOT_DELAY 1
+#define SNAPSHOT_ROWS_PER_SECOND 10000
+#define SNAPSHOT_MAX_DELAY 60
 
 /**
  * DeeSharedModelPrivate:
@@ -105,25 +164,85 @@ struct _DeeSharedModelPrivate
   gboolean    suppress_remote_signals;
   gboolean    clone_in_progress;
 
+  /* Serialized reply to the last Clone call, valid as long as the seqnum
+   * of the model is still clone_cache_seqnum */
+  GVariant   *clone_cache;
+  guint64     clone_cache_seqnum;
+  /* Sealed memfd holding clone_cache, lazily created for CloneFd calls.
+   * Once it exists clone_cache is a mapping of it, not a copy */
+  gint        clone_cache_fd;
+
+  /* Identifies the lineage of the model data, seqnums are only comparable
+   * between models with the same epoch */
+  gchar      *epoch;
+  /* The last COMMIT_HISTORY_LENGTH Commits we sent, oldest first */
+  GQueue     *commit_history;
+  DeeResourceManager *snapshot_manager;
+  guint       snapshot_timer_id;
+  /* TRUE if the model contents were loaded from a snapshot and we only
+   * need a delta from the leader */
+  gboolean    warm_started;
+
+  /* Follower side a{sv} passed to CloneFiltered, or NULL */
+  GVariant   *subscription;
+
+  /* Leader side map from the unique bus names of followers to the
+   * PeerFeatures they announced. Only used on a bus, on peer-to-peer
+   * connections the features are kept in the DeeConnectionInfo */
+  GHashTable *peer_features;
+
   DeeSharedModelAccessMode access_mode;
   DeeSharedModelFlushMode flush_mode;
 };
 
 typedef struct
 {
-  /* The revision type is: ROWS_ADDED, ROWS_REMOVED, or ROWS_CHANGED */
+  /* The revision type is: ROWS_ADDED, ROWS_REMOVED, ROWS_CHANGED,
+   * ROWS_MOVED or ROWS_REORDERED */
   guchar      change_type;
   guint32     pos;
-  guint64     seqnum;
+  guint32     new_pos;          /* Only used for moves */
+  GVariant   *payload;          /* Only used for reorders */
+  GVariant   *rows;             /* 'aav' of all rows after a reorder, kept
+                                 * for peers that don't understand it */
+  guint64     seqnum;           /* The last seqnum taken by the change */
+  guint       n_seqnums;        /* Seqnums taken by the change */
   GVariant  **row;
   DeeModel   *model;
 } DeeSharedModelRevision;
 
+/* The rows and columns a follower registered interest in with
+ * CloneFiltered. The leader keeps track of the matching rows, in the order
+ * of the model, so it can send Commits with positions in the filtered view */
+typedef struct
+{
+  guint        n_matches;
+  guint       *match_columns;
+  GVariant   **match_values;
+  guint        n_columns;       /* Projected columns */
+  guint       *columns;
+  GVariant    *schema;          /* 'as' of the projected columns */
+  GSequence   *rows;            /* Matching DeeModelIters in model order */
+  GHashTable  *row_map;         /* DeeModelIter -> GSequenceIter in rows */
+  GSList      *revisions;       /* FilteredRevisions, prepended */
+  guint64      last_sent_seqnum;
+} DeeSharedModelSubscription;
+
+typedef struct
+{
+  guchar      change_type;
+  guint32     pos;
+  GVariant   *row;              /* Projected 'av', NULL for removals. For
+                                 * moves and reorders their payload */
+} FilteredRevision;
+
 typedef struct
 {
   GDBusConnection *connection;
   guint            signal_subscription_id;
   guint            registration_id;
+  DeeSharedModelSubscription *subscription;
+  guint            features;    /* PeerFeatures of the other end */
 } DeeConnectionInfo;
 /* Globals */
 static GQuark           dee_shared_model_error_quark       = 0;
@@ -144,8 +263,29 @@ typedef enum
   CHANGE_TYPE_REMOVE = '\x01',
   CHANGE_TYPE_CHANGE = '\x02',
   CHANGE_TYPE_CLEAR  = '\x03',
+  /* Older peers don't understand these, see PeerFeatures */
+  CHANGE_TYPE_MOVE   = '\x04',
+  CHANGE_TYPE_REORDER = '\x05',
 } ChangeType;
 
+/* Optional parts of the protocol. Peers announce the ones they understand
+ * with the Features method, and changes the receiving peers don't
+ * understand are spelled out with the basic change types instead */
+typedef enum
+{
+  PEER_FEATURE_MOVE    = 1 << 0,
+  PEER_FEATURE_REORDER = 1 << 1,
+} PeerFeatures;
+
+#define PEER_FEATURES_ALL (PEER_FEATURE_MOVE | PEER_FEATURE_REORDER)
+
+static const gchar *peer_feature_names[] =
+{
+  "move",     /* PEER_FEATURE_MOVE */
+  "reorder",  /* PEER_FEATURE_REORDER */
+  NULL
+};
+
 
 enum
 {
@@ -199,7 +339,8 @@ static void     dee_shared_model_revision_free  (DeeSharedModelRevision *rev);
 static gboolean flush_revision_queue_timeout_cb  (DeeModel         *self);
 static guint    flush_revision_queue             (DeeModel         *self);
 
-static void     enqueue_revision                 (DeeModel          *self,
+static DeeSharedModelRevision*
+                enqueue_revision                 (DeeModel          *self,
                                                   ChangeType         type,
                                                   guint32            pos,
                                                   guint64            seqnum,
@@ -218,6 +359,13 @@ static void        on_self_row_removed           (DeeModel     *self,
 static void        on_self_row_changed           (DeeModel     *self,
                                                   DeeModelIter *iter);
 
+static void        on_self_row_moved             (DeeModel     *self,
+                                                  DeeModelIter *iter,
+                                                  guint         old_pos);
+
+static void        on_self_rows_reordered        (DeeModel     *self,
+                                                  const guint  *new_order);
+
 static void        reset_model                   (DeeModel       *self);
 
 static void        invalidate_peer               (DeeSharedModel  *self,
@@ -226,6 +374,55 @@ static void        invalidate_peer               (DeeSharedModel  *self,
 
 static gboolean    on_invalidate                 (DeeSharedModel  *self);
 
+static void        invalidate_clone_cache        (DeeSharedModel  *self);
+
+static void        record_commit                 (DeeSharedModel  *self,
+                                                  GVariant        *transaction);
+
+static void        clear_commit_history          (DeeSharedModel  *self);
+
+static DeeConnectionInfo*
+                   find_connection_info          (DeeSharedModel  *self,
+                                                  GDBusConnection *connection);
+
+static guint       connection_features           (DeeSharedModel    *self,
+                                                  DeeConnectionInfo *info);
+
+static gboolean    peers_lack_feature            (DeeSharedModel  *self,
+                                                  guint            feature);
+
+static void        subscription_free             (DeeSharedModelSubscription *sub);
+
+static void        subscriptions_enqueue_clear   (DeeModel        *self);
+
+static void        subscriptions_row_added       (DeeSharedModel  *self,
+                                                  DeeModelIter    *iter);
+
+static void        subscriptions_row_removed     (DeeSharedModel  *self,
+                                                  DeeModelIter    *iter);
+
+static void        subscriptions_row_changed     (DeeSharedModel  *self,
+                                                  DeeModelIter    *iter);
+
+static void        subscriptions_row_moved       (DeeSharedModel  *self,
+                                                  DeeModelIter    *iter);
+
+static GVariant*   build_filtered_commit         (DeeSharedModel  *self,
+                                                  DeeSharedModelSubscription *sub,
+                                                  guint64          seqnum_end);
+
+static void        store_snapshot                (DeeSharedModel  *self);
+
+static void        schedule_snapshot             (DeeSharedModel  *self);
+
+static gboolean    subscriptions_equal           (GVariant        *subscription,
+                                                  GVariant        *other);
+
+static gboolean    load_snapshot                 (DeeSharedModel  *self);
+
+static gboolean    apply_clone                   (DeeSharedModel  *self,
+                                                  GVariant        *data);
+
 
 /* Create a new revision. The revision will own @row */
 static DeeSharedModelRevision*
@@ -238,12 +435,18 @@ dee_shared_model_revision_new (ChangeType type,
   DeeSharedModelRevision *rev;
 
   g_return_val_if_fail (type != CHANGE_TYPE_REMOVE &&
-      type != CHANGE_TYPE_CLEAR ? row != NULL : TRUE, NULL);
+      type != CHANGE_TYPE_CLEAR && type != CHANGE_TYPE_MOVE &&
+      type != CHANGE_TYPE_REORDER ?
+      row != NULL : TRUE, NULL);
 
   rev = g_slice_new (DeeSharedModelRevision);
   rev->change_type = (guchar) type;
   rev->pos = pos;
+  rev->new_pos = 0;
+  rev->payload = NULL;
+  rev->rows = NULL;
   rev->seqnum = seqnum;
+  rev->n_seqnums = 1;
   rev->row = row;
   rev->model = model;
 
@@ -266,9 +469,179 @@ dee_shared_model_revision_free (DeeSharedModelRevision *rev)
     g_variant_unref (rev->row[i]);
 
   g_slice_free1 (row_slice_size, rev->row);
+  if (rev->payload != NULL)
+    g_variant_unref (rev->payload);
+  if (rev->rows != NULL)
+    g_variant_unref (rev->rows);
   g_slice_free (DeeSharedModelRevision, rev);
 }
 
+/* A move only carries the new position of the row in its 'av', the row
+ * itself is already known by the receiver */
+static GVariant*
+build_move_payload (guint32 new_pos)
+{
+  GVariant *payload;
+
+  payload = g_variant_new_variant (g_variant_new_uint32 (new_pos));
+  return g_variant_new_array (G_VARIANT_TYPE_VARIANT, &payload, 1);
+}
+
+/* A reorder carries the new order of the rows, as an 'au' of the old
+ * positions, instead of the rows themselves */
+static GVariant*
+build_reorder_payload (const guint *new_order,
+                       guint        n_rows)
+{
+  GVariant *payload;
+
+  payload = g_variant_new_variant (
+      g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, new_order,
+                                 n_rows, sizeof (guint32)));
+  return g_variant_new_array (G_VARIANT_TYPE_VARIANT, &payload, 1);
+}
+
+/* Serialize all rows of @self, in order, as an 'aav' */
+static GVariant*
+build_rows (DeeModel *self)
+{
+  GVariantBuilder  aav;
+  DeeModelIter    *iter, *end;
+  GVariant        *val;
+  guint            n_cols, i;
+
+  n_cols = dee_model_get_n_columns (self);
+  g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
+
+  iter = dee_model_get_first_iter (self);
+  end = dee_model_get_last_iter (self);
+  while (iter != end)
+    {
+      g_variant_builder_open (&aav, G_VARIANT_TYPE ("av"));
+      for (i = 0; i < n_cols; i++)
+        {
+          val = dee_model_get_value (self, iter, i);
+          g_variant_builder_add_value (&aav, g_variant_new_variant (val));
+          g_variant_unref (val);
+        }
+      g_variant_builder_close (&aav);
+      iter = dee_model_next (self, iter);
+    }
+
+  return g_variant_builder_end (&aav);
+}
+
+/* Build a Commit of the revisions in the (reversed) revision queue.
+ * Changes needing protocol features not in @features are spelled out
+ * with the basic change types, where the revision has the data for it */
+static GVariant*
+build_commit (DeeSharedModel *self,
+              guint           features,
+              guint64         seqnum_begin,
+              guint64         seqnum_end)
+{
+  DeeSharedModelPrivate  *priv = self->priv;
+  DeeSharedModelRevision *rev;
+  GVariantBuilder         aav, au, ay, transaction;
+  GSList                 *iter;
+  GVariant               *row;
+  gboolean                has_row;
+  guint                   n_cols, n_rows, i;
+
+  n_cols = dee_model_get_n_columns (DEE_MODEL (self));
+
+  g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
+  g_variant_builder_init (&au, G_VARIANT_TYPE ("au"));
+  g_variant_builder_init (&ay, G_VARIANT_TYPE ("ay"));
+  for (iter = priv->revision_queue; iter; iter = iter->next)
+    {
+      rev = (DeeSharedModelRevision*) iter->data;
+
+      /* A move is a removal followed by an addition of the row at its
+       * new position. Moves without a row were made while all peers
+       * understood them */
+      if (rev->change_type == CHANGE_TYPE_MOVE &&
+          (features & PEER_FEATURE_MOVE) == 0 && rev->row != NULL)
+        {
+          g_variant_builder_add_value (&aav,
+                                       g_variant_new_array (G_VARIANT_TYPE_VARIANT,
+                                                            NULL, 0));
+          g_variant_builder_add (&au, "u", rev->pos);
+          g_variant_builder_add (&ay, "y", (guchar) CHANGE_TYPE_REMOVE);
+
+          g_variant_builder_open (&aav, G_VARIANT_TYPE ("av"));
+          for (i = 0; i < n_cols; i++)
+            {
+              g_variant_builder_add_value (&aav,
+                                           g_variant_new_variant (rev->row[i]));
+            }
+          g_variant_builder_close (&aav);
+          g_variant_builder_add (&au, "u", rev->new_pos);
+          g_variant_builder_add (&ay, "y", (guchar) CHANGE_TYPE_ADD);
+          continue;
+        }
+
+      /* A reorder is a clear followed by adding all rows in their new
+       * order */
+      if (rev->change_type == CHANGE_TYPE_REORDER &&
+          (features & PEER_FEATURE_REORDER) == 0 && rev->rows != NULL)
+        {
+          g_variant_builder_add_value (&aav,
+                                       g_variant_new_array (G_VARIANT_TYPE_VARIANT,
+                                                            NULL, 0));
+          g_variant_builder_add (&au, "u", 0);
+          g_variant_builder_add (&ay, "y", (guchar) CHANGE_TYPE_CLEAR);
+
+          n_rows = g_variant_n_children (rev->rows);
+          for (i = 0; i < n_rows; i++)
+            {
+              row = g_variant_get_child_value (rev->rows, i);
+              g_variant_builder_add_value (&aav, row);
+              g_variant_unref (row);
+              g_variant_builder_add (&au, "u", i);
+              g_variant_builder_add (&ay, "y", (guchar) CHANGE_TYPE_ADD);
+            }
+          continue;
+        }
+
+      /* Build the variants for this change */
+      has_row = rev->change_type == CHANGE_TYPE_ADD ||
+        rev->change_type == CHANGE_TYPE_CHANGE;
+      if (rev->change_type == CHANGE_TYPE_MOVE)
+        {
+          g_variant_builder_add_value (&aav, build_move_payload (rev->new_pos));
+        }
+      else if (rev->change_type == CHANGE_TYPE_REORDER)
+        {
+          g_variant_builder_add_value (&aav, rev->payload);
+        }
+      else
+        {
+          g_variant_builder_open (&aav, G_VARIANT_TYPE ("av"));
+          for (i = 0; i < n_cols && has_row; i++)
+            {
+              g_variant_builder_add_value (&aav,
+                                           g_variant_new_variant (rev->row[i]));
+            }
+          g_variant_builder_close (&aav);
+        }
+      g_variant_builder_add (&au, "u", rev->pos);
+      g_variant_builder_add (&ay, "y", (guchar) rev->change_type);
+    }
+
+  g_variant_builder_init (&transaction, COMMIT_VARIANT_TYPE);
+  g_variant_builder_add (&transaction, "s", dee_peer_get_swarm_name (priv->swarm));
+  g_variant_builder_add_value (&transaction,
+                               g_variant_new_strv (dee_model_get_schema (DEE_MODEL (self), NULL), -1));
+  g_variant_builder_add_value (&transaction, g_variant_builder_end (&aav));
+  g_variant_builder_add_value (&transaction, g_variant_builder_end (&au));
+  g_variant_builder_add_value (&transaction, g_variant_builder_end (&ay));
+  g_variant_builder_add_value (&transaction,
+                               g_variant_new ("(tt)", seqnum_begin, seqnum_end));
+
+  return g_variant_builder_end (&transaction);
+}
+
 static gboolean
 flush_revision_queue_timeout_cb (DeeModel *self)
 {
@@ -293,11 +666,11 @@ flush_revision_queue (DeeModel *self)
   GError                 *error;
   GSList                 *iter;
   GSList                 *connection_iter;
-  GVariant               *schema;
   GVariant               *transaction_variant;
-  GVariantBuilder         aav, au, ay, transaction;
+  GVariant               *basic_variant;
+  GDBusMessage           *commit_msg;
   guint64                 seqnum_begin = 0, seqnum_end = 0;
-  guint                   n_cols, i;
+  guint                   used_features;
 
   g_return_val_if_fail (DEE_IS_SHARED_MODEL (self), 0);
   priv = DEE_SHARED_MODEL (self)->priv;
@@ -318,6 +691,10 @@ flush_revision_queue (DeeModel *self)
                        NULL);
       g_slist_free (priv->revision_queue);
       priv->revision_queue = NULL;
+
+      /* These changes never went out as a Commit, so the history can't
+       * describe how to get to the current seqnum any more */
+      clear_commit_history (DEE_SHARED_MODEL (self));
     }
 
   /* Clear the current timeout if we have one running */
@@ -338,88 +715,122 @@ flush_revision_queue (DeeModel *self)
   /* Since we always prepend to the queue we need to reverse it */
   priv->revision_queue = g_slist_reverse (priv->revision_queue);
 
-  n_cols = dee_model_get_n_columns (self);
-
   /* We know that the revision_queue is non-empty at this point. We peek the
    * first element and assume that the last seqnum before this transaction
    * started was the seqnum in the first revision - 1. */
-  seqnum_end = ((DeeSharedModelRevision *) priv->revision_queue->data)->seqnum - 1;
+  rev = (DeeSharedModelRevision *) priv->revision_queue->data;
+  seqnum_end = rev->seqnum - rev->n_seqnums;
   seqnum_begin = priv->last_committed_seqnum;
 
-  g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
-  g_variant_builder_init (&au, G_VARIANT_TYPE ("au"));
-  g_variant_builder_init (&ay, G_VARIANT_TYPE ("ay"));
+  used_features = 0;
   for (iter = priv->revision_queue; iter; iter = iter->next)
     {
-      gboolean is_remove;
+      gboolean has_row;
       gboolean sequential_revnum;
 
       rev = (DeeSharedModelRevision*) iter->data;
-      is_remove = rev->change_type == CHANGE_TYPE_REMOVE ||
-        rev->change_type == CHANGE_TYPE_CLEAR;
+      has_row = rev->change_type == CHANGE_TYPE_ADD ||
+        rev->change_type == CHANGE_TYPE_CHANGE;
       /* Clears are "compressed" so they don't require sequential revnums */
       sequential_revnum = rev->change_type != CHANGE_TYPE_CLEAR;
 
       /* Sanity check our seqnums */
-      if (sequential_revnum && rev->seqnum != seqnum_end + 1)
+      if (sequential_revnum && rev->seqnum != seqnum_end + rev->n_seqnums)
         {
           g_critical ("Internal accounting error of DeeSharedModel@%p. Seqnums "
                       "not sequential: "
-                      "%"G_GUINT64_FORMAT" != %"G_GUINT64_FORMAT" + 1",
-                      self, rev->seqnum, seqnum_end);
+                      "%"G_GUINT64_FORMAT" != %"G_GUINT64_FORMAT" + %u",
+                      self, rev->seqnum, seqnum_end, rev->n_seqnums);
           return 0;
         }
       seqnum_end = rev->seqnum;
 
-      if ((is_remove) != (rev->row == NULL))
+      /* Moves may keep their row for peers that don't understand them */
+      if (has_row != (rev->row != NULL) &&
+          rev->change_type != CHANGE_TYPE_MOVE)
         {
           g_critical ("Internal accounting error is DeeSharedModel@%p. "
                       "Transaction row payload must be empty iff the change"
-                      "type is is a removal", self);
-        }
-
-      /* Build the variants for this change */
-      g_variant_builder_open (&aav, G_VARIANT_TYPE ("av"));
-      for (i = 0; i < n_cols && !is_remove; i++)
-        {
-          g_variant_builder_add_value (&aav,
-                                       g_variant_new_variant (rev->row[i]));
+                      "type is is a removal, a move or a reorder", self);
         }
-      g_variant_builder_close (&aav);
-      g_variant_builder_add (&au, "u", rev->pos);
-      g_variant_builder_add (&ay, "y", (guchar) rev->change_type);
 
-      /* Free the revisions while we are traversing the linked list anyway */
-      dee_shared_model_revision_free (rev);
+      if (rev->change_type == CHANGE_TYPE_MOVE)
+        used_features |= PEER_FEATURE_MOVE;
+      else if (rev->change_type == CHANGE_TYPE_REORDER)
+        used_features |= PEER_FEATURE_REORDER;
     }
 
-  /* Collect the schema */
-  schema = g_variant_new_strv (dee_model_get_schema(self, NULL), -1);
+  transaction_variant = build_commit (DEE_SHARED_MODEL (self),
+                                      PEER_FEATURES_ALL,
+                                      seqnum_begin, seqnum_end);
+  basic_variant = NULL;
 
-  /* Build the Commit message */
-  g_variant_builder_init (&transaction, COMMIT_VARIANT_TYPE);
-  g_variant_builder_add (&transaction, "s", dee_peer_get_swarm_name (priv->swarm));
-  g_variant_builder_add_value (&transaction, schema);
-  g_variant_builder_add_value (&transaction, g_variant_builder_end (&aav));
-  g_variant_builder_add_value (&transaction, g_variant_builder_end (&au));
-  g_variant_builder_add_value (&transaction, g_variant_builder_end (&ay));
-  g_variant_builder_add_value (&transaction,
-                               g_variant_new ("(tt)", seqnum_begin, seqnum_end));
+  /* Build the Commit message once. Each connection needs its own copy
+   * because the serial is assigned on send. The copies share the body,
+   * but GDBus still marshals it again for every connection */
+  commit_msg = g_dbus_message_new_signal (priv->model_path,
+                                          "com.canonical.Dee.Model",
+                                          "Commit");
+  g_dbus_message_set_body (commit_msg, transaction_variant);
 
-  transaction_variant = g_variant_builder_end (&transaction);
+  record_commit (DEE_SHARED_MODEL (self), transaction_variant);
 
   /* Throw a Commit signal */
   for (connection_iter = priv->connections; connection_iter != NULL;
        connection_iter = connection_iter->next)
     {
+      DeeConnectionInfo *info;
+      GDBusMessage      *msg;
+      GVariant          *filtered;
+
       error = NULL;
-      g_dbus_connection_emit_signal((GDBusConnection*) connection_iter->data,
-                                    NULL,
-                                    priv->model_path,
-                                    "com.canonical.Dee.Model",
-                                    "Commit",
-                                    transaction_variant,
-                                    &error);
+      info = find_connection_info (DEE_SHARED_MODEL (self),
+                                   (GDBusConnection*) connection_iter->data);
+
+      if (info != NULL && info->subscription != NULL)
+        {
+          /* Followers with a subscription get their own, filtered, Commit.
+           * If nothing they are interested in changed we send nothing */
+          filtered = build_filtered_commit (DEE_SHARED_MODEL (self),
+                                            info->subscription, seqnum_end);
+          if (filtered == NULL)
+            continue;
+
+          msg = g_dbus_message_new_signal (priv->model_path,
+                                           "com.canonical.Dee.Model",
+                                           "Commit");
+          g_dbus_message_set_body (msg, filtered);
+        }
+      else if ((used_features &
+                ~connection_features (DEE_SHARED_MODEL (self), info)) != 0)
+        {
+          /* Some of the receiving peers don't understand all the changes,
+           * so they get them spelled out with the basic change types. The
+           * seqnums taken by the changes leave room for that */
+          if (basic_variant == NULL)
+            basic_variant = g_variant_ref_sink (
+                build_commit (DEE_SHARED_MODEL (self), 0,
+                              seqnum_begin, seqnum_end));
+
+          msg = g_dbus_message_new_signal (priv->model_path,
+                                           "com.canonical.Dee.Model",
+                                           "Commit");
+          g_dbus_message_set_body (msg, basic_variant);
+        }
+      else if (connection_iter->next == NULL)
+        msg = g_object_ref (commit_msg);
+      else
+        msg = g_dbus_message_copy (commit_msg, &error);
+
+      if (msg != NULL)
+        {
+          g_dbus_connection_send_message ((GDBusConnection*) connection_iter->data,
+                                          msg,
+                                          G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+                                          NULL,
+                                          &error);
+          g_object_unref (msg);
+        }
 
       if (error != NULL)
         {
@@ -429,24 +840,33 @@ flush_revision_queue (DeeModel *self)
         }
     }
 
+  if (basic_variant != NULL)
+    g_variant_unref (basic_variant);
+  g_object_unref (commit_msg);
+
   trace_object (self, "Flushed %"G_GUINT64_FORMAT" revisions. "
                 "Seqnum range %"G_GUINT64_FORMAT"-%"G_GUINT64_FORMAT,
                 seqnum_end - seqnum_begin, seqnum_begin, seqnum_end);
 
-  /* Free and reset the queue. Note that we freed the individual revisions while
-   * we constructed the Commit message */
-  g_slist_free (priv->revision_queue);
+  /* Free and reset the queue */
+  g_slist_free_full (priv->revision_queue,
+                     (GDestroyNotify) dee_shared_model_revision_free);
   priv->revision_queue = NULL;
 
   priv->last_committed_seqnum = seqnum_end;
 
+  /* Any cached Clone reply is stale now */
+  invalidate_clone_cache (DEE_SHARED_MODEL (self));
+
+  schedule_snapshot (DEE_SHARED_MODEL (self));
+
   return seqnum_end - seqnum_begin; // Very theoretical overflow possible here...
 }
 
 /* Prepare a revision to be emitted as a signal on the bus. The revisions
  * are queued up so that we can emit them in batches. Steals the ref on the
  * row array and assumes the refs on the variants as well */
-static void
+static DeeSharedModelRevision*
 enqueue_revision (DeeModel  *self,
                   ChangeType type,
                   guint32    pos,
@@ -456,7 +876,7 @@ enqueue_revision (DeeModel  *self,
   DeeSharedModelPrivate  *priv;
   DeeSharedModelRevision *rev;
 
-  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+  g_return_val_if_fail (DEE_IS_SHARED_MODEL (self), NULL);
   priv = DEE_SHARED_MODEL (self)->priv;
 
   rev = dee_shared_model_revision_new (type, pos, seqnum, row, self);
@@ -470,6 +890,8 @@ enqueue_revision (DeeModel  *self,
       priv->revision_queue_timeout_id =
         g_idle_add ((GSourceFunc)flush_revision_queue_timeout_cb, self);
     }
+
+  return rev;
 }
 
 /* GObject stuff */
@@ -486,6 +908,19 @@ dee_shared_model_finalize (GObject *object)
       priv->revision_queue = NULL;
     }
 
+  if (priv->snapshot_timer_id != 0)
+    {
+      g_source_remove (priv->snapshot_timer_id);
+      priv->snapshot_timer_id = 0;
+    }
+
+  if (priv->snapshot_manager != NULL)
+    {
+      store_snapshot (DEE_SHARED_MODEL (object));
+      g_object_unref (priv->snapshot_manager);
+      priv->snapshot_manager = NULL;
+    }
+
   if (priv->acquisition_timer_id != 0)
     {
       g_source_remove (priv->acquisition_timer_id);
@@ -515,6 +950,8 @@ dee_shared_model_finalize (GObject *object)
                                                info->registration_id);
           g_dbus_connection_signal_unsubscribe (info->connection,
                                                 info->signal_subscription_id);
+          if (info->subscription)
+            subscription_free (info->subscription);
         }
 
       g_array_unref (priv->connection_infos);
@@ -525,6 +962,13 @@ dee_shared_model_finalize (GObject *object)
       g_signal_handler_disconnect (priv->swarm, priv->swarm_leader_handler);
       priv->swarm_leader_handler = 0;
     }
+  invalidate_clone_cache (DEE_SHARED_MODEL (object));
+  clear_commit_history (DEE_SHARED_MODEL (object));
+  g_queue_free (priv->commit_history);
+  g_free (priv->epoch);
+  if (priv->subscription)
+    g_variant_unref (priv->subscription);
+  g_hash_table_unref (priv->peer_features);
   if (priv->model_path)
       {
         g_free (priv->model_path);
@@ -833,6 +1277,19 @@ dee_shared_model_init (DeeSharedModel *self)
   priv->found_first_peer = FALSE;
   priv->suppress_remote_signals = FALSE;
 
+  priv->clone_cache = NULL;
+  priv->clone_cache_seqnum = 0;
+  priv->clone_cache_fd = -1;
+
+  priv->epoch = g_dbus_generate_guid ();
+  priv->commit_history = g_queue_new ();
+  priv->snapshot_manager = NULL;
+  priv->snapshot_timer_id = 0;
+  priv->warm_started = FALSE;
+  priv->subscription = NULL;
+  priv->peer_features = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
+
   if (!dee_shared_model_error_quark)
     dee_shared_model_error_quark = g_quark_from_string ("dbus-model-error");
 
@@ -844,88 +1301,1153 @@ dee_shared_model_init (DeeSharedModel *self)
   g_signal_connect (self, "row-added", G_CALLBACK (on_self_row_added), NULL);
   g_signal_connect (self, "row-removed", G_CALLBACK (on_self_row_removed), NULL);
   g_signal_connect (self, "row-changed", G_CALLBACK (on_self_row_changed), NULL);
+  g_signal_connect (self, "row-moved", G_CALLBACK (on_self_row_moved), NULL);
+  g_signal_connect (self, "rows-reordered",
+                    G_CALLBACK (on_self_rows_reordered), NULL);
 }
 
+/* Drop the cached Clone reply, if any */
 static void
-handle_dbus_method_call (GDBusConnection       *connection,
-                         const gchar           *sender,
-                         const gchar           *object_path,
-                         const gchar           *interface_name,
-                         const gchar           *method_name,
-                         GVariant              *parameters,
-                         GDBusMethodInvocation *invocation,
-                         gpointer               user_data)
+invalidate_clone_cache (DeeSharedModel *self)
 {
-  GVariant              *retval;
-
-  g_return_if_fail (DEE_IS_SHARED_MODEL (user_data));
-
-  if (g_strcmp0 ("Clone", method_name) == 0)
-    {
-      /* If we have anything in the rev queue it wont validate against the
-       * seqnum for the cloned model. So flush the rev queue before answering
-       * the Clone call */
-      flush_revision_queue (DEE_MODEL (user_data));
+  DeeSharedModelPrivate *priv = self->priv;
 
-      /* We return a special error if we have no schema. It's legal for the
-       * leader to expect the schema from the slaves */
-      if (dee_model_get_n_columns (DEE_MODEL (user_data)) == 0)
-        {
-          g_dbus_method_invocation_return_dbus_error (invocation,
-                                                      "com.canonical.Dee.Model.NoSchemaError",
-                                                      "No schema defined");
-        }
-      else
-        {
-          // FIXME: It can be expensive to build the clone. Perhaps thread this?
-          retval = dee_serializable_serialize (DEE_SERIALIZABLE (user_data));
-          g_dbus_method_invocation_return_value (invocation, retval);
-          /* dee_serializable_serialize returns full ref, unref it */
-          g_variant_unref (retval);
-        }
-    }
-  else if (g_strcmp0 ("Invalidate", method_name) == 0)
+  if (priv->clone_cache != NULL)
     {
-      on_invalidate (DEE_SHARED_MODEL (user_data));
-      g_dbus_method_invocation_return_value (invocation, NULL);
+      g_variant_unref (priv->clone_cache);
+      priv->clone_cache = NULL;
     }
-  else
+
+  if (priv->clone_cache_fd >= 0)
     {
-      g_warning ("Unknown DBus method call %s.%s from %s on DeeSharedModel",
-                 interface_name, method_name, sender);
+      close (priv->clone_cache_fd);
+      priv->clone_cache_fd = -1;
     }
 }
 
-static const GDBusInterfaceVTable model_interface_vtable =
+/* Return the serialized model for a Clone reply. Concurrent or repeated
+ * Clone calls between two flushes are served from a cache keyed by the
+ * seqnum, so the model is only serialized once per revision.
+ * Returns a full reference */
+static GVariant*
+get_clone_reply (DeeSharedModel *self)
 {
-  handle_dbus_method_call,
-  NULL,
-  NULL
-};
+  DeeSharedModelPrivate *priv = self->priv;
+  guint64                seqnum;
 
-static void
-on_connection_acquired (DeeSharedModel *self,
-                        GDBusConnection *connection,
-                        DeePeer *peer)
-{
-  DeeSharedModelPrivate *priv;
-  DeeConnectionInfo      connection_info;
-  GDBusNodeInfo         *model_introspection_data;
-  guint                  dbus_signal_handler;
-  guint                  model_registration_id;
+  seqnum = dee_serializable_model_get_seqnum (DEE_MODEL (self));
 
-  /* Keep the parsed introspection data of the Model interface around */
-  static GDBusInterfaceInfo *model_interface_info = NULL;
+  if (priv->clone_cache != NULL && priv->clone_cache_seqnum == seqnum)
+    {
+      trace_object (self, "Serving Clone from cache, seqnum %"G_GUINT64_FORMAT,
+                    seqnum);
+      return g_variant_ref (priv->clone_cache);
+    }
 
-  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+  invalidate_clone_cache (self);
 
-  priv = self->priv;
+  // FIXME: It can be expensive to build the clone. Perhaps thread this?
+  priv->clone_cache = dee_serializable_serialize (DEE_SERIALIZABLE (self));
+  priv->clone_cache_seqnum = seqnum;
 
-  if (connection == NULL)
+  return g_variant_ref (priv->clone_cache);
+}
+
+/* Return a sealed memfd holding the serialized Clone reply. The fd is owned
+ * by the clone cache, so callers must dup it (GUnixFDList does that).
+ * Returns -1 and sets @error if memfds are not available */
+static gint
+get_clone_reply_fd (DeeSharedModel  *self,
+                    gsize           *out_size,
+                    GError         **error)
+{
+#ifdef HAVE_MEMFD_CREATE
+  DeeSharedModelPrivate *priv = self->priv;
+  GVariant              *clone;
+  GMappedFile           *mapped;
+  const gchar           *data;
+  gsize                  size, written;
+  gssize                 n;
+  gint                   fd;
+
+  clone = get_clone_reply (self);
+  size = g_variant_get_size (clone);
+  *out_size = size;
+
+  /* get_clone_reply() drops the fd along with a stale cache */
+  if (priv->clone_cache_fd >= 0)
     {
-      g_warning ("Internal error in DeeSharedModel. %s called with NULL "
-                 "connection", __func__);
-      return;
+      g_variant_unref (clone);
+      return priv->clone_cache_fd;
+    }
+
+  fd = memfd_create ("dee-clone", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0)
+    goto errno_out;
+
+  data = g_variant_get_data (clone);
+  for (written = 0; written < size; written += n)
+    {
+      n = write (fd, data + written, size - written);
+      if (n < 0 && errno == EINTR)
+        n = 0;
+      else if (n < 0)
+        goto errno_out;
+    }
+
+  if (fcntl (fd, F_ADD_SEALS,
+             F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+    goto errno_out;
+
+  /* Serve Clone calls from a mapping of the memfd as well, instead of
+   * keeping a second copy of the data around. The seals guarantee that
+   * the mapping stays valid */
+  mapped = g_mapped_file_new_from_fd (fd, FALSE, NULL);
+  if (mapped != NULL)
+    {
+      g_variant_unref (priv->clone_cache);
+      priv->clone_cache = g_variant_ref_sink (
+          g_variant_new_from_data (g_variant_get_type (clone),
+                                   g_mapped_file_get_contents (mapped), size,
+                                   TRUE,
+                                   (GDestroyNotify) g_mapped_file_unref,
+                                   mapped));
+    }
+
+  g_variant_unref (clone);
+  priv->clone_cache_fd = fd;
+  return fd;
+
+errno_out:
+  g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+               "Failed to write clone to memfd: %s", g_strerror (errno));
+  if (fd >= 0) close (fd);
+  g_variant_unref (clone);
+  return -1;
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "memfd_create() not available");
+  return -1;
+#endif
+}
+
+static void
+handle_clone_fd (DeeSharedModel        *self,
+                 GDBusConnection       *connection,
+                 GDBusMethodInvocation *invocation)
+{
+  GUnixFDList *fd_list;
+  GError      *error;
+  gsize        size;
+  gint         fd, fd_index;
+
+  if (!(g_dbus_connection_get_capabilities (connection) &
+        G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING))
+    {
+      g_dbus_method_invocation_return_dbus_error (invocation,
+                                                  "com.canonical.Dee.Model.NotSupportedError",
+                                                  "Connection does not support fd passing");
+      return;
+    }
+
+  error = NULL;
+  fd = get_clone_reply_fd (self, &size, &error);
+  if (fd < 0)
+    {
+      g_dbus_method_invocation_return_dbus_error (invocation,
+                                                  "com.canonical.Dee.Model.NotSupportedError",
+                                                  error->message);
+      g_error_free (error);
+      return;
+    }
+
+  fd_list = g_unix_fd_list_new ();
+  fd_index = g_unix_fd_list_append (fd_list, fd, &error);
+  if (fd_index < 0)
+    {
+      g_dbus_method_invocation_return_gerror (invocation, error);
+      g_error_free (error);
+    }
+  else
+    {
+      g_dbus_method_invocation_return_value_with_unix_fd_list (
+          invocation, g_variant_new ("(ht)", fd_index, (guint64) size), fd_list);
+    }
+
+  g_object_unref (fd_list);
+}
+
+/* Remember a Commit we sent or applied, so we can serve deltas to warm
+ * started followers if we are (or become) the leader */
+static void
+record_commit (DeeSharedModel *self,
+               GVariant       *transaction)
+{
+  GQueue *history = self->priv->commit_history;
+
+  g_queue_push_tail (history, g_variant_ref (transaction));
+  if (g_queue_get_length (history) > COMMIT_HISTORY_LENGTH)
+    g_variant_unref (g_queue_pop_head (history));
+}
+
+static void
+clear_commit_history (DeeSharedModel *self)
+{
+  GQueue *history = self->priv->commit_history;
+
+  while (!g_queue_is_empty (history))
+    g_variant_unref (g_queue_pop_head (history));
+}
+
+/*
+ * Subscriptions for filtered replication
+ */
+
+static DeeConnectionInfo*
+find_connection_info (DeeSharedModel  *self,
+                      GDBusConnection *connection)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeConnectionInfo *info;
+      info = &g_array_index (infos, DeeConnectionInfo, i);
+      if (info->connection == connection)
+        return info;
+    }
+
+  return NULL;
+}
+
+/* Return the PeerFeatures understood by every peer that receives our
+ * Commits on the connection of @info */
+static guint
+connection_features (DeeSharedModel    *self,
+                     DeeConnectionInfo *info)
+{
+  DeeSharedModelPrivate *priv = self->priv;
+  const gchar           *unique_name;
+  gchar                **peers;
+  guint                  features, i;
+
+  if (info == NULL)
+    return 0;
+
+  /* There is a single peer at the other end of a peer-to-peer connection */
+  if (DEE_IS_SERVER (priv->swarm) || DEE_IS_CLIENT (priv->swarm))
+    return info->features;
+
+  /* On a bus all peers in the swarm see our Commits. Followers only hear
+   * from the leader, so they can't vouch for the other followers */
+  if (!dee_peer_is_swarm_leader (priv->swarm))
+    return 0;
+
+  unique_name = g_dbus_connection_get_unique_name (info->connection);
+  peers = dee_peer_list_peers (priv->swarm);
+  features = PEER_FEATURES_ALL;
+  for (i = 0; peers[i] != NULL; i++)
+    {
+      if (g_strcmp0 (peers[i], unique_name) == 0)
+        continue;
+
+      features &= GPOINTER_TO_UINT (g_hash_table_lookup (priv->peer_features,
+                                                         peers[i]));
+    }
+  g_strfreev (peers);
+
+  return features;
+}
+
+/* Whether a peer that would receive our next Commit in full doesn't
+ * understand @feature. Followers with a subscription don't count, they
+ * all speak the current protocol */
+static gboolean
+peers_lack_feature (DeeSharedModel *self,
+                    guint           feature)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; i < infos->len; i++)
+    {
+      DeeConnectionInfo *info;
+      info = &g_array_index (infos, DeeConnectionInfo, i);
+      if (info->subscription == NULL &&
+          (connection_features (self, info) & feature) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Parse the 'as' of feature names of the Features method, ignoring
+ * features we don't know about */
+static guint
+parse_features (GVariant *names)
+{
+  GVariantIter  iter;
+  const gchar  *name;
+  guint         features, i;
+
+  features = 0;
+  g_variant_iter_init (&iter, names);
+  while (g_variant_iter_next (&iter, "&s", &name))
+    {
+      for (i = 0; peer_feature_names[i] != NULL; i++)
+        {
+          if (g_strcmp0 (name, peer_feature_names[i]) == 0)
+            features |= 1 << i;
+        }
+    }
+
+  return features;
+}
+
+static void
+filtered_revision_free (FilteredRevision *rev)
+{
+  if (rev->row)
+    g_variant_unref (rev->row);
+  g_slice_free (FilteredRevision, rev);
+}
+
+static void
+subscription_free (DeeSharedModelSubscription *sub)
+{
+  guint i;
+
+  for (i = 0; i < sub->n_matches; i++)
+    g_variant_unref (sub->match_values[i]);
+  g_free (sub->match_values);
+  g_free (sub->match_columns);
+  g_free (sub->columns);
+  g_variant_unref (sub->schema);
+  g_hash_table_unref (sub->row_map);
+  g_sequence_free (sub->rows);
+  g_slist_free_full (sub->revisions, (GDestroyNotify) filtered_revision_free);
+  g_slice_free (DeeSharedModelSubscription, sub);
+}
+
+/* Parse the a{sv} of a CloneFiltered call. Recognized keys are "match",
+ * an a{uv} of column values rows must be equal to, and "columns", an au of
+ * the columns to send */
+static DeeSharedModelSubscription*
+subscription_new (DeeSharedModel  *self,
+                  GVariant        *spec,
+                  GError         **error)
+{
+  DeeSharedModelSubscription *sub;
+  DeeModel                   *model = DEE_MODEL (self);
+  GVariant                   *matches, *columns, *value;
+  GVariantIter                iter;
+  const gchar               **schema;
+  guint                       n_cols, col, i;
+
+  n_cols = dee_model_get_n_columns (model);
+
+  sub = g_slice_new0 (DeeSharedModelSubscription);
+  sub->rows = g_sequence_new (NULL);
+  sub->row_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  matches = g_variant_lookup_value (spec, "match", G_VARIANT_TYPE ("a{uv}"));
+  if (matches != NULL)
+    {
+      sub->n_matches = g_variant_n_children (matches);
+      sub->match_columns = g_new (guint, sub->n_matches);
+      sub->match_values = g_new0 (GVariant*, sub->n_matches);
+
+      i = 0;
+      g_variant_iter_init (&iter, matches);
+      while (g_variant_iter_next (&iter, "{uv}", &col, &value))
+        {
+          sub->match_columns[i] = col;
+          sub->match_values[i++] = value;
+
+          if (col >= n_cols ||
+              !g_variant_is_of_type (value,
+                                     G_VARIANT_TYPE (dee_model_get_column_schema (model, col))))
+            {
+              g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "Invalid match on column %u", col);
+              sub->n_matches = i;
+              g_variant_unref (matches);
+              subscription_free (sub);
+              return NULL;
+            }
+        }
+      g_variant_unref (matches);
+    }
+
+  columns = g_variant_lookup_value (spec, "columns", G_VARIANT_TYPE ("au"));
+  if (columns != NULL && g_variant_n_children (columns) > 0)
+    {
+      sub->n_columns = g_variant_n_children (columns);
+      sub->columns = g_new (guint, sub->n_columns);
+      for (i = 0; i < sub->n_columns; i++)
+        g_variant_get_child (columns, i, "u", &sub->columns[i]);
+    }
+  else
+    {
+      sub->n_columns = n_cols;
+      sub->columns = g_new (guint, n_cols);
+      for (i = 0; i < n_cols; i++)
+        sub->columns[i] = i;
+    }
+  if (columns != NULL)
+    g_variant_unref (columns);
+
+  schema = g_new0 (const gchar*, sub->n_columns + 1);
+  for (i = 0; i < sub->n_columns; i++)
+    {
+      if (sub->columns[i] >= n_cols)
+        {
+          g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                       "Invalid column %u in projection", sub->columns[i]);
+          g_free (schema);
+          sub->schema = g_variant_ref_sink (g_variant_new_strv (NULL, 0));
+          subscription_free (sub);
+          return NULL;
+        }
+      schema[i] = dee_model_get_column_schema (model, sub->columns[i]);
+    }
+  sub->schema = g_variant_ref_sink (g_variant_new_strv (schema, -1));
+  g_free (schema);
+
+  return sub;
+}
+
+static gboolean
+subscription_matches (DeeSharedModel             *self,
+                      DeeSharedModelSubscription *sub,
+                      DeeModelIter               *iter)
+{
+  GVariant *value;
+  guint     i;
+
+  for (i = 0; i < sub->n_matches; i++)
+    {
+      value = dee_model_peek_value (DEE_MODEL (self), iter,
+                                    sub->match_columns[i]);
+      if (!g_variant_equal (value, sub->match_values[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Build the projected 'av' for a row */
+static GVariant*
+subscription_build_row (DeeSharedModel             *self,
+                        DeeSharedModelSubscription *sub,
+                        DeeModelIter               *iter)
+{
+  GVariantBuilder  av;
+  GVariant        *value;
+  guint            i;
+
+  g_variant_builder_init (&av, G_VARIANT_TYPE ("av"));
+  for (i = 0; i < sub->n_columns; i++)
+    {
+      value = dee_model_peek_value (DEE_MODEL (self), iter, sub->columns[i]);
+      g_variant_builder_add_value (&av, g_variant_new_variant (value));
+    }
+
+  return g_variant_ref_sink (g_variant_builder_end (&av));
+}
+
+static gint
+cmp_model_position (gconstpointer a,
+                    gconstpointer b,
+                    gpointer      model)
+{
+  guint pos_a, pos_b;
+
+  pos_a = dee_model_get_position ((DeeModel*) model, (DeeModelIter*) a);
+  pos_b = dee_model_get_position ((DeeModel*) model, (DeeModelIter*) b);
+
+  return pos_a < pos_b ? -1 : (pos_a > pos_b ? 1 : 0);
+}
+
+/* Queue up a revision for the follower, unless the change is coming
+ * from a remote peer */
+static void
+subscription_enqueue (DeeSharedModel             *self,
+                      DeeSharedModelSubscription *sub,
+                      ChangeType                  type,
+                      guint32                     pos,
+                      DeeModelIter               *iter)
+{
+  FilteredRevision *rev;
+
+  if (self->priv->suppress_remote_signals)
+    return;
+
+  rev = g_slice_new (FilteredRevision);
+  rev->change_type = (guchar) type;
+  rev->pos = pos;
+  rev->row = iter != NULL ? subscription_build_row (self, sub, iter) : NULL;
+  sub->revisions = g_slist_prepend (sub->revisions, rev);
+}
+
+static guint32
+subscription_insert (DeeSharedModel             *self,
+                     DeeSharedModelSubscription *sub,
+                     DeeModelIter               *iter)
+{
+  GSequenceIter *seq_iter;
+
+  seq_iter = g_sequence_insert_sorted (sub->rows, iter,
+                                       cmp_model_position, self);
+  g_hash_table_insert (sub->row_map, iter, seq_iter);
+
+  return g_sequence_iter_get_position (seq_iter);
+}
+
+static guint32
+subscription_remove (DeeSharedModelSubscription *sub,
+                     GSequenceIter              *seq_iter,
+                     DeeModelIter               *iter)
+{
+  guint32 pos;
+
+  pos = g_sequence_iter_get_position (seq_iter);
+  g_hash_table_remove (sub->row_map, iter);
+  g_sequence_remove (seq_iter);
+
+  return pos;
+}
+
+static void
+subscriptions_row_added (DeeSharedModel *self,
+                         DeeModelIter   *iter)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription *sub;
+      guint32                     pos;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL || !subscription_matches (self, sub, iter))
+        continue;
+
+      pos = subscription_insert (self, sub, iter);
+      subscription_enqueue (self, sub, CHANGE_TYPE_ADD, pos, iter);
+    }
+}
+
+static void
+subscriptions_row_removed (DeeSharedModel *self,
+                           DeeModelIter   *iter)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription *sub;
+      GSequenceIter              *seq_iter;
+      guint32                     pos;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL)
+        continue;
+
+      seq_iter = g_hash_table_lookup (sub->row_map, iter);
+      if (seq_iter == NULL)
+        continue;
+
+      pos = subscription_remove (sub, seq_iter, iter);
+      subscription_enqueue (self, sub, CHANGE_TYPE_REMOVE, pos, NULL);
+    }
+}
+
+/* A changed row may enter or leave the view of a follower, in which case
+ * it sees an addition or a removal instead of a change */
+static void
+subscriptions_row_changed (DeeSharedModel *self,
+                           DeeModelIter   *iter)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription *sub;
+      GSequenceIter              *seq_iter;
+      gboolean                    matches;
+      guint32                     pos;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL)
+        continue;
+
+      seq_iter = g_hash_table_lookup (sub->row_map, iter);
+      matches = subscription_matches (self, sub, iter);
+
+      if (seq_iter != NULL && matches)
+        {
+          pos = g_sequence_iter_get_position (seq_iter);
+          subscription_enqueue (self, sub, CHANGE_TYPE_CHANGE, pos, iter);
+        }
+      else if (seq_iter != NULL)
+        {
+          pos = subscription_remove (sub, seq_iter, iter);
+          subscription_enqueue (self, sub, CHANGE_TYPE_REMOVE, pos, NULL);
+        }
+      else if (matches)
+        {
+          pos = subscription_insert (self, sub, iter);
+          subscription_enqueue (self, sub, CHANGE_TYPE_ADD, pos, iter);
+        }
+    }
+}
+
+/* Only the position of a moved row changes, so it stays in or out of the
+ * view of a follower. Followers that see it get a move in their own
+ * positions, unless the rows it jumped over are all hidden from them */
+static void
+subscriptions_row_moved (DeeSharedModel *self,
+                         DeeModelIter   *iter)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription *sub;
+      GSequenceIter              *seq_iter;
+      FilteredRevision           *rev;
+      guint32                     old_pos, new_pos;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL)
+        continue;
+
+      seq_iter = g_hash_table_lookup (sub->row_map, iter);
+      if (seq_iter == NULL)
+        continue;
+
+      old_pos = g_sequence_iter_get_position (seq_iter);
+      g_sequence_sort_changed (seq_iter, cmp_model_position, self);
+      new_pos = g_sequence_iter_get_position (seq_iter);
+
+      if (old_pos == new_pos || self->priv->suppress_remote_signals)
+        continue;
+
+      rev = g_slice_new (FilteredRevision);
+      rev->change_type = (guchar) CHANGE_TYPE_MOVE;
+      rev->pos = old_pos;
+      rev->row = g_variant_ref_sink (build_move_payload (new_pos));
+      sub->revisions = g_slist_prepend (sub->revisions, rev);
+    }
+}
+
+/* Restore the model order of the rows matching a subscription after the
+ * model has been reordered, and tell the follower how they moved */
+static void
+subscriptions_rows_reordered (DeeSharedModel *self)
+{
+  GArray *infos = self->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription  *sub;
+      GSequenceIter              **seq_iters, *seq_iter;
+      FilteredRevision            *rev;
+      guint                       *filtered_order;
+      guint                        n_rows, j, pos;
+      gboolean                     reordered;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL)
+        continue;
+
+      n_rows = g_sequence_get_length (sub->rows);
+      if (n_rows < 2)
+        continue;
+
+      seq_iters = g_new (GSequenceIter*, n_rows);
+      seq_iter = g_sequence_get_begin_iter (sub->rows);
+      for (j = 0; j < n_rows; j++)
+        {
+          seq_iters[j] = seq_iter;
+          seq_iter = g_sequence_iter_next (seq_iter);
+        }
+
+      g_sequence_sort (sub->rows, cmp_model_position, self);
+
+      filtered_order = g_new (guint, n_rows);
+      reordered = FALSE;
+      for (j = 0; j < n_rows; j++)
+        {
+          pos = g_sequence_iter_get_position (seq_iters[j]);
+          filtered_order[pos] = j;
+          reordered |= pos != j;
+        }
+
+      if (reordered && !self->priv->suppress_remote_signals)
+        {
+          rev = g_slice_new (FilteredRevision);
+          rev->change_type = (guchar) CHANGE_TYPE_REORDER;
+          rev->pos = 0;
+          rev->row = g_variant_ref_sink (build_reorder_payload (filtered_order,
+                                                                n_rows));
+          sub->revisions = g_slist_prepend (sub->revisions, rev);
+        }
+
+      g_free (filtered_order);
+      g_free (seq_iters);
+    }
+}
+
+/* Called before the model is cleared. The rows are untracked one by one
+ * by subscriptions_row_removed() as the clear progresses */
+static void
+subscriptions_enqueue_clear (DeeModel *self)
+{
+  GArray *infos = DEE_SHARED_MODEL (self)->priv->connection_infos;
+  guint   i;
+
+  for (i = 0; infos != NULL && i < infos->len; i++)
+    {
+      DeeSharedModelSubscription *sub;
+
+      sub = g_array_index (infos, DeeConnectionInfo, i).subscription;
+      if (sub == NULL || g_sequence_get_length (sub->rows) == 0)
+        continue;
+
+      subscription_enqueue (DEE_SHARED_MODEL (self), sub,
+                            CHANGE_TYPE_CLEAR, 0, NULL);
+    }
+}
+
+/* Build the Commit for a follower with a subscription from the revisions
+ * queued for it. Returns NULL if there is nothing to send */
+static GVariant*
+build_filtered_commit (DeeSharedModel             *self,
+                       DeeSharedModelSubscription *sub,
+                       guint64                     seqnum_end)
+{
+  GVariantBuilder   aav, au, ay;
+  FilteredRevision *rev;
+  GSList           *iter;
+  GVariant         *commit;
+
+  if (sub->revisions == NULL)
+    return NULL;
+
+  sub->revisions = g_slist_reverse (sub->revisions);
+
+  g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
+  g_variant_builder_init (&au, G_VARIANT_TYPE ("au"));
+  g_variant_builder_init (&ay, G_VARIANT_TYPE ("ay"));
+  for (iter = sub->revisions; iter; iter = iter->next)
+    {
+      rev = (FilteredRevision*) iter->data;
+
+      if (rev->row != NULL)
+        g_variant_builder_add_value (&aav, rev->row);
+      else
+        g_variant_builder_add_value (&aav,
+                                     g_variant_new_array (G_VARIANT_TYPE_VARIANT,
+                                                          NULL, 0));
+      g_variant_builder_add (&au, "u", rev->pos);
+      g_variant_builder_add (&ay, "y", rev->change_type);
+    }
+
+  /* Followers only see the changes they're interested in, so the seqnum
+   * range starts where the previous Commit we sent them ended */
+  commit = g_variant_new ("(s@as@aav@au@ay(tt))",
+                          dee_shared_model_get_swarm_name (self),
+                          sub->schema,
+                          g_variant_builder_end (&aav),
+                          g_variant_builder_end (&au),
+                          g_variant_builder_end (&ay),
+                          sub->last_sent_seqnum, seqnum_end);
+
+  sub->last_sent_seqnum = seqnum_end;
+  g_slist_free_full (sub->revisions, (GDestroyNotify) filtered_revision_free);
+  sub->revisions = NULL;
+
+  return commit;
+}
+
+/* Build the Clone reply for a follower with a subscription */
+static GVariant*
+build_filtered_clone (DeeSharedModel             *self,
+                      DeeSharedModelSubscription *sub)
+{
+  DeeModel        *model = DEE_MODEL (self);
+  GVariantBuilder  aav, au, ay, hints, fields;
+  GSequenceIter   *seq_iter, *end;
+  GHashTable      *field_schemas;
+  GHashTableIter   ht_iter;
+  gpointer         key, value;
+  const gchar    **column_names, **projected_names;
+  guint            i, n_rows;
+  guint64          seqnum;
+
+  g_variant_builder_init (&aav, G_VARIANT_TYPE ("aav"));
+  g_variant_builder_init (&au, G_VARIANT_TYPE ("au"));
+  g_variant_builder_init (&ay, G_VARIANT_TYPE ("ay"));
+
+  n_rows = 0;
+  seq_iter = g_sequence_get_begin_iter (sub->rows);
+  end = g_sequence_get_end_iter (sub->rows);
+  for (; seq_iter != end; seq_iter = g_sequence_iter_next (seq_iter))
+    {
+      GVariant *row;
+
+      row = subscription_build_row (self, sub, g_sequence_get (seq_iter));
+      g_variant_builder_add_value (&aav, row);
+      g_variant_unref (row);
+      g_variant_builder_add (&au, "u", n_rows++);
+      g_variant_builder_add (&ay, "y", (guchar) CHANGE_TYPE_ADD);
+    }
+
+  /* Project the column names and vardict schemas as well */
+  g_variant_builder_init (&hints, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_init (&fields, G_VARIANT_TYPE ("a(uss)"));
+  column_names = dee_model_get_column_names (model, NULL);
+  projected_names = g_new0 (const gchar*, sub->n_columns + 1);
+  for (i = 0; i < sub->n_columns; i++)
+    {
+      if (column_names != NULL)
+        projected_names[i] = column_names[sub->columns[i]];
+
+      if (!g_variant_type_is_subtype_of (
+              G_VARIANT_TYPE (dee_model_get_column_schema (model, sub->columns[i])),
+              G_VARIANT_TYPE_VARDICT))
+        continue;
+
+      field_schemas = dee_model_get_vardict_schema (model, sub->columns[i]);
+      if (field_schemas == NULL) continue;
+      g_hash_table_iter_init (&ht_iter, field_schemas);
+      while (g_hash_table_iter_next (&ht_iter, &key, &value))
+        g_variant_builder_add (&fields, "(uss)", i, key, value);
+      g_hash_table_unref (field_schemas);
+    }
+  g_variant_builder_add (&hints, "{sv}", "column-names",
+                         g_variant_new_strv (projected_names,
+                                             column_names != NULL ? sub->n_columns : 0));
+  g_variant_builder_add (&hints, "{sv}", "fields", g_variant_builder_end (&fields));
+  g_free (projected_names);
+
+  seqnum = dee_serializable_model_get_seqnum (model);
+  sub->last_sent_seqnum = seqnum;
+
+  return g_variant_new ("(s@as@aav@au@ay(tt)@a{sv})",
+                        dee_shared_model_get_swarm_name (self),
+                        sub->schema,
+                        g_variant_builder_end (&aav),
+                        g_variant_builder_end (&au),
+                        g_variant_builder_end (&ay),
+                        seqnum - n_rows, seqnum,
+                        g_variant_builder_end (&hints));
+}
+
+/* Register (or replace) the subscription of the follower on @connection and
+ * return its filtered Clone, or NULL with @error set */
+static GVariant*
+handle_clone_filtered (DeeSharedModel   *self,
+                       GDBusConnection  *connection,
+                       GVariant         *spec,
+                       GError          **error)
+{
+  DeeConnectionInfo          *info;
+  DeeSharedModelSubscription *sub;
+  DeeModelIter               *iter, *end;
+  DeeModel                   *model = DEE_MODEL (self);
+
+  /* On a bus all followers share the connection and the Commit signals,
+   * so filtering is only possible for peer-to-peer connections */
+  info = find_connection_info (self, connection);
+  if (!DEE_IS_SERVER (self->priv->swarm) || info == NULL)
+    {
+      g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED,
+                           "Filtered replication requires a DeeServer");
+      return NULL;
+    }
+
+  sub = subscription_new (self, spec, error);
+  if (sub == NULL)
+    return NULL;
+
+  iter = dee_model_get_first_iter (model);
+  end = dee_model_get_last_iter (model);
+  while (iter != end)
+    {
+      if (subscription_matches (self, sub, iter))
+        {
+          g_hash_table_insert (sub->row_map, iter,
+                               g_sequence_append (sub->rows, iter));
+        }
+      iter = dee_model_next (model, iter);
+    }
+
+  if (info->subscription)
+    subscription_free (info->subscription);
+  info->subscription = sub;
+
+  trace_object (self, "Registered subscription with %u of %u rows",
+                g_sequence_get_length (sub->rows), dee_model_get_n_rows (model));
+
+  return build_filtered_clone (self, sub);
+}
+
+/* Forget the subscription of the follower on @connection, if it had one.
+ * Called when the follower asks for the full model again */
+static void
+drop_subscription (DeeSharedModel  *self,
+                   GDBusConnection *connection)
+{
+  DeeConnectionInfo *info;
+
+  info = find_connection_info (self, connection);
+  if (info == NULL || info->subscription == NULL)
+    return;
+
+  subscription_free (info->subscription);
+  info->subscription = NULL;
+
+  trace_object (self, "Dropped subscription of follower");
+}
+
+/* Collect the Commits needed to bring a model at @seqnum in lineage @epoch
+ * up to date with us. Returns NULL if we don't have that history */
+static GVariant*
+build_delta (DeeSharedModel *self,
+             const gchar    *epoch,
+             guint64         seqnum)
+{
+  DeeSharedModelPrivate *priv = self->priv;
+  GVariantBuilder        commits;
+  GList                 *iter;
+  guint64                current, commit_begin, commit_end;
+
+  current = dee_serializable_model_get_seqnum (DEE_MODEL (self));
+
+  if (g_strcmp0 (epoch, priv->epoch) != 0 || seqnum > current)
+    return NULL;
+
+  g_variant_builder_init (&commits, G_VARIANT_TYPE ("a(sasaavauay(tt))"));
+
+  /* Find the Commit starting at @seqnum and make sure the chain from there
+   * is unbroken all the way to our current seqnum */
+  for (iter = priv->commit_history->head;
+       iter != NULL && seqnum != current; iter = iter->next)
+    {
+      g_variant_get_child ((GVariant*) iter->data, 5, "(tt)",
+                           &commit_begin, &commit_end);
+
+      if (commit_begin < seqnum)
+        continue;
+      if (commit_begin != seqnum)
+        break;
+
+      g_variant_builder_add_value (&commits, (GVariant*) iter->data);
+      seqnum = commit_end;
+    }
+
+  if (seqnum != current)
+    {
+      g_variant_builder_clear (&commits);
+      return NULL;
+    }
+
+  return g_variant_new ("(@a(sasaavauay(tt)))",
+                        g_variant_builder_end (&commits));
+}
+
+static void
+handle_dbus_method_call (GDBusConnection       *connection,
+                         const gchar           *sender,
+                         const gchar           *object_path,
+                         const gchar           *interface_name,
+                         const gchar           *method_name,
+                         GVariant              *parameters,
+                         GDBusMethodInvocation *invocation,
+                         gpointer               user_data)
+{
+  GVariant              *retval;
+  DeeConnectionInfo     *info;
+
+  g_return_if_fail (DEE_IS_SHARED_MODEL (user_data));
+
+  if (g_strcmp0 ("Clone", method_name) == 0)
+    {
+      /* If we have anything in the rev queue it wont validate against the
+       * seqnum for the cloned model. So flush the rev queue before answering
+       * the Clone call */
+      flush_revision_queue (DEE_MODEL (user_data));
+      drop_subscription (DEE_SHARED_MODEL (user_data), connection);
+
+      /* We return a special error if we have no schema. It's legal for the
+       * leader to expect the schema from the slaves */
+      if (dee_model_get_n_columns (DEE_MODEL (user_data)) == 0)
+        {
+          g_dbus_method_invocation_return_dbus_error (invocation,
+                                                      "com.canonical.Dee.Model.NoSchemaError",
+                                                      "No schema defined");
+        }
+      else
+        {
+          retval = get_clone_reply (DEE_SHARED_MODEL (user_data));
+          g_dbus_method_invocation_return_value (invocation, retval);
+          /* get_clone_reply returns full ref, unref it */
+          g_variant_unref (retval);
+        }
+    }
+  else if (g_strcmp0 ("CloneFd", method_name) == 0)
+    {
+      /* Same as Clone, but the reply is passed as a sealed memfd. This is
+       * only worthwhile for peer-to-peer connections where both ends share
+       * a host, which is where fd passing is available anyway */
+      flush_revision_queue (DEE_MODEL (user_data));
+      drop_subscription (DEE_SHARED_MODEL (user_data), connection);
+
+      if (dee_model_get_n_columns (DEE_MODEL (user_data)) == 0)
+        {
+          g_dbus_method_invocation_return_dbus_error (invocation,
+                                                      "com.canonical.Dee.Model.NoSchemaError",
+                                                      "No schema defined");
+        }
+      else
+        {
+          handle_clone_fd (DEE_SHARED_MODEL (user_data), connection, invocation);
+        }
+    }
+  else if (g_strcmp0 ("CloneFiltered", method_name) == 0)
+    {
+      GVariant *spec;
+      GError   *error = NULL;
+
+      flush_revision_queue (DEE_MODEL (user_data));
+
+      if (dee_model_get_n_columns (DEE_MODEL (user_data)) == 0)
+        {
+          g_dbus_method_invocation_return_dbus_error (invocation,
+                                                      "com.canonical.Dee.Model.NoSchemaError",
+                                                      "No schema defined");
+          return;
+        }
+
+      g_variant_get (parameters, "(@a{sv})", &spec);
+      retval = handle_clone_filtered (DEE_SHARED_MODEL (user_data),
+                                      connection, spec, &error);
+      g_variant_unref (spec);
+
+      if (retval == NULL)
+        {
+          g_dbus_method_invocation_return_gerror (invocation, error);
+          g_error_free (error);
+        }
+      else
+        {
+          g_dbus_method_invocation_return_value (invocation, retval);
+        }
+    }
+  else if (g_strcmp0 ("CloneSince", method_name) == 0)
+    {
+      const gchar *epoch;
+      guint64      seqnum;
+
+      flush_revision_queue (DEE_MODEL (user_data));
+
+      g_variant_get (parameters, "(&st)", &epoch, &seqnum);
+      info = find_connection_info (DEE_SHARED_MODEL (user_data), connection);
+      /* Subscribed followers don't see the full Commits in our history */
+      if (info != NULL && info->subscription != NULL)
+        retval = NULL;
+      else
+        retval = build_delta (DEE_SHARED_MODEL (user_data), epoch, seqnum);
+
+      if (retval == NULL)
+        {
+          g_dbus_method_invocation_return_dbus_error (invocation,
+                                                      "com.canonical.Dee.Model.SeqnumUnavailableError",
+                                                      "Unable to serve changes since the requested seqnum");
+        }
+      else
+        {
+          g_dbus_method_invocation_return_value (invocation, retval);
+        }
+    }
+  else if (g_strcmp0 ("Features", method_name) == 0)
+    {
+      GVariant *names;
+      guint     features;
+
+      g_variant_get (parameters, "(@as)", &names);
+      features = parse_features (names);
+      g_variant_unref (names);
+
+      /* Followers on a bus share the connection, so tell them apart by
+       * their unique names. Peer-to-peer connections have no sender */
+      if (sender != NULL)
+        {
+          g_hash_table_insert (DEE_SHARED_MODEL (user_data)->priv->peer_features,
+                               g_strdup (sender), GUINT_TO_POINTER (features));
+        }
+      else
+        {
+          info = find_connection_info (DEE_SHARED_MODEL (user_data),
+                                       connection);
+          if (info != NULL)
+            info->features = features;
+        }
+
+      g_dbus_method_invocation_return_value (invocation,
+          g_variant_new ("(^as)", peer_feature_names));
+    }
+  else if (g_strcmp0 ("Invalidate", method_name) == 0)
+    {
+      on_invalidate (DEE_SHARED_MODEL (user_data));
+      g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+  else
+    {
+      g_warning ("Unknown DBus method call %s.%s from %s on DeeSharedModel",
+                 interface_name, method_name, sender);
+    }
+}
+
+static const GDBusInterfaceVTable model_interface_vtable =
+{
+  handle_dbus_method_call,
+  NULL,
+  NULL
+};
+
+static void
+on_connection_acquired (DeeSharedModel *self,
+                        GDBusConnection *connection,
+                        DeePeer *peer)
+{
+  DeeSharedModelPrivate *priv;
+  DeeConnectionInfo      connection_info;
+  GDBusNodeInfo         *model_introspection_data;
+  guint                  dbus_signal_handler;
+  guint                  model_registration_id;
+
+  /* Keep the parsed introspection data of the Model interface around */
+  static GDBusInterfaceInfo *model_interface_info = NULL;
+
+  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+
+  priv = self->priv;
+
+  if (connection == NULL)
+    {
+      g_warning ("Internal error in DeeSharedModel. %s called with NULL "
+                 "connection", __func__);
+      return;
     }
 
   /* Update our list of connections */
@@ -946,102 +2468,455 @@ on_connection_acquired (DeeSharedModel *self,
                                          self,                // user data
                                          NULL);               // user data destroy
 
-  /* Load com.canonical.Dee.Model introspection XML on first run */
-  if (model_interface_info == NULL)
+  /* Load com.canonical.Dee.Model introspection XML on first run */
+  if (model_interface_info == NULL)
+    {
+      model_introspection_data = g_dbus_node_info_new_for_xml (
+                                             com_canonical_Dee_Model_xml, NULL);
+      model_interface_info = g_dbus_node_info_lookup_interface (
+                                                     model_introspection_data,
+                                                     "com.canonical.Dee.Model");
+
+      g_dbus_interface_info_ref (model_interface_info);
+      g_dbus_node_info_unref (model_introspection_data);
+    }
+
+  /* Export the model on the bus */
+  model_registration_id =
+      g_dbus_connection_register_object (connection,
+                                         priv->model_path, /* object path */
+                                         model_interface_info,
+                                         &model_interface_vtable,
+                                         self,  /* user_data */
+                                         NULL,  /* user_data_free_func */
+                                         NULL); /* GError** */
+
+  connection_info.connection = connection;
+  connection_info.signal_subscription_id = dbus_signal_handler;
+  connection_info.registration_id = model_registration_id;
+  connection_info.subscription = NULL;
+  connection_info.features = 0;
+  g_array_append_val (priv->connection_infos, connection_info);
+
+  /* If we are swarm leaders and we have column type info we are ready by now.
+   * Otherwise we will be ready when we receive the model clone from the leader
+   */
+  if (dee_peer_is_swarm_leader (priv->swarm))
+    {
+      if (dee_model_get_n_columns (DEE_MODEL (self)) > 0 && !priv->synchronized)
+        {
+          priv->synchronized = TRUE;
+          g_object_notify (G_OBJECT (self), "synchronized");
+        }
+    }
+  else if (dee_peer_get_swarm_leader (priv->swarm) != NULL)
+    {
+      /* There is a leader and it's not us.
+       * Start cloning the model of the leader */
+
+      clone_leader (self);
+    }
+  else
+    {
+      // FIXME: There's no known leader, peer should soon emit notify::swarm-leader
+    }
+}
+
+static void
+on_connection_closed (DeeSharedModel  *self,
+                      GDBusConnection *connection,
+                      DeePeer         *peer)
+{
+  DeeSharedModelPrivate *priv;
+  guint i;
+
+  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+
+  priv = self->priv;
+
+  /* Update our list of connections */
+  if (priv->connections) g_slist_free (priv->connections);
+  priv->connections = dee_peer_get_connections (priv->swarm);
+
+  /* Disconnect signals etc */
+  for (i = 0; i < priv->connection_infos->len; i++)
+    {
+      DeeConnectionInfo *info;
+      info = &g_array_index (priv->connection_infos, DeeConnectionInfo, i);
+      if (info->connection == connection)
+        {
+          g_dbus_connection_unregister_object (info->connection,
+                                               info->registration_id);
+          g_dbus_connection_signal_unsubscribe (info->connection,
+                                                info->signal_subscription_id);
+          if (info->subscription)
+            subscription_free (info->subscription);
+          /* remove the item */
+          g_array_remove_index (priv->connection_infos, i);
+          break;
+        }
+    }
+}
+
+/* Replace the contents of the model with a serialized Clone. Returns FALSE
+ * if @data is not in a recognized format */
+static gboolean
+apply_clone (DeeSharedModel *self,
+             GVariant       *data)
+{
+  DeeModel              *model;
+  DeeSharedModelPrivate *priv;
+  GVariant              *transaction;
+  const gchar          **column_names;
+  guint                  i, n_column_names;
+  GVariant              *vardict;
+  GVariantIter          *iter;
+  gchar                 *epoch;
+
+  priv = self->priv;
+  model = DEE_MODEL (self);
+
+  /* Guard against a race where we might inadvertedly have accepted a Commit
+   * before receiving the initial Clone */
+  if (dee_model_get_n_columns (model) > 0)
+    {
+      priv->suppress_remote_signals = TRUE;
+      reset_model (model);
+      priv->suppress_remote_signals = FALSE;
+    }
+
+  /* Support both the 1.0 Clone signature as well as the 1.2 */
+  if (g_variant_type_equal (g_variant_get_type (data),
+                            CLONE_VARIANT_TYPE))
+    {
+      GVariant *transaction_members[COMMIT_TUPLE_ITEMS];
+      guint n_elements;
+
+      n_elements = G_N_ELEMENTS (transaction_members);
+
+      for (i = 0; i < n_elements; i++)
+        transaction_members[i] = g_variant_get_child_value (data, i);
+
+      transaction = g_variant_new_tuple (transaction_members, n_elements);
+      transaction = g_variant_ref_sink (transaction);
+
+      vardict = g_variant_get_child_value (data, 6);
+
+      if (g_variant_lookup (vardict, "column-names", "^a&s", &column_names))
+        n_column_names = g_strv_length ((gchar**) column_names);
+      else
+        column_names = NULL;
+      if (!g_variant_lookup (vardict, "fields", "a(uss)", &iter))
+        iter = NULL;
+
+      for (i = 0; i < n_elements; i++)
+        g_variant_unref (transaction_members[i]);
+    }
+  else if (g_variant_type_equal (g_variant_get_type (data),
+                                 COMMIT_VARIANT_TYPE))
+    {
+      transaction = g_variant_ref (data);
+      vardict = NULL;
+    }
+  else
+    {
+      g_critical ("Unable to Clone model: Unrecognized schema");
+      return FALSE;
+    }
+
+  /* We use the swarm name as sender_name here, because DBus passes us the
+  * unique name of the swarm leader here and we want to indicate in the debug
+  * messages that the transaction came from the leader */
+  commit_transaction (self,
+                      dee_shared_model_get_swarm_name (self),
+                      transaction);
+
+  /* A Clone is a snapshot, not a delta, so it can't be part of the history */
+  clear_commit_history (self);
+
+  if (vardict)
+    {
+      if (column_names && n_column_names > 0
+          && dee_model_get_column_names (model, NULL) == NULL)
+        {
+          dee_model_set_column_names_full (model, column_names, n_column_names);
+
+          if (iter != NULL)
+            {
+              dee_shared_model_parse_vardict_schemas (model, iter,
+                                                      n_column_names);
+              g_variant_iter_free (iter);
+            }
+        }
+
+      /* Adopt the data lineage of the model we cloned */
+      if (g_variant_lookup (vardict, "epoch", "s", &epoch))
+        {
+          g_free (priv->epoch);
+          priv->epoch = epoch;
+        }
+
+      g_free (column_names);
+      g_variant_unref (vardict);
+    }
+
+  g_variant_unref (transaction);
+
+  return TRUE;
+}
+
+/* Apply the reply to a Clone or CloneFd call. Consumes @data and @error */
+static void
+process_clone_reply (DeeSharedModel *self,
+                     GVariant       *data,
+                     GError         *error)
+{
+  DeeSharedModelPrivate *priv;
+  gchar                 *dbus_error;
+
+  priv = self->priv;
+
+  if (error != NULL)
+    {
+      dbus_error = g_dbus_error_get_remote_error (error);
+      if (g_strcmp0 (dbus_error, "com.canonical.Dee.Model.NoSchemaError") == 0)
+        {
+          trace_object (self, "Got Clone reply from leader, but leader has no schema");
+          g_error_free (error);
+          g_free (dbus_error);
+        }
+      else
+        {
+          g_critical ("Failed to clone model from leader: %s", error->message);
+          g_error_free (error);
+          g_free (dbus_error);
+          goto clone_recieved_out;
+        }
+    }
+
+  /* The data will be NULL if we received a com.canonical.Dee.Model.NoSchemaError,
+   * but in that case we should still consider our selves synchronized */
+  if (data != NULL)
     {
-      model_introspection_data = g_dbus_node_info_new_for_xml (
-                                             com_canonical_Dee_Model_xml, NULL);
-      model_interface_info = g_dbus_node_info_lookup_interface (
-                                                     model_introspection_data,
-                                                     "com.canonical.Dee.Model");
+      gboolean applied = apply_clone (self, data);
 
-      g_dbus_interface_info_ref (model_interface_info);
-      g_dbus_node_info_unref (model_introspection_data);
+      g_variant_unref (data);
+      if (!applied)
+        goto clone_recieved_out;
     }
 
-  /* Export the model on the bus */
-  model_registration_id =
-      g_dbus_connection_register_object (connection,
-                                         priv->model_path, /* object path */
-                                         model_interface_info,
-                                         &model_interface_vtable,
-                                         self,  /* user_data */
-                                         NULL,  /* user_data_free_func */
-                                         NULL); /* GError** */
+  /* If we where invalidated before, we should be fine now */
+  if (!priv->synchronized)
+    {
+      priv->synchronized = TRUE;
+      g_object_notify (G_OBJECT (self), "synchronized");
+    }
 
-  connection_info.connection = connection;
-  connection_info.signal_subscription_id = dbus_signal_handler;
-  connection_info.registration_id = model_registration_id;
-  g_array_append_val (priv->connection_infos, connection_info);
+  schedule_snapshot (self);
 
-  /* If we are swarm leaders and we have column type info we are ready by now.
-   * Otherwise we will be ready when we receive the model clone from the leader
-   */
-  if (dee_peer_is_swarm_leader (priv->swarm))
+clone_recieved_out:
+  priv->clone_in_progress = FALSE;
+}
+
+/* Callback for clone_leader() */
+static void
+on_clone_received (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  DeeSharedModel        *self;
+  GVariant              *data;
+  GError                *error;
+  GWeakRef              *weak_ref;
+
+  weak_ref = (GWeakRef*) user_data;
+  self = (DeeSharedModel*) g_weak_ref_get (weak_ref);
+  if (self == NULL)
     {
-      if (dee_model_get_n_columns (DEE_MODEL (self)) > 0 && !priv->synchronized)
-        {
-          priv->synchronized = TRUE;
-          g_object_notify (G_OBJECT (self), "synchronized");
-        }
+      g_weak_ref_clear (weak_ref);
+      g_free (weak_ref);
+      return;
     }
-  else if (dee_peer_get_swarm_leader (priv->swarm) != NULL)
+
+  error = NULL;
+  data = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
+                                        res, &error);
+
+  process_clone_reply (self, data, error);
+
+  g_object_unref (self); // weak ref got us a strong reference
+  g_weak_ref_clear (weak_ref);
+  g_free (weak_ref);
+}
+
+static void
+on_features_received (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  DeeSharedModel        *self;
+  DeeConnectionInfo     *info;
+  GVariant              *reply, *names;
+  GError                *error;
+  GWeakRef              *weak_ref;
+
+  weak_ref = (GWeakRef*) user_data;
+  self = (DeeSharedModel*) g_weak_ref_get (weak_ref);
+  g_weak_ref_clear (weak_ref);
+  g_free (weak_ref);
+
+  error = NULL;
+  reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
+                                         res, &error);
+
+  if (self == NULL)
     {
-      /* There is a leader and it's not us.
-       * Start cloning the model of the leader */
+      if (reply != NULL)
+        g_variant_unref (reply);
+      if (error != NULL)
+        g_error_free (error);
+      return;
+    }
 
-      clone_leader (self);
+  if (reply == NULL)
+    {
+      /* Leaders predating the Features method only speak the basic
+       * protocol, which is what we assume until told otherwise */
+      trace_object (self, "Leader features unknown: %s", error->message);
+      g_error_free (error);
     }
   else
     {
-      // FIXME: There's no known leader, peer should soon emit notify::swarm-leader
+      info = find_connection_info (self, G_DBUS_CONNECTION (source_object));
+      if (info != NULL)
+        {
+          g_variant_get (reply, "(@as)", &names);
+          info->features = parse_features (names);
+          g_variant_unref (names);
+        }
+      g_variant_unref (reply);
     }
+
+  g_object_unref (self); // weak ref got us a strong reference
 }
 
+/* Tell the leader on @connection which protocol features we understand
+ * and learn which ones it does */
 static void
-on_connection_closed (DeeSharedModel  *self,
-                      GDBusConnection *connection,
-                      DeePeer         *peer)
+call_features (DeeSharedModel  *self,
+               GDBusConnection *connection)
 {
-  DeeSharedModelPrivate *priv;
-  guint i;
+  GWeakRef *weak_ref;
+
+  weak_ref = g_new (GWeakRef, 1);
+  g_weak_ref_init (weak_ref, self);
+
+  g_dbus_connection_call (connection,
+                          dee_shared_model_get_swarm_name (self), // name
+                          self->priv->model_path,                 // obj path
+                          "com.canonical.Dee.Model",              // iface
+                          "Features",                             // member
+                          g_variant_new ("(^as)", peer_feature_names),
+                          G_VARIANT_TYPE ("(as)"),                // ret type
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,                                     // timeout
+                          NULL,                                   // cancel
+                          on_features_received,                   // cb
+                          weak_ref);                              // userdata
+}
 
-  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+/* Issue a plain Clone call on @connection, with a weak ref to @self */
+static void
+call_clone (DeeSharedModel  *self,
+            GDBusConnection *connection,
+            GWeakRef        *weak_ref)
+{
+  g_dbus_connection_call(connection,
+                         dee_shared_model_get_swarm_name (self), // name
+                         self->priv->model_path,                 // obj path
+                         "com.canonical.Dee.Model",              // iface
+                         "Clone",                                // member
+                         NULL,                                   // args
+                         NULL,                                   // ret type
+                         G_DBUS_CALL_FLAGS_NONE,
+                         -1,                                     // timeout
+                         NULL,                                   // cancel
+                         on_clone_received,                      // cb
+                         weak_ref);                              // userdata
+}
 
-  priv = self->priv;
+/* Map the memfd passed in a CloneFd reply and wrap it in a GVariant
+ * without copying. The leader must have sealed the memfd against writes and
+ * shrinking, otherwise it could change the data under our feet or truncate
+ * it and have us killed by SIGBUS. Returns a full reference or NULL on error,
+ * in which case the caller falls back to a regular Clone */
+static GVariant*
+map_clone_fd (GVariant     *reply,
+              GUnixFDList  *fd_list,
+              GError      **error)
+{
+  GMappedFile *mapped;
+  gint32       fd_index;
+  guint64      size;
+  gint         fd;
+#ifdef HAVE_MEMFD_CREATE
+  gint         seals;
+#endif
 
-  /* Update our list of connections */
-  if (priv->connections) g_slist_free (priv->connections);
-  priv->connections = dee_peer_get_connections (priv->swarm);
+  g_variant_get (reply, "(ht)", &fd_index, &size);
 
-  /* Disconnect signals etc */
-  for (i = 0; i < priv->connection_infos->len; i++)
+  fd = g_unix_fd_list_get (fd_list, fd_index, error);
+  if (fd < 0)
+    return NULL;
+
+#ifdef HAVE_MEMFD_CREATE
+  seals = fcntl (fd, F_GET_SEALS);
+  if (seals < 0 ||
+      (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) != (F_SEAL_WRITE | F_SEAL_SHRINK))
     {
-      DeeConnectionInfo *info;
-      info = &g_array_index (priv->connection_infos, DeeConnectionInfo, i);
-      if (info->connection == connection)
-        {
-          g_dbus_connection_unregister_object (info->connection,
-                                               info->registration_id);
-          g_dbus_connection_signal_unsubscribe (info->connection,
-                                                info->signal_subscription_id);
-          /* remove the item */
-          g_array_remove_index (priv->connection_infos, i);
-          break;
-        }
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           "Clone memfd is not sealed");
+      close (fd);
+      return NULL;
+    }
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "Unable to check the seals of the clone memfd");
+  close (fd);
+  return NULL;
+#endif
+
+  mapped = g_mapped_file_new_from_fd (fd, FALSE, error);
+  close (fd);
+  if (mapped == NULL)
+    return NULL;
+
+  if (g_mapped_file_get_length (mapped) < size)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "Clone memfd is smaller than the announced size");
+      g_mapped_file_unref (mapped);
+      return NULL;
     }
+
+  /* The data is untrusted, GVariant will validate it on access */
+  return g_variant_ref_sink (
+      g_variant_new_from_data (CLONE_VARIANT_TYPE,
+                               g_mapped_file_get_contents (mapped), size,
+                               FALSE,
+                               (GDestroyNotify) g_mapped_file_unref,
+                               mapped));
 }
 
-/* Callback for clone_leader() */
+/* Callback for CloneFiltered calls from clone_leader() */
 static void
-on_clone_received (GObject      *source_object,
-                   GAsyncResult *res,
-                   gpointer      user_data)
+on_filtered_clone_received (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
 {
-  DeeModel              *model;
   DeeSharedModel        *self;
-  DeeSharedModelPrivate *priv;
-  GVariant              *data, *transaction;
+  GDBusConnection       *connection;
+  GVariant              *data;
   GError                *error;
   GWeakRef              *weak_ref;
   gchar                 *dbus_error;
@@ -1054,126 +2929,157 @@ on_clone_received (GObject      *source_object,
       g_free (weak_ref);
       return;
     }
-  priv = self->priv;
 
+  connection = G_DBUS_CONNECTION (source_object);
   error = NULL;
-  data = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
-                                        res, &error);
+  data = g_dbus_connection_call_finish (connection, res, &error);
 
   if (error != NULL)
     {
       dbus_error = g_dbus_error_get_remote_error (error);
-      if (g_strcmp0 (dbus_error, "com.canonical.Dee.Model.NoSchemaError") == 0)
-        {
-          trace_object (self, "Got Clone reply from leader, but leader has no schema");
-          g_error_free (error);
-          g_free (dbus_error);
-        }
-      else
+      if (g_strcmp0 (dbus_error, "com.canonical.Dee.Model.NoSchemaError") != 0)
         {
-          g_critical ("Failed to clone model from leader: %s", error->message);
+          g_warning ("Leader can't filter model '%s', cloning everything: %s",
+                     dee_shared_model_get_swarm_name (self), error->message);
           g_error_free (error);
           g_free (dbus_error);
-          goto clone_recieved_out;
+          call_clone (self, connection, weak_ref);
+          g_object_unref (self);
+          return;
         }
+      g_free (dbus_error);
     }
 
-  /* The data will be NULL if we received a com.canonical.Dee.Model.NoSchemaError,
-   * but in that case we should still consider our selves synchronized */
-  if (data != NULL)
-    {
-      const gchar **column_names;
-      guint         i, n_column_names;
-      GVariant     *vardict;
-      GVariantIter *iter;
-
-      model = DEE_MODEL (self);
-      /* Guard against a race where we might inadvertedly have accepted a Commit
-       * before receiving the initial Clone */
-      if (dee_model_get_n_columns (model) > 0)
-        {
-          priv->suppress_remote_signals = TRUE;
-          reset_model (model);
-          priv->suppress_remote_signals = FALSE;
-        }
+  process_clone_reply (self, data, error);
 
-      /* Support both the 1.0 Clone signature as well as the 1.2 */
-      if (g_variant_type_equal (g_variant_get_type (data),
-                                CLONE_VARIANT_TYPE))
-        {
-          GVariant *transaction_members[COMMIT_TUPLE_ITEMS];
-          guint n_elements;
+  g_object_unref (self); // weak ref got us a strong reference
+  g_weak_ref_clear (weak_ref);
+  g_free (weak_ref);
+}
 
-          n_elements = G_N_ELEMENTS (transaction_members);
+/* Callback for CloneFd calls from clone_leader() */
+static void
+on_clone_fd_received (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  DeeSharedModel        *self;
+  GDBusConnection       *connection;
+  GUnixFDList           *fd_list;
+  GVariant              *reply, *data;
+  GError                *error;
+  GWeakRef              *weak_ref;
+  gchar                 *dbus_error;
 
-          for (i = 0; i < n_elements; i++)
-            transaction_members[i] = g_variant_get_child_value (data, i);
+  weak_ref = (GWeakRef*) user_data;
+  self = (DeeSharedModel*) g_weak_ref_get (weak_ref);
+  if (self == NULL)
+    {
+      g_weak_ref_clear (weak_ref);
+      g_free (weak_ref);
+      return;
+    }
 
-          transaction = g_variant_new_tuple (transaction_members, n_elements);
-          transaction = g_variant_ref_sink (transaction);
+  connection = G_DBUS_CONNECTION (source_object);
+  error = NULL;
+  fd_list = NULL;
+  data = NULL;
+  reply = g_dbus_connection_call_with_unix_fd_list_finish (connection,
+                                                           &fd_list,
+                                                           res, &error);
 
-          vardict = g_variant_get_child_value (data, 6);
+  if (reply != NULL)
+    {
+      data = map_clone_fd (reply, fd_list, &error);
+      g_variant_unref (reply);
+    }
 
-          if (g_variant_lookup (vardict, "column-names", "^a&s", &column_names))
-            n_column_names = g_strv_length ((gchar**) column_names);
-          else
-            column_names = NULL;
-          if (!g_variant_lookup (vardict, "fields", "a(uss)", &iter))
-            iter = NULL;
+  if (fd_list != NULL)
+    g_object_unref (fd_list);
 
-          for (i = 0; i < n_elements; i++)
-            g_variant_unref (transaction_members[i]);
-        }
-      else if (g_variant_type_equal (g_variant_get_type (data),
-                                     COMMIT_VARIANT_TYPE))
-        {
-          transaction = g_variant_ref (data);
-          vardict = NULL;
-        }
-      else
+  if (error != NULL)
+    {
+      dbus_error = g_dbus_error_get_remote_error (error);
+      if (g_strcmp0 (dbus_error, "com.canonical.Dee.Model.NoSchemaError") != 0)
         {
-          g_critical ("Unable to Clone model: Unrecognized schema");
-          goto clone_recieved_out;
+          /* The leader doesn't support CloneFd, or the transfer failed.
+           * Retry with a regular Clone, which takes over the weak ref */
+          trace_object (self, "CloneFd failed, falling back to Clone: %s",
+                        error->message);
+          g_error_free (error);
+          g_free (dbus_error);
+          call_clone (self, connection, weak_ref);
+          g_object_unref (self);
+          return;
         }
+      g_free (dbus_error);
+    }
 
-      /* We use the swarm name as sender_name here, because DBus passes us the
-      * unique name of the swarm leader here and we want to indicate in the debug
-      * messages that the transaction came from the leader */
-      commit_transaction (self,
-                          dee_shared_model_get_swarm_name (self),
-                          transaction);
+  process_clone_reply (self, data, error);
 
-      if (vardict)
-        {
-          if (column_names && n_column_names > 0
-              && dee_model_get_column_names (model, NULL) == NULL)
-            {
-              dee_model_set_column_names_full (model, column_names, n_column_names);
-
-              if (iter != NULL)
-                {
-                  dee_shared_model_parse_vardict_schemas (model, iter,
-                                                          n_column_names);
-                  g_variant_iter_free (iter);
-                }
-            }
-          g_free (column_names);
-          g_variant_unref (vardict);
-        }
+  g_object_unref (self); // weak ref got us a strong reference
+  g_weak_ref_clear (weak_ref);
+  g_free (weak_ref);
+}
 
-      g_variant_unref (transaction);
-      g_variant_unref (data);
+/* Callback for CloneSince calls from clone_leader() */
+static void
+on_delta_received (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  DeeSharedModel        *self;
+  DeeSharedModelPrivate *priv;
+  GDBusConnection       *connection;
+  GVariant              *data, *commit;
+  GVariantIter          *iter;
+  GError                *error;
+  GWeakRef              *weak_ref;
+
+  weak_ref = (GWeakRef*) user_data;
+  self = (DeeSharedModel*) g_weak_ref_get (weak_ref);
+  if (self == NULL)
+    {
+      g_weak_ref_clear (weak_ref);
+      g_free (weak_ref);
+      return;
     }
+  priv = self->priv;
 
-  /* If we where invalidated before, we should be fine now */
-  if (!priv->synchronized)
+  connection = G_DBUS_CONNECTION (source_object);
+  error = NULL;
+  data = g_dbus_connection_call_finish (connection, res, &error);
+
+  if (error != NULL)
     {
-      priv->synchronized = TRUE;
-      g_object_notify (G_OBJECT (self), "synchronized");
+      /* The leader can't serve the delta, drop the snapshot and do a full
+       * Clone instead. The Clone call takes over the weak ref */
+      trace_object (self, "Unable to get delta from leader, cloning: %s",
+                    error->message);
+      g_error_free (error);
+
+      priv->suppress_remote_signals = TRUE;
+      reset_model (DEE_MODEL (self));
+      priv->suppress_remote_signals = FALSE;
+
+      call_clone (self, connection, weak_ref);
+      g_object_unref (self);
+      return;
     }
 
-clone_recieved_out:
-  priv->clone_in_progress = FALSE;
+  trace_object (self, "Applying delta from leader");
+
+  g_variant_get (data, "(a(sasaavauay(tt)))", &iter);
+  while ((commit = g_variant_iter_next_value (iter)) != NULL)
+    {
+      commit_transaction (self, dee_shared_model_get_swarm_name (self), commit);
+      g_variant_unref (commit);
+    }
+  g_variant_iter_free (iter);
+  g_variant_unref (data);
+
+  priv->warm_started = FALSE;
+  process_clone_reply (self, NULL, NULL);
 
   g_object_unref (self); // weak ref got us a strong reference
   g_weak_ref_clear (weak_ref);
@@ -1190,7 +3096,8 @@ clone_leader (DeeSharedModel *self)
   g_return_if_fail (DEE_IS_SHARED_MODEL (self));
   g_return_if_fail (dee_peer_get_swarm_leader (self->priv->swarm) != NULL);
   g_return_if_fail (self->priv->revision_queue == NULL);
-  g_return_if_fail (dee_model_get_n_rows (DEE_MODEL (self)) == 0);
+  g_return_if_fail (self->priv->warm_started ||
+                    dee_model_get_n_rows (DEE_MODEL (self)) == 0);
 
   priv = self->priv;
 
@@ -1201,21 +3108,79 @@ clone_leader (DeeSharedModel *self)
    * have it here for consistency */
   for (iter = priv->connections; iter != NULL; iter = iter->next)
     {
-      GWeakRef *weak_ref;
+      GDBusConnection *connection;
+      GWeakRef        *weak_ref;
+
+      connection = (GDBusConnection*) iter->data;
+
+      /* The leader handles our calls in order, so it knows our features
+       * before it sends us anything after the clone */
+      call_features (self, connection);
+
       weak_ref = g_new (GWeakRef, 1);
       g_weak_ref_init (weak_ref, self);
-      g_dbus_connection_call((GDBusConnection*) iter->data,
-                             dee_shared_model_get_swarm_name (self), // name
-                             priv->model_path,                       // obj path
-                             "com.canonical.Dee.Model",              // iface
-                             "Clone",                                // member
-                             NULL,                                   // args
-                             NULL,                                   // ret type
-                             G_DBUS_CALL_FLAGS_NONE,
-                             -1,                                     // timeout
-                             NULL,                                   // cancel
-                             on_clone_received,                      // cb
-                             weak_ref);                              // userdata
+
+      /* If we're only interested in part of the model, let the leader
+       * do the filtering for us */
+      if (priv->subscription != NULL)
+        {
+          g_dbus_connection_call (
+              connection,
+              dee_shared_model_get_swarm_name (self), // name
+              priv->model_path,                       // obj path
+              "com.canonical.Dee.Model",              // iface
+              "CloneFiltered",                        // member
+              g_variant_new ("(@a{sv})", priv->subscription),
+              CLONE_VARIANT_TYPE,                     // ret type
+              G_DBUS_CALL_FLAGS_NONE,
+              -1,                                     // timeout
+              NULL,                                   // cancel
+              on_filtered_clone_received,             // cb
+              weak_ref);                              // userdata
+        }
+      /* If we have a snapshot we only need the changes since then */
+      else if (priv->warm_started)
+        {
+          g_dbus_connection_call (
+              connection,
+              dee_shared_model_get_swarm_name (self), // name
+              priv->model_path,                       // obj path
+              "com.canonical.Dee.Model",              // iface
+              "CloneSince",                           // member
+              g_variant_new ("(st)", priv->epoch,
+                             dee_serializable_model_get_seqnum (DEE_MODEL (self))),
+              COMMITS_VARIANT_TYPE,                   // ret type
+              G_DBUS_CALL_FLAGS_NONE,
+              -1,                                     // timeout
+              NULL,                                   // cancel
+              on_delta_received,                      // cb
+              weak_ref);                              // userdata
+        }
+      /* Peer-to-peer connections to a DeeServer are local, so try to get
+       * the clone as a memfd instead of pushing it through the socket */
+      else if (DEE_IS_CLIENT (priv->swarm) &&
+          (g_dbus_connection_get_capabilities (connection) &
+           G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING))
+        {
+          g_dbus_connection_call_with_unix_fd_list (
+              connection,
+              dee_shared_model_get_swarm_name (self), // name
+              priv->model_path,                       // obj path
+              "com.canonical.Dee.Model",              // iface
+              "CloneFd",                              // member
+              NULL,                                   // args
+              G_VARIANT_TYPE ("(ht)"),                // ret type
+              G_DBUS_CALL_FLAGS_NONE,
+              -1,                                     // timeout
+              NULL,                                   // fd list
+              NULL,                                   // cancel
+              on_clone_fd_received,                   // cb
+              weak_ref);                              // userdata
+        }
+      else
+        {
+          call_clone (self, connection, weak_ref);
+        }
 
       priv->clone_in_progress = TRUE;
     }
@@ -1231,6 +3196,7 @@ on_dbus_signal_received (GDBusConnection *connection,
                          gpointer         user_data)
 {
   DeeSharedModel *model;
+  DeeConnectionInfo *info;
   const gchar    *unique_name;
   gboolean        forced_ignore;
   gboolean        disable_write;
@@ -1255,6 +3221,19 @@ on_dbus_signal_received (GDBusConnection *connection,
        * meanwhile, this way we'll prevent unnecessary invalidation */
       if (model->priv->clone_in_progress) return;
 
+      /* Followers with a subscription only have a partial view of the model,
+       * so their positions are meaningless to us. Make them resync */
+      info = find_connection_info (model, connection);
+      if (info != NULL && info->subscription != NULL)
+        {
+          g_warning ("Ignoring Commit from filtered follower %s", sender_name);
+          g_dbus_connection_call (connection, sender_name, model->priv->model_path,
+                                  "com.canonical.Dee.Model", "Invalidate",
+                                  NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+                                  NULL, NULL, NULL);
+          return;
+        }
+
       /* Similarly if we receive a Commit before knowing who's the swarm leader
        * (can happen even before Clone() request, ignore the commit */
       if (model->priv->synchronized == FALSE &&
@@ -1331,12 +3310,15 @@ commit_transaction (DeeSharedModel *self,
   DeeSharedModelPrivate *priv;
   GVariantIter           iter;
   GVariant              *schema, *row, **row_buf, *val, *aav, *au, *ay, *tt;
+  GVariant              *payload;
   const gchar          **column_schemas;
   gsize                  column_schemas_len;
   gchar                 *swarm_name;
   guint64                seqnum_before, seqnum_after, current_seqnum;
   guint64                n_rows, n_cols, model_n_rows;
-  guint32                pos;
+  guint32                pos, new_pos;
+  const guint32         *order;
+  gsize                  n_order;
   guchar                 change_type;
   gint                   i, j;
   gboolean               transaction_error;
@@ -1505,6 +3487,73 @@ commit_transaction (DeeSharedModel *self,
           continue;
         }
 
+      /* Moves only carry the new position of the row */
+      if (change_type == CHANGE_TYPE_MOVE)
+        {
+          row = g_variant_get_child_value (aav, i);
+          new_pos = G_MAXUINT32;
+          if (g_variant_n_children (row) == 1)
+            {
+              val = g_variant_get_child_value (row, 0);
+              payload = g_variant_get_variant (val);
+              if (g_variant_is_of_type (payload, G_VARIANT_TYPE_UINT32))
+                new_pos = g_variant_get_uint32 (payload);
+              g_variant_unref (payload);
+              g_variant_unref (val);
+            }
+          g_variant_unref (row);
+
+          if (pos >= model_n_rows || new_pos >= model_n_rows)
+            {
+              g_critical ("Commit from %s contains an illegal move. "
+                          "The model may have been left in a dirty state",
+                          sender_name);
+              continue;
+            }
+
+          /* The row is in front of the rows after it while we look
+           * up where it goes */
+          dee_model_move_before (DEE_MODEL (self),
+                                 dee_model_get_iter_at_row (DEE_MODEL (self), pos),
+                                 dee_model_get_iter_at_row (DEE_MODEL (self),
+                                   new_pos < pos ? new_pos : new_pos + 1));
+          continue;
+        }
+
+      /* Reorders carry the old positions of the rows in their new order */
+      if (change_type == CHANGE_TYPE_REORDER)
+        {
+          row = g_variant_get_child_value (aav, i);
+          payload = NULL;
+          order = NULL;
+          n_order = 0;
+          if (g_variant_n_children (row) == 1)
+            {
+              val = g_variant_get_child_value (row, 0);
+              payload = g_variant_get_variant (val);
+              if (g_variant_is_of_type (payload, G_VARIANT_TYPE ("au")))
+                order = g_variant_get_fixed_array (payload, &n_order,
+                                                   sizeof (guint32));
+              g_variant_unref (val);
+            }
+
+          if (order == NULL || n_order != model_n_rows)
+            {
+              g_critical ("Commit from %s contains an illegal reorder. "
+                          "The model may have been left in a dirty state",
+                          sender_name);
+            }
+          else
+            {
+              dee_model_reorder (DEE_MODEL (self), order);
+            }
+
+          if (payload != NULL)
+            g_variant_unref (payload);
+          g_variant_unref (row);
+          continue;
+        }
+
       /* It's an Add or Change so parse the row data */
       row = g_variant_get_child_value (aav, i);
 
@@ -1560,6 +3609,8 @@ commit_transaction (DeeSharedModel *self,
     } /* End outer loop */
   priv->suppress_remote_signals = FALSE;
 
+  record_commit (self, transaction);
+
   g_variant_unref (transaction);
   g_variant_unref (aav);
   g_variant_unref (au);
@@ -1573,6 +3624,8 @@ commit_transaction (DeeSharedModel *self,
 
   g_signal_emit (self, _signals[END_TRANSACTION], 0, seqnum_before, seqnum_after);
   g_signal_emit_by_name (self, "changeset-finished");
+
+  schedule_snapshot (self);
 }
 
 static void
@@ -1585,6 +3638,8 @@ on_self_row_added (DeeModel *self, DeeModelIter *iter)
 
   priv = DEE_SHARED_MODEL (self)->priv;
 
+  subscriptions_row_added (DEE_SHARED_MODEL (self), iter);
+
   if (!priv->suppress_remote_signals)
     {
       row_slice_size = dee_model_get_n_columns(self) * sizeof (gpointer);
@@ -1607,6 +3662,8 @@ on_self_row_removed (DeeModel *self, DeeModelIter *iter)
 
   priv = DEE_SHARED_MODEL (self)->priv;
 
+  subscriptions_row_removed (DEE_SHARED_MODEL (self), iter);
+
   if (!priv->suppress_remote_signals)
     {
       pos = dee_model_get_position (self, iter);
@@ -1628,6 +3685,8 @@ on_self_row_changed (DeeModel *self, DeeModelIter *iter)
 
   priv = DEE_SHARED_MODEL (self)->priv;
 
+  subscriptions_row_changed (DEE_SHARED_MODEL (self), iter);
+
   if (!priv->suppress_remote_signals)
     {
       row_slice_size = dee_model_get_n_columns(self) * sizeof (gpointer);
@@ -1642,6 +3701,71 @@ on_self_row_changed (DeeModel *self, DeeModelIter *iter)
     }
 }
 
+static void
+on_self_row_moved (DeeModel *self, DeeModelIter *iter, guint old_pos)
+{
+  DeeSharedModelPrivate  *priv;
+  DeeSharedModelRevision *rev;
+
+  priv = DEE_SHARED_MODEL (self)->priv;
+
+  subscriptions_row_moved (DEE_SHARED_MODEL (self), iter);
+
+  if (!priv->suppress_remote_signals)
+    {
+      /* Peers that don't understand moves get a removal and an addition,
+       * which take a seqnum each. We always take both so the seqnums are
+       * the same for every peer */
+      dee_serializable_model_inc_seqnum (self);
+      rev = enqueue_revision (self,
+                              CHANGE_TYPE_MOVE,
+                              old_pos,
+                              dee_serializable_model_get_seqnum (self),
+                              NULL);
+      rev->new_pos = dee_model_get_position (self, iter);
+      rev->n_seqnums = 2;
+
+      if (peers_lack_feature (DEE_SHARED_MODEL (self), PEER_FEATURE_MOVE))
+        {
+          rev->row = g_slice_alloc (dee_model_get_n_columns (self) *
+                                    sizeof (gpointer));
+          dee_model_get_row (self, iter, rev->row);
+        }
+    }
+}
+
+static void
+on_self_rows_reordered (DeeModel *self, const guint *new_order)
+{
+  DeeSharedModelPrivate  *priv;
+  DeeSharedModelRevision *rev;
+  guint                   n_rows;
+
+  priv = DEE_SHARED_MODEL (self)->priv;
+
+  subscriptions_rows_reordered (DEE_SHARED_MODEL (self));
+
+  if (!priv->suppress_remote_signals)
+    {
+      /* Peers that don't understand reorders get a clear and an addition
+       * of every row, so take a seqnum for each of those */
+      n_rows = dee_model_get_n_rows (self);
+      dee_serializable_model_set_seqnum (self,
+          dee_serializable_model_get_seqnum (self) + n_rows);
+      rev = enqueue_revision (self,
+                              CHANGE_TYPE_REORDER,
+                              0,
+                              dee_serializable_model_get_seqnum (self),
+                              NULL);
+      rev->payload = g_variant_ref_sink (
+          build_reorder_payload (new_order, n_rows));
+      rev->n_seqnums = n_rows + 1;
+
+      if (peers_lack_feature (DEE_SHARED_MODEL (self), PEER_FEATURE_REORDER))
+        rev->rows = g_variant_ref_sink (build_rows (self));
+    }
+}
+
 /* Clears all data in the model and resets it to start from scratch */
 static void
 reset_model (DeeModel *self)
@@ -1655,6 +3779,13 @@ reset_model (DeeModel *self)
   dee_model_clear (self);
 
   dee_serializable_model_set_seqnum (self, 0);
+  invalidate_clone_cache (DEE_SHARED_MODEL (self));
+
+  /* Seqnums start over, so this is a new lineage of the data */
+  clear_commit_history (DEE_SHARED_MODEL (self));
+  g_free (DEE_SHARED_MODEL (self)->priv->epoch);
+  DEE_SHARED_MODEL (self)->priv->epoch = g_dbus_generate_guid ();
+  DEE_SHARED_MODEL (self)->priv->warm_started = FALSE;
 }
 
 /* Call DBus method com.canonical.Dee.Model.Invalidate() on @sender_name */
@@ -1933,6 +4064,154 @@ dee_shared_model_set_flush_mode (DeeSharedModel *self,
   g_object_set (self, "flush-mode", mode, NULL);
 }
 
+/**
+ * dee_shared_model_set_snapshot_manager:
+ * @self: A #DeeSharedModel
+ * @manager: (allow-none): The #DeeResourceManager to keep snapshots in,
+ *           or %NULL to disable snapshots
+ *
+ * Expert: Persist the synchronized state of @self through @manager, keyed
+ * by the swarm name, and warm start from such a snapshot now if one is
+ * available. The snapshot is updated a while after each change to @self and
+ * when @self is finalized.
+ *
+ * Every update serializes and writes the whole model. To bound that cost
+ * for a model that changes all the time, updates wait a second plus one
+ * more second per 10000 rows, up to a minute, and reuse a serialized Clone
+ * reply of the same revision if the model has one. The flip side is that
+ * a snapshot of a busy, large model may lag up to a minute behind. A
+ * follower warm started from it fetches the missing changes from the
+ * leader, or does a full clone if the leader no longer has them.
+ *
+ * A warm started follower only asks the swarm leader for the changes since
+ * the seqnum of the snapshot, instead of cloning the whole model. If the
+ * leader can not provide those changes the model falls back to a full clone.
+ *
+ * A snapshot records the subscription of the model it was taken from, see
+ * dee_shared_model_set_subscription(), and is only loaded by a model with an
+ * equal subscription. Set the subscription first if you use both.
+ *
+ * This must be called before @self has synchronized with its peers for the
+ * snapshot to be loaded.
+ */
+void
+dee_shared_model_set_snapshot_manager (DeeSharedModel     *self,
+                                       DeeResourceManager *manager)
+{
+  DeeSharedModelPrivate *priv;
+
+  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+  g_return_if_fail (manager == NULL || DEE_IS_RESOURCE_MANAGER (manager));
+
+  priv = self->priv;
+
+  if (manager != NULL) g_object_ref (manager);
+  if (priv->snapshot_manager != NULL) g_object_unref (priv->snapshot_manager);
+  priv->snapshot_manager = manager;
+
+  if (manager == NULL && priv->snapshot_timer_id != 0)
+    {
+      g_source_remove (priv->snapshot_timer_id);
+      priv->snapshot_timer_id = 0;
+    }
+
+  if (manager == NULL || priv->synchronized || priv->clone_in_progress ||
+      dee_model_get_n_rows (DEE_MODEL (self)) > 0)
+    return;
+
+  priv->warm_started = load_snapshot (self);
+  trace_object (self, "Warm started from snapshot: %s",
+                priv->warm_started ? "yes" : "no");
+}
+
+/**
+ * dee_shared_model_get_snapshot_manager:
+ * @self: A #DeeSharedModel
+ *
+ * Get the #DeeResourceManager set with
+ * dee_shared_model_set_snapshot_manager().
+ *
+ * Returns: (transfer none) (allow-none): The snapshot manager of @self
+ */
+DeeResourceManager*
+dee_shared_model_get_snapshot_manager (DeeSharedModel *self)
+{
+  g_return_val_if_fail (DEE_IS_SHARED_MODEL (self), NULL);
+
+  return self->priv->snapshot_manager;
+}
+
+/**
+ * dee_shared_model_set_subscription:
+ * @self: A #DeeSharedModel
+ * @subscription: (allow-none): A vardict describing the rows and columns
+ *                @self is interested in, or %NULL to receive everything
+ *
+ * Expert: Ask the swarm leader to only replicate part of the model to @self.
+ * This is only supported when the leader is a #DeeServer and @self is
+ * connected to it using a #DeeClient, as the filtering is done per
+ * connection.
+ *
+ * The recognized keys of @subscription are:
+ * <itemizedlist>
+ *   <listitem>"match" of type a{uv}: Only rows where each of the given
+ *             columns is equal to the given value are replicated</listitem>
+ *   <listitem>"columns" of type au: Only replicate the given columns, in
+ *             the given order. The schema of @self must match this
+ *             projection</listitem>
+ * </itemizedlist>
+ *
+ * A model with a subscription has a partial view of the swarm and must be
+ * treated as read only. If the leader can't filter the model @self falls
+ * back to replicating everything.
+ *
+ * Changing the subscription of a synchronized follower, including setting
+ * it to %NULL to unsubscribe, makes @self resynchronize with the leader.
+ */
+void
+dee_shared_model_set_subscription (DeeSharedModel *self,
+                                   GVariant       *subscription)
+{
+  DeeSharedModelPrivate *priv;
+  gboolean               changed;
+
+  g_return_if_fail (DEE_IS_SHARED_MODEL (self));
+  g_return_if_fail (subscription == NULL ||
+                    g_variant_is_of_type (subscription, G_VARIANT_TYPE_VARDICT));
+
+  priv = self->priv;
+
+  if (priv->clone_in_progress)
+    {
+      g_warning ("Subscription for shared model '%s' set while cloning, it "
+                 "will only take effect after a resync",
+                 dee_shared_model_get_swarm_name (self));
+    }
+
+  if (subscription != NULL) g_variant_ref_sink (subscription);
+  changed = !subscriptions_equal (subscription, priv->subscription);
+  if (priv->subscription != NULL) g_variant_unref (priv->subscription);
+  priv->subscription = subscription;
+
+  if (!changed)
+    return;
+
+  /* Start over, so the leader sends us the new view of the model */
+  if (priv->synchronized && !priv->clone_in_progress &&
+      !dee_peer_is_swarm_leader (priv->swarm))
+    {
+      on_invalidate (self);
+    }
+  /* A snapshot only holds the rows of the subscription it was taken with,
+   * so it's useless to us now */
+  else if (priv->warm_started)
+    {
+      priv->suppress_remote_signals = TRUE;
+      reset_model (DEE_MODEL (self));
+      priv->suppress_remote_signals = FALSE;
+    }
+}
+
 /**
  * dee_shared_model_is_leader:
  * @self: The model to inspect
@@ -2078,6 +4357,7 @@ dee_shared_model_clear (DeeModel *model)
                         0,
                         seqnum,
                         NULL);
+      subscriptions_enqueue_clear (model);
     }
   /* make sure we don't enqueue lots of CHANGE_TYPE_REMOVE */
   priv->suppress_remote_signals = TRUE;
@@ -2103,8 +4383,9 @@ dee_shared_model_serialize (DeeSerializable *self)
 {
   DeeSerializableIface   *serializable_model_iface;
   DeeModel               *_self;
-  GVariantBuilder         au, ay, clone;
-  GVariant               *schema, *aav, *tt, *hints, *serialized_model;
+  GVariantBuilder         au, ay, clone, hints_builder;
+  GVariantIter            hints_iter;
+  GVariant               *schema, *aav, *tt, *hints, *hint, *serialized_model;
   guint                   i, n_rows;
   guint64                 last_seqnum;
 
@@ -2147,6 +4428,20 @@ dee_shared_model_serialize (DeeSerializable *self)
   aav = g_variant_get_child_value (serialized_model, 1);
   hints = g_variant_get_child_value (serialized_model, 3);
 
+  /* Add the epoch to the hints, so warm started followers can later ask
+   * for deltas against this lineage of the data */
+  g_variant_builder_init (&hints_builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_iter_init (&hints_iter, hints);
+  while ((hint = g_variant_iter_next_value (&hints_iter)) != NULL)
+    {
+      g_variant_builder_add_value (&hints_builder, hint);
+      g_variant_unref (hint);
+    }
+  g_variant_builder_add (&hints_builder, "{sv}", "epoch",
+                         g_variant_new_string (DEE_SHARED_MODEL (self)->priv->epoch));
+  g_variant_unref (hints);
+  hints = g_variant_ref_sink (g_variant_builder_end (&hints_builder));
+
   /* Collect the seqnums */
   last_seqnum = dee_serializable_model_get_seqnum (_self);
   tt = g_variant_new ("(tt)", last_seqnum - i, last_seqnum);//  FIXME last_committed_seqnum
@@ -2173,6 +4468,279 @@ dee_shared_model_serialize (DeeSerializable *self)
   return g_variant_builder_end (&clone);
 }
 
+/*
+ * DeeSharedModelSnapshot
+ */
+
+static void
+dee_shared_model_snapshot_finalize (GObject *object)
+{
+  DeeSharedModelSnapshot *snapshot = (DeeSharedModelSnapshot*) object;
+
+  if (snapshot->data)
+    g_variant_unref (snapshot->data);
+
+  G_OBJECT_CLASS (dee_shared_model_snapshot_parent_class)->finalize (object);
+}
+
+static void
+dee_shared_model_snapshot_class_init (DeeSharedModelSnapshotClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = dee_shared_model_snapshot_finalize;
+}
+
+static void
+dee_shared_model_snapshot_init (DeeSharedModelSnapshot *self)
+{
+  self->data = NULL;
+}
+
+static GVariant*
+dee_shared_model_snapshot_serialize (DeeSerializable *self)
+{
+  return g_variant_ref (((DeeSharedModelSnapshot*) self)->data);
+}
+
+static GObject*
+dee_shared_model_snapshot_parse_serialized (GVariant *data)
+{
+  DeeSharedModelSnapshot *snapshot;
+
+  snapshot = g_object_new (dee_shared_model_snapshot_get_type (), NULL);
+  snapshot->data = g_variant_ref_sink (data);
+
+  return (GObject*) snapshot;
+}
+
+static void
+dee_shared_model_snapshot_serializable_iface_init (DeeSerializableIface *iface)
+{
+  iface->serialize = dee_shared_model_snapshot_serialize;
+
+  dee_serializable_register_parser (dee_shared_model_snapshot_get_type (),
+                                    CLONE_VARIANT_TYPE,
+                                    dee_shared_model_snapshot_parse_serialized);
+}
+
+/* Compare two subscription vardicts, either of which may be NULL */
+static gboolean
+subscriptions_equal (GVariant *subscription,
+                     GVariant *other)
+{
+  if (subscription == NULL || other == NULL)
+    return subscription == other;
+
+  return g_variant_equal (subscription, other);
+}
+
+/* Return a copy of the Clone @data with @value added to its hints as @key.
+ * Consumes @data and @value if it is floating */
+static GVariant*
+clone_add_hint (GVariant    *data,
+                const gchar *key,
+                GVariant    *value)
+{
+  GVariant        *members[CLONE_TUPLE_ITEMS];
+  GVariant        *hint;
+  GVariantBuilder  hints;
+  GVariantIter     iter;
+  guint            i;
+
+  for (i = 0; i < CLONE_TUPLE_ITEMS; i++)
+    members[i] = g_variant_get_child_value (data, i);
+
+  g_variant_builder_init (&hints, G_VARIANT_TYPE_VARDICT);
+  g_variant_iter_init (&iter, members[CLONE_TUPLE_ITEMS - 1]);
+  while ((hint = g_variant_iter_next_value (&iter)) != NULL)
+    {
+      g_variant_builder_add_value (&hints, hint);
+      g_variant_unref (hint);
+    }
+  g_variant_builder_add (&hints, "{sv}", key, value);
+  g_variant_unref (members[CLONE_TUPLE_ITEMS - 1]);
+  members[CLONE_TUPLE_ITEMS - 1] = g_variant_ref_sink (
+                                      g_variant_builder_end (&hints));
+
+  g_variant_unref (data);
+  data = g_variant_ref_sink (g_variant_new_tuple (members, CLONE_TUPLE_ITEMS));
+
+  for (i = 0; i < CLONE_TUPLE_ITEMS; i++)
+    g_variant_unref (members[i]);
+
+  return data;
+}
+
+/* Persist the current state of the model through the snapshot manager */
+static void
+store_snapshot (DeeSharedModel *self)
+{
+  DeeSharedModelPrivate  *priv = self->priv;
+  DeeSharedModelSnapshot *snapshot;
+  GError                 *error;
+
+  /* There's no point in storing a state nobody agreed on */
+  if (!priv->synchronized || dee_model_get_n_columns (DEE_MODEL (self)) == 0)
+    return;
+
+  snapshot = g_object_new (dee_shared_model_snapshot_get_type (), NULL);
+
+  /* The leader may have serialized this state for a Clone already */
+  if (priv->clone_cache != NULL && priv->clone_cache_seqnum ==
+      dee_serializable_model_get_seqnum (DEE_MODEL (self)))
+    snapshot->data = g_variant_ref (priv->clone_cache);
+  else
+    snapshot->data = dee_serializable_serialize (DEE_SERIALIZABLE (self));
+
+  /* Remember which part of the swarm we hold, so the snapshot of a
+   * subscribed model is never mistaken for the full model */
+  if (priv->subscription != NULL)
+    snapshot->data = clone_add_hint (snapshot->data, "subscription",
+                                     priv->subscription);
+
+  error = NULL;
+  if (!dee_resource_manager_store (priv->snapshot_manager,
+                                   DEE_SERIALIZABLE (snapshot),
+                                   dee_shared_model_get_swarm_name (self),
+                                   &error))
+    {
+      g_warning ("Failed to store snapshot of shared model '%s': %s",
+                 dee_shared_model_get_swarm_name (self), error->message);
+      g_error_free (error);
+    }
+  else
+    {
+      trace_object (self, "Stored snapshot at seqnum %"G_GUINT64_FORMAT,
+                    dee_serializable_model_get_seqnum (DEE_MODEL (self)));
+    }
+
+  g_object_unref (snapshot);
+}
+
+static gboolean
+store_snapshot_timeout_cb (DeeSharedModel *self)
+{
+  g_return_val_if_fail (DEE_IS_SHARED_MODEL (self), FALSE);
+
+  self->priv->snapshot_timer_id = 0;
+  store_snapshot (self);
+
+  return FALSE;
+}
+
+/* Persist the state of the model a little while from now, unless a store
+ * is already pending */
+static void
+schedule_snapshot (DeeSharedModel *self)
+{
+  DeeSharedModelPrivate *priv = self->priv;
+  guint                  delay;
+
+  if (priv->snapshot_manager == NULL || !priv->synchronized ||
+      priv->snapshot_timer_id != 0)
+    return;
+
+  delay = SNAPSHOT_DELAY +
+    dee_model_get_n_rows (DEE_MODEL (self)) / SNAPSHOT_ROWS_PER_SECOND;
+
+  priv->snapshot_timer_id =
+    g_timeout_add_seconds (MIN (delay, SNAPSHOT_MAX_DELAY),
+                           (GSourceFunc) store_snapshot_timeout_cb, self);
+}
+
+/* Check that a snapshot fits the schema of the model, if one is set */
+static gboolean
+snapshot_schema_matches (DeeSharedModel *self,
+                         GVariant       *data)
+{
+  const gchar *const *schema;
+  const gchar       **snapshot_schema;
+  guint                n_cols, i;
+  gboolean             matches;
+
+  schema = dee_model_get_schema (DEE_MODEL (self), &n_cols);
+  if (n_cols == 0)
+    return TRUE;
+
+  g_variant_get_child (data, 1, "^a&s", &snapshot_schema);
+  matches = g_strv_length ((gchar**) snapshot_schema) == n_cols;
+  for (i = 0; matches && i < n_cols; i++)
+    matches = g_strcmp0 (schema[i], snapshot_schema[i]) == 0;
+  g_free (snapshot_schema);
+
+  return matches;
+}
+
+/* Check that a snapshot was taken with the same subscription as ours */
+static gboolean
+snapshot_subscription_matches (DeeSharedModel *self,
+                               GVariant       *data)
+{
+  GVariant *hints, *subscription;
+  gboolean  matches;
+
+  hints = g_variant_get_child_value (data, CLONE_TUPLE_ITEMS - 1);
+  subscription = g_variant_lookup_value (hints, "subscription",
+                                         G_VARIANT_TYPE_VARDICT);
+
+  matches = subscriptions_equal (subscription, self->priv->subscription);
+
+  if (subscription != NULL)
+    g_variant_unref (subscription);
+  g_variant_unref (hints);
+
+  return matches;
+}
+
+/* Load the contents of the model from the snapshot manager, if there is a
+ * snapshot for our swarm. Returns TRUE if the model was populated */
+static gboolean
+load_snapshot (DeeSharedModel *self)
+{
+  DeeSharedModelPrivate  *priv = self->priv;
+  GObject                *snapshot;
+  GError                 *error;
+  gchar                  *swarm_name;
+  gboolean                loaded;
+
+  /* Make sure the parser is registered before we try to load */
+  g_type_class_unref (g_type_class_ref (dee_shared_model_snapshot_get_type ()));
+
+  error = NULL;
+  snapshot = dee_resource_manager_load (priv->snapshot_manager,
+                                        dee_shared_model_get_swarm_name (self),
+                                        &error);
+  if (snapshot == NULL)
+    {
+      if (error != NULL)
+        {
+          trace_object (self, "No snapshot loaded: %s", error->message);
+          g_error_free (error);
+        }
+      return FALSE;
+    }
+
+  loaded = FALSE;
+  if (G_TYPE_CHECK_INSTANCE_TYPE (snapshot,
+                                  dee_shared_model_snapshot_get_type ()))
+    {
+      GVariant *data = ((DeeSharedModelSnapshot*) snapshot)->data;
+
+      g_variant_get_child (data, 0, "&s", &swarm_name);
+      if (g_strcmp0 (swarm_name, dee_shared_model_get_swarm_name (self)) == 0 &&
+          snapshot_schema_matches (self, data) &&
+          snapshot_subscription_matches (self, data))
+        {
+          priv->suppress_remote_signals = TRUE;
+          loaded = apply_clone (self, data);
+          priv->suppress_remote_signals = FALSE;
+        }
+    }
+
+  g_object_unref (snapshot);
+
+  return loaded;
+}
+
 /* Handle an incoming Invalidate() message */
 static gboolean
 on_invalidate (DeeSharedModel   *self)
@@ -2346,9 +4914,14 @@ dee_shared_model_model_iface_init (DeeModelIface *iface)
   iface->insert_row           = proxy_model_iface->insert_row;
   iface->insert_row_before    = proxy_model_iface->insert_row_before;
   iface->remove               = proxy_model_iface->remove;
+  iface->move_before          = proxy_model_iface->move_before;
+  iface->reorder              = proxy_model_iface->reorder;
+  iface->insert_rows_before   = proxy_model_iface->insert_rows_before;
   iface->set_value            = proxy_model_iface->set_value;
   iface->set_row              = proxy_model_iface->set_row;
   iface->get_value            = proxy_model_iface->get_value;
+  iface->peek_value           = proxy_model_iface->peek_value;
+  iface->peek_row             = proxy_model_iface->peek_row;
   iface->get_first_iter       = proxy_model_iface->get_first_iter;
   iface->get_last_iter        = proxy_model_iface->get_last_iter;
   iface->get_iter_at_row      = proxy_model_iface->get_iter_at_row;
@@ -2365,6 +4938,7 @@ dee_shared_model_model_iface_init (DeeModelIface *iface)
   iface->is_first             = proxy_model_iface->is_first;
   iface->is_last              = proxy_model_iface->is_last;
   iface->get_position         = proxy_model_iface->get_position;
+  iface->foreach_range        = proxy_model_iface->foreach_range;
   iface->register_tag         = proxy_model_iface->register_tag;
   iface->get_tag              = proxy_model_iface->get_tag;
   iface->set_tag              = proxy_model_iface->set_tag;
@@ -30,6 +30,7 @@
 #include <dee-model.h>
 #include <dee-proxy-model.h>
 #include <dee-peer.h>
+#include <dee-resource-manager.h>
 
 G_BEGIN_DECLS
 
@@ -175,6 +176,17 @@ void                  dee_shared_model_set_flush_mode  (DeeSharedModel *self,
 
 DeeSharedModelFlushMode dee_shared_model_get_flush_mode (DeeSharedModel *self);
 
+void                  dee_shared_model_set_snapshot_manager
+                                                       (DeeSharedModel *self,
+                                                        DeeResourceManager *manager);
+
+DeeResourceManager*   dee_shared_model_get_snapshot_manager
+                                                       (DeeSharedModel *self);
+
+void                  dee_shared_model_set_subscription
+                                                       (DeeSharedModel *self,
+                                                        GVariant       *subscription);
+
 G_END_DECLS
 
 #endif /* _HAVE_DEE_SHARED_MODEL_H */
@@ -36,6 +36,20 @@
  * g_object_unref(). It is a programming error to try and access a transaction
  * that has been committed with the sole exception of calling
  * dee_transaction_is_committed().
+ *
+ * Concurrency is handled optimistically, per row. Changes to the target made
+ * while the transaction is open only make dee_transaction_commit() fail if
+ * they touch a row the transaction has also changed, removed or moved. Any
+ * other change to the target is picked up by the transaction, which reads
+ * through to the target for untouched rows. Rows added before a target row
+ * that is removed concurrently move on to the row after it.
+ *
+ * Changes can be discarded selectively with savepoints. Call
+ * dee_transaction_savepoint() before making some changes and
+ * dee_transaction_rollback_to() to revert them, or
+ * dee_transaction_release_savepoint() to keep them. Savepoints are cheaper
+ * than stacking a #DeeTransaction on top of another one, because they share
+ * the journal of the transaction.
  */
 #ifdef HAVE_CONFIG_H
 #include <config.h>
@@ -75,14 +89,27 @@
  *
  * CHANGE_TYPE_CHANGE: The jiter is an 'override' for an iter in the
  *                     target model that has been changed. The jiter.overlay
- *                     points to the original. The jiter.row_data member will
- *                     contain all the values for the changed row
+ *                     points to the original. Columns changed one at a time
+ *                     are kept as a list of jiter.deltas, columns that are
+ *                     not in it are read from the original. A row set as a
+ *                     whole is kept in jiter.row_data in stead
  *
  * CHANGE_TYPE_ADD: The jiter does not correspond to an iter in the target, and
  *                  the jiter.override member will be unset. Additions are
  *                  grouped together in "segments" and these segments points
  *                  to an iter in the target they attach *before*
  *
+ * CHANGE_TYPE_MOVE: The jiter is a row from the target model that has been
+ *                   moved with dee_model_move_before(). Like an addition it
+ *                   lives in a segment, and the jiter.move_source member
+ *                   points to the row in the target. Values are read from
+ *                   there, unless the row has been changed, which is
+ *                   recorded just like for CHANGE_TYPE_CHANGE. The iter in the
+ *                   target is overridden by a CHANGE_TYPE_REMOVE jiter with
+ *                   the jiter.moved_to member pointing back to the move, so
+ *                   the row is skipped at its old position. On commit the
+ *                   target row is moved and not removed
+ *
  * To ease internal book keeping we also have the IterType enumeration which
  * describes if a given pointer is a jiter or an iter.
  *
@@ -90,15 +117,42 @@
  * Jiters that are additions are grouped into "segments" and each segment
  * points to a row in the target model.
  *
+ * Memory
+ * Jiters, segments, row data and deltas are all allocated from arenas owned
+ * by the transaction and are only released together, on commit() or
+ * finalize(). Jiters have an arena of their own, which lets us tell a jiter
+ * from an iter of the target model by its address alone. What we know
+ * about the rows of the target model - their override jiter and the
+ * segment attached before them - is kept in a single hash table.
+ *
+ * Savepoints
+ * All savepoints share the one journal. While there are savepoints every
+ * change to the journal also pushes a JournalUndo on the undo log, and
+ * rolling back pops the log down to the savepoint, reverting the changes
+ * in reverse order. To make that possible added and moved rows never leave
+ * their segment while there are savepoints. Removing them turns them into
+ * CHANGE_TYPE_REMOVE jiters that stay in the segment as "tombstones", and
+ * moving them leaves a tombstone behind and puts a new jiter in the
+ * segment it goes to. This way the neighbours of a row are still around
+ * when it is brought back, even if the target has rebased the segment in
+ * the meantime.
+ *
  */
 
 typedef struct _JournalSegment JournalSegment;
 typedef struct _JournalIter JournalIter;
+typedef struct _ColumnDelta ColumnDelta;
+typedef struct _TargetRow TargetRow;
+typedef struct _JournalArenaBlock JournalArenaBlock;
+typedef struct _JournalArena JournalArena;
+typedef struct _JournalUndo JournalUndo;
+typedef struct _Savepoint Savepoint;
 
 typedef enum {
   CHANGE_TYPE_REMOVE,
   CHANGE_TYPE_CHANGE,
-  CHANGE_TYPE_ADD
+  CHANGE_TYPE_ADD,
+  CHANGE_TYPE_MOVE
 } ChangeType;
 
 typedef enum {
@@ -106,6 +160,14 @@ typedef enum {
   ITER_TYPE_JOURNAL
 } IterType;
 
+typedef enum {
+  UNDO_TYPE_NEW_JITER,
+  UNDO_TYPE_SET_VALUE,
+  UNDO_TYPE_SET_ROW,
+  UNDO_TYPE_REMOVE,
+  UNDO_TYPE_MOVE
+} UndoType;
+
 struct _JournalSegment {
   /* End points of the journal iters in the segment */
   JournalIter    *first_iter;
@@ -125,9 +187,17 @@ struct _JournalSegment {
   gboolean        is_committed;
 };
 
+/* A changed column of a row in the target model */
+struct _ColumnDelta {
+  ColumnDelta    *next;
+  guint           column;
+  GVariant       *value;
+};
+
 /* Implements a two dimensional doubly linked list. One dimension is the
  * playback queue and the other is the order of the iters (inside a segment).
- * INVARIANT: Set if and only if change_type == CHANGE_TYPE_ADD */
+ * INVARIANT: Set if and only if change_type == CHANGE_TYPE_{ADD,MOVE}, or
+ *            the jiter is a tombstone of one of those */
 struct _JournalIter {
   /* Added rows all belong to a specific segment
    * attached before a row in the target */
@@ -145,11 +215,71 @@ struct _JournalIter {
    * INVARIANT: Set if and only if change_type == CHANGE_TYPE_{CHANGE,REMOVE} */
   DeeModelIter    *override_iter;
 
+  /* The row in the target model that a CHANGE_TYPE_MOVE jiter moves, and
+   * the move a CHANGE_TYPE_REMOVE jiter has been left behind by */
+  DeeModelIter    *move_source;
+  JournalIter     *moved_to;
+
   /* FIXME: Not implemented. I am not even sure it's theoretically possible */
   GSList          *tags;
 
   ChangeType       change_type;
+
+  /* All values of the row. Always set for CHANGE_TYPE_ADD. Rows from the
+   * target model only have it once they've been set as a whole, otherwise
+   * changed columns are in deltas */
+  GVariant       **row_data;
+  ColumnDelta     *deltas;
+};
+
+/* What the journal knows about a row in the target model */
+struct _TargetRow {
+  JournalIter    *jiter;           /* The override of the row, if any */
+  JournalSegment *segment_before;  /* Rows added before the row, if any */
+};
+
+/* A bump allocator. Nothing is freed individually, all blocks are released
+ * at once. Block sizes double, so n allocations span O(log n) blocks */
+struct _JournalArenaBlock {
+  JournalArenaBlock *next;
+  gsize              size;
+  gsize              used;
+};
+
+struct _JournalArena {
+  JournalArenaBlock *blocks; /* Newest first */
+  gsize              next_size;
+};
+
+/* An entry in the undo log, recording how to revert one change made to the
+ * journal while a savepoint is held */
+struct _JournalUndo {
+  JournalUndo     *next;       /* The entry before this one */
+  UndoType         undo_type;
+
+  /* The jiter created, changed or removed. For UNDO_TYPE_MOVE the jiter
+   * created for the moved row */
+  JournalIter     *jiter;
+
+  /* UNDO_TYPE_MOVE: The jiter left behind by the move and whether the move
+   * created it. UNDO_TYPE_{REMOVE,MOVE}: The change type it had before */
+  JournalIter     *origin;
+  gboolean         origin_is_new;
+  ChangeType       old_change_type;
+
+  /* UNDO_TYPE_SET_VALUE: The previous value of the column, or NULL if the
+   * column was read from the target before */
+  guint            column;
+  GVariant        *value;
+
+  /* UNDO_TYPE_SET_ROW: The previous values of the jiter */
   GVariant       **row_data;
+  ColumnDelta     *deltas;
+};
+
+struct _Savepoint {
+  guint            id;
+  JournalUndo     *mark;       /* The newest undo entry when it was taken */
 };
 
 /**
@@ -162,20 +292,28 @@ struct _DeeTransactionPrivate
   /* The model the transaction applies against */
   DeeModel  *target;
 
-  /* The journal maps DeeModelIters from the target model to JournalIters.
-   * Also maps JournalIters to them selves.
-   * INAVARIANT: If an iter is not in the journal it
-   *             it is an untouched iter from the target model
-   * NOTE: Different keys may point to the same jiter
+  /* Maps DeeModelIters from the target model to TargetRows, holding the
+   * jiter overriding the row and the JournalSegment that lies immediately
+   * before it.
+   * INAVARIANT: If an iter is not in here and not a jiter, it is an
+   *             untouched iter from the target model
    */
-  GHashTable *journal;
+  GHashTable *rows;
 
-  /* The segments map DeeModelIters from the target model,
-   * to JournalSegments that lie immediately before them.
-   * INVARIANT: A JournalIter that has a segment has change_type CHANGE_TYPE_ADD
-   * NOTE: different keys may correspond to the same segment
-   */
-  GHashTable *segments;
+  /* Jiters are the only thing allocated from iter_arena. Segments, row data,
+   * deltas and TargetRows come from data_arena */
+  JournalArena iter_arena;
+  JournalArena data_arena;
+
+  /* Number of jiters ever allocated, and of rows with a segment before them */
+  guint      n_journal;
+  guint      n_segments;
+
+  /* Savepoints, newest first, and the undo log of the changes made since
+   * the oldest of them. The log is only kept while there are savepoints */
+  GSList      *savepoints;
+  JournalUndo *undo_log;
+  guint        last_savepoint_id;
 
   /* The head and the tail of the queue of JournalIters constituting
    * the changes we must play back on the target model.
@@ -185,13 +323,20 @@ struct _DeeTransactionPrivate
   JournalIter *first_playback;
   JournalIter *last_playback;
 
-  /* Signals handlers to check for the concurrent modification of the back end */
-  gulong     target_row_added_handler;
+  /* Signals handlers to check for the concurrent modification of the back end.
+   * They are disconnected when commit() starts to apply the journal */
   gulong     target_row_removed_handler;
   gulong     target_row_changed_handler;
+  gulong     target_row_moved_handler;
+  gulong     target_rows_reordered_handler;
+
+  /* Tracks whether someone holds a changeset open on the target, so commit()
+   * only opens one of its own if nobody else does */
+  gulong     target_changeset_started_handler;
+  gulong     target_changeset_finished_handler;
+  gboolean   target_in_changeset;
 
-  /* canary to saniy check that no one sneaks changes into the target while
-   * the txn is open */
+  /* Seqnum of the target when the txn was created */
   guint64    begin_seqnum;
 
   /* DeeTransactionError code. If != 0 we have an error state set */
@@ -201,21 +346,98 @@ struct _DeeTransactionPrivate
   guint n_cols;
 };
 
+#define ARENA_ALIGN(n) \
+  (((n) + 2 * sizeof (gpointer) - 1) & ~(2 * sizeof (gpointer) - 1))
+
+#define ARENA_FIRST_BLOCK_SIZE 4096
+
+#define ARENA_BLOCK_DATA(block) \
+  ((guint8 *) (block) + ARENA_ALIGN (sizeof (JournalArenaBlock)))
+
+static void
+journal_arena_init (JournalArena *arena)
+{
+  arena->blocks = NULL;
+  arena->next_size = ARENA_FIRST_BLOCK_SIZE;
+}
+
+/* Returns zeroed memory */
+static gpointer
+journal_arena_alloc (JournalArena *arena, gsize size)
+{
+  JournalArenaBlock *block;
+  gsize              block_size;
+  gpointer           mem;
+
+  size = ARENA_ALIGN (size);
+  block = arena->blocks;
+
+  if (block == NULL || block->size - block->used < size)
+    {
+      block_size = MAX (arena->next_size, size);
+      block = g_malloc (ARENA_ALIGN (sizeof (JournalArenaBlock)) + block_size);
+      block->size = block_size;
+      block->used = 0;
+      block->next = arena->blocks;
+      arena->blocks = block;
+      arena->next_size = block_size * 2;
+    }
+
+  mem = ARENA_BLOCK_DATA (block) + block->used;
+  block->used += size;
+  memset (mem, 0, size);
+
+  return mem;
+}
+
+static gboolean
+journal_arena_contains (JournalArena *arena, gconstpointer ptr)
+{
+  JournalArenaBlock *block;
+
+  for (block = arena->blocks; block != NULL; block = block->next)
+    {
+      if ((const guint8 *) ptr >= ARENA_BLOCK_DATA (block) &&
+          (const guint8 *) ptr < ARENA_BLOCK_DATA (block) + block->used)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+journal_arena_clear (JournalArena *arena)
+{
+  JournalArenaBlock *block, *next;
+
+  for (block = arena->blocks; block != NULL; block = next)
+    {
+      next = block->next;
+      g_free (block);
+    }
+
+  journal_arena_init (arena);
+}
+
 static JournalIter*
-journal_iter_new (ChangeType ct)
+journal_iter_new (DeeTransaction *txn, ChangeType ct)
 {
   JournalIter *jent;
 
-  jent = g_slice_new0 (JournalIter);
+  jent = journal_arena_alloc (&txn->priv->iter_arena, sizeof (JournalIter));
   jent->change_type = ct;
+  txn->priv->n_journal++;
 
   return jent;
 }
 
+/* Drops the values held by a jiter. The memory of the jiter stays in the
+ * arena until the journal is released */
 static void
-journal_iter_free (JournalIter *jiter)
+journal_iter_unref_values (JournalIter *jiter)
 {
-  GVariant **v;
+  GVariant    **v;
+  ColumnDelta  *delta;
 
   if (jiter->row_data)
     {
@@ -224,48 +446,159 @@ journal_iter_free (JournalIter *jiter)
           g_variant_unref (*v);
           *v = NULL;
         }
-      g_free (jiter->row_data);
       jiter->row_data = NULL;
     }
 
-  // FIXME: free tags, when/if we implement tags
+  for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+    g_variant_unref (delta->value);
+  jiter->deltas = NULL;
 
-  g_slice_free (JournalIter, jiter);
+  // FIXME: free tags, when/if we implement tags
 }
 
 #define journal_iter_is_removed(jiter) (jiter->change_type == CHANGE_TYPE_REMOVE)
 
+/* A removed row that stays in its segment for the sake of savepoints */
+#define journal_iter_is_tombstone(jiter) \
+  (jiter->change_type == CHANGE_TYPE_REMOVE && jiter->segment != NULL)
+
+/* The row in the target model that a CHANGE or MOVE jiter reads unchanged
+ * columns from */
+#define journal_iter_base(jiter) \
+  (jiter->change_type == CHANGE_TYPE_MOVE ? jiter->move_source : jiter->override_iter)
+
 static JournalSegment*
 journal_segment_new_before (DeeModelIter *iter, DeeTransaction *txn)
 {
-  JournalSegment *jseg = g_slice_new0 (JournalSegment);
+  JournalSegment *jseg = journal_arena_alloc (&txn->priv->data_arena,
+                                              sizeof (JournalSegment));
   jseg->target_iter = iter;
   jseg->txn = txn;
   jseg->is_committed = FALSE;
   return jseg;
 }
 
-static void
-journal_segment_free (JournalSegment *segment)
+/* Returns a NULL terminated copy of row_data, allocated from the arena */
+static GVariant**
+copy_row_data (DeeTransaction *txn, GVariant **row_data)
+{
+  GVariant **copy;
+  guint      i, n_cols;
+
+  n_cols = txn->priv->n_cols;
+  copy = journal_arena_alloc (&txn->priv->data_arena,
+                              (n_cols + 1) * sizeof (GVariant*));
+  for (i = 0; i < n_cols; i++)
+    copy[i] = g_variant_ref_sink (row_data[i]);
+
+  return copy;
+}
+
+static GVariant*
+journal_iter_peek_value (DeeTransaction *txn,
+                         JournalIter    *jiter,
+                         guint           column)
 {
-  g_slice_free (JournalSegment, segment);
+  ColumnDelta *delta;
+
+  if (jiter->row_data)
+    return jiter->row_data[column];
+
+  for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+    {
+      if (delta->column == column)
+        return delta->value;
+    }
+
+  return dee_model_peek_value (txn->priv->target,
+                               journal_iter_base (jiter), column);
 }
 
+/* out_row_members must have room for all columns */
 static GVariant**
-copy_row_data (GVariant **row_data, guint n_cols)
+journal_iter_peek_row (DeeTransaction  *txn,
+                       JournalIter     *jiter,
+                       GVariant       **out_row_members)
+{
+  ColumnDelta *delta;
+
+  if (jiter->row_data)
+    {
+      memcpy (out_row_members, jiter->row_data,
+              txn->priv->n_cols * sizeof (GVariant*));
+      return out_row_members;
+    }
+
+  dee_model_peek_row (txn->priv->target, journal_iter_base (jiter),
+                      out_row_members);
+  for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+    out_row_members[delta->column] = delta->value;
+
+  return out_row_members;
+}
+
+static void
+journal_iter_set_value (DeeTransaction *txn,
+                        JournalIter    *jiter,
+                        guint           column,
+                        GVariant       *value)
+{
+  ColumnDelta *delta;
+
+  value = g_variant_ref_sink (value);
+
+  if (jiter->row_data)
+    {
+      g_variant_unref (jiter->row_data[column]);
+      jiter->row_data[column] = value;
+      return;
+    }
+
+  for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+    {
+      if (delta->column == column)
+        {
+          g_variant_unref (delta->value);
+          delta->value = value;
+          return;
+        }
+    }
+
+  delta = journal_arena_alloc (&txn->priv->data_arena, sizeof (ColumnDelta));
+  delta->column = column;
+  delta->value = value;
+  delta->next = jiter->deltas;
+  jiter->deltas = delta;
+}
+
+static void
+journal_iter_set_row (DeeTransaction  *txn,
+                      JournalIter     *jiter,
+                      GVariant       **row_members)
 {
-  GVariant **iter, **copy;
+  GVariant **row_data;
   guint      i;
 
-  for (iter = row_data, i = 0; i < n_cols; iter++, i++)
+  /* Reuse the row_data we already have. Sink the new values before we drop
+   * the old ones, in case they are the same */
+  row_data = jiter->row_data;
+  if (row_data)
+    {
+      for (i = 0; i < txn->priv->n_cols; i++)
+        {
+          g_variant_ref_sink (row_members[i]);
+          g_variant_unref (row_data[i]);
+          row_data[i] = row_members[i];
+        }
+    }
+  else
     {
-      g_variant_ref_sink (*iter);
+      row_data = copy_row_data (txn, row_members);
     }
 
-  copy = g_new (GVariant*, n_cols + 1);
-  memcpy (copy, row_data, n_cols * sizeof (GVariant*));
-  copy[n_cols] = NULL;
-  return copy;
+  jiter->row_data = NULL;
+  journal_iter_unref_values (jiter);
+  jiter->row_data = row_data;
 }
 
 static JournalIter*
@@ -276,9 +609,9 @@ journal_segment_append (JournalSegment *jseg, GVariant **row_data)
   g_assert ((jseg->last_iter == NULL && jseg->first_iter == NULL) ||
             jseg->last_iter->next_iter == NULL);
 
-  new_jiter = journal_iter_new (CHANGE_TYPE_ADD);
+  new_jiter = journal_iter_new (jseg->txn, CHANGE_TYPE_ADD);
   new_jiter->segment = jseg;
-  new_jiter->row_data = copy_row_data (row_data, jseg->txn->priv->n_cols);
+  new_jiter->row_data = copy_row_data (jseg->txn, row_data);
 
   if (jseg->last_iter == NULL)
     {
@@ -303,9 +636,9 @@ journal_segment_prepend (JournalSegment *jseg, GVariant **row_data)
   g_assert ((jseg->last_iter == NULL && jseg->first_iter == NULL) ||
               jseg->first_iter->prev_iter == NULL);
 
-  new_jiter = journal_iter_new (CHANGE_TYPE_ADD);
+  new_jiter = journal_iter_new (jseg->txn, CHANGE_TYPE_ADD);
   new_jiter->segment = jseg;
-  new_jiter->row_data = copy_row_data (row_data, jseg->txn->priv->n_cols);
+  new_jiter->row_data = copy_row_data (jseg->txn, row_data);
 
   if (jseg->first_iter == NULL)
     {
@@ -342,9 +675,9 @@ journal_segment_insert_before (JournalSegment  *jseg,
     }
 
   /* It's not a pre- or append(), but a genuine insertion */
-  new_jiter = journal_iter_new (CHANGE_TYPE_ADD);
+  new_jiter = journal_iter_new (jseg->txn, CHANGE_TYPE_ADD);
   new_jiter->segment = jseg;
-  new_jiter->row_data = copy_row_data (row_data, jseg->txn->priv->n_cols);
+  new_jiter->row_data = copy_row_data (jseg->txn, row_data);
 
   if (jseg->first_iter == NULL)
     {
@@ -362,23 +695,146 @@ journal_segment_insert_before (JournalSegment  *jseg,
   return new_jiter;
 }
 
+/* Link an existing jiter into a segment, before the jiter 'before' or at
+ * the end of the segment if 'before' is NULL */
+static void
+journal_segment_link_before (JournalSegment *jseg,
+                             JournalIter    *before,
+                             JournalIter    *jiter)
+{
+  jiter->segment = jseg;
+  jiter->next_iter = before;
+
+  if (before == NULL)
+    {
+      jiter->prev_iter = jseg->last_iter;
+      jseg->last_iter = jiter;
+    }
+  else
+    {
+      jiter->prev_iter = before->prev_iter;
+      before->prev_iter = jiter;
+    }
+
+  if (jiter->prev_iter)
+    jiter->prev_iter->next_iter = jiter;
+  else
+    jseg->first_iter = jiter;
+}
+
+static void
+journal_segment_unlink (JournalSegment *jseg, JournalIter *jiter)
+{
+  if (jseg->first_iter == jiter)
+    jseg->first_iter = jiter->next_iter;
+
+  if (jseg->last_iter == jiter)
+    jseg->last_iter = jiter->prev_iter;
+
+  if (jiter->prev_iter)
+    jiter->prev_iter->next_iter = jiter->next_iter;
+
+  if (jiter->next_iter)
+    jiter->next_iter->prev_iter = jiter->prev_iter;
+
+  jiter->prev_iter = NULL;
+  jiter->next_iter = NULL;
+  jiter->segment = NULL;
+}
+
 #define AS_TXN(ptr) ((DeeTransaction*)ptr)
 
+#define is_journal_iter(iter) \
+  journal_arena_contains (&priv->iter_arena, iter)
+
+static TargetRow*
+lookup_target_row (DeeTransactionPrivate *priv,
+                   DeeModelIter          *iter,
+                   gboolean               create)
+{
+  TargetRow *trow;
+
+  trow = g_hash_table_lookup (priv->rows, iter);
+  if (trow == NULL && create)
+    {
+      trow = journal_arena_alloc (&priv->data_arena, sizeof (TargetRow));
+      g_hash_table_insert (priv->rows, iter, trow);
+    }
+
+  return trow;
+}
+
+static JournalSegment*
+lookup_segment_before (DeeTransactionPrivate *priv,
+                       DeeModelIter          *iter)
+{
+  TargetRow *trow;
+
+  if (is_journal_iter (iter))
+    return NULL;
+
+  trow = g_hash_table_lookup (priv->rows, iter);
+  return trow ? trow->segment_before : NULL;
+}
+
+static void
+update_segment_before (DeeTransactionPrivate *priv,
+                       DeeModelIter          *iter,
+                       JournalSegment        *jseg)
+{
+  TargetRow *trow;
+
+  trow = lookup_target_row (priv, iter, jseg != NULL);
+  if (trow == NULL)
+    return;
+
+  if (trow->segment_before == NULL && jseg != NULL)
+    priv->n_segments++;
+  else if (trow->segment_before != NULL && jseg == NULL)
+    priv->n_segments--;
+
+  trow->segment_before = jseg;
+}
+
+/* Returns TRUE and sets *out_jiter if iter is a jiter, or a row of the
+ * target model with an override in the journal */
+static gboolean
+lookup_journal_iter (DeeTransactionPrivate  *priv,
+                     DeeModelIter           *iter,
+                     JournalIter           **out_jiter)
+{
+  TargetRow   *trow;
+  JournalIter *jiter;
+
+  if (is_journal_iter (iter))
+    jiter = (JournalIter *) iter;
+  else if ((trow = g_hash_table_lookup (priv->rows, iter)) != NULL)
+    jiter = trow->jiter;
+  else
+    jiter = NULL;
+
+  if (out_jiter)
+    *out_jiter = jiter;
+
+  return jiter != NULL;
+}
+
 #define get_journal_segment_before(iter) \
-  g_hash_table_lookup (priv->segments, iter)
+  lookup_segment_before (priv, iter)
 
 #define set_journal_segment_before(iter,jseg) \
-  g_hash_table_insert (priv->segments, iter, jseg)
+  update_segment_before (priv, iter, jseg)
 
-#define register_journal_iter(jiter) \
-  g_hash_table_insert (priv->journal, jiter, jiter); \
-  if (jiter->override_iter) g_hash_table_insert (priv->journal, jiter->override_iter, jiter);
+#define clear_journal_segment_before(iter) \
+  update_segment_before (priv, iter, NULL)
 
-#define unregister_journal_iter(jiter) \
-    g_hash_table_remove (priv->journal, jiter);
+#define register_journal_iter(ji) G_STMT_START { \
+  if (ji->override_iter) \
+    lookup_target_row (priv, ji->override_iter, TRUE)->jiter = ji; \
+  } G_STMT_END
 
 #define check_journal_iter(iter,jiter_p) \
-    g_hash_table_lookup_extended (priv->journal, iter, NULL, (void**)jiter_p)
+  lookup_journal_iter (priv, iter, jiter_p)
 
 #define JOURNAL_ITER(iter) \
   ((JournalIter*)iter)
@@ -386,6 +842,17 @@ journal_segment_insert_before (JournalSegment  *jseg,
 #define MODEL_ITER(jiter) \
   ((DeeModelIter*)jiter)
 
+#define remove_from_playback(jiter) \
+    if (jiter->prev_playback) \
+      jiter->prev_playback->next_playback = jiter->next_playback; \
+    else \
+      priv->first_playback = jiter->next_playback; \
+    \
+    if (jiter->next_playback) \
+      jiter->next_playback->prev_playback = jiter->prev_playback; \
+    else \
+      priv->last_playback = jiter->prev_playback;
+
 #define append_to_playback(jiter) \
     if (priv->first_playback == NULL) \
       priv->first_playback = jiter; \
@@ -398,6 +865,75 @@ journal_segment_insert_before (JournalSegment  *jseg,
     \
     priv->last_playback = jiter;
 
+#define unregister_journal_iter(ji) G_STMT_START { \
+  TargetRow *_trow = g_hash_table_lookup (priv->rows, ji->override_iter); \
+  if (_trow != NULL && _trow->jiter == ji) \
+    _trow->jiter = NULL; \
+  } G_STMT_END
+
+#define has_savepoints() (priv->savepoints != NULL)
+
+/* Record a change to the journal on the undo log. Only call this while
+ * there are savepoints */
+static JournalUndo*
+journal_undo_push (DeeTransaction *txn,
+                   UndoType        undo_type,
+                   JournalIter    *jiter)
+{
+  DeeTransactionPrivate *priv = txn->priv;
+  JournalUndo           *undo;
+
+  g_assert (has_savepoints ());
+
+  undo = journal_arena_alloc (&priv->data_arena, sizeof (JournalUndo));
+  undo->undo_type = undo_type;
+  undo->jiter = jiter;
+  undo->next = priv->undo_log;
+  priv->undo_log = undo;
+
+  return undo;
+}
+
+/* Drops the values an undo entry holds on to */
+static void
+journal_undo_unref_values (DeeTransaction *txn, JournalUndo *undo)
+{
+  ColumnDelta *delta;
+  guint        i;
+
+  if (undo->value)
+    {
+      g_variant_unref (undo->value);
+      undo->value = NULL;
+    }
+
+  if (undo->row_data)
+    {
+      for (i = 0; i < txn->priv->n_cols; i++)
+        g_variant_unref (undo->row_data[i]);
+      undo->row_data = NULL;
+    }
+
+  for (delta = undo->deltas; delta != NULL; delta = delta->next)
+    g_variant_unref (delta->value);
+  undo->deltas = NULL;
+}
+
+/* Forget the whole undo log and all savepoints */
+static void
+journal_undo_release_all (DeeTransaction *txn)
+{
+  DeeTransactionPrivate *priv = txn->priv;
+  JournalUndo           *undo;
+
+  for (undo = priv->undo_log; undo != NULL; undo = undo->next)
+    journal_undo_unref_values (txn, undo);
+
+  priv->undo_log = NULL;
+  g_slist_free (priv->savepoints);
+  priv->savepoints = NULL;
+}
+
 static void dee_transaction_model_iface_init (DeeModelIface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (DeeTransaction,
@@ -431,6 +967,10 @@ static DeeModelIter*  dee_transaction_insert_row_before (DeeModel      *self,
 static void           dee_transaction_remove         (DeeModel     *self,
                                                       DeeModelIter *iter);
 
+static DeeModelIter*  dee_transaction_move_before    (DeeModel     *self,
+                                                      DeeModelIter *iter,
+                                                      DeeModelIter *before);
+
 static void           dee_transaction_set_value      (DeeModel       *self,
                                                       DeeModelIter   *iter,
                                                       guint           column,
@@ -444,6 +984,14 @@ static GVariant*      dee_transaction_get_value      (DeeModel     *self,
                                                       DeeModelIter *iter,
                                                       guint          column);
 
+static GVariant*      dee_transaction_peek_value     (DeeModel     *self,
+                                                      DeeModelIter *iter,
+                                                      guint          column);
+
+static GVariant**     dee_transaction_peek_row       (DeeModel      *self,
+                                                      DeeModelIter  *iter,
+                                                      GVariant     **out_row_members);
+
 static DeeModelIter* dee_transaction_get_first_iter  (DeeModel     *self);
 
 static DeeModelIter* dee_transaction_get_last_iter   (DeeModel     *self);
@@ -475,8 +1023,48 @@ static const gchar*   dee_transaction_get_field_schema (DeeModel    *self,
                                                         const gchar *field_name,
                                                         guint       *out_column);
 
-static void           on_target_modified             (DeeTransaction *self,
-                                                      DeeModelIter  *iter);
+static void           on_target_row_removed          (DeeTransaction *self,
+                                                      DeeModelIter   *iter);
+
+static void           on_target_row_changed          (DeeTransaction *self,
+                                                      DeeModelIter   *iter);
+
+static void           on_target_row_moved            (DeeTransaction *self,
+                                                      DeeModelIter   *iter,
+                                                      guint           old_position);
+
+static void           on_target_rows_reordered       (DeeTransaction *self,
+                                                      const guint    *new_order);
+
+static void           on_target_changeset_started    (DeeTransaction *self,
+                                                      DeeModel       *target);
+
+static void           on_target_changeset_finished   (DeeTransaction *self,
+                                                      DeeModel       *target);
+
+static void
+disconnect_target_handlers (DeeTransaction *self)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  gulong                *handlers[] = {
+    &priv->target_row_removed_handler,
+    &priv->target_row_changed_handler,
+    &priv->target_row_moved_handler,
+    &priv->target_rows_reordered_handler,
+    &priv->target_changeset_started_handler,
+    &priv->target_changeset_finished_handler
+  };
+  guint                  i;
+
+  for (i = 0; i < G_N_ELEMENTS (handlers); i++)
+    {
+      if (*handlers[i] != 0)
+        {
+          g_signal_handler_disconnect (priv->target, *handlers[i]);
+          *handlers[i] = 0;
+        }
+    }
+}
 
 /* GObject Init */
 static void
@@ -486,48 +1074,33 @@ dee_transaction_finalize (GObject *object)
   
   if (priv->target)
     {
-      g_signal_handler_disconnect (priv->target, priv->target_row_added_handler);
-      g_signal_handler_disconnect (priv->target, priv->target_row_removed_handler);
-      g_signal_handler_disconnect (priv->target, priv->target_row_changed_handler);
-
+      disconnect_target_handlers (DEE_TRANSACTION (object));
       g_object_unref (priv->target);
     }
   
-  if (priv->journal)
+  if (priv->rows)
     {
-      g_hash_table_unref (priv->journal);
-      priv->journal = NULL;
+      g_hash_table_unref (priv->rows);
+      priv->rows = NULL;
     }
 
-  if (priv->segments)
-    {
-      g_hash_table_unref (priv->segments);
-      priv->segments = NULL;
-    }
+  /* The journal memory goes with the arenas, but the values need unreffing */
+  journal_undo_release_all (DEE_TRANSACTION (object));
 
   if (priv->first_playback)
     {
-      JournalIter *jiter, *free_jiter;
-      GHashTable  *freed_segments = g_hash_table_new (g_direct_hash,
-                                                      g_direct_equal);
-      for (jiter = priv->first_playback; jiter != NULL; )
-        {
-          if (jiter->segment &&
-              g_hash_table_lookup (freed_segments, jiter->segment))
-            {
-              g_hash_table_insert (freed_segments,jiter->segment, jiter->segment);
-              journal_segment_free (jiter->segment);
-            }
+      JournalIter *jiter;
+
+      for (jiter = priv->first_playback; jiter != NULL; jiter = jiter->next_playback)
+        journal_iter_unref_values (jiter);
 
-          free_jiter = jiter;
-          jiter = jiter->next_playback;
-          journal_iter_free (free_jiter);
-        }
       priv->first_playback = NULL;
       priv->last_playback = NULL;
-      g_hash_table_destroy (freed_segments);
     }
 
+  journal_arena_clear (&priv->iter_arena);
+  journal_arena_clear (&priv->data_arena);
+
   G_OBJECT_CLASS (dee_transaction_parent_class)->finalize (object);
 }
 
@@ -575,15 +1148,26 @@ dee_transaction_constructed (GObject *object)
     }
   dee_serializable_model_set_seqnum (DEE_MODEL (object), priv->begin_seqnum);
 
-  priv->target_row_added_handler =
-      g_signal_connect_swapped (priv->target, "row-added",
-                                G_CALLBACK (on_target_modified), object);
+  /* Rows added to the target need no attention. They simply show up in the
+   * transaction like any other untouched row */
   priv->target_row_removed_handler =
       g_signal_connect_swapped (priv->target, "row-removed",
-                                G_CALLBACK (on_target_modified), object);
+                                G_CALLBACK (on_target_row_removed), object);
   priv->target_row_changed_handler =
       g_signal_connect_swapped (priv->target, "row-changed",
-                                G_CALLBACK (on_target_modified), object);
+                                G_CALLBACK (on_target_row_changed), object);
+  priv->target_row_moved_handler =
+      g_signal_connect_swapped (priv->target, "row-moved",
+                                G_CALLBACK (on_target_row_moved), object);
+  priv->target_rows_reordered_handler =
+      g_signal_connect_swapped (priv->target, "rows-reordered",
+                                G_CALLBACK (on_target_rows_reordered), object);
+  priv->target_changeset_started_handler =
+      g_signal_connect_swapped (priv->target, "changeset-started",
+                                G_CALLBACK (on_target_changeset_started), object);
+  priv->target_changeset_finished_handler =
+      g_signal_connect_swapped (priv->target, "changeset-finished",
+                                G_CALLBACK (on_target_changeset_finished), object);
 }
 
 static void
@@ -666,9 +1250,12 @@ dee_transaction_model_iface_init (DeeModelIface *iface)
   iface->insert_row           = piface->insert_row;
   iface->insert_row_before    = dee_transaction_insert_row_before;
   iface->remove               = dee_transaction_remove;
+  iface->move_before          = dee_transaction_move_before;
   iface->set_value            = dee_transaction_set_value;
   iface->set_row              = dee_transaction_set_row;
   iface->get_value            = dee_transaction_get_value;
+  iface->peek_value           = dee_transaction_peek_value;
+  iface->peek_row             = dee_transaction_peek_row;
   iface->get_first_iter       = dee_transaction_get_first_iter;
   iface->get_last_iter        = dee_transaction_get_last_iter;
   iface->get_iter_at_row      = piface->get_iter_at_row;
@@ -698,12 +1285,23 @@ dee_transaction_init (DeeTransaction *model)
   priv = model->priv = DEE_TRANSACTION_GET_PRIVATE (model);
   priv->target = NULL;
   
-  priv->journal = g_hash_table_new (g_direct_hash, g_direct_equal);
-  priv->segments = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+  journal_arena_init (&priv->iter_arena);
+  journal_arena_init (&priv->data_arena);
+  priv->n_journal = 0;
+  priv->n_segments = 0;
+
+  priv->savepoints = NULL;
+  priv->undo_log = NULL;
+  priv->last_savepoint_id = 0;
 
-  priv->target_row_added_handler = 0;
   priv->target_row_removed_handler = 0;
   priv->target_row_changed_handler = 0;
+  priv->target_row_moved_handler = 0;
+  priv->target_rows_reordered_handler = 0;
+  priv->target_changeset_started_handler = 0;
+  priv->target_changeset_finished_handler = 0;
+  priv->target_in_changeset = FALSE;
 }
 
 /*
@@ -759,28 +1357,26 @@ dee_transaction_insert_row_before (DeeModel      *self,
 
   if (check_journal_iter (iter, &jiter))
     {
-      /* If the jiter has a segment it must be an added row and we wire
-       * into that segment */
+      /* Inserting relative to a removed row is a consumer error */
+      if (G_UNLIKELY (jiter->change_type == CHANGE_TYPE_REMOVE))
+        {
+          g_critical ("Inserting new row relative to previously removed row");
+          return iter;
+        }
+
+      /* If the jiter has a segment it must be an added or moved row and we
+       * wire into that segment */
       if (jiter->segment)
         {
-          g_assert (jiter->change_type == CHANGE_TYPE_ADD);
+          g_assert (jiter->change_type == CHANGE_TYPE_ADD ||
+                    jiter->change_type == CHANGE_TYPE_MOVE);
           new_jiter = journal_segment_insert_before (jiter->segment,
                                                      jiter,
                                                      row_members);
         }
       else
         {
-          g_assert (jiter->change_type == CHANGE_TYPE_CHANGE ||
-                    jiter->change_type == CHANGE_TYPE_REMOVE);
-
-          /* Inserting relative to a removed row is a consumer error, but
-           * note we still want the assertion above to verify our own
-           * invariants */
-          if (G_UNLIKELY (jiter->change_type == CHANGE_TYPE_REMOVE))
-            {
-              g_critical ("Inserting new row relative to previously removed row");
-              return iter;
-            }
+          g_assert (jiter->change_type == CHANGE_TYPE_CHANGE);
 
           /* Note that on commit time we might have removed the iter we attach
            * before. We handle that at that point by scanning forwards until we
@@ -820,18 +1416,40 @@ dee_transaction_insert_row_before (DeeModel      *self,
   append_to_playback (new_jiter);
   register_journal_iter (new_jiter);
 
+  if (has_savepoints ())
+    journal_undo_push (DEE_TRANSACTION (self), UNDO_TYPE_NEW_JITER, new_jiter);
+
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-added", new_jiter);
 
   return MODEL_ITER (new_jiter);
 }
 
+/* Take an added or moved jiter out of its segment. A segment left empty
+ * is dropped */
+static void
+journal_detach_from_segment (DeeTransaction *self, JournalIter *jiter)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  JournalSegment        *jseg;
+
+  jseg = jiter->segment;
+  journal_segment_unlink (jseg, jiter);
+
+  if (jseg->first_iter == NULL)
+    {
+      g_assert (jseg->last_iter == NULL);
+      clear_journal_segment_before (jseg->target_iter);
+    }
+}
+
 static void
 dee_transaction_remove (DeeModel     *self,
                         DeeModelIter *iter)
 {
   DeeTransactionPrivate *priv;
-  JournalIter           *jiter;
+  JournalIter           *jiter, *placeholder;
+  JournalUndo           *undo;
   gboolean               should_free_jiter;
 
   g_return_if_fail (DEE_IS_TRANSACTION (self));
@@ -848,16 +1466,32 @@ dee_transaction_remove (DeeModel     *self,
           return;
         }
 
+      if (has_savepoints ())
+        {
+          undo = journal_undo_push (DEE_TRANSACTION (self),
+                                    UNDO_TYPE_REMOVE, jiter);
+          undo->old_change_type = jiter->change_type;
+        }
+
       /* If jiter is something we've added we can just unlink it from the
        * playback queue and its segment and free it. If it's a change we
-       * can simply mark it as a removal in stead.
+       * can simply mark it as a removal in stead. Removing a moved row
+       * turns the jiter it left behind into a plain removal.
+       * While there are savepoints added and moved rows are kept in their
+       * segment as tombstones, so they can be brought back.
        * Note that if a segment is attached to a removed row, we resolve
-       * that at commit() time by scanning forwards to the next non-removed
-       * row. */
+       * that at commit() time by committing the segment first */
       if (jiter->change_type == CHANGE_TYPE_CHANGE)
         {
           jiter->change_type = CHANGE_TYPE_REMOVE;
         }
+      else if (jiter->change_type == CHANGE_TYPE_MOVE)
+        {
+          check_journal_iter (jiter->move_source, &placeholder);
+          g_assert (placeholder->moved_to == jiter);
+          placeholder->moved_to = NULL;
+          should_free_jiter = TRUE;
+        }
       else
         {
           g_assert (jiter->change_type == CHANGE_TYPE_ADD);
@@ -866,10 +1500,13 @@ dee_transaction_remove (DeeModel     *self,
     }
   else
     {
-      jiter = journal_iter_new (CHANGE_TYPE_REMOVE);
+      jiter = journal_iter_new (DEE_TRANSACTION (self), CHANGE_TYPE_REMOVE);
       jiter->override_iter = iter;
       register_journal_iter (jiter);
       append_to_playback (jiter);
+
+      if (has_savepoints ())
+        journal_undo_push (DEE_TRANSACTION (self), UNDO_TYPE_NEW_JITER, jiter);
     }
 
   /* Emit the removed signal while the iter is still valid,
@@ -878,40 +1515,160 @@ dee_transaction_remove (DeeModel     *self,
   g_signal_emit_by_name (self, "row-removed",
                          jiter->override_iter ? jiter->override_iter : MODEL_ITER (jiter));
 
-  if (should_free_jiter)
+  if (should_free_jiter && has_savepoints ())
     {
-      /* Detach from segment */
-      if (jiter->segment->first_iter == jiter)
-        jiter->segment->first_iter = jiter->next_iter;
-
-      if (jiter->segment->last_iter == jiter)
-        jiter->segment->last_iter = jiter->prev_iter;
-
-      /* If our host segment is empty we must get rid of it,
-       * else we unlink our selves from the internal list */
-      if (jiter->segment->first_iter == NULL)
-        {
-          g_assert (jiter->segment->last_iter == NULL);
-          g_hash_table_remove (priv->segments, jiter->segment->target_iter);
-        }
-      else{
+      jiter->change_type = CHANGE_TYPE_REMOVE;
+    }
+  else if (should_free_jiter)
+    {
+      journal_detach_from_segment (DEE_TRANSACTION (self), jiter);
+      remove_from_playback (jiter);
+    }
 
-          if (jiter->prev_iter)
-            jiter->prev_iter->next_iter = jiter->next_iter;
+  /* The values of a removed row are no longer needed, unless rolling back
+   * to a savepoint brings the row back */
+  if (!has_savepoints ())
+    journal_iter_unref_values (jiter);
+}
 
-          if (jiter->next_iter)
-            jiter->next_iter->prev_iter = jiter->prev_iter;
-      }
+static DeeModelIter*
+dee_transaction_move_before (DeeModel     *self,
+                             DeeModelIter *iter,
+                             DeeModelIter *before)
+{
+  DeeTransactionPrivate *priv;
+  JournalIter           *jiter, *before_jiter, *moved, *placeholder;
+  JournalSegment        *jseg;
+  JournalUndo           *undo;
+  gboolean               origin_is_new;
+  guint                  old_pos;
+
+  g_return_val_if_fail (DEE_IS_TRANSACTION (self), NULL);
+  g_return_val_if_fail (!dee_transaction_is_committed (AS_TXN (self)), NULL);
+
+  priv = DEE_TRANSACTION (self)->priv;
+
+  if (iter == before || dee_model_next (self, iter) == before)
+    return iter;
+
+  /* Work out where the row goes before touching the journal. Rows that are
+   * added or already moved sit in a segment, others get one attached
+   * before them just like dee_transaction_insert_row_before() does */
+  if (check_journal_iter (before, &before_jiter))
+    {
+      if (G_UNLIKELY (before_jiter->change_type == CHANGE_TYPE_REMOVE))
+        {
+          g_critical ("Moving row relative to previously removed row");
+          return iter;
+        }
+      if (before_jiter->segment == NULL)
+        before_jiter = NULL;
+    }
+  else
+    before_jiter = NULL;
 
-      /* Remove from playback queue */
-      if (jiter->prev_playback)
-        jiter->prev_playback->next_playback = jiter->next_playback;
+  jiter = NULL;
+  if (check_journal_iter (iter, &jiter) &&
+      G_UNLIKELY (jiter->change_type == CHANGE_TYPE_REMOVE))
+    {
+      g_critical ("Row %p already removed from transaction", iter);
+      return iter;
+    }
+
+  old_pos = dee_model_get_position (self, iter);
 
-      if (jiter->next_playback)
-        jiter->next_playback->prev_playback = jiter->prev_playback;
+  if (jiter != NULL && jiter->segment != NULL && !has_savepoints ())
+    {
+      /* Added and moved rows are simply relinked. They keep their place
+       * in the playback queue */
+      moved = jiter;
+      journal_detach_from_segment (DEE_TRANSACTION (self), moved);
+    }
+  else if (jiter != NULL && jiter->segment != NULL)
+    {
+      /* While there are savepoints the row leaves a tombstone behind, and
+       * a new jiter takes over its values at the new position */
+      moved = journal_iter_new (DEE_TRANSACTION (self), jiter->change_type);
+      moved->move_source = jiter->move_source;
+      moved->row_data = jiter->row_data;
+      moved->deltas = jiter->deltas;
+      jiter->row_data = NULL;
+      jiter->deltas = NULL;
+
+      if (jiter->change_type == CHANGE_TYPE_MOVE)
+        {
+          check_journal_iter (jiter->move_source, &placeholder);
+          g_assert (placeholder->moved_to == jiter);
+          placeholder->moved_to = moved;
+        }
+
+      undo = journal_undo_push (DEE_TRANSACTION (self), UNDO_TYPE_MOVE, moved);
+      undo->origin = jiter;
+      undo->old_change_type = jiter->change_type;
+
+      jiter->change_type = CHANGE_TYPE_REMOVE;
+      jiter->moved_to = moved;
+      append_to_playback (moved);
+    }
+  else
+    {
+      /* A row from the target model. Leave a removal behind at its old
+       * position that commit() skips in favour of the move */
+      moved = journal_iter_new (DEE_TRANSACTION (self), CHANGE_TYPE_MOVE);
+      moved->move_source = iter;
+
+      /* The moved row keeps reading from the target row, and takes over
+       * any changes made to it */
+      origin_is_new = (jiter == NULL);
+      if (jiter != NULL)
+        {
+          g_assert (jiter->change_type == CHANGE_TYPE_CHANGE);
+          moved->row_data = jiter->row_data;
+          moved->deltas = jiter->deltas;
+          jiter->row_data = NULL;
+          jiter->deltas = NULL;
+          jiter->change_type = CHANGE_TYPE_REMOVE;
+        }
+      else
+        {
+          jiter = journal_iter_new (DEE_TRANSACTION (self), CHANGE_TYPE_REMOVE);
+          jiter->override_iter = iter;
+          register_journal_iter (jiter);
+          append_to_playback (jiter);
+        }
+
+      jiter->moved_to = moved;
+      register_journal_iter (moved);
+      append_to_playback (moved);
+
+      if (has_savepoints ())
+        {
+          undo = journal_undo_push (DEE_TRANSACTION (self),
+                                    UNDO_TYPE_MOVE, moved);
+          undo->origin = jiter;
+          undo->origin_is_new = origin_is_new;
+          undo->old_change_type = CHANGE_TYPE_CHANGE;
+        }
+    }
 
-      unregister_journal_iter (jiter);
+  if (before_jiter != NULL)
+    {
+      journal_segment_link_before (before_jiter->segment, before_jiter, moved);
+    }
+  else
+    {
+      if ((jseg = get_journal_segment_before (before)) == NULL)
+        {
+          jseg = journal_segment_new_before (before, DEE_TRANSACTION (self));
+          set_journal_segment_before (before, jseg);
+        }
+      journal_segment_link_before (jseg, NULL, moved);
     }
+
+  dee_serializable_model_inc_seqnum (self);
+  g_signal_emit_by_name (self, "row-moved", MODEL_ITER (moved), old_pos);
+
+  return MODEL_ITER (moved);
 }
 
 static void
@@ -921,7 +1678,7 @@ dee_transaction_set_row (DeeModel       *self,
 {
   DeeTransactionPrivate *priv;
   JournalIter           *jiter;
-  GVariant              **v;
+  JournalUndo           *undo;
 
   g_return_if_fail (DEE_IS_TRANSACTION (self));
   g_return_if_fail (!dee_transaction_is_committed (AS_TXN (self)));
@@ -937,22 +1694,26 @@ dee_transaction_set_row (DeeModel       *self,
           return;
         }
 
-      g_assert (jiter->row_data != NULL);
-      for (v = jiter->row_data; *v != NULL; v++)
+      if (has_savepoints ())
         {
-          g_variant_unref (*v);
+          undo = journal_undo_push (DEE_TRANSACTION (self),
+                                    UNDO_TYPE_SET_ROW, jiter);
+          if (jiter->row_data)
+            undo->row_data = copy_row_data (DEE_TRANSACTION (self),
+                                            jiter->row_data);
+          undo->deltas = jiter->deltas;
+          jiter->deltas = NULL;
         }
-      g_free (jiter->row_data);
 
-      jiter->row_data = copy_row_data (row_members, priv->n_cols);
+      journal_iter_set_row (DEE_TRANSACTION (self), jiter, row_members);
     }
   else
     {
       /* A simple check to raise the probability of iter being a valid
        * iter in the target */
       if (strcmp (g_variant_get_type_string (row_members[0]),
-                  g_variant_get_type_string (dee_model_get_value (priv->target,
-                                                                  iter, 0)))
+                  g_variant_get_type_string (dee_model_peek_value (priv->target,
+                                                                   iter, 0)))
                   != 0)
         {
           g_critical ("Error setting row in transaction %p. The iter is "
@@ -960,16 +1721,20 @@ dee_transaction_set_row (DeeModel       *self,
           return;
         }
 
-      jiter = journal_iter_new (CHANGE_TYPE_CHANGE);
-      jiter->row_data = copy_row_data (row_members, priv->n_cols);
+      jiter = journal_iter_new (DEE_TRANSACTION (self), CHANGE_TYPE_CHANGE);
+      jiter->row_data = copy_row_data (DEE_TRANSACTION (self), row_members);
       jiter->override_iter = iter;
       register_journal_iter (jiter);
       append_to_playback (jiter);
+
+      if (has_savepoints ())
+        journal_undo_push (DEE_TRANSACTION (self), UNDO_TYPE_NEW_JITER, jiter);
     }
 
   g_assert (jiter != NULL);
   g_assert (   (jiter->override_iter != NULL && jiter->change_type == CHANGE_TYPE_CHANGE)
-            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_ADD));
+            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_ADD)
+            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_MOVE));
 
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-changed",
@@ -985,6 +1750,8 @@ dee_transaction_set_value (DeeModel      *self,
 {
   DeeTransactionPrivate *priv;
   JournalIter           *jiter;
+  JournalUndo           *undo;
+  ColumnDelta           *delta;
 
   g_return_if_fail (DEE_IS_TRANSACTION (self));
   g_return_if_fail (iter != NULL);
@@ -1003,28 +1770,44 @@ dee_transaction_set_value (DeeModel      *self,
           return;
         }
 
-      g_variant_unref (jiter->row_data[column]);
-      jiter->row_data[column] = g_variant_ref_sink (value);
+      if (has_savepoints ())
+        {
+          undo = journal_undo_push (DEE_TRANSACTION (self),
+                                    UNDO_TYPE_SET_VALUE, jiter);
+          undo->column = column;
+
+          if (jiter->row_data)
+            undo->value = g_variant_ref (jiter->row_data[column]);
+
+          for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+            {
+              if (delta->column == column)
+                undo->value = g_variant_ref (delta->value);
+            }
+        }
+
+      journal_iter_set_value (DEE_TRANSACTION (self), jiter, column, value);
     }
   else
     {
       /* We haven't touched this row before, which guarantees that the iter
-       * must point to a row in the target model */
-      jiter = journal_iter_new (CHANGE_TYPE_CHANGE);
+       * must point to a row in the target model. Only the changed column
+       * is journaled, the rest is read from the target */
+      jiter = journal_iter_new (DEE_TRANSACTION (self), CHANGE_TYPE_CHANGE);
       jiter->override_iter = iter;
-
-      /* Assume row data */
-      jiter->row_data = dee_model_get_row (priv->target, iter, NULL);
-      g_variant_unref (jiter->row_data[column]);
-      jiter->row_data[column] = g_variant_ref_sink (value);
+      journal_iter_set_value (DEE_TRANSACTION (self), jiter, column, value);
 
       register_journal_iter (jiter);
       append_to_playback (jiter);
+
+      if (has_savepoints ())
+        journal_undo_push (DEE_TRANSACTION (self), UNDO_TYPE_NEW_JITER, jiter);
     }
 
   g_assert (jiter != NULL);
   g_assert (   (jiter->override_iter != NULL && jiter->change_type == CHANGE_TYPE_CHANGE)
-            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_ADD));
+            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_ADD)
+            || (jiter->override_iter == NULL && jiter->change_type == CHANGE_TYPE_MOVE));
 
   dee_serializable_model_inc_seqnum (self);
   g_signal_emit_by_name (self, "row-changed",
@@ -1054,7 +1837,8 @@ dee_transaction_get_value (DeeModel     *self,
         }
 
       g_return_val_if_fail (column < priv->n_cols, NULL);
-      return g_variant_ref (jiter->row_data[column]);
+      return g_variant_ref (journal_iter_peek_value (DEE_TRANSACTION (self),
+                                                     jiter, column));
     }
   else
     {
@@ -1062,6 +1846,71 @@ dee_transaction_get_value (DeeModel     *self,
     }
 }
 
+static GVariant*
+dee_transaction_peek_value (DeeModel     *self,
+                            DeeModelIter *iter,
+                            guint         column)
+{
+  DeeTransactionPrivate *priv;
+  JournalIter          *jiter;
+
+  g_return_val_if_fail (DEE_IS_TRANSACTION (self), NULL);
+  g_return_val_if_fail (!dee_transaction_is_committed (AS_TXN (self)), NULL);
+
+  priv = DEE_TRANSACTION (self)->priv;
+
+  if(check_journal_iter (iter, &jiter))
+    {
+      if (G_UNLIKELY (jiter->change_type == CHANGE_TYPE_REMOVE))
+        {
+          g_critical ("Trying to get value from a row that has been removed "
+                      "from the transaction");
+          return NULL;
+        }
+
+      g_return_val_if_fail (column < priv->n_cols, NULL);
+      return journal_iter_peek_value (DEE_TRANSACTION (self), jiter, column);
+    }
+  else
+    {
+      return dee_model_peek_value (priv->target, iter, column);
+    }
+}
+
+static GVariant**
+dee_transaction_peek_row (DeeModel      *self,
+                          DeeModelIter  *iter,
+                          GVariant     **out_row_members)
+{
+  DeeTransactionPrivate *priv;
+  JournalIter          *jiter;
+
+  g_return_val_if_fail (DEE_IS_TRANSACTION (self), NULL);
+  g_return_val_if_fail (!dee_transaction_is_committed (AS_TXN (self)), NULL);
+
+  priv = DEE_TRANSACTION (self)->priv;
+
+  if(check_journal_iter (iter, &jiter))
+    {
+      if (G_UNLIKELY (jiter->change_type == CHANGE_TYPE_REMOVE))
+        {
+          g_critical ("Trying to get row that has been removed "
+                      "from the transaction");
+          return NULL;
+        }
+
+      if (out_row_members == NULL)
+        out_row_members = g_new0 (GVariant*, priv->n_cols + 1);
+
+      return journal_iter_peek_row (DEE_TRANSACTION (self), jiter,
+                                    out_row_members);
+    }
+  else
+    {
+      return dee_model_peek_row (priv->target, iter, out_row_members);
+    }
+}
+
 /* Inherited methods */
 // dee_transaction_get_bool ()
 
@@ -1221,8 +2070,8 @@ dee_transaction_get_first_iter (DeeModel     *self)
     }
 
   /* Now scan forwards until we have something which is not deleted.
-   * This is complicated by the fact that we may have attached segments
-   * before iters that have been marked removed */
+   * Stepping out of a segment may land us on a removed row again, and
+   * segments may hold tombstones */
   while (itype == ITER_TYPE_JOURNAL && journal_iter_is_removed (jiter))
     {
       iter = dee_transaction_next_raw (self, iter, &itype);
@@ -1231,11 +2080,6 @@ dee_transaction_get_first_iter (DeeModel     *self)
         {
           jiter = JOURNAL_ITER (iter);
         }
-
-      if ((jseg = get_journal_segment_before (iter)) != NULL)
-        {
-          return MODEL_ITER (jseg->first_iter);
-        }
     }
 
   /* Finally - for override iters (changes, this shouldn't be a removal),
@@ -1266,10 +2110,8 @@ static DeeModelIter*
 dee_transaction_next (DeeModel     *self,
                       DeeModelIter *iter)
 {
-  DeeTransactionPrivate *priv;
   IterType               itype;
   JournalIter           *jiter;
-  JournalSegment        *jseg;
 
   // FIXME: Strictly - this method will work even if 'iter' has been marked
   //        removed. It might be nice to complain if anyone does this...
@@ -1277,13 +2119,11 @@ dee_transaction_next (DeeModel     *self,
   g_return_val_if_fail (DEE_IS_TRANSACTION (self), NULL);
   g_return_val_if_fail (!dee_transaction_is_committed (AS_TXN (self)), NULL);
 
-  priv = DEE_TRANSACTION (self)->priv;
-
   iter = dee_transaction_next_raw (self, iter, &itype);
 
   /* Now scan forwards until we have something which is not deleted.
-   * This is complicated by the fact that we may have attached segments
-   * before iters that have been marked removed */
+   * Stepping out of a segment may land us on a removed row again, and
+   * segments may hold tombstones */
   jiter = JOURNAL_ITER (iter);
   while (itype == ITER_TYPE_JOURNAL && journal_iter_is_removed (jiter))
     {
@@ -1293,11 +2133,6 @@ dee_transaction_next (DeeModel     *self,
         {
           jiter = JOURNAL_ITER (iter);
         }
-
-      if ((jseg = get_journal_segment_before (iter)) != NULL)
-        {
-          return MODEL_ITER (jseg->first_iter);
-        }
     }
 
   return iter;
@@ -1318,9 +2153,14 @@ dee_transaction_prev (DeeModel     *self,
 
   if (check_journal_iter(iter, &jiter))
     {
-      if (jiter->prev_iter)
+      /* Skip the tombstones before the row */
+      jiter_prev = jiter->prev_iter;
+      while (jiter_prev != NULL && journal_iter_is_removed (jiter_prev))
+        jiter_prev = jiter_prev->prev_iter;
+
+      if (jiter_prev)
         {
-          return MODEL_ITER (jiter->prev_iter);
+          return MODEL_ITER (jiter_prev);
         }
       else if (dee_model_is_first (priv->target, jiter->segment->target_iter))
         {
@@ -1341,8 +2181,12 @@ dee_transaction_prev (DeeModel     *self,
   /* If there's a segment before the current iter in the target model,
    * step into that segment. Otherwise just step normally on the target */
   jseg = get_journal_segment_before (iter);
-  if (jseg != NULL)
-    return MODEL_ITER (jseg->last_iter);
+  jiter_prev = jseg != NULL ? jseg->last_iter : NULL;
+  while (jiter_prev != NULL && journal_iter_is_removed (jiter_prev))
+    jiter_prev = jiter_prev->prev_iter;
+
+  if (jiter_prev != NULL)
+    return MODEL_ITER (jiter_prev);
   else
     return dee_model_prev (priv->target, iter);
 }
@@ -1392,17 +2236,266 @@ dee_transaction_set_tag (DeeModel       *self,
 
 /*
  * Signal handlers on the target model.
- * Used to detect concurrent changes - which we do not support
+ * Used to detect concurrent changes. Only changes to rows that are in the
+ * journal, or that new rows are attached to, can conflict with the
+ * transaction. Everything else is read through from the target anyway
  */
 
 static void
-on_target_modified (DeeTransaction *self,
-                    DeeModelIter  *iter)
+set_conflict (DeeTransaction *self)
 {
-  if (self->priv->error_code != DEE_TRANSACTION_ERROR_COMMITTED)
+  if (self->priv->error_code == 0)
     self->priv->error_code = DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION;
 }
 
+static void
+on_target_row_removed (DeeTransaction *self,
+                       DeeModelIter   *iter)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  JournalSegment        *jseg, *next_jseg;
+  JournalIter           *jiter;
+  DeeModelIter          *next;
+
+  if (check_journal_iter (iter, &jiter))
+    {
+      set_conflict (self);
+      return;
+    }
+
+  /* Rebase rows that were added before the removed row onto the row after
+   * it. The iter is still valid while the signal is emitted, but the
+   * address may be reused for a new row afterwards, so forget about it */
+  jseg = get_journal_segment_before (iter);
+  clear_journal_segment_before (iter);
+  g_hash_table_remove (priv->rows, iter);
+
+  if (jseg == NULL)
+    return;
+
+  next = dee_model_next (priv->target, iter);
+
+  if ((next_jseg = get_journal_segment_before (next)) != NULL)
+    {
+      /* The rows of jseg come before the rows already attached to next */
+      for (jiter = jseg->first_iter; jiter; jiter = jiter->next_iter)
+        jiter->segment = next_jseg;
+
+      jseg->last_iter->next_iter = next_jseg->first_iter;
+      next_jseg->first_iter->prev_iter = jseg->last_iter;
+      next_jseg->first_iter = jseg->first_iter;
+    }
+  else
+    {
+      jseg->target_iter = next;
+      set_journal_segment_before (next, jseg);
+    }
+}
+
+static void
+on_target_row_changed (DeeTransaction *self,
+                       DeeModelIter   *iter)
+{
+  DeeTransactionPrivate *priv = self->priv;
+
+  if (check_journal_iter (iter, NULL))
+    set_conflict (self);
+}
+
+static void
+on_target_row_moved (DeeTransaction *self,
+                     DeeModelIter   *iter,
+                     guint           old_position)
+{
+  DeeTransactionPrivate *priv = self->priv;
+
+  /* Rows added before the moved row would either follow it or stay behind,
+   * and we can not tell which one the caller meant */
+  if (check_journal_iter (iter, NULL) ||
+      get_journal_segment_before (iter) != NULL)
+    set_conflict (self);
+}
+
+static void
+on_target_rows_reordered (DeeTransaction *self,
+                          const guint    *new_order)
+{
+  DeeTransactionPrivate *priv = self->priv;
+
+  /* Changes and removals don't depend on the order of the rows, but added
+   * and moved rows are placed relative to the rows around them */
+  if (priv->n_segments > 0)
+    set_conflict (self);
+}
+
+static void
+on_target_changeset_started (DeeTransaction *self,
+                             DeeModel       *target)
+{
+  self->priv->target_in_changeset = TRUE;
+}
+
+static void
+on_target_changeset_finished (DeeTransaction *self,
+                              DeeModel       *target)
+{
+  self->priv->target_in_changeset = FALSE;
+}
+
+/*
+ * Savepoints
+ */
+
+/* Revert the change recorded by an undo entry. Entries must be reverted
+ * newest first, which leaves the journal just like it was right after the
+ * change was made */
+static void
+journal_undo_apply (DeeTransaction *self,
+                    JournalUndo    *undo)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  JournalIter           *jiter, *origin, *placeholder;
+  ColumnDelta           *delta;
+  DeeModelIter          *iter;
+
+  jiter = undo->jiter;
+  iter = jiter->override_iter ? jiter->override_iter : MODEL_ITER (jiter);
+
+  switch (undo->undo_type)
+  {
+    case UNDO_TYPE_NEW_JITER:
+      if (jiter->change_type == CHANGE_TYPE_ADD)
+        {
+          /* Emit the removed signal while the iter is still valid */
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-removed", iter);
+          journal_detach_from_segment (self, jiter);
+        }
+      else
+        {
+          unregister_journal_iter (jiter);
+        }
+
+      remove_from_playback (jiter);
+      journal_iter_unref_values (jiter);
+
+      if (jiter->change_type == CHANGE_TYPE_CHANGE)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-changed", iter);
+        }
+      else if (jiter->change_type == CHANGE_TYPE_REMOVE)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "row-added", iter);
+        }
+      break;
+    case UNDO_TYPE_SET_VALUE:
+      if (undo->value)
+        {
+          journal_iter_set_value (self, jiter, undo->column, undo->value);
+        }
+      else
+        {
+          /* The delta for the column was the last one to be added */
+          delta = jiter->deltas;
+          g_assert (delta != NULL && delta->column == undo->column);
+          jiter->deltas = delta->next;
+          g_variant_unref (delta->value);
+        }
+
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-changed", iter);
+      break;
+    case UNDO_TYPE_SET_ROW:
+      journal_iter_unref_values (jiter);
+      jiter->row_data = undo->row_data;
+      jiter->deltas = undo->deltas;
+      undo->row_data = NULL;
+      undo->deltas = NULL;
+
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-changed", iter);
+      break;
+    case UNDO_TYPE_REMOVE:
+      jiter->change_type = undo->old_change_type;
+      if (jiter->change_type == CHANGE_TYPE_MOVE)
+        {
+          check_journal_iter (jiter->move_source, &placeholder);
+          placeholder->moved_to = jiter;
+        }
+
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-added", iter);
+      break;
+    case UNDO_TYPE_MOVE:
+      origin = undo->origin;
+
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-removed", iter);
+      journal_detach_from_segment (self, jiter);
+      remove_from_playback (jiter);
+      origin->moved_to = NULL;
+
+      /* The row goes back to where it came from, with its values */
+      if (undo->origin_is_new)
+        {
+          iter = origin->override_iter;
+          unregister_journal_iter (origin);
+          remove_from_playback (origin);
+          journal_iter_unref_values (jiter);
+        }
+      else
+        {
+          origin->change_type = undo->old_change_type;
+          origin->row_data = jiter->row_data;
+          origin->deltas = jiter->deltas;
+          jiter->row_data = NULL;
+          jiter->deltas = NULL;
+
+          if (origin->change_type == CHANGE_TYPE_MOVE)
+            {
+              check_journal_iter (origin->move_source, &placeholder);
+              placeholder->moved_to = origin;
+            }
+
+          iter = origin->override_iter ? origin->override_iter : MODEL_ITER (origin);
+        }
+
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-added", iter);
+      break;
+    default:
+      g_critical ("Unexpected undo type %u", undo->undo_type);
+      break;
+  }
+}
+
+/* Drops the savepoints taken after the one with the given id and returns
+ * it, or NULL if there is no such savepoint */
+static Savepoint*
+journal_pop_savepoints (DeeTransaction *self,
+                        guint           id)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  GSList                *link;
+
+  for (link = priv->savepoints; link != NULL; link = link->next)
+    {
+      if (((Savepoint *) link->data)->id == id)
+        break;
+    }
+
+  if (link == NULL)
+    return NULL;
+
+  while (priv->savepoints != link)
+    priv->savepoints = g_slist_delete_link (priv->savepoints,
+                                            priv->savepoints);
+
+  return link->data;
+}
+
 /*
  * PUBLIC API
  */
@@ -1474,6 +2567,107 @@ get_txn_error_string (guint error_code)
   }
 }
 
+/* Scratch space for commit(), allocated once */
+typedef struct
+{
+  GVariant ***batch;   /* Rows of a run of additions */
+  GVariant  **row_buf; /* Row assembled from column deltas */
+} CommitBuffers;
+
+static void commit_segment (DeeTransaction  *self,
+                            JournalSegment  *jseg,
+                            CommitBuffers   *bufs);
+
+/* Rows added before a target row that is about to be removed or moved away
+ * must land at its old position, so commit them first */
+static void
+commit_segment_before (DeeTransaction  *self,
+                       DeeModelIter    *iter,
+                       CommitBuffers   *bufs)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  JournalSegment        *jseg;
+
+  if ((jseg = get_journal_segment_before (iter)) != NULL)
+    commit_segment (self, jseg, bufs);
+}
+
+/* Apply the changes journaled for a row from the target. Rows that are
+ * only changed column wise are completed from the target and set in one
+ * go, so the target emits a single row-changed */
+static void
+commit_row_changes (DeeTransaction  *self,
+                    DeeModelIter    *iter,
+                    JournalIter     *jiter,
+                    CommitBuffers   *bufs)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  ColumnDelta           *delta;
+
+  if (jiter->row_data)
+    {
+      dee_model_set_row (priv->target, iter, jiter->row_data);
+    }
+  else if (jiter->deltas)
+    {
+      dee_model_peek_row (priv->target, iter, bufs->row_buf);
+      for (delta = jiter->deltas; delta != NULL; delta = delta->next)
+        bufs->row_buf[delta->column] = delta->value;
+      dee_model_set_row (priv->target, iter, bufs->row_buf);
+    }
+}
+
+/* We can commit the whole segment since a segment is comprised purely of
+ * additions and moves, and tombstones that are skipped. Runs of additions
+ * are collected in batch and handed to the target in one
+ * dee_model_insert_rows_before() call. The batch must be flushed before
+ * recursing into another segment, which reuses it */
+static void
+commit_segment (DeeTransaction  *self,
+                JournalSegment  *jseg,
+                CommitBuffers   *bufs)
+{
+  DeeTransactionPrivate *priv = self->priv;
+  JournalIter           *seg_iter;
+  DeeModelIter          *iter, *anchor;
+  guint                  n_batch;
+
+  if (jseg->is_committed)
+    return;
+
+  jseg->is_committed = TRUE;
+
+  anchor = jseg->target_iter;
+  n_batch = 0;
+  for (seg_iter = jseg->first_iter; seg_iter; seg_iter = seg_iter->next_iter)
+    {
+      if (seg_iter->change_type == CHANGE_TYPE_MOVE)
+        {
+          dee_model_insert_rows_before (priv->target, anchor,
+                                        bufs->batch, n_batch);
+          n_batch = 0;
+
+          commit_segment_before (self, seg_iter->move_source, bufs);
+          iter = dee_model_move_before (priv->target,
+                                        seg_iter->move_source,
+                                        anchor);
+
+          /* The segment may be attached before the moved row itself, in
+           * which case the rest of the segment goes after it */
+          if (iter == anchor)
+            anchor = dee_model_next (priv->target, iter);
+
+          commit_row_changes (self, iter, seg_iter, bufs);
+        }
+      else if (seg_iter->change_type == CHANGE_TYPE_ADD)
+        {
+          bufs->batch[n_batch++] = seg_iter->row_data;
+        }
+    }
+
+  dee_model_insert_rows_before (priv->target, anchor, bufs->batch, n_batch);
+}
+
 /**
  * dee_transaction_commit:
  * @self: The transaction to commit
@@ -1483,15 +2677,27 @@ get_txn_error_string (guint error_code)
  * Apply a transaction to its target model. After this call the transaction
  * is invalidated and must be freed with g_object_unref().
  *
+ * The changes are applied inside a changeset on the target, unless one is
+ * already open, and consecutive added rows are inserted with
+ * dee_model_insert_rows_before(). The target still emits a
+ * #DeeModel::row-added for each of them.
+ *
+ * The commit fails with %DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION if a
+ * row changed, removed or moved in the transaction has been modified in the
+ * target since. Concurrent changes to other rows are kept and the journal is
+ * applied on top of them.
+ *
+ * Committing releases all savepoints of the transaction.
+ *
  * Returns: %TRUE if and only if the transaction successfully applies to :target.
  */
 gboolean
 dee_transaction_commit (DeeTransaction *self, GError **error)
 {
   DeeTransactionPrivate *priv;
-  JournalIter           *jiter, *seg_iter, *free_jiter;
-  GSList                *segments_to_free;
-  DeeModelIter          *iter;
+  JournalIter           *jiter;
+  CommitBuffers          bufs;
+  gboolean               own_changeset;
 
   g_return_val_if_fail (DEE_IS_TRANSACTION (self), FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -1508,75 +2714,177 @@ dee_transaction_commit (DeeTransaction *self, GError **error)
       return FALSE;
     }
 
-  if (DEE_IS_SERIALIZABLE_MODEL (priv->target) &&
-      priv->begin_seqnum != dee_serializable_model_get_seqnum (priv->target))
-    {
-      g_set_error (error,
-                   DEE_TRANSACTION_ERROR,
-                   DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION,
-                   "Target model seqnum has changed during the transaction");
-      return FALSE;
-    }
+  /* Our own changes to the target are not concurrent modifications */
+  disconnect_target_handlers (self);
+
+  /* No run of additions can be longer than the journal */
+  bufs.batch = g_new (GVariant**, priv->n_journal + 1);
+  bufs.row_buf = g_new0 (GVariant*, priv->n_cols + 1);
 
-  /* Because we have many criss crossing references to the segments we need
-   * to collect them carefully to free all of them; and each only once! */
-  segments_to_free = NULL;
+  own_changeset = !priv->target_in_changeset;
+  if (own_changeset)
+    dee_model_begin_changeset (priv->target);
 
-  /* To avoid an extra traversal on finalize() we free the journal iters
-   * as we traverse them now. The txn is illegal after commit() by API
-   * contract anyway */
-  for (jiter = priv->first_playback; jiter != NULL; )
+  /* To avoid an extra traversal on finalize() we drop the values of the
+   * journal iters as we traverse them now. The txn is illegal after commit()
+   * by API contract anyway */
+  for (jiter = priv->first_playback; jiter != NULL; jiter = jiter->next_playback)
     {
       switch (jiter->change_type)
       {
         case CHANGE_TYPE_ADD:
-          /* We can commit the whole segment since a segment is comprised
-           * purely of additions */
-
-          if (jiter->segment->is_committed)
-            break;
-
-          for (seg_iter = jiter->segment->first_iter,
-               iter = jiter->segment->target_iter;
-               seg_iter;
-               seg_iter = seg_iter->next_iter)
-            {
-              dee_model_insert_row_before (priv->target,
-                                           iter,
-                                           seg_iter->row_data);
-            }
-
-          jiter->segment->is_committed = TRUE;
-          segments_to_free = g_slist_prepend (segments_to_free, jiter->segment);
+        case CHANGE_TYPE_MOVE:
+          commit_segment (self, jiter->segment, &bufs);
           break;
         case CHANGE_TYPE_REMOVE:
+          /* Moved rows are played back by their CHANGE_TYPE_MOVE jiter,
+           * and tombstones were never in the target */
+          if (jiter->moved_to != NULL || journal_iter_is_tombstone (jiter))
+            break;
+
+          commit_segment_before (self, jiter->override_iter, &bufs);
           dee_model_remove (priv->target, jiter->override_iter);
           break;
         case CHANGE_TYPE_CHANGE:
-          dee_model_set_row (priv->target,
-                             jiter->override_iter,
-                             jiter->row_data);
+          commit_row_changes (self, jiter->override_iter, jiter, &bufs);
           break;
         default:
           g_critical ("Unexpected change type %u", jiter->change_type);
           break;
       }
 
-      free_jiter = jiter;
-      jiter = jiter->next_playback;
-      journal_iter_free (free_jiter);
+      journal_iter_unref_values (jiter);
     }
 
-  /* By now all jiters  have been freed. Remaining is to free the segments */
-  g_slist_free_full (segments_to_free, (GDestroyNotify) journal_segment_free);
+  if (own_changeset)
+    dee_model_end_changeset (priv->target);
+
+  g_free (bufs.batch);
+  g_free (bufs.row_buf);
 
+  /* Release the journal in one go */
+  journal_undo_release_all (self);
   priv->first_playback = NULL;
   priv->last_playback = NULL;
+  g_hash_table_remove_all (priv->rows);
+  journal_arena_clear (&priv->iter_arena);
+  journal_arena_clear (&priv->data_arena);
 
   priv->error_code = DEE_TRANSACTION_ERROR_COMMITTED;
   return TRUE;
 }
 
+/**
+ * dee_transaction_savepoint:
+ * @self: The transaction to set a savepoint in
+ *
+ * Set a savepoint in the transaction. The changes made to the transaction
+ * after the savepoint can be discarded with dee_transaction_rollback_to(),
+ * leaving the ones made before it in place.
+ *
+ * Savepoints can be nested and they all share the journal of the
+ * transaction. Unlike a #DeeTransaction targeting another transaction no
+ * rows are copied and reading from the transaction is no slower. Changes
+ * made while there are savepoints are recorded in an undo log until the
+ * last savepoint is released or the transaction is committed.
+ *
+ * Returns: An id for the savepoint to pass to dee_transaction_rollback_to()
+ *          or dee_transaction_release_savepoint()
+ */
+guint
+dee_transaction_savepoint (DeeTransaction *self)
+{
+  DeeTransactionPrivate *priv;
+  Savepoint             *savepoint;
+
+  g_return_val_if_fail (DEE_IS_TRANSACTION (self), 0);
+  g_return_val_if_fail (!dee_transaction_is_committed (self), 0);
+
+  priv = self->priv;
+
+  savepoint = journal_arena_alloc (&priv->data_arena, sizeof (Savepoint));
+  savepoint->id = ++priv->last_savepoint_id;
+  savepoint->mark = priv->undo_log;
+  priv->savepoints = g_slist_prepend (priv->savepoints, savepoint);
+
+  return savepoint->id;
+}
+
+/**
+ * dee_transaction_rollback_to:
+ * @self: The transaction to roll back
+ * @savepoint: A savepoint id as returned by dee_transaction_savepoint()
+ *
+ * Discard all changes made to the transaction since @savepoint was set.
+ * The transaction emits the signals needed to bring its rows back to the
+ * state they were in at the savepoint.
+ *
+ * The savepoint itself is kept and can be rolled back to again, but any
+ * savepoints set after it are released.
+ *
+ * Rolling back does not undo a concurrent modification of the target model
+ * that has made the transaction fail.
+ */
+void
+dee_transaction_rollback_to (DeeTransaction *self,
+                             guint           savepoint)
+{
+  DeeTransactionPrivate *priv;
+  Savepoint             *sp;
+  JournalUndo           *undo;
+
+  g_return_if_fail (DEE_IS_TRANSACTION (self));
+  g_return_if_fail (!dee_transaction_is_committed (self));
+
+  priv = self->priv;
+
+  if ((sp = journal_pop_savepoints (self, savepoint)) == NULL)
+    {
+      g_critical ("No savepoint %u in transaction %p", savepoint, self);
+      return;
+    }
+
+  while (priv->undo_log != sp->mark)
+    {
+      undo = priv->undo_log;
+      priv->undo_log = undo->next;
+      journal_undo_apply (self, undo);
+      journal_undo_unref_values (self, undo);
+    }
+}
+
+/**
+ * dee_transaction_release_savepoint:
+ * @self: The transaction to release the savepoint of
+ * @savepoint: A savepoint id as returned by dee_transaction_savepoint()
+ *
+ * Release @savepoint and all savepoints set after it, keeping the changes
+ * made since. Once the last savepoint is released the transaction stops
+ * recording an undo log.
+ */
+void
+dee_transaction_release_savepoint (DeeTransaction *self,
+                                   guint           savepoint)
+{
+  DeeTransactionPrivate *priv;
+
+  g_return_if_fail (DEE_IS_TRANSACTION (self));
+  g_return_if_fail (!dee_transaction_is_committed (self));
+
+  priv = self->priv;
+
+  if (journal_pop_savepoints (self, savepoint) == NULL)
+    {
+      g_critical ("No savepoint %u in transaction %p", savepoint, self);
+      return;
+    }
+
+  priv->savepoints = g_slist_delete_link (priv->savepoints, priv->savepoints);
+
+  if (priv->savepoints == NULL)
+    journal_undo_release_all (self);
+}
+
 GQuark
 dee_transaction_error_quark (void)
 {
@@ -93,8 +93,9 @@ struct _DeeTransactionClass
  * Error codes for the #DeeTransaction class. These codes will be set when the
  * error domain is #DEE_TRANSACTION_ERROR.
  *
- * @DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION: The target model has been
- *   modified while the transaction was open.
+ * @DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION: A row the transaction
+ *   changed, removed or moved has been modified in the target model while
+ *   the transaction was open.
  *
  * @DEE_TRANSACTION_ERROR_COMMITTED: Raised when someone tries to commit a
  *   transaction that has already been committed
@@ -122,6 +123,14 @@ gboolean        dee_transaction_is_committed           (DeeTransaction  *self);
 gboolean        dee_transaction_commit                 (DeeTransaction  *self,
                                                         GError         **error);
 
+guint           dee_transaction_savepoint              (DeeTransaction  *self);
+
+void            dee_transaction_rollback_to            (DeeTransaction  *self,
+                                                        guint            savepoint);
+
+void            dee_transaction_release_savepoint      (DeeTransaction  *self,
+                                                        guint            savepoint);
+
 GQuark          dee_transaction_error_quark            (void);
 
 G_END_DECLS
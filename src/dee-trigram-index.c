@@ -0,0 +1,704 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:dee-trigram-index
+ * @short_description: Substring lookups in a string column
+ * @include: dee.h
+ *
+ * A #DeeTrigramIndex records which rows of a #DeeModel contain each
+ * trigram, that is each sequence of three consecutive characters, of a
+ * string column. The strings are case folded with g_utf8_casefold() before
+ * they are split into trigrams.
+ *
+ * Looking up a piece of text yields the rows containing all the trigrams
+ * of the text. This is a superset of the rows actually containing the text,
+ * so the candidates still need to be verified, but for a reasonably
+ * specific text it is only a small fraction of the model.
+ *
+ * The index keeps itself up to date by listening for changes in the model.
+ * While a trigram index exists for a model it is also picked up
+ * automatically by dee_filter_new_regex() and dee_filter_new_for_substring().
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "dee-trigram-index.h"
+#include "dee-result-set.h"
+#include "dee-glist-result-set.h"
+#include "trace-log.h"
+
+G_DEFINE_TYPE (DeeTrigramIndex, dee_trigram_index, G_TYPE_OBJECT);
+
+#define DEE_TRIGRAM_INDEX_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE(obj, DEE_TYPE_TRIGRAM_INDEX, DeeTrigramIndexPrivate))
+
+/* The trigram indexes of a model are registered on the model under this key
+ * as a GSList. The list does not hold references on the indexes */
+#define TRIGRAM_INDEXES_KEY "dee-trigram-indexes"
+
+/* Room for three UTF-8 encoded characters and a terminating nul */
+#define TRIGRAM_BUF_SIZE 19
+
+typedef void (*TrigramFunc) (const gchar *trigram,
+                             gpointer     user_data);
+
+/*
+ * FORWARDS
+ */
+static void     on_row_added (DeeTrigramIndex *self,
+                              DeeModelIter    *iter,
+                              DeeModel        *model);
+
+static void     on_row_removed (DeeTrigramIndex *self,
+                                DeeModelIter    *iter,
+                                DeeModel        *model);
+
+static void     on_row_changed (DeeTrigramIndex *self,
+                                DeeModelIter    *iter,
+                                DeeModel        *model);
+
+/*
+ * GOBJECT STUFF
+ */
+
+/**
+ * DeeTrigramIndexPrivate:
+ *
+ * Ignore this structure.
+ **/
+struct _DeeTrigramIndexPrivate
+{
+  DeeModel   *model;
+  guint       column;
+
+  /* Holds map of trigram -> GHashTable<DeeModelIter,NULL> */
+  GHashTable *trigrams;
+
+  /* Holds map of DeeModelIter -> case folded string. We need this to find
+   * the old trigrams of a row when it changes */
+  GHashTable *row_texts;
+
+  gulong      on_row_added_handler;
+  gulong      on_row_removed_handler;
+  gulong      on_row_changed_handler;
+};
+
+enum
+{
+  PROP_0,
+  PROP_MODEL,
+  PROP_COLUMN
+};
+
+static void
+dee_trigram_index_finalize (GObject *object)
+{
+  DeeTrigramIndexPrivate *priv = DEE_TRIGRAM_INDEX (object)->priv;
+  GSList                 *indexes;
+
+  if (priv->model)
+    {
+      if (priv->on_row_added_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_added_handler);
+      if (priv->on_row_removed_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_removed_handler);
+      if (priv->on_row_changed_handler)
+        g_signal_handler_disconnect(priv->model, priv->on_row_changed_handler);
+
+      indexes = g_object_get_data (G_OBJECT (priv->model), TRIGRAM_INDEXES_KEY);
+      indexes = g_slist_remove (indexes, object);
+      g_object_set_data (G_OBJECT (priv->model), TRIGRAM_INDEXES_KEY, indexes);
+
+      g_object_unref (priv->model);
+      priv->model = NULL;
+    }
+
+  if (priv->trigrams)
+    {
+      g_hash_table_unref (priv->trigrams);
+      priv->trigrams = NULL;
+    }
+  if (priv->row_texts)
+    {
+      g_hash_table_unref (priv->row_texts);
+      priv->row_texts = NULL;
+    }
+
+  G_OBJECT_CLASS (dee_trigram_index_parent_class)->finalize (object);
+}
+
+static gboolean
+index_existing_row (DeeModel     *model,
+                    DeeModelIter *iter,
+                    gpointer      user_data)
+{
+  on_row_added ((DeeTrigramIndex *) user_data, iter, model);
+  return FALSE;
+}
+
+static void
+dee_trigram_index_constructed (GObject *object)
+{
+  DeeTrigramIndexPrivate *priv = DEE_TRIGRAM_INDEX (object)->priv;
+  DeeTrigramIndex        *self = DEE_TRIGRAM_INDEX (object);
+  GSList                 *indexes;
+
+  if (priv->model == NULL)
+    {
+      g_critical ("You must set the 'model' property when "
+                  "creating a DeeTrigramIndex");
+      return;
+    }
+
+  if (priv->column >= dee_model_get_n_columns (priv->model))
+    {
+      g_critical ("Can not index column %u. The model only has %u columns",
+                  priv->column, dee_model_get_n_columns (priv->model));
+      return;
+    }
+
+  if (g_strcmp0 (dee_model_get_column_schema (priv->model, priv->column),
+                 "s") != 0)
+    {
+      g_critical ("Can not build a trigram index for column %u with "
+                  "schema '%s'. Only string columns are supported",
+                  priv->column,
+                  dee_model_get_column_schema (priv->model, priv->column));
+      return;
+    }
+
+  /* Listen for changes in the model so we automagically pick those up */
+  priv->on_row_added_handler =
+    g_signal_connect_swapped (priv->model, "row-added",
+                              G_CALLBACK (on_row_added), self);
+
+  priv->on_row_removed_handler =
+    g_signal_connect_swapped (priv->model, "row-removed",
+                              G_CALLBACK (on_row_removed), self);
+
+  priv->on_row_changed_handler =
+    g_signal_connect_swapped (priv->model, "row-changed",
+                              G_CALLBACK (on_row_changed), self);
+
+  /* Index existing rows in the model */
+  dee_model_foreach_range (priv->model, NULL, NULL, index_existing_row, self);
+
+  /* Make ourselves known to dee_trigram_index_find() */
+  indexes = g_object_get_data (G_OBJECT (priv->model), TRIGRAM_INDEXES_KEY);
+  indexes = g_slist_prepend (indexes, self);
+  g_object_set_data (G_OBJECT (priv->model), TRIGRAM_INDEXES_KEY, indexes);
+
+  if (G_OBJECT_CLASS (dee_trigram_index_parent_class)->constructed)
+    G_OBJECT_CLASS (dee_trigram_index_parent_class)->constructed (object);
+}
+
+static void
+dee_trigram_index_set_property (GObject       *object,
+                                guint          id,
+                                const GValue  *value,
+                                GParamSpec    *pspec)
+{
+  DeeTrigramIndexPrivate *priv = DEE_TRIGRAM_INDEX (object)->priv;
+
+  switch (id)
+  {
+    case PROP_MODEL:
+      priv->model = DEE_MODEL (g_value_dup_object (value));
+      break;
+    case PROP_COLUMN:
+      priv->column = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+  }
+}
+
+static void
+dee_trigram_index_get_property (GObject     *object,
+                                guint        id,
+                                GValue      *value,
+                                GParamSpec  *pspec)
+{
+  DeeTrigramIndexPrivate *priv = DEE_TRIGRAM_INDEX (object)->priv;
+
+  switch (id)
+  {
+    case PROP_MODEL:
+      g_value_set_object (value, priv->model);
+      break;
+    case PROP_COLUMN:
+      g_value_set_uint (value, priv->column);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+  }
+}
+
+static void
+dee_trigram_index_class_init (DeeTrigramIndexClass *klass)
+{
+  GParamSpec    *pspec;
+  GObjectClass  *obj_class = G_OBJECT_CLASS (klass);
+
+  obj_class->finalize     = dee_trigram_index_finalize;
+  obj_class->constructed  = dee_trigram_index_constructed;
+  obj_class->get_property = dee_trigram_index_get_property;
+  obj_class->set_property = dee_trigram_index_set_property;
+
+  /**
+   * DeeTrigramIndex:model:
+   *
+   * The #DeeModel being indexed
+   */
+  pspec = g_param_spec_object ("model", "Model",
+                               "The model being indexed",
+                               DEE_TYPE_MODEL,
+                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                               | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_MODEL, pspec);
+
+  /**
+   * DeeTrigramIndex:column:
+   *
+   * The index of the string column being indexed
+   */
+  pspec = g_param_spec_uint ("column", "Column",
+                             "The column being indexed",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+                             | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_COLUMN, pspec);
+
+  /* Add private data */
+  g_type_class_add_private (obj_class, sizeof (DeeTrigramIndexPrivate));
+}
+
+static void
+dee_trigram_index_init (DeeTrigramIndex *self)
+{
+  self->priv = DEE_TRIGRAM_INDEX_GET_PRIVATE (self);
+
+  self->priv->trigrams = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free,
+                                                (GDestroyNotify) g_hash_table_unref);
+  self->priv->row_texts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                 NULL, g_free);
+}
+
+/*
+ * IMPLEMENTATION
+ */
+
+/* Call func for each trigram in the (already case folded) text. Trigrams
+ * occurring more than once are passed more than once */
+static void
+foreach_trigram (const gchar *text,
+                 TrigramFunc  func,
+                 gpointer     user_data)
+{
+  const gchar *c0, *c1, *c2, *end;
+  gchar        buf[TRIGRAM_BUF_SIZE];
+  gsize        len;
+
+  c0 = text;
+  if (*c0 == '\0')
+    return;
+  c1 = g_utf8_next_char (c0);
+  if (*c1 == '\0')
+    return;
+  c2 = g_utf8_next_char (c1);
+
+  while (*c2 != '\0')
+    {
+      end = g_utf8_next_char (c2);
+      len = end - c0;
+
+      if (len < TRIGRAM_BUF_SIZE)
+        {
+          memcpy (buf, c0, len);
+          buf[len] = '\0';
+          func (buf, user_data);
+        }
+
+      c0 = c1;
+      c1 = c2;
+      c2 = end;
+    }
+}
+
+typedef struct
+{
+  DeeTrigramIndexPrivate *priv;
+  DeeModelIter           *iter;
+} RowData;
+
+static void
+add_trigram (const gchar *trigram,
+             RowData     *data)
+{
+  GHashTable *rows;
+
+  rows = g_hash_table_lookup (data->priv->trigrams, trigram);
+  if (rows == NULL)
+    {
+      rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_hash_table_insert (data->priv->trigrams, g_strdup (trigram), rows);
+    }
+
+  g_hash_table_insert (rows, data->iter, NULL);
+}
+
+static void
+remove_trigram (const gchar *trigram,
+                RowData     *data)
+{
+  GHashTable *rows;
+
+  rows = g_hash_table_lookup (data->priv->trigrams, trigram);
+  if (rows == NULL)
+    return;
+
+  g_hash_table_remove (rows, data->iter);
+  if (g_hash_table_size (rows) == 0)
+    g_hash_table_remove (data->priv->trigrams, trigram);
+}
+
+/* Takes ownership of text */
+static void
+add_text (DeeTrigramIndex *self,
+          DeeModelIter    *iter,
+          gchar           *text)
+{
+  RowData data;
+
+  data.priv = self->priv;
+  data.iter = iter;
+  foreach_trigram (text, (TrigramFunc) add_trigram, &data);
+
+  g_hash_table_insert (self->priv->row_texts, iter, text);
+}
+
+static void
+remove_text (DeeTrigramIndex *self,
+             DeeModelIter    *iter)
+{
+  RowData      data;
+  const gchar *text;
+
+  text = g_hash_table_lookup (self->priv->row_texts, iter);
+  if (text == NULL)
+    return;
+
+  data.priv = self->priv;
+  data.iter = iter;
+  foreach_trigram (text, (TrigramFunc) remove_trigram, &data);
+
+  g_hash_table_remove (self->priv->row_texts, iter);
+}
+
+static void
+on_row_added (DeeTrigramIndex *self,
+              DeeModelIter    *iter,
+              DeeModel        *model)
+{
+  const gchar *val;
+
+  val = dee_model_get_string (model, iter, self->priv->column);
+  add_text (self, iter, g_utf8_casefold (val, -1));
+}
+
+static void
+on_row_removed (DeeTrigramIndex *self,
+                DeeModelIter    *iter,
+                DeeModel        *model)
+{
+  remove_text (self, iter);
+}
+
+static void
+on_row_changed (DeeTrigramIndex *self,
+                DeeModelIter    *iter,
+                DeeModel        *model)
+{
+  const gchar *val, *old_text;
+  gchar       *text;
+
+  val = dee_model_get_string (model, iter, self->priv->column);
+  text = g_utf8_casefold (val, -1);
+
+  /* Most changes don't touch the indexed column */
+  old_text = g_hash_table_lookup (self->priv->row_texts, iter);
+  if (g_strcmp0 (old_text, text) == 0)
+    {
+      g_free (text);
+      return;
+    }
+
+  remove_text (self, iter);
+  add_text (self, iter, text);
+}
+
+static void
+collect_trigram_rows (const gchar *trigram,
+                      gpointer     user_data)
+{
+  gpointer   *data = (gpointer *) user_data;
+  GHashTable *trigrams = data[0];
+  GPtrArray  *row_sets = data[1];
+  GHashTable *rows;
+
+  rows = g_hash_table_lookup (trigrams, trigram);
+
+  /* A NULL entry means that no rows can match */
+  g_ptr_array_add (row_sets, rows);
+}
+
+static gint
+cmp_row_set_size (gconstpointer a, gconstpointer b)
+{
+  guint size1 = g_hash_table_size (*((GHashTable **) a));
+  guint size2 = g_hash_table_size (*((GHashTable **) b));
+
+  return size1 < size2 ? -1 : (size1 > size2 ? 1 : 0);
+}
+
+/*
+ * API
+ */
+
+/**
+ * dee_trigram_index_new:
+ * @model: The model to index
+ * @column: The index of a string column to index
+ *
+ * Create a new trigram index. The index registers itself with @model so it
+ * will be used by the filters created with dee_filter_new_regex() and
+ * dee_filter_new_for_substring() for as long as it is alive.
+ *
+ * Returns: (transfer full): A newly allocated trigram index. Free with g_object_unref().
+ */
+DeeTrigramIndex*
+dee_trigram_index_new (DeeModel *model,
+                       guint     column)
+{
+  g_return_val_if_fail (DEE_IS_MODEL (model), NULL);
+
+  return (DeeTrigramIndex*) g_object_new (DEE_TYPE_TRIGRAM_INDEX,
+                                          "model", model,
+                                          "column", column,
+                                          NULL);
+}
+
+/**
+ * dee_trigram_index_find:
+ * @model: The model to find a trigram index for
+ * @column: The column the index must cover
+ *
+ * Look up a #DeeTrigramIndex previously created for @column in @model.
+ *
+ * Returns: (transfer none) (allow-none): A #DeeTrigramIndex or %NULL if
+ *          there is no index for @column in @model
+ */
+DeeTrigramIndex*
+dee_trigram_index_find (DeeModel *model,
+                        guint     column)
+{
+  GSList *iter;
+
+  g_return_val_if_fail (DEE_IS_MODEL (model), NULL);
+
+  for (iter = g_object_get_data (G_OBJECT (model), TRIGRAM_INDEXES_KEY);
+       iter != NULL;
+       iter = iter->next)
+    {
+      if (DEE_TRIGRAM_INDEX (iter->data)->priv->column == column)
+        return DEE_TRIGRAM_INDEX (iter->data);
+    }
+
+  return NULL;
+}
+
+/**
+ * dee_trigram_index_get_model:
+ * @self: The index to get the model for
+ *
+ * Get the model being indexed by this index
+ *
+ * Returns: (transfer none): The #DeeModel being indexed by this index
+ */
+DeeModel*
+dee_trigram_index_get_model (DeeTrigramIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_TRIGRAM_INDEX (self), NULL);
+
+  return self->priv->model;
+}
+
+/**
+ * dee_trigram_index_get_column:
+ * @self: The index to get the column for
+ *
+ * Returns: The index of the column being indexed by this index
+ */
+guint
+dee_trigram_index_get_column (DeeTrigramIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_TRIGRAM_INDEX (self), 0);
+
+  return self->priv->column;
+}
+
+/**
+ * dee_trigram_index_lookup:
+ * @self: The index to perform the lookup in
+ * @text: The text to look up
+ *
+ * Find the rows containing all the trigrams of @text, ignoring case. This
+ * includes all the rows containing @text, but may include rows not
+ * containing it as well.
+ *
+ * Returns: (transfer full) (allow-none): A #DeeResultSet or %NULL if @text
+ *          is too short to contain any trigrams, in which case any row may
+ *          contain it. Free with g_object_unref().
+ */
+DeeResultSet*
+dee_trigram_index_lookup (DeeTrigramIndex *self,
+                          const gchar     *text)
+{
+  const gchar *texts[2];
+
+  g_return_val_if_fail (text != NULL, NULL);
+
+  texts[0] = text;
+  texts[1] = NULL;
+
+  return dee_trigram_index_lookup_strv (self, texts);
+}
+
+/**
+ * dee_trigram_index_lookup_strv:
+ * @self: The index to perform the lookup in
+ * @texts: (array zero-terminated=1): A %NULL terminated array of texts to
+ *         look up
+ *
+ * Find the rows containing all the trigrams of all the strings in @texts,
+ * ignoring case. This includes all the rows containing every string in
+ * @texts, but may include rows not containing them as well.
+ *
+ * Returns: (transfer full) (allow-none): A #DeeResultSet or %NULL if none
+ *          of the strings in @texts contain any trigrams, in which case any
+ *          row may contain them. Free with g_object_unref().
+ */
+DeeResultSet*
+dee_trigram_index_lookup_strv (DeeTrigramIndex *self,
+                               const gchar    **texts)
+{
+  DeeTrigramIndexPrivate *priv;
+  DeeResultSet           *results;
+  GPtrArray              *row_sets;
+  GHashTableIter          iter;
+  DeeModelIter           *row;
+  GObject                *rows_owner;
+  GList                  *rows;
+  gpointer                data[2];
+  gchar                  *folded;
+  guint                   i, j;
+
+  g_return_val_if_fail (DEE_IS_TRIGRAM_INDEX (self), NULL);
+  g_return_val_if_fail (texts != NULL, NULL);
+
+  priv = self->priv;
+  row_sets = g_ptr_array_new ();
+  data[0] = priv->trigrams;
+  data[1] = row_sets;
+
+  for (i = 0; texts[i] != NULL; i++)
+    {
+      folded = g_utf8_casefold (texts[i], -1);
+      foreach_trigram (folded, collect_trigram_rows, data);
+      g_free (folded);
+    }
+
+  if (row_sets->len == 0)
+    {
+      g_ptr_array_free (row_sets, TRUE);
+      return NULL;
+    }
+
+  /* A trigram no row has */
+  for (i = 0; i < row_sets->len; i++)
+    {
+      if (g_ptr_array_index (row_sets, i) == NULL)
+        {
+          g_ptr_array_free (row_sets, TRUE);
+          return dee_glist_result_set_new (NULL, /* The empty GList */
+                                           priv->model,
+                                           NULL);
+        }
+    }
+
+  /* Intersect starting from the smallest set of rows, so we look
+   * at as few rows as possible */
+  g_ptr_array_sort (row_sets, cmp_row_set_size);
+
+  rows = NULL;
+  g_hash_table_iter_init (&iter, g_ptr_array_index (row_sets, 0));
+  while (g_hash_table_iter_next (&iter, (gpointer *) &row, NULL))
+    {
+      for (j = 1; j < row_sets->len; j++)
+        {
+          if (!g_hash_table_lookup_extended (g_ptr_array_index (row_sets, j),
+                                             row, NULL, NULL))
+            break;
+        }
+
+      if (j == row_sets->len)
+        rows = g_list_prepend (rows, row);
+    }
+
+  g_ptr_array_free (row_sets, TRUE);
+
+  /* We use a dummy GObject to bolt ref counting onto the GList */
+  rows_owner = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_data_full (rows_owner, "rows",
+                          rows, (GDestroyNotify) g_list_free);
+
+  results = dee_glist_result_set_new (rows, priv->model, rows_owner);
+  g_object_unref (rows_owner);
+
+  return results;
+}
+
+/**
+ * dee_trigram_index_get_n_trigrams:
+ * @self: The index to inspect
+ *
+ * Returns: The number of distinct trigrams in the indexed column
+ */
+guint
+dee_trigram_index_get_n_trigrams (DeeTrigramIndex *self)
+{
+  g_return_val_if_fail (DEE_IS_TRIGRAM_INDEX (self), 0);
+
+  return g_hash_table_size (self->priv->trigrams);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2011 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (_DEE_H_INSIDE) && !defined (DEE_COMPILATION)
+#error "Only <dee.h> can be included directly."
+#endif
+
+#ifndef _HAVE_DEE_TRIGRAM_INDEX_H
+#define _HAVE_DEE_TRIGRAM_INDEX_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee-model.h>
+#include <dee-result-set.h>
+
+G_BEGIN_DECLS
+
+#define DEE_TYPE_TRIGRAM_INDEX (dee_trigram_index_get_type ())
+
+#define DEE_TRIGRAM_INDEX(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+        DEE_TYPE_TRIGRAM_INDEX, DeeTrigramIndex))
+
+#define DEE_TRIGRAM_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), \
+        DEE_TYPE_TRIGRAM_INDEX, DeeTrigramIndexClass))
+
+#define DEE_IS_TRIGRAM_INDEX(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+        DEE_TYPE_TRIGRAM_INDEX))
+
+#define DEE_IS_TRIGRAM_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+        DEE_TYPE_TRIGRAM_INDEX))
+
+#define DEE_TRIGRAM_INDEX_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+        DEE_TYPE_TRIGRAM_INDEX, DeeTrigramIndexClass))
+
+typedef struct _DeeTrigramIndexClass DeeTrigramIndexClass;
+typedef struct _DeeTrigramIndex DeeTrigramIndex;
+typedef struct _DeeTrigramIndexPrivate DeeTrigramIndexPrivate;
+
+/**
+ * DeeTrigramIndex:
+ *
+ * All fields in the DeeTrigramIndex structure are private and should never be
+ * accessed directly
+ */
+struct _DeeTrigramIndex
+{
+  /*< private >*/
+  GObject                 parent;
+
+  DeeTrigramIndexPrivate *priv;
+};
+
+struct _DeeTrigramIndexClass
+{
+  GObjectClass     parent_class;
+};
+
+GType                dee_trigram_index_get_type        (void);
+
+DeeTrigramIndex*     dee_trigram_index_new             (DeeModel        *model,
+                                                        guint            column);
+
+DeeTrigramIndex*     dee_trigram_index_find            (DeeModel        *model,
+                                                        guint            column);
+
+DeeModel*            dee_trigram_index_get_model       (DeeTrigramIndex *self);
+
+guint                dee_trigram_index_get_column      (DeeTrigramIndex *self);
+
+DeeResultSet*        dee_trigram_index_lookup          (DeeTrigramIndex *self,
+                                                        const gchar     *text);
+
+DeeResultSet*        dee_trigram_index_lookup_strv     (DeeTrigramIndex *self,
+                                                        const gchar    **texts);
+
+guint                dee_trigram_index_get_n_trigrams  (DeeTrigramIndex *self);
+
+G_END_DECLS
+
+#endif /* _HAVE_DEE_TRIGRAM_INDEX_H */
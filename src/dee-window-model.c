@@ -0,0 +1,1248 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by:
+ *               agent <agent@local>
+ */
+
+/**
+ * SECTION:dee-window-model
+ * @short_description: A #DeeModel exposing a range of rows from another
+ *                     #DeeModel
+ * @include: dee.h
+ *
+ * A #DeeWindowModel is a view on the rows [offset, offset + limit) of
+ * another #DeeModel. It is meant for paginated or scrolled user interfaces
+ * that only ever display a small slice of a potentially very large model,
+ * such as the results of a #DeeFilterModel.
+ *
+ * Like #DeeFilterModel the window model re-uses the #DeeModelIter<!-- -->s
+ * of its back end model, so any iter from the window model can be used
+ * directly on the back end model. The window model does not copy or track
+ * the rows it exposes, it only keeps a reference to the first row in the
+ * window and to the row just after it.
+ *
+ * Changes to the back end model only cause signals on the window model when
+ * they change the rows inside the window. A row added or removed before the
+ * window shifts the window contents by one row, which is signalled as one
+ * row entering and one row leaving the window. Changes after the window are
+ * never signalled.
+ *
+ * The window can be moved or resized with dee_window_model_set_window().
+ * Locating the new window costs O(log n) in the size of the back end model,
+ * plus a signal for each row entering or leaving the window.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "dee-model.h"
+#include "dee-proxy-model.h"
+#include "dee-window-model.h"
+#include "dee-serializable-model.h"
+#include "trace-log.h"
+
+static void dee_window_model_model_iface_init (DeeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (DeeWindowModel,
+                         dee_window_model,
+                         DEE_TYPE_PROXY_MODEL,
+                         G_IMPLEMENT_INTERFACE (DEE_TYPE_MODEL,
+                                                dee_window_model_model_iface_init));
+
+#define DEE_WINDOW_MODEL_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE(obj, DEE_TYPE_WINDOW_MODEL, DeeWindowModelPrivate))
+
+/**
+ * DeeWindowModelPrivate:
+ *
+ * Ignore this structure.
+ **/
+struct _DeeWindowModelPrivate
+{
+  DeeModel     *orig_model;
+
+  guint         offset;
+  guint         limit;
+  guint         n_rows;
+
+  /* The first row in the window and the row just after the window. The
+   * latter is the last iter of orig_model if the window reaches the end of
+   * orig_model. When the window is empty both are the last iter of
+   * orig_model */
+  DeeModelIter *first;
+  DeeModelIter *end;
+
+  /* Set while we refill the window from a row-removed handler. The row is
+   * still in orig_model at that time, but no longer part of the window */
+  DeeModelIter *doomed;
+
+  /* Set while we signal the removal of a row that orig_model has already
+   * moved out of the window. The row is presented at pinned_pos and the
+   * other rows are the ones from first to end in orig_model */
+  DeeModelIter *pinned;
+  guint         pinned_pos;
+
+  /* Set while we signal the removal of the rows that were in the window
+   * before orig_model was reordered. Those rows are presented in their old
+   * order and priv->end is the last iter of orig_model */
+  GPtrArray    *stale;
+
+  gulong        on_orig_row_added_id;
+  gulong        on_orig_row_removed_id;
+  gulong        on_orig_row_changed_id;
+  gulong        on_orig_row_moved_id;
+  gulong        on_orig_rows_reordered_id;
+  gulong        on_orig_changeset_started_id;
+  gulong        on_orig_changeset_finished_id;
+};
+
+enum
+{
+  PROP_0,
+  PROP_OFFSET,
+  PROP_LIMIT
+};
+
+/*
+ * DeeModel forward declarations
+ */
+static void           dee_window_model_set_schema_full  (DeeModel           *self,
+                                                         const gchar* const *schema,
+                                                         guint               n_columns);
+
+static guint          dee_window_model_get_n_rows       (DeeModel *self);
+
+static DeeModelIter*  dee_window_model_prepend_row      (DeeModel  *self,
+                                                         GVariant **row_members);
+
+static DeeModelIter*  dee_window_model_append_row       (DeeModel  *self,
+                                                         GVariant **row_members);
+
+static DeeModelIter*  dee_window_model_insert_row       (DeeModel  *self,
+                                                         guint      pos,
+                                                         GVariant **row_members);
+
+static DeeModelIter*  dee_window_model_find_row_sorted  (DeeModel           *self,
+                                                         GVariant          **row_spec,
+                                                         DeeCompareRowFunc   cmp_func,
+                                                         gpointer            user_data,
+                                                         gboolean           *out_was_found);
+
+static DeeModelIter*  dee_window_model_get_first_iter   (DeeModel     *self);
+
+static DeeModelIter*  dee_window_model_get_last_iter    (DeeModel     *self);
+
+static DeeModelIter*  dee_window_model_get_iter_at_row  (DeeModel     *self,
+                                                         guint         row);
+
+static DeeModelIter*  dee_window_model_next             (DeeModel     *self,
+                                                         DeeModelIter *iter);
+
+static DeeModelIter*  dee_window_model_prev             (DeeModel     *self,
+                                                         DeeModelIter *iter);
+
+static gboolean       dee_window_model_is_first         (DeeModel     *self,
+                                                         DeeModelIter *iter);
+
+static gboolean       dee_window_model_is_last          (DeeModel     *self,
+                                                         DeeModelIter *iter);
+
+static guint          dee_window_model_get_position     (DeeModel     *self,
+                                                         DeeModelIter *iter);
+
+/*
+ * Callbacks
+ */
+static void        on_orig_model_row_added          (DeeWindowModel *self,
+                                                     DeeModelIter   *iter);
+
+static void        on_orig_model_row_removed        (DeeWindowModel *self,
+                                                     DeeModelIter   *iter);
+
+static void        on_orig_model_row_changed        (DeeWindowModel *self,
+                                                     DeeModelIter   *iter);
+
+static void        on_orig_model_row_moved          (DeeWindowModel *self,
+                                                     DeeModelIter   *iter,
+                                                     guint           old_pos);
+
+static void        on_orig_model_rows_reordered     (DeeWindowModel *self,
+                                                     const guint    *new_order);
+
+static void        on_orig_model_changeset_started  (DeeWindowModel *self,
+                                                     DeeModel       *model);
+
+static void        on_orig_model_changeset_finished (DeeWindowModel *self,
+                                                     DeeModel       *model);
+
+/* GObject stuff */
+static void
+dee_window_model_finalize (GObject *object)
+{
+  DeeWindowModelPrivate *priv = DEE_WINDOW_MODEL (object)->priv;
+
+  if (priv->on_orig_row_added_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_added_id);
+  if (priv->on_orig_row_removed_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_removed_id);
+  if (priv->on_orig_row_changed_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_changed_id);
+  if (priv->on_orig_row_moved_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_row_moved_id);
+  if (priv->on_orig_rows_reordered_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_rows_reordered_id);
+  if (priv->on_orig_changeset_started_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_changeset_started_id);
+  if (priv->on_orig_changeset_finished_id != 0)
+    g_signal_handler_disconnect (priv->orig_model, priv->on_orig_changeset_finished_id);
+
+  priv->on_orig_row_added_id = 0;
+  priv->on_orig_row_removed_id = 0;
+  priv->on_orig_row_changed_id = 0;
+  priv->on_orig_row_moved_id = 0;
+  priv->on_orig_rows_reordered_id = 0;
+  priv->on_orig_changeset_started_id = 0;
+  priv->on_orig_changeset_finished_id = 0;
+
+  if (priv->orig_model)
+    {
+      g_object_unref (priv->orig_model);
+      priv->orig_model = NULL;
+    }
+
+  G_OBJECT_CLASS (dee_window_model_parent_class)->finalize (object);
+}
+
+/* Locate the rows of the window in orig_model without emitting any
+ * signals */
+static void
+dee_window_model_locate (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                  n_orig_rows;
+
+  n_orig_rows = dee_model_get_n_rows (priv->orig_model);
+
+  if (priv->limit == 0 || priv->offset >= n_orig_rows)
+    {
+      priv->n_rows = 0;
+      priv->first = dee_model_get_last_iter (priv->orig_model);
+      priv->end = priv->first;
+      return;
+    }
+
+  priv->n_rows = MIN (priv->limit, n_orig_rows - priv->offset);
+  priv->first = dee_model_get_iter_at_row (priv->orig_model, priv->offset);
+  priv->end = dee_model_get_iter_at_row (priv->orig_model,
+                                         priv->offset + priv->n_rows);
+}
+
+static void
+dee_window_model_constructed (GObject *object)
+{
+  DeeWindowModel        *self = DEE_WINDOW_MODEL (object);
+  DeeWindowModelPrivate *priv = self->priv;
+
+  /* This will return a new reference on back-end */
+  g_object_get (object, "back-end", &(priv->orig_model), NULL);
+
+  dee_window_model_locate (self);
+
+  /* Listen for changes to orig_model */
+  priv->on_orig_row_added_id =
+    g_signal_connect_swapped (priv->orig_model, "row-added",
+                              G_CALLBACK (on_orig_model_row_added), object);
+
+  priv->on_orig_row_removed_id =
+    g_signal_connect_swapped (priv->orig_model, "row-removed",
+                              G_CALLBACK (on_orig_model_row_removed), object);
+
+  priv->on_orig_row_changed_id =
+    g_signal_connect_swapped (priv->orig_model, "row-changed",
+                              G_CALLBACK (on_orig_model_row_changed), object);
+
+  priv->on_orig_row_moved_id =
+    g_signal_connect_swapped (priv->orig_model, "row-moved",
+                              G_CALLBACK (on_orig_model_row_moved), object);
+
+  priv->on_orig_rows_reordered_id =
+    g_signal_connect_swapped (priv->orig_model, "rows-reordered",
+                              G_CALLBACK (on_orig_model_rows_reordered),
+                              object);
+
+  priv->on_orig_changeset_started_id =
+    g_signal_connect_swapped (priv->orig_model, "changeset-started",
+                              G_CALLBACK (on_orig_model_changeset_started),
+                              object);
+
+  priv->on_orig_changeset_finished_id =
+    g_signal_connect_swapped (priv->orig_model, "changeset-finished",
+                              G_CALLBACK (on_orig_model_changeset_finished),
+                              object);
+
+  if (G_OBJECT_CLASS (dee_window_model_parent_class)->constructed)
+    G_OBJECT_CLASS (dee_window_model_parent_class)->constructed (object);
+}
+
+static void
+dee_window_model_set_property (GObject       *object,
+                               guint          id,
+                               const GValue  *value,
+                               GParamSpec    *pspec)
+{
+  DeeWindowModel        *self = DEE_WINDOW_MODEL (object);
+  DeeWindowModelPrivate *priv = self->priv;
+
+  switch (id)
+    {
+    case PROP_OFFSET:
+      if (priv->orig_model)
+        dee_window_model_set_window (self, g_value_get_uint (value),
+                                     priv->limit);
+      else
+        priv->offset = g_value_get_uint (value);
+      break;
+    case PROP_LIMIT:
+      if (priv->orig_model)
+        dee_window_model_set_window (self, priv->offset,
+                                     g_value_get_uint (value));
+      else
+        priv->limit = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+    }
+}
+
+static void
+dee_window_model_get_property (GObject     *object,
+                               guint        id,
+                               GValue      *value,
+                               GParamSpec  *pspec)
+{
+  switch (id)
+    {
+    case PROP_OFFSET:
+      g_value_set_uint (value, DEE_WINDOW_MODEL (object)->priv->offset);
+      break;
+    case PROP_LIMIT:
+      g_value_set_uint (value, DEE_WINDOW_MODEL (object)->priv->limit);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, id, pspec);
+      break;
+    }
+}
+
+static void
+dee_window_model_class_init (DeeWindowModelClass *klass)
+{
+  GParamSpec    *pspec;
+  GObjectClass  *obj_class = G_OBJECT_CLASS (klass);
+
+  obj_class->finalize     = dee_window_model_finalize;
+  obj_class->constructed  = dee_window_model_constructed;
+  obj_class->get_property = dee_window_model_get_property;
+  obj_class->set_property = dee_window_model_set_property;
+
+  /**
+   * DeeWindowModel:offset:
+   *
+   * The position in the back end model of the first row in the window
+   */
+  pspec = g_param_spec_uint ("offset", "Offset",
+                             "Position of the first row in the window",
+                             0, G_MAXUINT, 0,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+                             | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_OFFSET, pspec);
+
+  /**
+   * DeeWindowModel:limit:
+   *
+   * The maximum number of rows in the window
+   */
+  pspec = g_param_spec_uint ("limit", "Limit",
+                             "Maximum number of rows in the window",
+                             0, G_MAXUINT, G_MAXUINT,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+                             | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (obj_class, PROP_LIMIT, pspec);
+
+  /* Add private data */
+  g_type_class_add_private (obj_class, sizeof (DeeWindowModelPrivate));
+}
+
+static void
+dee_window_model_init (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv;
+
+  priv = self->priv = DEE_WINDOW_MODEL_GET_PRIVATE (self);
+
+  priv->orig_model = NULL;
+  priv->offset = 0;
+  priv->limit = G_MAXUINT;
+  priv->n_rows = 0;
+  priv->first = NULL;
+  priv->end = NULL;
+  priv->doomed = NULL;
+  priv->pinned = NULL;
+  priv->pinned_pos = 0;
+  priv->stale = NULL;
+
+  priv->on_orig_row_added_id = 0;
+  priv->on_orig_row_removed_id = 0;
+  priv->on_orig_row_changed_id = 0;
+  priv->on_orig_row_moved_id = 0;
+  priv->on_orig_rows_reordered_id = 0;
+  priv->on_orig_changeset_started_id = 0;
+  priv->on_orig_changeset_finished_id = 0;
+}
+
+static void
+dee_window_model_model_iface_init (DeeModelIface *iface)
+{
+  iface->set_schema_full      = dee_window_model_set_schema_full;
+  iface->get_n_rows           = dee_window_model_get_n_rows;
+  iface->prepend_row          = dee_window_model_prepend_row;
+  iface->append_row           = dee_window_model_append_row;
+  iface->insert_row           = dee_window_model_insert_row;
+  iface->find_row_sorted      = dee_window_model_find_row_sorted;
+  iface->get_first_iter       = dee_window_model_get_first_iter;
+  iface->get_last_iter        = dee_window_model_get_last_iter;
+  iface->get_iter_at_row      = dee_window_model_get_iter_at_row;
+  iface->next                 = dee_window_model_next;
+  iface->prev                 = dee_window_model_prev;
+  iface->is_first             = dee_window_model_is_first;
+  iface->is_last              = dee_window_model_is_last;
+  iface->get_position         = dee_window_model_get_position;
+
+  /* Positions in a reordering are relative to the window, not orig_model.
+   * Leave it to the generic implementation, which moves rows by iter */
+  iface->reorder              = NULL;
+
+  /* The proxy walks orig_model directly, which visits rows outside the
+   * window and ignores the pinned, doomed and stale rows of a window that
+   * is being changed. The generic walk goes through our next and is_last */
+  iface->foreach_range        = NULL;
+}
+
+/*
+ * Helpers for changing the window. Each of them leaves the window in
+ * a consistent state while the signal is emitted
+ */
+
+static void
+dee_window_model_emit (DeeWindowModel *self,
+                       const gchar    *signal,
+                       DeeModelIter   *iter)
+{
+  dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+  g_signal_emit_by_name (self, signal, iter);
+}
+
+/* Drop the first row of the window. The caller must adjust priv->offset */
+static void
+dee_window_model_remove_first (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+
+  dee_window_model_emit (self, "row-removed", priv->first);
+  priv->first = dee_model_next (priv->orig_model, priv->first);
+  priv->n_rows--;
+}
+
+static void
+dee_window_model_remove_last (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  DeeModelIter          *last;
+
+  last = dee_model_prev (priv->orig_model, priv->end);
+  dee_window_model_emit (self, "row-removed", last);
+  priv->end = last;
+  priv->n_rows--;
+}
+
+/* Include the row before the window. The caller must adjust priv->offset */
+static void
+dee_window_model_add_first (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+
+  priv->first = dee_model_prev (priv->orig_model, priv->first);
+  priv->n_rows++;
+  dee_window_model_emit (self, "row-added", priv->first);
+}
+
+/* Include the row just after the window, if there is one */
+static gboolean
+dee_window_model_add_last (DeeWindowModel *self)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  DeeModelIter          *iter;
+
+  if (dee_model_is_last (priv->orig_model, priv->end))
+    return FALSE;
+
+  iter = priv->end;
+  priv->end = dee_model_next (priv->orig_model, iter);
+  priv->n_rows++;
+  dee_window_model_emit (self, "row-added", iter);
+
+  return TRUE;
+}
+
+/*
+ * Callbacks
+ */
+
+static void
+on_orig_model_row_added (DeeWindowModel *self,
+                         DeeModelIter   *iter)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                  pos;
+
+  if (priv->limit == 0)
+    return;
+
+  pos = dee_model_get_position (priv->orig_model, iter);
+
+  /* Rows added after the window are never seen, but the row just after
+   * the window may have changed */
+  if (pos >= priv->offset && pos - priv->offset >= priv->limit)
+    {
+      if (pos - priv->offset == priv->limit)
+        priv->end = iter;
+      return;
+    }
+
+  /* The window is still empty if orig_model doesn't reach it */
+  if (priv->offset >= dee_model_get_n_rows (priv->orig_model))
+    return;
+
+  /* A row added before the window pushes the row just before the window
+   * into it. That row is the new row itself if it was added at the start
+   * of the window */
+  if (pos <= priv->offset)
+    dee_window_model_add_first (self);
+  else
+    {
+      priv->n_rows++;
+      dee_window_model_emit (self, "row-added", iter);
+    }
+
+  /* The last row may have been pushed out of the window */
+  if (priv->n_rows > priv->limit)
+    dee_window_model_remove_last (self);
+}
+
+static void
+on_orig_model_row_removed (DeeWindowModel *self,
+                           DeeModelIter   *iter)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                  pos;
+
+  if (priv->n_rows == 0)
+    return;
+
+  pos = dee_model_get_position (priv->orig_model, iter);
+
+  if (pos >= priv->offset + priv->n_rows)
+    {
+      if (iter == priv->end)
+        priv->end = dee_model_next (priv->orig_model, iter);
+      return;
+    }
+
+  /* A row removed before the window pulls the first row of the window
+   * out of it */
+  if (pos < priv->offset || iter == priv->first)
+    dee_window_model_remove_first (self);
+  else
+    {
+      dee_window_model_emit (self, "row-removed", iter);
+      priv->n_rows--;
+    }
+
+  /* Pull in the row after the window. The removed row is still in
+   * orig_model, so hide it from anyone inspecting us meanwhile */
+  priv->doomed = iter;
+  dee_window_model_add_last (self);
+  priv->doomed = NULL;
+
+  if (priv->n_rows == 0)
+    {
+      priv->first = dee_model_get_last_iter (priv->orig_model);
+      priv->end = priv->first;
+    }
+}
+
+static void
+on_orig_model_row_changed (DeeWindowModel *self,
+                           DeeModelIter   *iter)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                  pos;
+
+  if (priv->n_rows == 0)
+    return;
+
+  pos = dee_model_get_position (priv->orig_model, iter);
+  if (pos >= priv->offset && pos - priv->offset < priv->n_rows)
+    dee_window_model_emit (self, "row-changed", iter);
+}
+
+/* Signal the removal of a row that orig_model has moved from window position
+ * pos to outside the window. The rows left in the window must already run
+ * from priv->first to priv->end */
+static void
+dee_window_model_remove_pinned (DeeWindowModel *self,
+                                DeeModelIter   *iter,
+                                guint           pos)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+
+  priv->pinned = iter;
+  priv->pinned_pos = pos;
+  dee_window_model_emit (self, "row-removed", iter);
+  priv->pinned = NULL;
+  priv->n_rows--;
+}
+
+static void
+on_orig_model_row_moved (DeeWindowModel *self,
+                         DeeModelIter   *iter,
+                         guint           old_pos)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                  new_pos, start, stop;
+  gboolean               was_in, is_in;
+
+  if (priv->n_rows == 0)
+    return;
+
+  new_pos = dee_model_get_position (priv->orig_model, iter);
+  start = priv->offset;
+  stop = priv->offset + priv->n_rows;
+  was_in = old_pos >= start && old_pos < stop;
+  is_in = new_pos >= start && new_pos < stop;
+
+  /* The rows shifted by the move all lie between old_pos and new_pos.
+   * Each case below first points priv->first and priv->end at a run of
+   * orig_model that matches what we signal, so the window is consistent
+   * during every emission */
+  if (was_in && is_in)
+    {
+      dee_window_model_locate (self);
+      dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+      g_signal_emit_by_name (self, "row-moved", iter, old_pos - start);
+    }
+  else if (was_in)
+    {
+      /* The row left the window and a neighbour takes its place */
+      if (new_pos >= stop)
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model, start);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop - 1);
+          dee_window_model_remove_pinned (self, iter, old_pos - start);
+          dee_window_model_add_last (self);
+        }
+      else
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model,
+                                                   start + 1);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop);
+          dee_window_model_remove_pinned (self, iter, old_pos - start);
+          dee_window_model_add_first (self);
+        }
+    }
+  else if (is_in)
+    {
+      /* The row entered the window and pushed a row out of it */
+      if (old_pos < start)
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model,
+                                                   start - 1);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop);
+          priv->n_rows++;
+          dee_window_model_emit (self, "row-added", iter);
+          dee_window_model_remove_first (self);
+        }
+      else
+        {
+          /* The row may have landed in the first slot */
+          priv->first = dee_model_get_iter_at_row (priv->orig_model, start);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop + 1);
+          priv->n_rows++;
+          dee_window_model_emit (self, "row-added", iter);
+          dee_window_model_remove_last (self);
+        }
+    }
+  else if ((old_pos < start) != (new_pos < start))
+    {
+      /* The row jumped over the window, so all of it shifts by one */
+      if (old_pos < start)
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model,
+                                                   start - 1);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop - 1);
+          dee_window_model_remove_first (self);
+          dee_window_model_add_last (self);
+        }
+      else
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model,
+                                                   start + 1);
+          priv->end = dee_model_get_iter_at_row (priv->orig_model, stop + 1);
+          dee_window_model_remove_last (self);
+          dee_window_model_add_first (self);
+        }
+    }
+  else
+    {
+      /* Both positions are on the same side of the window. Only the row
+       * just after the window may have changed */
+      dee_window_model_locate (self);
+    }
+}
+
+static void
+on_orig_model_rows_reordered (DeeWindowModel *self,
+                              const guint    *new_order)
+{
+  DeeWindowModelPrivate *priv = self->priv;
+  guint                 *window_order;
+  guint                  n_orig_rows, start, stop, pos;
+  gboolean               kept, reordered;
+
+  if (priv->n_rows == 0)
+    return;
+
+  start = priv->offset;
+  stop = priv->offset + priv->n_rows;
+
+  /* If the window still holds the same rows we can pass on the reordering */
+  window_order = g_new (guint, priv->n_rows);
+  kept = TRUE;
+  reordered = FALSE;
+  for (pos = start; pos < stop && kept; pos++)
+    {
+      kept = new_order[pos] >= start && new_order[pos] < stop;
+      window_order[pos - start] = new_order[pos] - start;
+      reordered |= new_order[pos] != pos;
+    }
+
+  if (kept)
+    {
+      dee_window_model_locate (self);
+      if (reordered)
+        {
+          dee_serializable_model_inc_seqnum (DEE_MODEL (self));
+          g_signal_emit_by_name (self, "rows-reordered", window_order);
+        }
+      g_free (window_order);
+      return;
+    }
+
+  g_free (window_order);
+
+  /* Otherwise drop the old rows and add the new ones. A window is small,
+   * so that is cheaper than working out what moved where. The old rows
+   * are scattered over orig_model by now, so present them from a list
+   * while we signal their removal */
+  n_orig_rows = dee_model_get_n_rows (priv->orig_model);
+  priv->stale = g_ptr_array_sized_new (priv->n_rows);
+  g_ptr_array_set_size (priv->stale, priv->n_rows);
+  for (pos = 0; pos < n_orig_rows; pos++)
+    {
+      if (new_order[pos] >= start && new_order[pos] < stop)
+        g_ptr_array_index (priv->stale, new_order[pos] - start) =
+          dee_model_get_iter_at_row (priv->orig_model, pos);
+    }
+
+  priv->end = dee_model_get_last_iter (priv->orig_model);
+  while (priv->n_rows > 0)
+    {
+      dee_window_model_emit (self, "row-removed",
+                             g_ptr_array_index (priv->stale, priv->n_rows - 1));
+      priv->n_rows--;
+      g_ptr_array_set_size (priv->stale, priv->n_rows);
+    }
+
+  g_ptr_array_unref (priv->stale);
+  priv->stale = NULL;
+
+  /* Fill the window again from an empty run at its start */
+  priv->first = dee_model_get_iter_at_row (priv->orig_model, start);
+  priv->end = priv->first;
+  for (pos = start; pos < stop; pos++)
+    dee_window_model_add_last (self);
+}
+
+static void
+on_orig_model_changeset_started (DeeWindowModel *self,
+                                 DeeModel       *model)
+{
+  g_signal_emit_by_name (self, "changeset-started");
+}
+
+static void
+on_orig_model_changeset_finished (DeeWindowModel *self,
+                                  DeeModel       *model)
+{
+  g_signal_emit_by_name (self, "changeset-finished");
+}
+
+/*
+ * DeeModel Interface Implementation
+ */
+
+static void
+dee_window_model_set_schema_full (DeeModel *self,
+                                  const gchar* const *schema,
+                                  guint     n_columns)
+{
+  g_return_if_fail (DEE_IS_WINDOW_MODEL (self));
+
+  g_critical ("You can not set the schema on a DeeWindowModel. "
+              "It will always inherit the ones on the original model");
+}
+
+static guint
+dee_window_model_get_n_rows (DeeModel *self)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), 0);
+
+  return DEE_WINDOW_MODEL (self)->priv->n_rows;
+}
+
+static DeeModelIter*
+dee_window_model_prepend_row (DeeModel  *self,
+                              GVariant **row_members)
+{
+  return dee_window_model_insert_row (self, 0, row_members);
+}
+
+static DeeModelIter*
+dee_window_model_append_row (DeeModel  *self,
+                             GVariant **row_members)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  return dee_window_model_insert_row (self,
+                                      DEE_WINDOW_MODEL (self)->priv->n_rows,
+                                      row_members);
+}
+
+/* The row is added to orig_model at the corresponding position. Our
+ * signal handlers take care of the rest */
+static DeeModelIter*
+dee_window_model_insert_row (DeeModel  *self,
+                             guint      pos,
+                             GVariant **row_members)
+{
+  DeeWindowModelPrivate *priv;
+  DeeModelIter          *iter;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  priv = DEE_WINDOW_MODEL (self)->priv;
+
+  if (priv->n_rows == 0)
+    return dee_model_insert_row (priv->orig_model, priv->offset, row_members);
+
+  iter = dee_window_model_get_iter_at_row (self, pos);
+  return dee_model_insert_row_before (priv->orig_model, iter, row_members);
+}
+
+static DeeModelIter*
+dee_window_model_find_row_sorted (DeeModel           *self,
+                                  GVariant          **row_spec,
+                                  DeeCompareRowFunc   cmp_func,
+                                  gpointer            user_data,
+                                  gboolean           *out_was_found)
+{
+  DeeModelIter  *iter;
+  GVariant     **row_buf;
+  guint          lo, hi, mid, n_cols;
+  gint           cmp;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+  g_return_val_if_fail (row_spec != NULL, NULL);
+  g_return_val_if_fail (cmp_func != NULL, NULL);
+
+  if (out_was_found != NULL) *out_was_found = FALSE;
+
+  n_cols = dee_model_get_n_columns (self);
+  row_buf = g_alloca (sizeof (GVariant*) * n_cols);
+
+  /* Like g_sequence_search() find the row after the last one comparing
+   * equal to row_spec */
+  lo = 0;
+  hi = DEE_WINDOW_MODEL (self)->priv->n_rows;
+  cmp = 1;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      iter = dee_window_model_get_iter_at_row (self, mid);
+      dee_model_peek_row (self, iter, row_buf);
+      cmp = cmp_func (row_buf, row_spec, user_data);
+
+      if (cmp <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo > 0)
+    {
+      iter = dee_window_model_get_iter_at_row (self, lo - 1);
+      dee_model_peek_row (self, iter, row_buf);
+      cmp = cmp_func (row_buf, row_spec, user_data);
+
+      if (cmp == 0)
+        {
+          if (out_was_found != NULL) *out_was_found = TRUE;
+          return iter;
+        }
+    }
+
+  return dee_window_model_get_iter_at_row (self, lo);
+}
+
+static DeeModelIter*
+dee_window_model_get_first_iter (DeeModel *self)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  if (DEE_WINDOW_MODEL (self)->priv->pinned != NULL &&
+      DEE_WINDOW_MODEL (self)->priv->pinned_pos == 0)
+    return DEE_WINDOW_MODEL (self)->priv->pinned;
+
+  if (DEE_WINDOW_MODEL (self)->priv->stale != NULL)
+    return dee_window_model_get_iter_at_row (self, 0);
+
+  return DEE_WINDOW_MODEL (self)->priv->first;
+}
+
+static DeeModelIter*
+dee_window_model_get_last_iter (DeeModel *self)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  return DEE_WINDOW_MODEL (self)->priv->end;
+}
+
+static DeeModelIter*
+dee_window_model_get_iter_at_row (DeeModel *self,
+                                  guint     row)
+{
+  DeeWindowModelPrivate *priv;
+  guint                  base, target;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  priv = DEE_WINDOW_MODEL (self)->priv;
+
+  if (row >= priv->n_rows)
+    return priv->end;
+  if (priv->stale != NULL)
+    return g_ptr_array_index (priv->stale, row);
+  if (priv->pinned != NULL)
+    {
+      if (row == priv->pinned_pos)
+        return priv->pinned;
+      if (row > priv->pinned_pos)
+        row--;
+    }
+  if (row == 0)
+    return priv->first;
+
+  base = dee_model_get_position (priv->orig_model, priv->first);
+  target = base + row;
+  if (priv->doomed != NULL &&
+      dee_model_get_position (priv->orig_model, priv->doomed) >= base &&
+      dee_model_get_position (priv->orig_model, priv->doomed) <= target)
+    target++;
+
+  return dee_model_get_iter_at_row (priv->orig_model, target);
+}
+
+static DeeModelIter*
+dee_window_model_next (DeeModel     *self,
+                       DeeModelIter *iter)
+{
+  DeeWindowModelPrivate *priv;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  priv = DEE_WINDOW_MODEL (self)->priv;
+
+  if (iter == priv->end)
+    {
+      g_critical ("Can not get next iter from end iter");
+      return NULL;
+    }
+
+  if (priv->pinned != NULL || priv->stale != NULL)
+    return dee_window_model_get_iter_at_row (self,
+               dee_window_model_get_position (self, iter) + 1);
+
+  iter = dee_model_next (priv->orig_model, iter);
+  if (iter == priv->doomed)
+    iter = dee_model_next (priv->orig_model, iter);
+
+  return iter;
+}
+
+static DeeModelIter*
+dee_window_model_prev (DeeModel     *self,
+                       DeeModelIter *iter)
+{
+  DeeWindowModelPrivate *priv;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), NULL);
+
+  priv = DEE_WINDOW_MODEL (self)->priv;
+
+  if (dee_window_model_is_first (self, iter))
+    {
+      g_critical ("Can not get previous iter from first iter");
+      return NULL;
+    }
+
+  if (priv->pinned != NULL || priv->stale != NULL)
+    return dee_window_model_get_iter_at_row (self,
+               dee_window_model_get_position (self, iter) - 1);
+
+  iter = dee_model_prev (priv->orig_model, iter);
+  if (iter == priv->doomed)
+    iter = dee_model_prev (priv->orig_model, iter);
+
+  return iter;
+}
+
+static gboolean
+dee_window_model_is_first (DeeModel     *self,
+                           DeeModelIter *iter)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), FALSE);
+
+  return iter == dee_window_model_get_first_iter (self);
+}
+
+static gboolean
+dee_window_model_is_last (DeeModel     *self,
+                          DeeModelIter *iter)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), FALSE);
+
+  return iter == DEE_WINDOW_MODEL (self)->priv->end;
+}
+
+static guint
+dee_window_model_get_position (DeeModel     *self,
+                               DeeModelIter *iter)
+{
+  DeeWindowModelPrivate *priv;
+  guint                  base, pos, doomed_pos;
+
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), 0);
+
+  priv = DEE_WINDOW_MODEL (self)->priv;
+
+  if (iter == priv->end)
+    return priv->n_rows;
+  if (iter == priv->pinned)
+    return priv->pinned_pos;
+  if (priv->stale != NULL)
+    {
+      for (pos = 0; pos < priv->stale->len; pos++)
+        {
+          if (g_ptr_array_index (priv->stale, pos) == iter)
+            return pos;
+        }
+      g_critical ("Iter is not in the DeeWindowModel");
+      return 0;
+    }
+
+  base = dee_model_get_position (priv->orig_model, priv->first);
+  pos = dee_model_get_position (priv->orig_model, iter);
+  if (pos < base)
+    {
+      g_critical ("Iter is not in the DeeWindowModel");
+      return 0;
+    }
+
+  if (priv->doomed != NULL)
+    {
+      doomed_pos = dee_model_get_position (priv->orig_model, priv->doomed);
+      if (doomed_pos >= base && doomed_pos < pos)
+        pos--;
+    }
+
+  /* The pinned row isn't part of the run from priv->first */
+  if (priv->pinned != NULL && pos - base >= priv->pinned_pos)
+    pos++;
+
+  return pos - base;
+}
+
+/*
+ * Public API
+ */
+
+/**
+ * dee_window_model_new:
+ * @orig_model: The back end model. This will be set as the
+ *              #DeeProxyModel:back-end property
+ * @offset: The position in @orig_model of the first row in the window
+ * @limit: The maximum number of rows in the window
+ *
+ * Create a view on the rows [@offset, @offset + @limit) of @orig_model.
+ * The window contains fewer rows if @orig_model isn't big enough.
+ *
+ * Returns: (transfer full) (type DeeWindowModel): A newly allocated
+ *          #DeeWindowModel. Free with g_object_unref().
+ */
+DeeModel*
+dee_window_model_new (DeeModel *orig_model,
+                      guint     offset,
+                      guint     limit)
+{
+  g_return_val_if_fail (DEE_IS_MODEL (orig_model), NULL);
+
+  return DEE_MODEL (g_object_new (DEE_TYPE_WINDOW_MODEL,
+                                  "back-end", orig_model,
+                                  "proxy-signals", FALSE,
+                                  "inherit-seqnums", FALSE,
+                                  "offset", offset,
+                                  "limit", limit,
+                                  NULL));
+}
+
+/**
+ * dee_window_model_set_window:
+ * @self: The #DeeWindowModel to move
+ * @offset: The position in the back end model of the first row in the window
+ * @limit: The maximum number of rows in the window
+ *
+ * Move or resize the window. Rows leaving the window are signalled with
+ * #DeeModel::row-removed and rows entering it with #DeeModel::row-added,
+ * all within one changeset. Rows in both the old and the new window are
+ * left alone.
+ */
+void
+dee_window_model_set_window (DeeWindowModel *self,
+                             guint           offset,
+                             guint           limit)
+{
+  DeeWindowModelPrivate *priv;
+  guint                  n_orig_rows, stop;
+  gboolean               offset_changed, limit_changed;
+
+  g_return_if_fail (DEE_IS_WINDOW_MODEL (self));
+
+  priv = self->priv;
+
+  offset_changed = offset != priv->offset;
+  limit_changed = limit != priv->limit;
+  if (!offset_changed && !limit_changed)
+    return;
+
+  n_orig_rows = dee_model_get_n_rows (priv->orig_model);
+  stop = offset < n_orig_rows ? offset + MIN (limit, n_orig_rows - offset)
+                              : offset;
+
+  g_signal_emit_by_name (self, "changeset-started");
+
+  if (priv->n_rows == 0 || stop <= offset ||
+      offset >= priv->offset + priv->n_rows || stop <= priv->offset)
+    {
+      /* The windows don't overlap, so replace all the rows */
+      while (priv->n_rows > 0)
+        dee_window_model_remove_first (self);
+
+      priv->offset = offset;
+      priv->limit = limit;
+
+      if (stop > offset)
+        {
+          priv->first = dee_model_get_iter_at_row (priv->orig_model, offset);
+          priv->end = priv->first;
+          while (priv->n_rows < limit && dee_window_model_add_last (self));
+        }
+      else
+        {
+          priv->first = dee_model_get_last_iter (priv->orig_model);
+          priv->end = priv->first;
+        }
+    }
+  else
+    {
+      /* Trim the rows outside the new window, then extend it */
+      for (; priv->offset < offset; priv->offset++)
+        dee_window_model_remove_first (self);
+      while (priv->offset + priv->n_rows > stop)
+        dee_window_model_remove_last (self);
+      for (; priv->offset > offset; priv->offset--)
+        dee_window_model_add_first (self);
+
+      priv->limit = limit;
+      while (priv->n_rows < limit && dee_window_model_add_last (self));
+    }
+
+  g_signal_emit_by_name (self, "changeset-finished");
+
+  if (offset_changed)
+    g_object_notify (G_OBJECT (self), "offset");
+  if (limit_changed)
+    g_object_notify (G_OBJECT (self), "limit");
+}
+
+/**
+ * dee_window_model_get_offset:
+ * @self: The #DeeWindowModel to inspect
+ *
+ * Returns: The position in the back end model of the first row in the window
+ */
+guint
+dee_window_model_get_offset (DeeWindowModel *self)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), 0);
+
+  return self->priv->offset;
+}
+
+/**
+ * dee_window_model_get_limit:
+ * @self: The #DeeWindowModel to inspect
+ *
+ * Returns: The maximum number of rows in the window
+ */
+guint
+dee_window_model_get_limit (DeeWindowModel *self)
+{
+  g_return_val_if_fail (DEE_IS_WINDOW_MODEL (self), 0);
+
+  return self->priv->limit;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 3.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License version 3.0 for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authored by agent <agent@local>
+ */
+
+#if !defined (_DEE_H_INSIDE) && !defined (DEE_COMPILATION)
+#error "Only <dee.h> can be included directly."
+#endif
+
+#ifndef _HAVE_DEE_WINDOW_MODEL_H
+#define _HAVE_DEE_WINDOW_MODEL_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <dee-model.h>
+#include <dee-proxy-model.h>
+
+G_BEGIN_DECLS
+
+#define DEE_TYPE_WINDOW_MODEL (dee_window_model_get_type ())
+
+#define DEE_WINDOW_MODEL(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+        DEE_TYPE_WINDOW_MODEL, DeeWindowModel))
+
+#define DEE_WINDOW_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), \
+        DEE_TYPE_WINDOW_MODEL, DeeWindowModelClass))
+
+#define DEE_IS_WINDOW_MODEL(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+        DEE_TYPE_WINDOW_MODEL))
+
+#define DEE_IS_WINDOW_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+        DEE_TYPE_WINDOW_MODEL))
+
+#define DEE_WINDOW_MODEL_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+        DEE_TYPE_WINDOW_MODEL, DeeWindowModelClass))
+
+typedef struct _DeeWindowModel DeeWindowModel;
+typedef struct _DeeWindowModelClass DeeWindowModelClass;
+typedef struct _DeeWindowModelPrivate DeeWindowModelPrivate;
+
+/**
+ * DeeWindowModel:
+ *
+ * All fields in the DeeWindowModel structure are private and should never be
+ * accessed directly
+ */
+struct _DeeWindowModel
+{
+  /*< private >*/
+  DeeProxyModel          parent;
+
+  DeeWindowModelPrivate *priv;
+};
+
+struct _DeeWindowModelClass
+{
+  /*< private >*/
+  DeeProxyModelClass parent_class;
+
+  /*< private >*/
+  void (*_dee_window_model_1) (void);
+  void (*_dee_window_model_2) (void);
+  void (*_dee_window_model_3) (void);
+  void (*_dee_window_model_4) (void);
+};
+
+/**
+ * dee_window_model_get_type:
+ *
+ * The GType of #DeeWindowModel
+ *
+ * Return value: the #GType of #DeeWindowModel
+ **/
+GType                 dee_window_model_get_type        (void);
+
+DeeModel*             dee_window_model_new             (DeeModel *orig_model,
+                                                        guint     offset,
+                                                        guint     limit);
+
+void                  dee_window_model_set_window      (DeeWindowModel *self,
+                                                        guint           offset,
+                                                        guint           limit);
+
+guint                 dee_window_model_get_offset      (DeeWindowModel *self);
+
+guint                 dee_window_model_get_limit       (DeeWindowModel *self);
+
+G_END_DECLS
+
+#endif /* _HAVE_DEE_WINDOW_MODEL_H */
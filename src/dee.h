@@ -38,11 +38,15 @@
 #include <dee-proxy-model.h>
 #include <dee-sequence-model.h>
 #include <dee-shared-model.h>
+#include <dee-aggregate-model.h>
 #include <dee-filter-model.h>
+#include <dee-window-model.h>
 #include <dee-filter.h>
 #include <dee-index.h>
+#include <dee-column-index.h>
 #include <dee-hash-index.h>
 #include <dee-tree-index.h>
+#include <dee-trigram-index.h>
 #include <dee-term-list.h>
 #include <dee-result-set.h>
 #include <dee-analyzer.h>
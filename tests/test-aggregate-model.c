@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2011 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee.h>
+
+typedef struct
+{
+  DeeModel *model;
+  DeeModel *aggregates;
+
+} Fixture;
+
+static void setup    (Fixture *fix, gconstpointer data);
+static void teardown (Fixture *fix, gconstpointer data);
+
+static void
+setup (Fixture *fix, gconstpointer data)
+{
+  DeeAggregate aggregates[] = {
+    { DEE_AGGREGATE_COUNT, 0 },
+    { DEE_AGGREGATE_SUM, 1 },
+    { DEE_AGGREGATE_MIN, 1 },
+    { DEE_AGGREGATE_MAX, 1 }
+  };
+
+  fix->model = dee_sequence_model_new ();
+  dee_model_set_schema (fix->model, "s", "i", NULL);
+
+  dee_model_append (fix->model, "apps", 10);
+  dee_model_append (fix->model, "files", 5);
+  dee_model_append (fix->model, "apps", 3);
+  dee_model_append (fix->model, "apps", 7);
+
+  fix->aggregates = dee_aggregate_model_new (fix->model, 0, aggregates,
+                                             G_N_ELEMENTS (aggregates));
+}
+
+static void
+teardown (Fixture *fix, gconstpointer data)
+{
+  g_object_unref (fix->aggregates);
+  g_object_unref (fix->model);
+  fix->aggregates = NULL;
+  fix->model = NULL;
+}
+
+/* Check the count, sum, min and max of a group */
+static void
+assert_group (Fixture *fix, const gchar *key,
+              guint count, gint64 sum, gint min, gint max)
+{
+  DeeModelIter *iter;
+
+  iter = dee_aggregate_model_find_group (DEE_AGGREGATE_MODEL (fix->aggregates),
+                                         g_variant_new_string (key));
+  g_assert (iter != NULL);
+  g_assert_cmpstr (key, ==, dee_model_get_string (fix->aggregates, iter, 0));
+  g_assert_cmpuint (count, ==, dee_model_get_uint32 (fix->aggregates, iter, 1));
+  g_assert_cmpint (sum, ==, dee_model_get_int64 (fix->aggregates, iter, 2));
+  g_assert_cmpint (min, ==, dee_model_get_int32 (fix->aggregates, iter, 3));
+  g_assert_cmpint (max, ==, dee_model_get_int32 (fix->aggregates, iter, 4));
+}
+
+static void
+test_initial (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+
+  g_assert_cmpuint (5, ==, dee_model_get_n_columns (fix->aggregates));
+  g_assert_cmpstr ("s", ==, dee_model_get_column_schema (fix->aggregates, 0));
+  g_assert_cmpstr ("u", ==, dee_model_get_column_schema (fix->aggregates, 1));
+  g_assert_cmpstr ("x", ==, dee_model_get_column_schema (fix->aggregates, 2));
+  g_assert_cmpstr ("i", ==, dee_model_get_column_schema (fix->aggregates, 3));
+
+  /* Groups are in the order they first appear */
+  g_assert_cmpuint (2, ==, dee_model_get_n_rows (fix->aggregates));
+  iter = dee_model_get_first_iter (fix->aggregates);
+  g_assert_cmpstr ("apps", ==, dee_model_get_string (fix->aggregates, iter, 0));
+
+  assert_group (fix, "apps", 3, 20, 3, 10);
+  assert_group (fix, "files", 1, 5, 5, 5);
+
+  g_assert (dee_aggregate_model_find_group (DEE_AGGREGATE_MODEL (fix->aggregates),
+                                            g_variant_new_string ("music")) == NULL);
+}
+
+static void
+test_updates (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+
+  dee_model_append (fix->model, "music", 2);
+  g_assert_cmpuint (3, ==, dee_model_get_n_rows (fix->aggregates));
+  assert_group (fix, "music", 1, 2, 2, 2);
+
+  dee_model_append (fix->model, "apps", 20);
+  assert_group (fix, "apps", 4, 40, 3, 20);
+
+  /* Removing the max must expose the next largest value */
+  iter = dee_model_prev (fix->model, dee_model_get_last_iter (fix->model));
+  dee_model_remove (fix->model, iter);
+  assert_group (fix, "apps", 3, 20, 3, 10);
+
+  /* Change the min in place */
+  iter = dee_model_get_iter_at_row (fix->model, 2);
+  dee_model_set (fix->model, iter, "apps", 12);
+  assert_group (fix, "apps", 3, 29, 7, 12);
+
+  /* Move a row to another group */
+  dee_model_set (fix->model, iter, "files", 12);
+  assert_group (fix, "apps", 2, 17, 7, 10);
+  assert_group (fix, "files", 2, 17, 5, 12);
+
+  /* The group goes away with its last row */
+  dee_model_remove (fix->model, dee_model_get_iter_at_row (fix->model, 4));
+  g_assert_cmpuint (2, ==, dee_model_get_n_rows (fix->aggregates));
+  g_assert (dee_aggregate_model_find_group (DEE_AGGREGATE_MODEL (fix->aggregates),
+                                            g_variant_new_string ("music")) == NULL);
+
+  dee_model_clear (fix->model);
+  g_assert_cmpuint (0, ==, dee_model_get_n_rows (fix->aggregates));
+}
+
+void
+test_aggregate_model_create_suite (void)
+{
+#define DOMAIN "/Model/Aggregate"
+
+  g_test_add (DOMAIN"/Initial", Fixture, 0,
+              setup, test_initial, teardown);
+  g_test_add (DOMAIN"/Updates", Fixture, 0,
+              setup, test_updates, teardown);
+}
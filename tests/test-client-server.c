@@ -17,14 +17,30 @@
  *
  */
 
+#include "config.h"
+
+#ifdef HAVE_MEMFD_CREATE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <glib-object.h>
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 #include <dee.h>
 #include <gtx.h>
 
 #define TIMEOUT 100
 #define PEER_NAME "com.canonical.Dee.Peer.Tests.Interactions"
 #define MODEL_NAME "com.canonical.Dee.Peer.Tests.Interactions"
+#define FAKE_LEADER_NAME "com.canonical.Dee.Peer.Tests.FakeLeader"
+#define FAKE_LEADER_PATH "/com/canonical/dee/model/com/canonical/Dee/Peer/Tests/FakeLeader"
+#define MODEL_PATH "/com/canonical/dee/model/com/canonical/Dee/Peer/Tests/Interactions"
 
 /* A command line that launches the appropriate *-helper-* executable,
  * giving $name as first argument */
@@ -75,6 +91,22 @@ static void test_multiple_models  (Fixture *fix, gconstpointer data);
 static void test_multiple_models2 (Fixture *fix, gconstpointer data);
 static void test_remote_append    (Fixture *fix, gconstpointer data);
 static void test_disabled_writes  (Fixture *fix, gconstpointer data);
+static void test_commit_fanout    (Fixture *fix, gconstpointer data);
+static void test_clone_cache      (Fixture *fix, gconstpointer data);
+#ifdef HAVE_MEMFD_CREATE
+static void test_clone_fd_unsealed (Fixture *fix, gconstpointer data);
+#endif
+static void test_clone_since_hit   (Fixture *fix, gconstpointer data);
+static void test_clone_since_miss  (Fixture *fix, gconstpointer data);
+static void test_clone_since_stale (Fixture *fix, gconstpointer data);
+static void test_snapshot_subscription (Fixture *fix, gconstpointer data);
+static void test_snapshot_periodic (Fixture *fix, gconstpointer data);
+static void test_subscription      (Fixture *fix, gconstpointer data);
+static void test_unsubscribe       (Fixture *fix, gconstpointer data);
+static void test_move              (Fixture *fix, gconstpointer data);
+static void test_move_old_peer     (Fixture *fix, gconstpointer data);
+static void test_reorder           (Fixture *fix, gconstpointer data);
+static void test_reorder_old_peer  (Fixture *fix, gconstpointer data);
 
 void
 test_client_server_interactions_create_suite (void)
@@ -127,6 +159,36 @@ test_client_server_interactions_create_suite (void)
               model_setup, test_remote_append, model_teardown);
   g_test_add (DOMAIN"/DisabledWrites", Fixture, 0,
               model_setup_null, test_disabled_writes, model_teardown_null);
+  g_test_add (DOMAIN"/CommitFanout", Fixture, 0,
+              model_setup, test_commit_fanout, model_teardown);
+  g_test_add (DOMAIN"/CloneCache", Fixture, 0,
+              model_setup, test_clone_cache, model_teardown);
+#ifdef HAVE_MEMFD_CREATE
+  g_test_add (DOMAIN"/CloneFdUnsealed", Fixture, 0,
+              model_setup_null, test_clone_fd_unsealed, model_teardown_null);
+#endif
+  g_test_add (DOMAIN"/CloneSinceHit", Fixture, 0,
+              model_setup, test_clone_since_hit, model_teardown);
+  g_test_add (DOMAIN"/CloneSinceMiss", Fixture, 0,
+              model_setup, test_clone_since_miss, model_teardown);
+  g_test_add (DOMAIN"/CloneSinceStale", Fixture, 0,
+              model_setup, test_clone_since_stale, model_teardown);
+  g_test_add (DOMAIN"/SnapshotSubscription", Fixture, 0,
+              model_setup, test_snapshot_subscription, model_teardown);
+  g_test_add (DOMAIN"/SnapshotPeriodic", Fixture, 0,
+              model_setup, test_snapshot_periodic, model_teardown);
+  g_test_add (DOMAIN"/Subscription", Fixture, 0,
+              model_setup, test_subscription, model_teardown);
+  g_test_add (DOMAIN"/Unsubscribe", Fixture, 0,
+              model_setup, test_unsubscribe, model_teardown);
+  g_test_add (DOMAIN"/Move", Fixture, 0,
+              model_setup, test_move, model_teardown);
+  g_test_add (DOMAIN"/MoveOldPeer", Fixture, 0,
+              model_setup, test_move_old_peer, model_teardown);
+  g_test_add (DOMAIN"/Reorder", Fixture, 0,
+              model_setup, test_reorder, model_teardown);
+  g_test_add (DOMAIN"/ReorderOldPeer", Fixture, 0,
+              model_setup, test_reorder_old_peer, model_teardown);
 }
 
 static void
@@ -890,3 +952,1004 @@ test_disabled_writes (Fixture *fix, gconstpointer data)
   g_assert_cmpstr (dee_model_get_string (fix->model, iter, 1), ==, "eightyone");
 }
 
+static DeeModel*
+_new_client_model (void)
+{
+  DeeModel *model;
+
+  model = dee_shared_model_new_for_peer (
+      DEE_PEER (dee_client_new (MODEL_NAME)));
+
+  if (!dee_shared_model_is_synchronized (DEE_SHARED_MODEL (model)))
+    {
+      if (gtx_wait_for_signal (G_OBJECT (model), TIMEOUT,
+                               "notify::synchronized", NULL))
+        g_critical ("Client model never synchronized");
+    }
+
+  return model;
+}
+
+static void
+_assert_same_rows (DeeModel *model, DeeModel *other)
+{
+  DeeModelIter *iter, *other_iter;
+
+  g_assert_cmpuint (dee_model_get_n_rows (model), ==,
+                    dee_model_get_n_rows (other));
+
+  iter = dee_model_get_first_iter (model);
+  other_iter = dee_model_get_first_iter (other);
+  while (!dee_model_is_last (model, iter))
+    {
+      g_assert_cmpint (dee_model_get_int32 (model, iter, 0), ==,
+                       dee_model_get_int32 (other, other_iter, 0));
+      g_assert_cmpstr (dee_model_get_string (model, iter, 1), ==,
+                       dee_model_get_string (other, other_iter, 1));
+      iter = dee_model_next (model, iter);
+      other_iter = dee_model_next (other, other_iter);
+    }
+}
+
+static void
+test_commit_fanout (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model1, *client_model2, *client_model3;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  client_model1 = _new_client_model ();
+  client_model2 = _new_client_model ();
+  client_model3 = _new_client_model ();
+
+  /* The leader serializes each Commit once and sends the same body to
+   * every connection, so all clients must end up with identical rows */
+  _add5rows (fix->model);
+  gtx_yield_main_loop (500);
+
+  _assert_same_rows (fix->model, client_model1);
+  _assert_same_rows (fix->model, client_model2);
+  _assert_same_rows (fix->model, client_model3);
+
+  _remove3rows (fix->model);
+  _insert1row (fix->model);
+  gtx_yield_main_loop (500);
+
+  g_assert_cmpuint (dee_model_get_n_rows (fix->model), ==, 3);
+  _assert_same_rows (fix->model, client_model1);
+  _assert_same_rows (fix->model, client_model2);
+  _assert_same_rows (fix->model, client_model3);
+
+  /* And so must the seqnums, as they are part of the shared body */
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model1), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model2), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model3), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  g_object_unref (client_model1);
+  g_object_unref (client_model2);
+  g_object_unref (client_model3);
+}
+
+static void
+test_clone_cache (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model1, *client_model2, *client_model3, *client_model4;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  _add5rows (fix->model);
+
+  /* The first clone fills the cache, the second is served from it */
+  client_model1 = _new_client_model ();
+  client_model2 = _new_client_model ();
+  _assert_same_rows (fix->model, client_model1);
+  _assert_same_rows (fix->model, client_model2);
+
+  /* Changing the leader must invalidate the cache. Don't spin the main
+   * loop in between, so the revisions are still queued when the clone
+   * request comes in */
+  _remove3rows (fix->model);
+  client_model3 = _new_client_model ();
+  _assert_same_rows (fix->model, client_model3);
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model3), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  /* Same for a clear followed by new rows */
+  dee_model_clear (fix->model);
+  _add3rows (fix->model);
+  client_model4 = _new_client_model ();
+  _assert_same_rows (fix->model, client_model4);
+
+  /* The older clients followed along through the regular Commits */
+  gtx_yield_main_loop (500);
+  _assert_same_rows (fix->model, client_model1);
+  _assert_same_rows (fix->model, client_model2);
+  _assert_same_rows (fix->model, client_model3);
+
+  g_object_unref (client_model1);
+  g_object_unref (client_model2);
+  g_object_unref (client_model3);
+  g_object_unref (client_model4);
+}
+
+#ifdef HAVE_MEMFD_CREATE
+
+/* A minimal stand-in for a DeeServer leader, serving a fixed two row clone.
+ * It hands out the CloneFd memfd without sealing it, which followers must
+ * refuse in favour of a regular Clone */
+typedef struct
+{
+  GDBusServer     *server;
+  GDBusConnection *connection;
+  GSList          *calls;
+} FakeLeader;
+
+static const gchar fake_leader_xml[] =
+  "<node>"
+  "  <interface name='com.canonical.Dee.Model'>"
+  "    <method name='Clone'>"
+  "      <arg name='swarm_name' type='s' direction='out'/>"
+  "      <arg name='schema' type='as' direction='out'/>"
+  "      <arg name='row_data' type='aav' direction='out'/>"
+  "      <arg name='positions' type='au' direction='out'/>"
+  "      <arg name='change_types' type='ay' direction='out'/>"
+  "      <arg name='seqnum_before_after' type='(tt)' direction='out'/>"
+  "      <arg name='hints' type='a{sv}' direction='out'/>"
+  "    </method>"
+  "    <method name='CloneFd'>"
+  "      <arg name='clone_fd' type='h' direction='out'/>"
+  "      <arg name='size' type='t' direction='out'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+static void
+fake_leader_method_call (GDBusConnection       *connection,
+                         const gchar           *sender,
+                         const gchar           *object_path,
+                         const gchar           *interface_name,
+                         const gchar           *method_name,
+                         GVariant              *parameters,
+                         GDBusMethodInvocation *invocation,
+                         gpointer               user_data)
+{
+  FakeLeader  *leader = (FakeLeader*) user_data;
+  GVariant    *clone;
+  GUnixFDList *fd_list;
+  gsize        size;
+  gint         fd;
+
+  leader->calls = g_slist_append (leader->calls, g_strdup (method_name));
+
+  clone = g_variant_ref_sink (g_variant_new_parsed (
+      "(%s, ['i', 's'],"
+      " [[<int32 0>, <'zero'>], [<int32 1>, <'one'>]],"
+      " [uint32 0, 1], [byte 0x00, 0x00], (uint64 0, uint64 2),"
+      " @a{sv} {})", FAKE_LEADER_NAME));
+
+  if (g_strcmp0 (method_name, "CloneFd") == 0)
+    {
+      size = g_variant_get_size (clone);
+      fd = memfd_create ("dee-test-clone", MFD_CLOEXEC);
+      g_assert_cmpint (fd, >=, 0);
+      g_assert_cmpint (write (fd, g_variant_get_data (clone), size), ==, size);
+
+      fd_list = g_unix_fd_list_new_from_array (&fd, 1);
+      g_dbus_method_invocation_return_value_with_unix_fd_list (
+          invocation, g_variant_new ("(ht)", 0, (guint64) size), fd_list);
+      g_object_unref (fd_list);
+    }
+  else
+    {
+      g_dbus_method_invocation_return_value (invocation, clone);
+    }
+
+  g_variant_unref (clone);
+}
+
+static const GDBusInterfaceVTable fake_leader_vtable =
+{
+  fake_leader_method_call,
+  NULL,
+  NULL
+};
+
+static gboolean
+fake_leader_new_connection (GDBusServer     *server,
+                            GDBusConnection *connection,
+                            FakeLeader      *leader)
+{
+  GDBusNodeInfo *node_info;
+
+  node_info = g_dbus_node_info_new_for_xml (fake_leader_xml, NULL);
+  g_dbus_connection_register_object (connection, FAKE_LEADER_PATH,
+                                     node_info->interfaces[0],
+                                     &fake_leader_vtable, leader,
+                                     NULL, NULL);
+  g_dbus_node_info_unref (node_info);
+
+  leader->connection = g_object_ref (connection);
+  return TRUE;
+}
+
+static void
+test_clone_fd_unsealed (Fixture *fix, gconstpointer data)
+{
+  FakeLeader  leader = { NULL, NULL, NULL };
+  DeeModel   *model;
+  gchar      *guid;
+
+  guid = g_dbus_generate_guid ();
+  leader.server = g_dbus_server_new_sync ("unix:tmpdir=/tmp",
+                                          G_DBUS_SERVER_FLAGS_AUTHENTICATION_ALLOW_ANONYMOUS,
+                                          guid, NULL, NULL, NULL);
+  g_assert (leader.server != NULL);
+  g_signal_connect (leader.server, "new-connection",
+                    G_CALLBACK (fake_leader_new_connection), &leader);
+  g_dbus_server_start (leader.server);
+
+  model = dee_shared_model_new_for_peer (DEE_PEER (
+      dee_client_new_for_address (FAKE_LEADER_NAME,
+                                  g_dbus_server_get_client_address (leader.server))));
+
+  if (gtx_wait_for_signal (G_OBJECT (model), 1000,
+                           "notify::synchronized", NULL))
+    g_critical ("Model never synchronized");
+
+  /* The unsealed memfd must have been refused in favour of a regular Clone */
+  g_assert_cmpuint (g_slist_length (leader.calls), ==, 2);
+  g_assert_cmpstr (leader.calls->data, ==, "CloneFd");
+  g_assert_cmpstr (leader.calls->next->data, ==, "Clone");
+
+  g_assert_cmpuint (dee_model_get_n_rows (model), ==, 2);
+  g_assert_cmpstr (dee_model_get_string (model,
+                                         dee_model_get_iter_at_row (model, 1),
+                                         1), ==, "one");
+
+  gtx_assert_last_unref (model);
+
+  g_dbus_server_stop (leader.server);
+  if (leader.connection != NULL)
+    {
+      g_dbus_connection_close_sync (leader.connection, NULL, NULL);
+      g_object_unref (leader.connection);
+    }
+  g_object_unref (leader.server);
+  g_slist_free_full (leader.calls, g_free);
+  g_free (guid);
+
+  gtx_yield_main_loop (200);
+}
+
+#endif /* HAVE_MEMFD_CREATE */
+
+static void
+_count_row_added (DeeModel *model, DeeModelIter *iter, guint *count)
+{
+  (*count)++;
+}
+
+/* Create a client model that warm starts from @rm, if possible, and
+ * count the rows added to it after loading the snapshot. The rows loaded
+ * from the snapshot are returned in @n_loaded */
+static DeeModel*
+_new_snapshot_client (DeeResourceManager *rm,
+                      GVariant           *subscription,
+                      guint              *n_loaded,
+                      guint              *n_added)
+{
+  DeeModel *model;
+
+  model = dee_shared_model_new_for_peer (
+      DEE_PEER (dee_client_new (MODEL_NAME)));
+  if (subscription != NULL)
+    dee_shared_model_set_subscription (DEE_SHARED_MODEL (model), subscription);
+  dee_shared_model_set_snapshot_manager (DEE_SHARED_MODEL (model), rm);
+
+  *n_loaded = dee_model_get_n_rows (model);
+  *n_added = 0;
+  g_signal_connect (model, "row-added", G_CALLBACK (_count_row_added), n_added);
+
+  if (gtx_wait_for_signal (G_OBJECT (model), TIMEOUT,
+                           "notify::synchronized", NULL))
+    g_critical ("Client model never synchronized");
+
+  return model;
+}
+
+static gchar*
+_new_snapshot_dir (DeeResourceManager **rm)
+{
+  gchar *dir;
+
+  dir = g_dir_make_tmp ("dee-test-snapshots-XXXXXX", NULL);
+  g_assert (dir != NULL);
+  *rm = dee_file_resource_manager_new (dir);
+
+  return dir;
+}
+
+static void
+_remove_snapshot_dir (gchar *dir, DeeResourceManager *rm)
+{
+  gchar *path;
+
+  path = g_build_filename (dir, MODEL_NAME, NULL);
+  g_unlink (path);
+  g_rmdir (dir);
+
+  g_object_unref (rm);
+  g_free (path);
+  g_free (dir);
+}
+
+static void
+test_clone_since_hit (Fixture *fix, gconstpointer data)
+{
+  DeeResourceManager *rm;
+  DeeModel           *client_model;
+  gchar              *dir;
+  guint               n_loaded, n_added;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  dir = _new_snapshot_dir (&rm);
+
+  _add5rows (fix->model);
+
+  /* The first run clones and stores a snapshot when it goes away */
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 0);
+  _assert_same_rows (fix->model, client_model);
+  g_object_unref (client_model);
+
+  /* The leader moves on while the follower is gone */
+  _remove3rows (fix->model);
+  dee_model_append (fix->model, 5, "five");
+  dee_shared_model_flush_revision_queue (DEE_SHARED_MODEL (fix->model));
+
+  /* The second run loads the snapshot and only fetches the changes */
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 5);
+  g_assert_cmpuint (n_added, ==, 1);
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  /* And follows along as usual */
+  dee_model_append (fix->model, 6, "six");
+  gtx_yield_main_loop (500);
+  _assert_same_rows (fix->model, client_model);
+
+  gtx_assert_last_unref (client_model);
+  _remove_snapshot_dir (dir, rm);
+}
+
+static void
+test_clone_since_miss (Fixture *fix, gconstpointer data)
+{
+  DeeResourceManager *rm;
+  DeeModel           *client_model;
+  gchar              *dir;
+  guint               n_loaded, n_added, i;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  dir = _new_snapshot_dir (&rm);
+
+  _add5rows (fix->model);
+
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_object_unref (client_model);
+
+  /* Push the seqnum of the snapshot out of the leader's history */
+  for (i = 0; i < 100; i++)
+    {
+      dee_model_append (fix->model, 5 + i, "more");
+      dee_shared_model_flush_revision_queue (DEE_SHARED_MODEL (fix->model));
+    }
+
+  /* The leader can't provide the delta, so we get a full clone */
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 5);
+  g_assert_cmpuint (n_added, ==, 105);
+  _assert_same_rows (fix->model, client_model);
+
+  gtx_assert_last_unref (client_model);
+  _remove_snapshot_dir (dir, rm);
+}
+
+static void
+test_clone_since_stale (Fixture *fix, gconstpointer data)
+{
+  DeeResourceManager *rm;
+  DeeModel           *client_model;
+  gchar              *dir;
+  guint               n_loaded, n_added;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  dir = _new_snapshot_dir (&rm);
+
+  _add5rows (fix->model);
+
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_object_unref (client_model);
+
+  /* Restart the leader with other data. Its seqnums are not comparable
+   * with those of the snapshot */
+  model_teardown (fix, data);
+  model_setup (fix, data);
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  _add3rows (fix->model);
+  dee_model_append (fix->model, 3, "three");
+  dee_model_append (fix->model, 4, "four");
+  dee_model_append (fix->model, 5, "five");
+
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 5);
+  g_assert_cmpuint (n_added, ==, 6);
+  _assert_same_rows (fix->model, client_model);
+
+  gtx_assert_last_unref (client_model);
+  _remove_snapshot_dir (dir, rm);
+}
+
+static void
+test_snapshot_subscription (Fixture *fix, gconstpointer data)
+{
+  DeeResourceManager *rm;
+  DeeModel           *client_model;
+  GVariant           *subscription;
+  gchar              *dir;
+  guint               n_loaded, n_added;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  dir = _new_snapshot_dir (&rm);
+
+  _add5rows (fix->model);
+
+  subscription = g_variant_ref_sink (
+      g_variant_new_parsed ("{'match': <{uint32 0: <int32 1>}>}"));
+  client_model = _new_snapshot_client (rm, subscription, &n_loaded, &n_added);
+  g_assert_cmpuint (dee_model_get_n_rows (client_model), ==, 1);
+  g_object_unref (client_model);
+
+  /* The snapshot only holds part of the model, so a model without a
+   * subscription must not warm start from it */
+  client_model = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 0);
+  _assert_same_rows (fix->model, client_model);
+  g_object_unref (client_model);
+
+  /* Now the full model is in the snapshot, which is no good for a
+   * subscribed model either */
+  client_model = _new_snapshot_client (rm, subscription, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 0);
+  g_assert_cmpuint (dee_model_get_n_rows (client_model), ==, 1);
+  g_object_unref (client_model);
+
+  /* But an equal subscription is fine */
+  client_model = _new_snapshot_client (rm, subscription, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 1);
+  g_assert_cmpuint (dee_model_get_n_rows (client_model), ==, 1);
+  g_assert_cmpint (dee_model_get_int32 (client_model,
+                                        dee_model_get_first_iter (client_model),
+                                        0), ==, 1);
+
+  gtx_assert_last_unref (client_model);
+  g_variant_unref (subscription);
+  _remove_snapshot_dir (dir, rm);
+}
+
+static void
+test_snapshot_periodic (Fixture *fix, gconstpointer data)
+{
+  DeeResourceManager *rm;
+  DeeModel           *client_model1, *client_model2;
+  gchar              *dir;
+  guint               n_loaded, n_added;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+  dir = _new_snapshot_dir (&rm);
+
+  _add5rows (fix->model);
+
+  client_model1 = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  dee_model_append (fix->model, 5, "five");
+
+  /* The snapshot is written shortly after the change, without waiting for
+   * the first client to go away */
+  gtx_yield_main_loop (2500);
+
+  client_model2 = _new_snapshot_client (rm, NULL, &n_loaded, &n_added);
+  g_assert_cmpuint (n_loaded, ==, 6);
+  g_assert_cmpuint (n_added, ==, 0);
+  _assert_same_rows (fix->model, client_model2);
+
+  g_object_unref (client_model1);
+  gtx_assert_last_unref (client_model2);
+  _remove_snapshot_dir (dir, rm);
+}
+
+/* Assert that the string column of @model holds the given NULL terminated
+ * list of strings, in order */
+static void
+_assert_strings (DeeModel *model, ...)
+{
+  DeeModelIter *iter;
+  const gchar  *expected;
+  va_list       args;
+
+  iter = dee_model_get_first_iter (model);
+
+  va_start (args, model);
+  while ((expected = va_arg (args, const gchar*)) != NULL)
+    {
+      g_assert (!dee_model_is_last (model, iter));
+      g_assert_cmpstr (dee_model_get_string (model, iter, 1), ==, expected);
+      iter = dee_model_next (model, iter);
+    }
+  va_end (args);
+
+  g_assert (dee_model_is_last (model, iter));
+}
+
+/* Create a client model that only replicates the rows where the first
+ * column is 1 */
+static DeeModel*
+_new_subscribed_client (void)
+{
+  DeeModel *model;
+
+  model = dee_shared_model_new_for_peer (
+      DEE_PEER (dee_client_new (MODEL_NAME)));
+  dee_shared_model_set_subscription (DEE_SHARED_MODEL (model),
+      g_variant_new_parsed ("{'match': <{uint32 0: <int32 1>}>}"));
+
+  if (gtx_wait_for_signal (G_OBJECT (model), TIMEOUT,
+                           "notify::synchronized", NULL))
+    g_critical ("Client model never synchronized");
+
+  return model;
+}
+
+static void
+test_subscription (Fixture *fix, gconstpointer data)
+{
+  DeeModel     *client_model;
+  DeeModelIter *a, *b, *c;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  a = dee_model_append (fix->model, 1, "a");
+  b = dee_model_append (fix->model, 2, "b");
+  c = dee_model_append (fix->model, 1, "c");
+
+  /* The initial clone only holds the matching rows */
+  client_model = _new_subscribed_client ();
+  _assert_strings (client_model, "a", "c", NULL);
+
+  /* New rows that match come in, others don't */
+  dee_model_append (fix->model, 1, "d");
+  dee_model_append (fix->model, 5, "x");
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "a", "c", "d", NULL);
+
+  /* A row that starts matching enters at its place in the model order */
+  dee_model_set_value (fix->model, b, 0, g_variant_new_int32 (1));
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "a", "b", "c", "d", NULL);
+
+  /* A row that stops matching leaves */
+  dee_model_set_value (fix->model, a, 0, g_variant_new_int32 (3));
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "b", "c", "d", NULL);
+
+  /* Changes to matching rows are relayed */
+  dee_model_set_value (fix->model, c, 1, g_variant_new_string ("changed"));
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "b", "changed", "d", NULL);
+
+  /* And so are removals, while removing other rows is invisible */
+  dee_model_remove (fix->model, c);
+  dee_model_remove (fix->model, a);
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "b", "d", NULL);
+
+  /* The leader itself is unaffected */
+  g_assert_cmpuint (dee_model_get_n_rows (fix->model), ==, 3);
+
+  gtx_assert_last_unref (client_model);
+}
+
+static void
+test_unsubscribe (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  dee_model_append (fix->model, 1, "a");
+  dee_model_append (fix->model, 2, "b");
+
+  client_model = _new_subscribed_client ();
+  _assert_strings (client_model, "a", NULL);
+
+  /* Dropping the subscription resyncs the full model */
+  dee_shared_model_set_subscription (DEE_SHARED_MODEL (client_model), NULL);
+  g_assert (!dee_shared_model_is_synchronized (DEE_SHARED_MODEL (client_model)));
+
+  if (gtx_wait_for_signal (G_OBJECT (client_model), TIMEOUT,
+                           "notify::synchronized", NULL))
+    g_critical ("Client model never resynchronized");
+
+  _assert_same_rows (fix->model, client_model);
+
+  /* The leader must have stopped filtering for us as well */
+  dee_model_append (fix->model, 3, "c");
+  dee_model_prepend (fix->model, 1, "z");
+  gtx_yield_main_loop (500);
+  _assert_strings (client_model, "z", "a", "b", "c", NULL);
+
+  /* And we can subscribe again */
+  dee_shared_model_set_subscription (DEE_SHARED_MODEL (client_model),
+      g_variant_new_parsed ("{'match': <{uint32 0: <int32 2>}>}"));
+  if (gtx_wait_for_signal (G_OBJECT (client_model), TIMEOUT,
+                           "notify::synchronized", NULL))
+    g_critical ("Client model never resynchronized");
+
+  _assert_strings (client_model, "b", NULL);
+
+  gtx_assert_last_unref (client_model);
+}
+
+static void
+_count_row_moved (DeeModel     *model,
+                  DeeModelIter *iter,
+                  guint         old_pos,
+                  guint        *count)
+{
+  (*count)++;
+}
+
+/* Moves travel as a MOVE change, so the peers must see them as a single
+ * row-moved and end up with the same rows, in both directions */
+static void
+test_move (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model;
+  guint     n_added = 0, n_removed = 0, n_moved = 0, n_leader_moved = 0;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  _add5rows (fix->model);
+  client_model = _new_client_model ();
+  _assert_same_rows (fix->model, client_model);
+
+  g_signal_connect (client_model, "row-added",
+                    G_CALLBACK (_count_row_added), &n_added);
+  g_signal_connect (client_model, "row-removed",
+                    G_CALLBACK (_count_row_added), &n_removed);
+  g_signal_connect (client_model, "row-moved",
+                    G_CALLBACK (_count_row_moved), &n_moved);
+  g_signal_connect (fix->model, "row-moved",
+                    G_CALLBACK (_count_row_moved), &n_leader_moved);
+
+  /* Forwards and backwards */
+  dee_model_move_before (fix->model,
+                         dee_model_get_iter_at_row (fix->model, 0),
+                         dee_model_get_iter_at_row (fix->model, 3));
+  dee_model_move_before (fix->model,
+                         dee_model_get_iter_at_row (fix->model, 4),
+                         dee_model_get_first_iter (fix->model));
+  gtx_yield_main_loop (500);
+
+  _assert_strings (fix->model, "four", "one", "two", "zero", "three", NULL);
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (2, ==, n_moved);
+  g_assert_cmpuint (0, ==, n_added + n_removed);
+
+  /* A move to the end, made by the follower */
+  dee_model_move_before (client_model,
+                         dee_model_get_iter_at_row (client_model, 1),
+                         dee_model_get_last_iter (client_model));
+  gtx_yield_main_loop (500);
+
+  _assert_strings (fix->model, "four", "two", "zero", "three", "one", NULL);
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (3, ==, n_leader_moved);
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  gtx_assert_last_unref (client_model);
+}
+
+/* A follower predating the Features method. It clones the leader with
+ * a plain Clone and keeps the last Commit it received */
+typedef struct
+{
+  GDBusConnection *connection;
+  GVariant        *clone;
+  GVariant        *commit;
+} OldPeer;
+
+static void
+_old_peer_connected (GObject *source, GAsyncResult *res, OldPeer *peer)
+{
+  peer->connection = g_dbus_connection_new_for_address_finish (res, NULL);
+}
+
+static void
+_old_peer_cloned (GObject *source, GAsyncResult *res, OldPeer *peer)
+{
+  peer->clone = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source),
+                                               res, NULL);
+}
+
+static void
+_old_peer_commit (GDBusConnection *connection,
+                  const gchar     *sender_name,
+                  const gchar     *object_path,
+                  const gchar     *interface_name,
+                  const gchar     *signal_name,
+                  GVariant        *parameters,
+                  OldPeer         *peer)
+{
+  if (peer->commit != NULL)
+    g_variant_unref (peer->commit);
+  peer->commit = g_variant_ref (parameters);
+}
+
+static void
+_old_peer_init (OldPeer *peer, DeeModel *leader)
+{
+  DeeServer *server;
+
+  peer->connection = NULL;
+  peer->clone = NULL;
+  peer->commit = NULL;
+
+  server = DEE_SERVER (dee_shared_model_get_peer (DEE_SHARED_MODEL (leader)));
+  g_dbus_connection_new_for_address (dee_server_get_client_address (server),
+                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                     NULL, NULL,
+                                     (GAsyncReadyCallback) _old_peer_connected,
+                                     peer);
+  gtx_yield_main_loop (200);
+  g_assert (peer->connection != NULL);
+
+  g_dbus_connection_signal_subscribe (peer->connection, NULL,
+                                      "com.canonical.Dee.Model", "Commit",
+                                      NULL, MODEL_NAME,
+                                      G_DBUS_SIGNAL_FLAGS_NONE,
+                                      (GDBusSignalCallback) _old_peer_commit,
+                                      peer, NULL);
+  g_dbus_connection_call (peer->connection, NULL, MODEL_PATH,
+                          "com.canonical.Dee.Model", "Clone", NULL, NULL,
+                          G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                          (GAsyncReadyCallback) _old_peer_cloned, peer);
+  gtx_yield_main_loop (200);
+  g_assert (peer->clone != NULL);
+}
+
+static void
+_old_peer_clear (OldPeer *peer)
+{
+  g_dbus_connection_close (peer->connection, NULL, NULL, NULL);
+  g_object_unref (peer->connection);
+  g_variant_unref (peer->clone);
+  if (peer->commit != NULL)
+    g_variant_unref (peer->commit);
+}
+
+/* Peers that don't announce moves get them as a removal and an addition,
+ * while the other peers still get a single move */
+static void
+test_move_old_peer (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model;
+  OldPeer   old_peer;
+  GVariant *positions, *types;
+  guint64   seqnum_before, seqnum_after;
+  guint32   pos;
+  guchar    type;
+  guint     n_added = 0, n_removed = 0, n_moved = 0;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  _add5rows (fix->model);
+  _old_peer_init (&old_peer, fix->model);
+  client_model = _new_client_model ();
+  _assert_same_rows (fix->model, client_model);
+
+  g_signal_connect (client_model, "row-added",
+                    G_CALLBACK (_count_row_added), &n_added);
+  g_signal_connect (client_model, "row-removed",
+                    G_CALLBACK (_count_row_added), &n_removed);
+  g_signal_connect (client_model, "row-moved",
+                    G_CALLBACK (_count_row_moved), &n_moved);
+
+  dee_model_move_before (fix->model,
+                         dee_model_get_iter_at_row (fix->model, 0),
+                         dee_model_get_iter_at_row (fix->model, 3));
+  gtx_yield_main_loop (500);
+
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (1, ==, n_moved);
+  g_assert_cmpuint (0, ==, n_added + n_removed);
+
+  g_assert (old_peer.commit != NULL);
+  positions = g_variant_get_child_value (old_peer.commit, 3);
+  types = g_variant_get_child_value (old_peer.commit, 4);
+  g_variant_get_child (old_peer.commit, 5, "(tt)",
+                       &seqnum_before, &seqnum_after);
+  g_assert_cmpuint (2, ==, g_variant_n_children (types));
+
+  /* A removal of the first row */
+  g_variant_get_child (types, 0, "y", &type);
+  g_variant_get_child (positions, 0, "u", &pos);
+  g_assert_cmpuint (0x01, ==, type);
+  g_assert_cmpuint (0, ==, pos);
+
+  /* And an addition in front of "three" */
+  g_variant_get_child (types, 1, "y", &type);
+  g_variant_get_child (positions, 1, "u", &pos);
+  g_assert_cmpuint (0x00, ==, type);
+  g_assert_cmpuint (2, ==, pos);
+
+  /* Both encodings take the same seqnums */
+  g_assert_cmpuint (seqnum_after - seqnum_before, ==, 2);
+  g_assert_cmpuint (seqnum_after, ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  g_variant_unref (positions);
+  g_variant_unref (types);
+  _old_peer_clear (&old_peer);
+  gtx_assert_last_unref (client_model);
+}
+
+static void
+_count_rows_reordered (DeeModel    *model,
+                       const guint *new_order,
+                       guint       *count)
+{
+  (*count)++;
+}
+
+static gint
+_cmp_strings (GVariant **row1, GVariant **row2, gpointer user_data)
+{
+  return g_strcmp0 (g_variant_get_string (row1[1], NULL),
+                    g_variant_get_string (row2[1], NULL));
+}
+
+/* Reorders travel as a single REORDER change, in both directions */
+static void
+test_reorder (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model;
+  guint     n_added = 0, n_removed = 0, n_reordered = 0;
+  guint     n_leader_reordered = 0;
+  guint     reverse[] = { 4, 3, 2, 1, 0 };
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  _add5rows (fix->model);
+  client_model = _new_client_model ();
+  _assert_same_rows (fix->model, client_model);
+
+  g_signal_connect (client_model, "row-added",
+                    G_CALLBACK (_count_row_added), &n_added);
+  g_signal_connect (client_model, "row-removed",
+                    G_CALLBACK (_count_row_added), &n_removed);
+  g_signal_connect (client_model, "rows-reordered",
+                    G_CALLBACK (_count_rows_reordered), &n_reordered);
+  g_signal_connect (fix->model, "rows-reordered",
+                    G_CALLBACK (_count_rows_reordered), &n_leader_reordered);
+
+  dee_model_sort (fix->model, _cmp_strings, NULL);
+  gtx_yield_main_loop (500);
+
+  _assert_strings (fix->model, "four", "one", "three", "two", "zero", NULL);
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (1, ==, n_reordered);
+  g_assert_cmpuint (0, ==, n_added + n_removed);
+
+  dee_model_reorder (client_model, reverse);
+  gtx_yield_main_loop (500);
+
+  _assert_strings (fix->model, "zero", "two", "three", "one", "four", NULL);
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (2, ==, n_leader_reordered);
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  gtx_assert_last_unref (client_model);
+}
+
+/* Peers that don't announce reorders get a clear and all the rows again,
+ * while the other peers still get a single reorder */
+static void
+test_reorder_old_peer (Fixture *fix, gconstpointer data)
+{
+  DeeModel *client_model;
+  OldPeer   old_peer;
+  GVariant *types, *rows, *row, *val;
+  guint64   seqnum_before, seqnum_after;
+  guchar    type;
+  guint     i, n_added = 0, n_removed = 0, n_reordered = 0;
+
+  gtx_wait_for_signal (G_OBJECT (fix->model), TIMEOUT,
+                       "notify::synchronized", NULL);
+
+  _add5rows (fix->model);
+  _old_peer_init (&old_peer, fix->model);
+  client_model = _new_client_model ();
+  _assert_same_rows (fix->model, client_model);
+
+  g_signal_connect (client_model, "row-added",
+                    G_CALLBACK (_count_row_added), &n_added);
+  g_signal_connect (client_model, "row-removed",
+                    G_CALLBACK (_count_row_added), &n_removed);
+  g_signal_connect (client_model, "rows-reordered",
+                    G_CALLBACK (_count_rows_reordered), &n_reordered);
+
+  dee_model_sort (fix->model, _cmp_strings, NULL);
+  gtx_yield_main_loop (500);
+
+  _assert_same_rows (fix->model, client_model);
+  g_assert_cmpuint (1, ==, n_reordered);
+  g_assert_cmpuint (0, ==, n_added + n_removed);
+
+  g_assert (old_peer.commit != NULL);
+  rows = g_variant_get_child_value (old_peer.commit, 2);
+  types = g_variant_get_child_value (old_peer.commit, 4);
+  g_variant_get_child (old_peer.commit, 5, "(tt)",
+                       &seqnum_before, &seqnum_after);
+  g_assert_cmpuint (6, ==, g_variant_n_children (types));
+
+  g_variant_get_child (types, 0, "y", &type);
+  g_assert_cmpuint (0x03, ==, type);
+  for (i = 1; i < 6; i++)
+    {
+      g_variant_get_child (types, i, "y", &type);
+      g_assert_cmpuint (0x00, ==, type);
+
+      /* The rows come in their new order */
+      row = g_variant_get_child_value (rows, i);
+      g_variant_get_child (row, 1, "v", &val);
+      g_assert_cmpstr (g_variant_get_string (val, NULL), ==,
+                       dee_model_get_string (fix->model,
+                         dee_model_get_iter_at_row (fix->model, i - 1), 1));
+      g_variant_unref (val);
+      g_variant_unref (row);
+    }
+
+  /* Both encodings take the same seqnums */
+  g_assert_cmpuint (seqnum_after - seqnum_before, ==, 6);
+  g_assert_cmpuint (seqnum_after, ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+  g_assert_cmpuint (dee_serializable_model_get_seqnum (client_model), ==,
+                    dee_serializable_model_get_seqnum (fix->model));
+
+  g_variant_unref (rows);
+  g_variant_unref (types);
+  _old_peer_clear (&old_peer);
+  gtx_assert_last_unref (client_model);
+}
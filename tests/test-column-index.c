@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2011 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee.h>
+
+typedef struct
+{
+  DeeModel       *model;
+  DeeColumnIndex *index;
+
+} Fixture;
+
+static void setup    (Fixture *fix, gconstpointer data);
+static void teardown (Fixture *fix, gconstpointer data);
+
+static void
+setup (Fixture *fix, gconstpointer data)
+{
+  fix->model = dee_sequence_model_new ();
+  dee_model_set_schema (fix->model, "s", "i", NULL);
+
+  dee_model_append (fix->model, "apps", 0);
+  dee_model_append (fix->model, "files", 1);
+  dee_model_append (fix->model, "apps", 2);
+  dee_model_append (fix->model, "music", 3);
+  dee_model_append (fix->model, "apps", 4);
+
+  fix->index = dee_column_index_new (fix->model, 0);
+}
+
+static void
+teardown (Fixture *fix, gconstpointer data)
+{
+  if (fix->index)
+    g_object_unref (fix->index);
+  g_object_unref (fix->model);
+  fix->index = NULL;
+  fix->model = NULL;
+}
+
+static guint
+count_rows (DeeColumnIndex *index, const gchar *value)
+{
+  DeeResultSet *results;
+  guint         n_rows;
+
+  results = dee_column_index_lookup (index, g_variant_new_string (value));
+  n_rows = dee_result_set_get_n_rows (results);
+  g_assert_cmpuint (n_rows, ==,
+                    dee_column_index_get_n_rows_for_value (index,
+                                                 g_variant_new_string (value)));
+  g_object_unref (results);
+
+  return n_rows;
+}
+
+static void
+test_lookup (Fixture *fix, gconstpointer data)
+{
+  DeeResultSet *results;
+  DeeModelIter *iter;
+
+  g_assert (dee_column_index_get_model (fix->index) == fix->model);
+  g_assert_cmpuint (dee_column_index_get_column (fix->index), ==, 0);
+  g_assert (dee_column_index_find (fix->model, 0) == fix->index);
+  g_assert (dee_column_index_find (fix->model, 1) == NULL);
+
+  g_assert_cmpuint (dee_column_index_get_n_values (fix->index), ==, 3);
+  g_assert_cmpuint (count_rows (fix->index, "apps"), ==, 3);
+  g_assert_cmpuint (count_rows (fix->index, "files"), ==, 1);
+  g_assert_cmpuint (count_rows (fix->index, "music"), ==, 1);
+  g_assert_cmpuint (count_rows (fix->index, "video"), ==, 0);
+
+  results = dee_column_index_lookup (fix->index, g_variant_new_string ("apps"));
+  while (dee_result_set_has_next (results))
+    {
+      iter = dee_result_set_next (results);
+      g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "apps");
+    }
+  g_object_unref (results);
+
+  iter = dee_column_index_lookup_one (fix->index, g_variant_new_string ("apps"));
+  g_assert (iter == dee_model_get_first_iter (fix->model));
+
+  g_assert (dee_column_index_lookup_one (fix->index,
+                                         g_variant_new_string ("video")) == NULL);
+
+  g_object_unref (fix->index);
+  fix->index = NULL;
+  g_assert (dee_column_index_find (fix->model, 0) == NULL);
+}
+
+static void
+test_updates (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+
+  /* Add a new value */
+  iter = dee_model_append (fix->model, "video", 5);
+  g_assert_cmpuint (dee_column_index_get_n_values (fix->index), ==, 4);
+  g_assert_cmpuint (count_rows (fix->index, "video"), ==, 1);
+
+  /* Change the non-indexed column */
+  dee_model_set (fix->model, iter, "video", 6);
+  g_assert_cmpuint (count_rows (fix->index, "video"), ==, 1);
+
+  /* Move the row to another value */
+  dee_model_set (fix->model, iter, "apps", 6);
+  g_assert_cmpuint (dee_column_index_get_n_values (fix->index), ==, 3);
+  g_assert_cmpuint (count_rows (fix->index, "video"), ==, 0);
+  g_assert_cmpuint (count_rows (fix->index, "apps"), ==, 4);
+
+  /* Removing the first "apps" row changes the result of lookup_one */
+  dee_model_remove (fix->model, dee_model_get_first_iter (fix->model));
+  g_assert_cmpuint (count_rows (fix->index, "apps"), ==, 3);
+  iter = dee_column_index_lookup_one (fix->index, g_variant_new_string ("apps"));
+  g_assert_cmpint (dee_model_get_int32 (fix->model, iter, 1), ==, 2);
+
+  dee_model_clear (fix->model);
+  g_assert_cmpuint (dee_column_index_get_n_values (fix->index), ==, 0);
+  g_assert_cmpuint (count_rows (fix->index, "apps"), ==, 0);
+}
+
+static void
+test_find_by_value (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+
+  /* With the index */
+  iter = dee_model_find_by_value (fix->model, 1, g_variant_new_int32 (3));
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "music");
+
+  iter = dee_model_find_by_value (fix->model, 0, g_variant_new_string ("apps"));
+  g_assert_cmpint (dee_model_get_int32 (fix->model, iter, 1), ==, 0);
+
+  g_assert (dee_model_find_by_value (fix->model, 0,
+                                     g_variant_new_string ("video")) == NULL);
+
+  /* Without the index we must get the same results from a scan */
+  g_object_unref (fix->index);
+  fix->index = NULL;
+
+  iter = dee_model_find_by_value (fix->model, 0, g_variant_new_string ("apps"));
+  g_assert_cmpint (dee_model_get_int32 (fix->model, iter, 1), ==, 0);
+
+  g_assert (dee_model_find_by_value (fix->model, 0,
+                                     g_variant_new_string ("video")) == NULL);
+}
+
+static void
+test_filter (Fixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *filter_model;
+  DeeModelIter *iter;
+  gint          expected[] = { 0, 2, 4 };
+  guint         i;
+
+  dee_filter_new_for_key_column (0, "apps", &filter);
+  filter_model = dee_filter_model_new (fix->model, &filter);
+
+  g_assert_cmpuint (dee_model_get_n_rows (filter_model), ==, 3);
+
+  /* The rows must be in the order of the original model */
+  iter = dee_model_get_first_iter (filter_model);
+  for (i = 0; i < G_N_ELEMENTS (expected); i++)
+    {
+      g_assert_cmpint (dee_model_get_int32 (filter_model, iter, 1), ==,
+                       expected[i]);
+      iter = dee_model_next (filter_model, iter);
+    }
+  g_assert (dee_model_is_last (filter_model, iter));
+
+  g_object_unref (filter_model);
+
+  dee_filter_new_for_any_column (0, g_variant_new_string ("files"), &filter);
+  filter_model = dee_filter_model_new (fix->model, &filter);
+
+  g_assert_cmpuint (dee_model_get_n_rows (filter_model), ==, 1);
+  iter = dee_model_get_first_iter (filter_model);
+  g_assert_cmpint (dee_model_get_int32 (filter_model, iter, 1), ==, 1);
+
+  g_object_unref (filter_model);
+}
+
+void
+test_column_index_create_suite (void)
+{
+#define DOMAIN "/Index/Column"
+
+  g_test_add (DOMAIN"/Lookup", Fixture, 0,
+              setup, test_lookup, teardown);
+  g_test_add (DOMAIN"/Updates", Fixture, 0,
+              setup, test_updates, teardown);
+  g_test_add (DOMAIN"/FindByValue", Fixture, 0,
+              setup, test_find_by_value, teardown);
+  g_test_add (DOMAIN"/Filter", Fixture, 0,
+              setup, test_filter, teardown);
+}
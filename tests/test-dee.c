@@ -31,12 +31,16 @@ void test_model_tags_create_suite (void);
 void test_filter_model_create_suite (void);
 void test_term_list_create_suite (void);
 void test_hash_index_create_suite (void);
+void test_column_index_create_suite (void);
+void test_trigram_index_create_suite (void);
 void test_analyzer_create_suite (void);
 void test_model_readers_create_suite (void);
 void test_glist_result_set_create_suite (void);
 void test_serializable_create_suite (void);
 void test_resource_manager_create_suite (void);
 void test_transaction_create_suite (void);
+void test_window_model_create_suite (void);
+void test_aggregate_model_create_suite (void);
 
 #ifdef HAVE_GTX
 void test_model_interactions_create_suite(void);
@@ -67,12 +71,16 @@ main (gint argc, gchar *argv[])
   test_filter_model_create_suite ();
   test_term_list_create_suite ();
   test_hash_index_create_suite ();
+  test_column_index_create_suite ();
+  test_trigram_index_create_suite ();
   test_analyzer_create_suite ();
   test_model_readers_create_suite ();
   test_glist_result_set_create_suite ();
   test_serializable_create_suite ();
   test_resource_manager_create_suite ();
   test_transaction_create_suite ();
+  test_window_model_create_suite ();
+  test_aggregate_model_create_suite ();
 
 #ifdef HAVE_GTX
   test_model_interactions_create_suite();
@@ -56,15 +56,51 @@ static void test_collator_desc                  (FilterFixture *fix,
 static void test_key                           (FilterFixture *fix,
                                                 gconstpointer  data);
 
+static void test_key_sparse                    (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_key_changed                   (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_collator_changed              (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_key_compact                   (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_compact_consistency           (FilterFixture *fix,
+                                                gconstpointer  data);
+
 static void test_any                           (FilterFixture *fix,
                                                 gconstpointer  data);
 
 static void test_regex                         (FilterFixture *fix,
                                                 gconstpointer  data);
 
+static void test_column_sort                   (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_column_sort_txn               (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_predicate                     (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_predicate_indexed             (FilterFixture *fix,
+                                                gconstpointer  data);
+
 static void test_changesets                    (FilterFixture *fix,
                                                 gconstpointer  data);
 
+static void test_append_iters                  (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_moves                         (FilterFixture *fix,
+                                                gconstpointer  data);
+
+static void test_reorder                       (FilterFixture *fix,
+                                                gconstpointer  data);
+
 void
 test_filter_model_create_suite (void)
 {
@@ -85,12 +121,36 @@ test_filter_model_create_suite (void)
               setup, test_collator_desc, teardown);
   g_test_add (DOMAIN"/Key", FilterFixture, 0,
               setup, test_key, teardown);
+  g_test_add (DOMAIN"/KeySparse", FilterFixture, 0,
+              setup_empty, test_key_sparse, teardown);
+  g_test_add (DOMAIN"/KeyChanged", FilterFixture, 0,
+              setup, test_key_changed, teardown);
+  g_test_add (DOMAIN"/CollatorChanged", FilterFixture, 0,
+              setup, test_collator_changed, teardown);
+  g_test_add (DOMAIN"/KeyCompact", FilterFixture, 0,
+              setup, test_key_compact, teardown);
+  g_test_add (DOMAIN"/CompactConsistency", FilterFixture, 0,
+              setup_empty, test_compact_consistency, teardown);
   g_test_add (DOMAIN"/Any", FilterFixture, 0,
               setup, test_any, teardown);
   g_test_add (DOMAIN"/Regex", FilterFixture, 0,
               setup, test_regex, teardown);
+  g_test_add (DOMAIN"/ColumnSort", FilterFixture, 0,
+              setup, test_column_sort, teardown);
+  g_test_add (DOMAIN"/ColumnSortTransaction", FilterFixture, 0,
+              setup, test_column_sort_txn, teardown);
+  g_test_add (DOMAIN"/Predicate", FilterFixture, 0,
+              setup, test_predicate, teardown);
+  g_test_add (DOMAIN"/PredicateIndexed", FilterFixture, 0,
+              setup, test_predicate_indexed, teardown);
   g_test_add (DOMAIN"/Changesets", FilterFixture, 0,
               setup_empty, test_changesets, teardown);
+  g_test_add (DOMAIN"/AppendIters", FilterFixture, 0,
+              setup, test_append_iters, teardown);
+  g_test_add (DOMAIN"/Moves", FilterFixture, 0,
+              setup_empty, test_moves, teardown);
+  g_test_add (DOMAIN"/Reorder", FilterFixture, 0,
+              setup_empty, test_reorder, teardown);
 }
 
 static void
@@ -532,10 +592,16 @@ test_collator_desc (FilterFixture *fix, gconstpointer data)
 
 static void
 _test_orig_ordering (FilterFixture *fix,
-                     DeeFilter     *filter)
+                     DeeFilter     *filter,
+                     gboolean       compact)
 {
   DeeModelIter *r0, *r1, *r2, *r3, *r4;//, *r5;
-  DeeModel     *m = dee_filter_model_new (fix->model, filter);
+  DeeModel     *m;
+
+  if (compact)
+    m = dee_filter_model_new_compact (fix->model, filter);
+  else
+    m = dee_filter_model_new (fix->model, filter);
 
   /* Assert that the initial filtering is good:
    * { [  0, "Zero" ] }        { [  0, "Zero" ],
@@ -634,7 +700,332 @@ test_key (FilterFixture *fix, gconstpointer data)
   DeeFilter    filter;
 
   dee_filter_new_for_key_column (1, "Zero", &filter);
-  _test_orig_ordering (fix, &filter);
+  _test_orig_ordering (fix, &filter, FALSE);
+}
+
+/* Test that a sparse key filter keeps the original order when rows are
+ * inserted all over the original model */
+static void
+test_key_sparse (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m;
+  DeeModelIter *iter;
+  gint          i, last;
+
+  dee_filter_new_for_key_column (1, "Match", &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+
+  for (i = 0; i < 1000; i++)
+    dee_model_append (fix->model, i, i % 100 == 0 ? "Match" : "Other");
+
+  g_assert_cmpint (10, ==, dee_model_get_n_rows (m));
+
+  /* Insert matching rows at the front, in the middle and at the end,
+   * both right next to other matches and far away from them */
+  dee_model_prepend (fix->model, -1, "Match");
+  dee_model_insert (fix->model, 151, 150, "Match");
+  dee_model_insert (fix->model, 502, 499, "Match");
+  dee_model_insert (fix->model, 999, 996, "Match");
+  dee_model_append (fix->model, 1000, "Match");
+
+  g_assert_cmpint (15, ==, dee_model_get_n_rows (m));
+
+  last = G_MININT;
+  iter = dee_model_get_first_iter (m);
+  while (!dee_model_is_last (m, iter))
+    {
+      i = dee_model_get_int32 (m, iter, 0);
+      g_assert_cmpint (i, >, last);
+      g_assert_cmpstr ("Match", ==, dee_model_get_string (m, iter, 1));
+      last = i;
+      iter = dee_model_next (m, iter);
+    }
+
+  g_object_unref (m);
+}
+
+static void
+increment_counter (gint *counter)
+{
+  (*counter)++;
+}
+
+/* Test that changing rows in the original model makes them enter and leave
+ * a key filtered model, and that changes not affecting membership are just
+ * forwarded as row-changed */
+static void
+test_key_changed (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m;
+  DeeModelIter *r0, *r1, *r2;
+  gint          n_added = 0, n_removed = 0, n_changed = 0;
+
+  dee_filter_new_for_key_column (1, "Zero", &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+
+  g_signal_connect_swapped (m, "row-added",
+                            G_CALLBACK (increment_counter), &n_added);
+  g_signal_connect_swapped (m, "row-removed",
+                            G_CALLBACK (increment_counter), &n_removed);
+  g_signal_connect_swapped (m, "row-changed",
+                            G_CALLBACK (increment_counter), &n_changed);
+
+  r0 = dee_model_get_iter_at_row (fix->model, 0);
+  r1 = dee_model_get_iter_at_row (fix->model, 1);
+  r2 = dee_model_get_iter_at_row (fix->model, 2);
+  g_assert_cmpint (1, ==, dee_model_get_n_rows (m));
+
+  /* Changing a column the filter doesn't look at keeps the row in place */
+  dee_model_set (fix->model, r0, 10, "Zero");
+  g_assert_cmpint (1, ==, dee_model_get_n_rows (m));
+  g_assert_cmpint (0, ==, n_added);
+  g_assert_cmpint (0, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  /* Rows entering the filter keep the original order */
+  dee_model_set (fix->model, r2, 2, "Zero");
+  dee_model_set (fix->model, r1, 1, "Zero");
+  g_assert_cmpint (3, ==, dee_model_get_n_rows (m));
+  g_assert (dee_model_get_iter_at_row (m, 0) == r0);
+  g_assert (dee_model_get_iter_at_row (m, 1) == r1);
+  g_assert (dee_model_get_iter_at_row (m, 2) == r2);
+  g_assert_cmpint (2, ==, n_added);
+  g_assert_cmpint (0, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  /* Rows leaving the filter are removed */
+  dee_model_set (fix->model, r1, 1, "One");
+  g_assert_cmpint (2, ==, dee_model_get_n_rows (m));
+  g_assert (!dee_filter_model_contains (DEE_FILTER_MODEL (m), r1));
+  g_assert_cmpint (2, ==, n_added);
+  g_assert_cmpint (1, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  /* Rows that didn't match before and still don't are ignored */
+  dee_model_set (fix->model, r1, 1, "Still not zero");
+  g_assert_cmpint (2, ==, dee_model_get_n_rows (m));
+  g_assert_cmpint (2, ==, n_added);
+  g_assert_cmpint (1, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  g_object_unref (m);
+}
+
+/* Test that changing the sort key of a row moves it in a collated model */
+static void
+test_collator_changed (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     collator;
+  DeeModel     *m;
+  DeeModelIter *iter;
+  gint          n_added = 0, n_removed = 0, n_changed = 0;
+
+  dee_filter_new_collator (1, &collator);
+  m = dee_filter_model_new (fix->model, &collator);
+
+  g_signal_connect_swapped (m, "row-added",
+                            G_CALLBACK (increment_counter), &n_added);
+  g_signal_connect_swapped (m, "row-removed",
+                            G_CALLBACK (increment_counter), &n_removed);
+  g_signal_connect_swapped (m, "row-changed",
+                            G_CALLBACK (increment_counter), &n_changed);
+
+  /* Sorted as One, Two, Zero. Changes that keep the order don't move rows */
+  iter = dee_model_get_iter_at_row (m, 1);
+  dee_model_set (fix->model, iter, 2, "Twenty");
+  g_assert (dee_model_get_iter_at_row (m, 1) == iter);
+  g_assert_cmpint (0, ==, n_added);
+  g_assert_cmpint (0, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  /* Move the first row to the end */
+  iter = dee_model_get_iter_at_row (m, 0);
+  dee_model_set (fix->model, iter, 1, "Zzzz");
+  g_assert_cmpint (3, ==, dee_model_get_n_rows (m));
+  g_assert (dee_model_get_iter_at_row (m, 2) == iter);
+  g_assert_cmpstr ("Twenty", ==,
+                   dee_model_get_string (m, dee_model_get_iter_at_row (m, 0), 1));
+  g_assert_cmpstr ("Zero", ==,
+                   dee_model_get_string (m, dee_model_get_iter_at_row (m, 1), 1));
+  g_assert_cmpint (1, ==, n_added);
+  g_assert_cmpint (1, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  /* And back to the front */
+  dee_model_set (fix->model, iter, 1, "Aaaa");
+  g_assert (dee_model_get_iter_at_row (m, 0) == iter);
+  g_assert_cmpstr ("Zero", ==,
+                   dee_model_get_string (m, dee_model_get_iter_at_row (m, 2), 1));
+  g_assert_cmpint (2, ==, n_added);
+  g_assert_cmpint (2, ==, n_removed);
+  g_assert_cmpint (1, ==, n_changed);
+
+  g_object_unref (m);
+}
+
+/* Test dee_filter_new_for_key_column() with a compact filter model */
+static void
+test_key_compact (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter    filter;
+
+  dee_filter_new_for_key_column (1, "Zero", &filter);
+  _test_orig_ordering (fix, &filter, TRUE);
+}
+
+static gboolean
+_collect_iter (DeeModel *model, DeeModelIter *iter, GPtrArray *iters)
+{
+  g_ptr_array_add (iters, iter);
+  return FALSE;
+}
+
+static void
+_assert_same_rows (DeeModel *m1, DeeModel *m2)
+{
+  DeeModelIter *iter1, *iter2;
+  GPtrArray    *walked;
+  guint         i, n_rows;
+
+  n_rows = dee_model_get_n_rows (m1);
+  g_assert_cmpuint (n_rows, ==, dee_model_get_n_rows (m2));
+
+  /* Walking the filter model natively must visit the same rows */
+  walked = g_ptr_array_new ();
+  dee_model_foreach_range (m2, NULL, NULL,
+                           (DeeModelIterFunc) _collect_iter, walked);
+  g_assert_cmpuint (n_rows, ==, walked->len);
+  for (i = 0; i < n_rows; i++)
+    g_assert (g_ptr_array_index (walked, i) ==
+              dee_model_get_iter_at_row (m1, i));
+  g_ptr_array_free (walked, TRUE);
+
+  iter1 = dee_model_get_first_iter (m1);
+  iter2 = dee_model_get_first_iter (m2);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_assert (iter1 == iter2);
+      g_assert (dee_model_get_iter_at_row (m2, i) == iter2);
+      g_assert_cmpuint (i, ==, dee_model_get_position (m2, iter2));
+      if (i > 0)
+        g_assert (dee_model_prev (m2, iter2) == dee_model_prev (m1, iter1));
+
+      iter1 = dee_model_next (m1, iter1);
+      iter2 = dee_model_next (m2, iter2);
+    }
+
+  g_assert (dee_model_is_last (m1, iter1));
+  g_assert (dee_model_is_last (m2, iter2));
+}
+
+static gint
+_cmp_int_desc (GVariant **row1, GVariant **row2, gpointer user_data)
+{
+  return g_variant_get_int32 (row2[0]) - g_variant_get_int32 (row1[0]);
+}
+
+/* Check that dee_model_foreach_range() visits the right rows of a range in
+ * the middle of @m. _assert_same_rows() covers walking all of it */
+static void
+_assert_foreach_range (DeeModel *m)
+{
+  GPtrArray    *iters;
+  DeeModelIter *start, *end;
+  guint         i, first, last;
+
+  first = dee_model_get_n_rows (m) / 3;
+  last = 2 * dee_model_get_n_rows (m) / 3;
+  start = dee_model_get_iter_at_row (m, first);
+  end = dee_model_get_iter_at_row (m, last);
+
+  iters = g_ptr_array_new ();
+  dee_model_foreach_range (m, start, end,
+                           (DeeModelIterFunc) _collect_iter, iters);
+  g_assert_cmpuint (last - first, ==, iters->len);
+  for (i = 0; i < iters->len; i++)
+    g_assert (dee_model_get_iter_at_row (m, first + i) ==
+              g_ptr_array_index (iters, i));
+
+  g_ptr_array_free (iters, TRUE);
+}
+
+/* Test that a compact filter model tracks the same rows as a regular one
+ * while the original model is being modified */
+static void
+test_compact_consistency (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m, *compact;
+  DeeModelIter *iter;
+  GRand        *rand;
+  guint         i, n_rows;
+
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i < 3000; i++)
+    dee_model_append (fix->model, i, g_rand_int_range (rand, 0, 8) == 0 ?
+                                     "Match" : "Other");
+
+  dee_filter_new_for_key_column (1, "Match", &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+  dee_filter_new_for_key_column (1, "Match", &filter);
+  compact = dee_filter_model_new_compact (fix->model, &filter);
+
+  _assert_same_rows (m, compact);
+  _assert_foreach_range (compact);
+
+  for (i = 0; i < 3000; i++)
+    {
+      n_rows = dee_model_get_n_rows (fix->model);
+      iter = dee_model_get_iter_at_row (fix->model,
+                                        g_rand_int_range (rand, 0, n_rows));
+      switch (g_rand_int_range (rand, 0, 4))
+        {
+          case 0:
+            dee_model_insert_before (fix->model, iter, i, "Match");
+            break;
+          case 1:
+            dee_model_insert_before (fix->model, iter, i, "Other");
+            break;
+          case 2:
+            dee_model_set (fix->model, iter, i,
+                           g_rand_boolean (rand) ? "Match" : "Other");
+            break;
+          case 3:
+            dee_model_remove (fix->model, iter);
+            break;
+        }
+    }
+
+  _assert_same_rows (m, compact);
+  _assert_foreach_range (compact);
+
+  /* Both follow a reordering of the original model */
+  dee_model_sort (fix->model, _cmp_int_desc, NULL);
+  _assert_same_rows (m, compact);
+  _assert_foreach_range (compact);
+  g_assert_cmpint (dee_model_get_int32 (compact,
+                                        dee_model_get_iter_at_row (compact, 0),
+                                        0), >,
+                   dee_model_get_int32 (compact,
+                                        dee_model_get_iter_at_row (compact, 1),
+                                        0));
+
+  /* Rows added through the filter model are always included */
+  dee_model_append (compact, -1, "Other");
+  dee_model_prepend (compact, -2, "Other");
+  g_assert_cmpint (-2, ==, dee_model_get_int32 (compact,
+                                                dee_model_get_first_iter (compact),
+                                                0));
+  iter = dee_model_get_iter_at_row (compact,
+                                    dee_model_get_n_rows (compact) - 1);
+  g_assert_cmpint (-1, ==, dee_model_get_int32 (compact, iter, 0));
+
+  g_object_unref (m);
+  g_object_unref (compact);
+  g_rand_free (rand);
 }
 
 /* Test dee_filter_new_for_any_column() */
@@ -645,7 +1036,7 @@ test_any (FilterFixture *fix, gconstpointer data)
 
   dee_filter_new_for_any_column (1, g_variant_new_string ("Zero"), &filter);
 
-  _test_orig_ordering (fix, &filter);
+  _test_orig_ordering (fix, &filter, FALSE);
 }
 
 /* Test dee_filter_new_regex() */
@@ -658,8 +1049,194 @@ test_regex (FilterFixture *fix, gconstpointer data)
   regex = g_regex_new (".ero", 0, 0, NULL);
   dee_filter_new_regex (1, regex, &filter);
 
-  _test_orig_ordering (fix, &filter);
+  _test_orig_ordering (fix, &filter, FALSE);
+  g_regex_unref (regex);
+}
+
+static void
+_assert_ints (DeeModel *m, const gint *expected, guint n_expected)
+{
+  DeeModelIter *iter;
+  guint         i;
+
+  g_assert_cmpuint (n_expected, ==, dee_model_get_n_rows (m));
+
+  iter = dee_model_get_first_iter (m);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert_cmpint (expected[i], ==, dee_model_get_int32 (m, iter, 0));
+      iter = dee_model_next (m, iter);
+    }
+}
+
+/* Test sorting an integer column descending with cached sort keys */
+static void
+test_column_sort (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m;
+  DeeModelIter *iter;
+  gint          initial[] = { 2, 1, 0 };
+  gint          added[] = { 7, 2, 1, 0, -5 };
+  gint          changed[] = { 10, 7, 2, 1, -5 };
+  gint          removed[] = { 10, 7, 1, -5 };
+
+  dee_filter_new_column_sort (0, TRUE, &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_ints (m, initial, G_N_ELEMENTS (initial));
+
+  /* Negative numbers must sort below positive ones */
+  dee_model_append (fix->model, -5, "Minus five");
+  dee_model_prepend (fix->model, 7, "Seven");
+  _assert_ints (m, added, G_N_ELEMENTS (added));
+
+  /* The row with 0 moves to the top */
+  iter = dee_model_get_iter_at_row (fix->model, 1);
+  g_assert_cmpint (0, ==, dee_model_get_int32 (fix->model, iter, 0));
+  dee_model_set (fix->model, iter, 10, "Ten");
+  _assert_ints (m, changed, G_N_ELEMENTS (changed));
+
+  /* Changing the string column leaves the order alone */
+  dee_model_set (fix->model, iter, 10, "Still ten");
+  _assert_ints (m, changed, G_N_ELEMENTS (changed));
+
+  dee_model_remove (fix->model, dee_model_get_iter_at_row (fix->model, 3));
+  _assert_ints (m, removed, G_N_ELEMENTS (removed));
+
+  g_object_unref (m);
+}
+
+/* The sort keys must not be stored on the original model, which would fail
+ * on a transaction */
+static void
+test_column_sort_txn (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *txn, *m;
+  gint          initial[] = { 2, 1, 0 };
+  gint          added[] = { 3, 2, 1, 0 };
+  gint          removed[] = { 3, 1, 0 };
+
+  txn = dee_transaction_new (fix->model);
+  dee_filter_new_column_sort (0, TRUE, &filter);
+  m = dee_filter_model_new (txn, &filter);
+  _assert_ints (m, initial, G_N_ELEMENTS (initial));
+
+  dee_model_append (txn, 3, "Three");
+  _assert_ints (m, added, G_N_ELEMENTS (added));
+
+  dee_model_remove (txn, dee_model_get_iter_at_row (txn, 2));
+  _assert_ints (m, removed, G_N_ELEMENTS (removed));
+
+  g_object_unref (m);
+  g_object_unref (txn);
+}
+
+static gint
+_cmp_string_desc (GVariant **row1, GVariant **row2, gpointer user_data)
+{
+  return g_utf8_collate (g_variant_get_string (row2[1], NULL),
+                         g_variant_get_string (row1[1], NULL));
+}
+
+static void
+_assert_strings (DeeModel *m, const gchar **expected, guint n_expected)
+{
+  DeeModelIter *iter;
+  guint         i;
+
+  g_assert_cmpuint (n_expected, ==, dee_model_get_n_rows (m));
+
+  iter = dee_model_get_first_iter (m);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert_cmpstr (expected[i], ==, dee_model_get_string (m, iter, 1));
+      iter = dee_model_next (m, iter);
+    }
+}
+
+/* Test a sorted filter with nested predicates through additions and
+ * changes in the original model */
+static void
+test_predicate (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m;
+  DeeModelIter *iter;
+  GRegex       *regex;
+  const gchar  *initial[] = { "Zero", "Two" };
+  const gchar  *added[] = { "Zero", "Two", "Twelve" };
+  const gchar  *changed[] = { "Two", "Twelve", "Nero" };
+  const gchar  *removed[] = { "Two", "Twelve" };
+
+  regex = g_regex_new ("^.[ew]", 0, 0, NULL);
+  dee_filter_new_for_predicate (
+      dee_filter_predicate_new_all (
+          dee_filter_predicate_new_regex (1, regex),
+          dee_filter_predicate_new_any (
+              dee_filter_predicate_new_value (0, g_variant_new_int32 (0)),
+              dee_filter_predicate_new_value (0, g_variant_new_int32 (2)),
+              NULL),
+          NULL),
+      _cmp_string_desc, NULL, NULL, &filter);
   g_regex_unref (regex);
+
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_strings (m, initial, G_N_ELEMENTS (initial));
+
+  /* Only matches the regex */
+  dee_model_append (fix->model, 4, "Zebra");
+  /* Matches both and goes in sorted */
+  dee_model_append (fix->model, 2, "Twelve");
+  _assert_strings (m, added, G_N_ELEMENTS (added));
+
+  /* Still matches, but moves to the end */
+  iter = dee_model_get_first_iter (fix->model);
+  dee_model_set (fix->model, iter, 0, "Nero");
+  _assert_strings (m, changed, G_N_ELEMENTS (changed));
+
+  /* Stops matching the disjunction */
+  dee_model_set (fix->model, iter, 5, "Nero");
+  _assert_strings (m, removed, G_N_ELEMENTS (removed));
+
+  g_object_unref (m);
+}
+
+/* Test that a predicate filter driven by a column index finds the same rows
+ * as a scan, in the order of the original model */
+static void
+test_predicate_indexed (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter       filter;
+  DeeModel       *m;
+  DeeColumnIndex *index;
+  const gchar    *expected[] = { "Two", "Two" };
+
+  dee_model_append (fix->model, 3, "Two");
+  dee_model_append (fix->model, 4, "Two");
+  dee_model_prepend (fix->model, 5, "Two");
+
+  index = dee_column_index_new (fix->model, 1);
+
+  dee_filter_new_for_predicate (
+      dee_filter_predicate_new_all (
+          dee_filter_predicate_new_key (1, "Two"),
+          dee_filter_predicate_new_any (
+              dee_filter_predicate_new_value (0, g_variant_new_int32 (2)),
+              dee_filter_predicate_new_value (0, g_variant_new_int32 (4)),
+              NULL),
+          NULL),
+      NULL, NULL, NULL, &filter);
+
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_strings (m, expected, G_N_ELEMENTS (expected));
+  g_assert_cmpint (2, ==, dee_model_get_int32 (m,
+                                  dee_model_get_iter_at_row (m, 0), 0));
+  g_assert_cmpint (4, ==, dee_model_get_int32 (m,
+                                  dee_model_get_iter_at_row (m, 1), 0));
+
+  g_object_unref (m);
+  g_object_unref (index);
 }
 
 static void
@@ -746,3 +1323,190 @@ test_changesets (FilterFixture *fix, gconstpointer data)
   g_assert_cmpint (tuple_m3.first, ==, 1);
   g_assert_cmpint (tuple_m3.second, ==, 1);
 }
+
+static void
+reverse_model_map (DeeModel       *orig_model,
+                   DeeFilterModel *mapped_model,
+                   gpointer        user_data)
+{
+  DeeModelIter **iters;
+  guint          i, n_rows;
+
+  n_rows = dee_model_get_n_rows (orig_model);
+  iters = g_new (DeeModelIter*, n_rows);
+  for (i = 0; i < n_rows; i++)
+    iters[n_rows - i - 1] = dee_model_get_iter_at_row (orig_model, i);
+
+  dee_filter_model_append_iters (mapped_model, iters, n_rows);
+  g_free (iters);
+}
+
+static gboolean
+append_iters_model_notify (DeeModel       *orig_model,
+                           DeeModelIter   *orig_iter,
+                           DeeFilterModel *mapped_model,
+                           gpointer        user_data)
+{
+  dee_filter_model_append_iters (mapped_model, &orig_iter, 1);
+  return TRUE;
+}
+
+/* Test populating a filter model in one go from the map func */
+static void
+test_append_iters (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter  filter;
+  DeeModel  *m;
+  gint       reversed[] = { 2, 1, 0 };
+  gint       appended[] = { 2, 1, 0, 3 };
+  guint      filter_add_count = 0;
+
+  dee_filter_new (reverse_model_map,
+                  append_iters_model_notify,
+                  NULL,
+                  NULL,
+                  &filter);
+
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_ints (m, reversed, G_N_ELEMENTS (reversed));
+  g_assert_cmpuint (3, ==, dee_serializable_model_get_seqnum (m));
+
+  /* Rows included after construction must be signalled as usual */
+  g_signal_connect (m, "row-added",
+                    G_CALLBACK (signal_counter), &filter_add_count);
+  dee_model_append (fix->model, 3, "Three");
+  g_assert_cmpuint (1, ==, filter_add_count);
+  _assert_ints (m, appended, G_N_ELEMENTS (appended));
+
+  g_object_unref (m);
+}
+
+static void
+on_row_moved (DeeModel *model, DeeModelIter *iter, guint old_pos,
+              gint *last_old_pos)
+{
+  *last_old_pos = old_pos;
+}
+
+/* Moves in the original model must be relayed as row-moved by filter
+ * models that don't keep a bitmap, not as a removal and an addition */
+static void
+test_moves (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m, *sorted;
+  DeeModelIter *r0, *r1, *r3;
+  gint          n_added = 0, n_removed = 0, n_moved = 0, old_pos = -1;
+  gint          n_sorted_moved = 0;
+  gint          initial[] = { 0, 2, 3 };
+  gint          moved[] = { 3, 0, 2 };
+  gint          by_value[] = { 3, 2, 1, 0 };
+
+  r0 = dee_model_append (fix->model, 0, "a");
+  r1 = dee_model_append (fix->model, 1, "b");
+  dee_model_append (fix->model, 2, "a");
+  r3 = dee_model_append (fix->model, 3, "a");
+
+  dee_filter_new_for_key_column (1, "a", &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_ints (m, initial, G_N_ELEMENTS (initial));
+
+  dee_filter_new_column_sort (0, TRUE, &filter);
+  sorted = dee_filter_model_new (fix->model, &filter);
+
+  g_signal_connect_swapped (m, "row-added",
+                            G_CALLBACK (increment_counter), &n_added);
+  g_signal_connect_swapped (m, "row-removed",
+                            G_CALLBACK (increment_counter), &n_removed);
+  g_signal_connect_swapped (m, "row-moved",
+                            G_CALLBACK (increment_counter), &n_moved);
+  g_signal_connect (m, "row-moved", G_CALLBACK (on_row_moved), &old_pos);
+  g_signal_connect_swapped (sorted, "row-moved",
+                            G_CALLBACK (increment_counter), &n_sorted_moved);
+
+  dee_model_move_before (fix->model, r3, r0);
+  _assert_ints (m, moved, G_N_ELEMENTS (moved));
+  g_assert (dee_model_get_first_iter (m) == r3);
+  g_assert_cmpint (0, ==, n_added);
+  g_assert_cmpint (0, ==, n_removed);
+  g_assert_cmpint (1, ==, n_moved);
+  g_assert_cmpint (2, ==, old_pos);
+
+  /* Moving a row that isn't included is invisible */
+  dee_model_move_before (fix->model, r1, r3);
+  _assert_ints (m, moved, G_N_ELEMENTS (moved));
+  g_assert_cmpint (1, ==, n_moved);
+
+  /* A sorted filter model ignores the order of the original model, so
+   * moves never change it */
+  _assert_ints (sorted, by_value, G_N_ELEMENTS (by_value));
+  g_assert_cmpint (0, ==, n_sorted_moved);
+
+  g_object_unref (sorted);
+  g_object_unref (m);
+}
+
+static void
+on_rows_reordered (DeeModel *model, const guint *new_order, guint *order)
+{
+  guint i;
+
+  for (i = 0; i < 3; i++)
+    order[i] = new_order[i];
+}
+
+/* Reordering the original model must give a single rows-reordered with
+ * the permutation of the filtered rows */
+static void
+test_reorder (FilterFixture *fix, gconstpointer data)
+{
+  DeeFilter     filter;
+  DeeModel     *m, *sorted;
+  gint          n_added = 0, n_removed = 0, n_reordered = 0;
+  gint          n_sorted_reordered = 0;
+  guint         reverse[] = { 3, 2, 1, 0 };
+  guint         order[3] = { 0, 0, 0 };
+  gint          initial[] = { 0, 2, 3 };
+  gint          reversed[] = { 3, 2, 0 };
+  gint          by_value[] = { 3, 2, 1, 0 };
+
+  dee_model_append (fix->model, 0, "a");
+  dee_model_append (fix->model, 1, "b");
+  dee_model_append (fix->model, 2, "a");
+  dee_model_append (fix->model, 3, "a");
+
+  dee_filter_new_for_key_column (1, "a", &filter);
+  m = dee_filter_model_new (fix->model, &filter);
+  _assert_ints (m, initial, G_N_ELEMENTS (initial));
+
+  dee_filter_new_column_sort (0, TRUE, &filter);
+  sorted = dee_filter_model_new (fix->model, &filter);
+
+  g_signal_connect_swapped (m, "row-added",
+                            G_CALLBACK (increment_counter), &n_added);
+  g_signal_connect_swapped (m, "row-removed",
+                            G_CALLBACK (increment_counter), &n_removed);
+  g_signal_connect_swapped (m, "rows-reordered",
+                            G_CALLBACK (increment_counter), &n_reordered);
+  g_signal_connect (m, "rows-reordered",
+                    G_CALLBACK (on_rows_reordered), order);
+  g_signal_connect_swapped (sorted, "rows-reordered",
+                            G_CALLBACK (increment_counter),
+                            &n_sorted_reordered);
+
+  dee_model_reorder (fix->model, reverse);
+  _assert_ints (m, reversed, G_N_ELEMENTS (reversed));
+  g_assert_cmpint (0, ==, n_added);
+  g_assert_cmpint (0, ==, n_removed);
+  g_assert_cmpint (1, ==, n_reordered);
+  g_assert_cmpuint (2, ==, order[0]);
+  g_assert_cmpuint (1, ==, order[1]);
+  g_assert_cmpuint (0, ==, order[2]);
+
+  /* The sorted filter model keeps its order */
+  _assert_ints (sorted, by_value, G_N_ELEMENTS (by_value));
+  g_assert_cmpint (0, ==, n_sorted_reordered);
+
+  g_object_unref (sorted);
+  g_object_unref (m);
+}
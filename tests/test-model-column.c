@@ -42,6 +42,8 @@ static void test_get_schema          (ColumnFixture *fix, gconstpointer data);
 static void test_no_schema           (ColumnFixture *fix, gconstpointer data);
 static void test_bad_schemas         (void);
 static void test_null_string         (ColumnFixture *fix, gconstpointer data);
+static void test_all_basic_types     (void);
+static void test_intern_strings      (void);
 
 void
 test_model_column_create_suite (void)
@@ -75,6 +77,8 @@ test_model_column_create_suite (void)
               proxy_column_setup, test_no_schema, proxy_column_teardown);
 
   g_test_add_func ("/Model/Column/BadSchemas", test_bad_schemas);
+  g_test_add_func ("/Model/Column/AllBasicTypes", test_all_basic_types);
+  g_test_add_func (SEQ_DOMAIN"/InternStrings", test_intern_strings);
 
   g_test_add (SEQ_DOMAIN"/NullString", ColumnFixture, 0,
               column_setup, test_null_string, column_teardown);
@@ -398,3 +402,121 @@ test_null_string (ColumnFixture *fix, gconstpointer data)
                  NULL);
   g_assert_cmpstr ("", ==, dee_model_get_string (model, iter, 7));
 }
+
+/* Round trip every basic type, and a container, through the varargs API of
+ * a sequence model and a proxy on top of it */
+static void
+test_all_basic_types (void)
+{
+  DeeModel     *models[2];
+  DeeModelIter *iter;
+  GVariant     *container;
+  gboolean      b;
+  guchar        y;
+  gint16        n;
+  guint16       q;
+  gint32        i, h;
+  guint32       u;
+  gint64        x;
+  guint64       t;
+  gdouble       d;
+  const gchar  *s, *o, *g;
+  guint         m;
+
+  models[0] = dee_sequence_model_new ();
+  dee_model_set_schema (models[0], "b", "y", "n", "q", "i", "u", "h", "x",
+                        "t", "d", "s", "o", "g", "as", NULL);
+  models[1] = g_object_new (DEE_TYPE_PROXY_MODEL,
+                            "back-end", models[0], NULL);
+
+  for (m = 0; m < G_N_ELEMENTS (models); m++)
+    {
+      container = g_variant_new_strv (NULL, 0);
+      iter = dee_model_append (models[m], TRUE, 'y', G_MININT16, G_MAXUINT16,
+                               G_MININT32, G_MAXUINT32, 3, G_MININT64,
+                               G_MAXUINT64, 0.5, "s", "/o", "g", container);
+
+      dee_model_get (models[m], iter, &b, &y, &n, &q, &i, &u, &h, &x,
+                     &t, &d, &s, &o, &g, &container);
+
+      g_assert (b == TRUE);
+      g_assert_cmpint (y, ==, 'y');
+      g_assert_cmpint (n, ==, G_MININT16);
+      g_assert_cmpuint (q, ==, G_MAXUINT16);
+      g_assert_cmpint (i, ==, G_MININT32);
+      g_assert_cmpuint (u, ==, G_MAXUINT32);
+      g_assert_cmpint (h, ==, 3);
+      g_assert (x == G_MININT64);
+      g_assert (t == G_MAXUINT64);
+      g_assert_cmpfloat (d, ==, 0.5);
+      g_assert_cmpstr (s, ==, "s");
+      g_assert_cmpstr (o, ==, "/o");
+      g_assert_cmpstr (g, ==, "g");
+      g_assert_cmpstr (g_variant_get_type_string (container), ==, "as");
+      g_variant_unref (container);
+    }
+
+  g_assert_cmpuint (2, ==, dee_model_get_n_rows (models[0]));
+
+  g_object_unref (models[1]);
+  g_object_unref (models[0]);
+}
+
+static void
+test_intern_strings (void)
+{
+  DeeModel     *model;
+  DeeModelIter *iter0, *iter1, *iter2, *iter3;
+  GVariant     *v0, *v1, *v2, *v3;
+
+  model = dee_sequence_model_new ();
+  dee_model_set_schema (model, "s", "i", NULL);
+
+  iter0 = dee_model_append (model, "text/plain", 0);
+  iter1 = dee_model_append (model, "text/plain", 1);
+
+  v0 = dee_model_get_value (model, iter0, 0);
+  v1 = dee_model_get_value (model, iter1, 0);
+  g_assert (v0 != v1);
+  g_variant_unref (v0);
+  g_variant_unref (v1);
+
+  /* Rows already in the model are interned when enabling it */
+  g_object_set (model, "intern-strings", TRUE, NULL);
+  g_assert (dee_sequence_model_get_intern_strings (DEE_SEQUENCE_MODEL (model)));
+  iter2 = dee_model_append (model, "text/plain", 2);
+
+  v0 = dee_model_get_value (model, iter0, 0);
+  v1 = dee_model_get_value (model, iter1, 0);
+  v2 = dee_model_get_value (model, iter2, 0);
+  g_assert (v0 == v1);
+  g_assert (v1 == v2);
+  g_variant_unref (v0);
+  g_variant_unref (v1);
+  g_variant_unref (v2);
+
+  /* Changing a value doesn't affect the other rows */
+  dee_model_set_value (model, iter0, 0, g_variant_new_string ("text/html"));
+  g_assert_cmpstr ("text/html", ==, dee_model_get_string (model, iter0, 0));
+  g_assert_cmpstr ("text/plain", ==, dee_model_get_string (model, iter1, 0));
+
+  /* Removing all rows holding a value and adding it back works */
+  dee_model_remove (model, iter0);
+  iter0 = dee_model_append (model, "text/html", 0);
+  g_assert_cmpstr ("text/html", ==, dee_model_get_string (model, iter0, 0));
+
+  dee_sequence_model_set_intern_strings (DEE_SEQUENCE_MODEL (model), FALSE);
+  iter3 = dee_model_append (model, "text/plain", 3);
+
+  v1 = dee_model_get_value (model, iter1, 0);
+  v3 = dee_model_get_value (model, iter3, 0);
+  g_assert (v1 != v3);
+  g_assert (g_variant_equal (v1, v3));
+  g_variant_unref (v1);
+  g_variant_unref (v3);
+
+  dee_model_clear (model);
+  g_assert_cmpuint (0, ==, dee_model_get_n_rows (model));
+
+  g_object_unref (model);
+}
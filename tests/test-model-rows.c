@@ -50,6 +50,10 @@ static void test_prepend         (RowsFixture *fix, gconstpointer data);
 static void test_append          (RowsFixture *fix, gconstpointer data);
 static void test_get_value       (RowsFixture *fix, gconstpointer data);
 static void test_no_transfer     (RowsFixture *fix, gconstpointer data);
+static void test_peek            (RowsFixture *fix, gconstpointer data);
+static void test_foreach_range   (RowsFixture *fix, gconstpointer data);
+static void test_move            (RowsFixture *fix, gconstpointer data);
+static void test_sort            (RowsFixture *fix, gconstpointer data);
 static void test_iter_backwards  (RowsFixture *fix, gconstpointer data);
 static void test_illegal_access  (RowsFixture *fix, gconstpointer data);
 static void test_sorted          (RowsFixture *fix, gconstpointer data);
@@ -132,6 +136,34 @@ test_model_rows_create_suite (void)
   g_test_add (TXN_DOMAIN"/NoTransfer", RowsFixture, 0,
               txn_rows_setup, test_no_transfer, txn_rows_teardown);
 
+  g_test_add (SEQ_DOMAIN"/Peek", RowsFixture, 0,
+              seq_rows_setup, test_peek, seq_rows_teardown);
+  g_test_add (PROXY_DOMAIN"/Peek", RowsFixture, 0,
+              proxy_rows_setup, test_peek, proxy_rows_teardown);
+  g_test_add (TXN_DOMAIN"/Peek", RowsFixture, 0,
+              txn_rows_setup, test_peek, txn_rows_teardown);
+
+  g_test_add (SEQ_DOMAIN"/ForeachRange", RowsFixture, 0,
+              seq_rows_setup, test_foreach_range, seq_rows_teardown);
+  g_test_add (PROXY_DOMAIN"/ForeachRange", RowsFixture, 0,
+              proxy_rows_setup, test_foreach_range, proxy_rows_teardown);
+  g_test_add (TXN_DOMAIN"/ForeachRange", RowsFixture, 0,
+              txn_rows_setup, test_foreach_range, txn_rows_teardown);
+
+  g_test_add (SEQ_DOMAIN"/Move", RowsFixture, 0,
+              seq_rows_setup, test_move, seq_rows_teardown);
+  g_test_add (PROXY_DOMAIN"/Move", RowsFixture, 0,
+              proxy_rows_setup, test_move, proxy_rows_teardown);
+  g_test_add (TXN_DOMAIN"/Move", RowsFixture, 0,
+              txn_rows_setup, test_move, txn_rows_teardown);
+
+  g_test_add (SEQ_DOMAIN"/Sort", RowsFixture, 0,
+              seq_rows_setup, test_sort, seq_rows_teardown);
+  g_test_add (PROXY_DOMAIN"/Sort", RowsFixture, 0,
+              proxy_rows_setup, test_sort, proxy_rows_teardown);
+  g_test_add (TXN_DOMAIN"/Sort", RowsFixture, 0,
+              txn_rows_setup, test_sort, txn_rows_teardown);
+
   g_test_add (SEQ_DOMAIN"/IterBackwards", RowsFixture, 0,
               seq_rows_setup, test_iter_backwards, seq_rows_teardown);
   g_test_add (PROXY_DOMAIN"/IterBackwards", RowsFixture, 0,
@@ -506,6 +538,259 @@ test_get_value (RowsFixture *fix, gconstpointer data)
   g_assert (dee_model_is_last (fix->model, iter));
 }
 
+static void
+test_peek (RowsFixture *fix, gconstpointer data)
+{
+  DeeModelIter  *iter;
+  GVariant      *variant;
+  GVariant      *row_buf[2];
+  GVariant     **row;
+
+  dee_model_append (fix->model, 11, "First");
+  dee_model_append (fix->model, 12, "Last");
+
+  /* Peeking borrows the very same variant get_value() hands out a ref to */
+  iter = dee_model_get_first_iter (fix->model);
+  variant = dee_model_get_value (fix->model, iter, 1);
+  g_assert (variant == dee_model_peek_value (fix->model, iter, 1));
+  g_assert_cmpstr ("First", ==,
+                   g_variant_get_string (dee_model_peek_value (fix->model,
+                                                               iter, 1),
+                                         NULL));
+  g_variant_unref (variant);
+
+  iter = dee_model_next (fix->model, iter);
+  g_assert (dee_model_peek_row (fix->model, iter, row_buf) == row_buf);
+  g_assert_cmpint (12, ==, g_variant_get_int32 (row_buf[0]));
+  g_assert_cmpstr ("Last", ==, g_variant_get_string (row_buf[1], NULL));
+
+  /* A newly allocated row is NULL terminated and only the array is ours */
+  row = dee_model_peek_row (fix->model, iter, NULL);
+  g_assert (row[0] == row_buf[0]);
+  g_assert (row[1] == row_buf[1]);
+  g_assert (row[2] == NULL);
+  g_free (row);
+
+  /* The values are still owned by the model */
+  g_assert_cmpint (12, ==, dee_model_get_int32 (fix->model, iter, 0));
+}
+
+typedef struct
+{
+  DeeModel *model;
+  gint      sum;
+  guint     n_rows;
+  guint     n_chunks;
+  guint     stop_after;
+} WalkData;
+
+static gboolean
+walk_row (DeeModel *model, DeeModelIter *iter, WalkData *walk)
+{
+  g_assert (model == walk->model);
+  walk->sum += dee_model_get_int32 (model, iter, 0);
+  walk->n_rows++;
+
+  return walk->n_rows == walk->stop_after;
+}
+
+static gboolean
+walk_chunk (DeeModel *model, DeeModelIter **iters, guint n_iters,
+            WalkData *walk)
+{
+  guint i;
+
+  for (i = 0; i < n_iters; i++)
+    walk_row (model, iters[i], walk);
+  walk->n_chunks++;
+
+  return FALSE;
+}
+
+static void
+test_foreach_range (RowsFixture *fix, gconstpointer data)
+{
+  WalkData  walk = { 0, };
+  gint      i;
+
+  for (i = 0; i < 1000; i++)
+    dee_model_append (fix->model, i, "Row");
+
+  walk.model = fix->model;
+  dee_model_foreach_range (fix->model, NULL, NULL,
+                           (DeeModelIterFunc) walk_row, &walk);
+  g_assert_cmpuint (1000, ==, walk.n_rows);
+  g_assert_cmpint (999 * 1000 / 2, ==, walk.sum);
+
+  /* The end row is not visited */
+  memset (&walk, 0, sizeof (WalkData));
+  walk.model = fix->model;
+  dee_model_foreach_range (fix->model,
+                           dee_model_get_iter_at_row (fix->model, 10),
+                           dee_model_get_iter_at_row (fix->model, 13),
+                           (DeeModelIterFunc) walk_row, &walk);
+  g_assert_cmpuint (3, ==, walk.n_rows);
+  g_assert_cmpint (10 + 11 + 12, ==, walk.sum);
+
+  /* Returning TRUE stops the walk */
+  memset (&walk, 0, sizeof (WalkData));
+  walk.model = fix->model;
+  walk.stop_after = 5;
+  dee_model_foreach_range (fix->model, NULL, NULL,
+                           (DeeModelIterFunc) walk_row, &walk);
+  g_assert_cmpuint (5, ==, walk.n_rows);
+
+  memset (&walk, 0, sizeof (WalkData));
+  walk.model = fix->model;
+  dee_model_foreach_range_chunked (fix->model, NULL, NULL,
+                                   (DeeModelChunkFunc) walk_chunk, &walk);
+  g_assert_cmpuint (1000, ==, walk.n_rows);
+  g_assert_cmpint (999 * 1000 / 2, ==, walk.sum);
+  g_assert_cmpuint (1, <, walk.n_chunks);
+}
+
+static void
+on_row_moved (DeeModel *model, DeeModelIter *iter, guint old_pos, gint *data)
+{
+  /* Remember the old position and the row that was moved */
+  data[0] = old_pos;
+  data[1] = dee_model_get_int32 (model, iter, 0);
+}
+
+static void
+assert_order (DeeModel *model, const gint *expected, guint n_expected)
+{
+  DeeModelIter *iter;
+  guint         i;
+
+  g_assert_cmpuint (n_expected, ==, dee_model_get_n_rows (model));
+
+  iter = dee_model_get_first_iter (model);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert_cmpint (expected[i], ==, dee_model_get_int32 (model, iter, 0));
+      g_assert_cmpuint (i, ==, dee_model_get_position (model, iter));
+      iter = dee_model_next (model, iter);
+    }
+  g_assert (dee_model_is_last (model, iter));
+}
+
+static void
+test_move (RowsFixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter, *moved;
+  gint          moved_data[2] = { -1, -1 };
+  gint          to_end[] = { 1, 2, 3, 0 };
+  gint          to_front[] = { 3, 1, 2, 0 };
+  gint          to_mid[] = { 3, 2, 1, 0 };
+  gint          i;
+
+  for (i = 0; i < 4; i++)
+    dee_model_append (fix->model, i, "Row");
+
+  g_signal_connect (fix->model, "row-moved",
+                    G_CALLBACK (on_row_moved), moved_data);
+
+  /* Moving a row in front of itself or its successor is a no-op */
+  iter = dee_model_get_first_iter (fix->model);
+  g_assert (iter == dee_model_move_before (fix->model, iter, iter));
+  g_assert (iter == dee_model_move_before (fix->model, iter,
+                                           dee_model_next (fix->model, iter)));
+  g_assert_cmpint (-1, ==, moved_data[0]);
+
+  moved = dee_model_move_before (fix->model, iter,
+                                 dee_model_get_last_iter (fix->model));
+  assert_order (fix->model, to_end, G_N_ELEMENTS (to_end));
+  g_assert_cmpint (0, ==, dee_model_get_int32 (fix->model, moved, 0));
+  g_assert_cmpint (0, ==, moved_data[0]);
+  g_assert_cmpint (0, ==, moved_data[1]);
+
+  iter = dee_model_get_iter_at_row (fix->model, 2);
+  moved = dee_model_move_before (fix->model, iter,
+                                 dee_model_get_first_iter (fix->model));
+  assert_order (fix->model, to_front, G_N_ELEMENTS (to_front));
+  g_assert (dee_model_is_first (fix->model, moved));
+  g_assert_cmpint (2, ==, moved_data[0]);
+  g_assert_cmpint (3, ==, moved_data[1]);
+
+  iter = dee_model_get_iter_at_row (fix->model, 1);
+  moved = dee_model_move_before (fix->model, iter,
+                                 dee_model_get_iter_at_row (fix->model, 3));
+  assert_order (fix->model, to_mid, G_N_ELEMENTS (to_mid));
+  g_assert_cmpuint (2, ==, dee_model_get_position (fix->model, moved));
+  g_assert_cmpint (1, ==, moved_data[0]);
+  g_assert_cmpint (1, ==, moved_data[1]);
+
+  /* The moved row keeps its values */
+  g_assert_cmpstr ("Row", ==, dee_model_get_string (fix->model, moved, 1));
+}
+
+static gint
+cmp_first_column (GVariant **row1, GVariant **row2, gpointer user_data)
+{
+  return g_variant_get_int32 (row1[0]) - g_variant_get_int32 (row2[0]);
+}
+
+static void
+on_rows_reordered (DeeModel *model, const guint *new_order, GArray *orders)
+{
+  g_array_append_vals (orders, new_order, dee_model_get_n_rows (model));
+}
+
+static void
+test_sort (RowsFixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter, *first;
+  GArray       *orders;
+  const gchar  *names[] = { "b", "d", "a", "c", "e" };
+  guint         expected_order[] = { 1, 3, 0, 2, 4 };
+  gint          expected[] = { 1, 1, 2, 2, 3 };
+  guint         i;
+
+  dee_model_append (fix->model, 2, "a");
+  dee_model_append (fix->model, 1, "b");
+  dee_model_append (fix->model, 2, "c");
+  dee_model_append (fix->model, 1, "d");
+  dee_model_append (fix->model, 3, "e");
+  first = dee_model_get_first_iter (fix->model);
+
+  orders = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_signal_connect (fix->model, "rows-reordered",
+                    G_CALLBACK (on_rows_reordered), orders);
+
+  dee_model_sort (fix->model, cmp_first_column, NULL);
+  assert_order (fix->model, expected, G_N_ELEMENTS (expected));
+
+  /* Rows that compare equal keep their order */
+  iter = dee_model_get_first_iter (fix->model);
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      g_assert_cmpstr (names[i], ==, dee_model_get_string (fix->model, iter, 1));
+      iter = dee_model_next (fix->model, iter);
+    }
+
+  /* A transaction can't reorder its journal natively and moves the rows
+   * one by one instead */
+  if (!DEE_IS_TRANSACTION (fix->model))
+    {
+      g_assert_cmpuint (G_N_ELEMENTS (expected_order), ==, orders->len);
+      for (i = 0; i < orders->len; i++)
+        g_assert_cmpuint (expected_order[i], ==,
+                          g_array_index (orders, guint, i));
+
+      /* Iters stay valid */
+      g_assert_cmpstr ("a", ==, dee_model_get_string (fix->model, first, 1));
+      g_assert_cmpuint (2, ==, dee_model_get_position (fix->model, first));
+    }
+
+  /* Sorting a sorted model doesn't signal anything */
+  g_array_set_size (orders, 0);
+  dee_model_sort (fix->model, cmp_first_column, NULL);
+  g_assert_cmpuint (0, ==, orders->len);
+
+  g_array_free (orders, TRUE);
+}
+
 static void
 test_iter_backwards (RowsFixture *fix, gconstpointer data)
 {
@@ -964,6 +964,66 @@ test_target_2_change_remove_append (Fixture *fix, gconstpointer data)
   g_assert_cmpint (i, ==, 11);
 }
 
+static void
+test_target_3_move_change (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+  GError       *error;
+  const gchar  *expected[] = { "C", "A'", "B" };
+  gint32        i;
+
+  /**
+   * Target: A  B  C
+   * Txn:    C  A' B
+   */
+
+  dee_model_append (fix->model, "A", 1);
+  dee_model_append (fix->model, "B", 2);
+  dee_model_append (fix->model, "C", 3);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  /* Move the last row to the front */
+  iter = dee_model_get_last_iter (fix->txn);
+  iter = dee_model_prev (fix->txn, iter);
+  iter = dee_model_move_before (fix->txn, iter,
+                                dee_model_get_first_iter (fix->txn));
+  g_assert (dee_model_is_first (fix->txn, iter));
+  g_assert_cmpstr (dee_model_get_string (fix->txn, iter, 0), ==, "C");
+  g_assert_cmpint (dee_model_get_n_rows (fix->txn), == , 3);
+
+  /* Change the row that is now second */
+  iter = dee_model_next (fix->txn, iter);
+  dee_model_set_value (fix->txn, iter, 0, g_variant_new_string ("A'"));
+
+  /* The target is untouched until we commit */
+  iter = dee_model_get_first_iter (fix->model);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "A");
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit with: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_assert_cmpint (3, ==, dee_model_get_n_rows (fix->model));
+
+  iter = dee_model_get_first_iter (fix->model);
+  for (i = 0; i < 3; i++)
+    {
+      g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==,
+                       expected[i]);
+      iter = dee_model_next (fix->model, iter);
+    }
+  g_assert (dee_model_is_last (fix->model, iter));
+
+  /* The moved row kept its value */
+  iter = dee_model_get_first_iter (fix->model);
+  g_assert_cmpint (dee_model_get_int32 (fix->model, iter, 1), ==, 3);
+}
+
 static int txn_remaining_rows = 2;
 
 void
@@ -1072,14 +1132,17 @@ test_concurrent_modification (Fixture *fix, gconstpointer data)
   GError       *error;
 
   /**
-   * Target: -   (add A while txn open)
-   * Txn:    I
+   * Target: A   (change A while txn open)
+   * Txn:    -
    */
 
+  dee_model_append (fix->model, "TwentySeven", 27);
+
   fix->txn = dee_transaction_new (fix->model);
 
-  dee_model_append (fix->model, "TwentySeven", 27);
   dee_model_clear (fix->txn);
+  dee_model_set (fix->model, dee_model_get_first_iter (fix->model),
+                 "TwentyEight", 28);
 
   /* COMMIT */
   error = NULL;
@@ -1097,11 +1160,245 @@ test_concurrent_modification (Fixture *fix, gconstpointer data)
   g_assert (g_error_matches (error,
                              DEE_TRANSACTION_ERROR,
                              DEE_TRANSACTION_ERROR_CONCURRENT_MODIFICATION));
+  g_error_free (error);
 
   g_assert (!dee_transaction_is_committed (DEE_TRANSACTION (fix->txn)));
 
   /* Target model should not have been cleared */
   g_assert_cmpint (dee_model_get_n_rows (fix->model), ==, 1);
+  g_assert_cmpstr (dee_model_get_string (fix->model,
+                                         dee_model_get_first_iter (fix->model),
+                                         0), ==, "TwentyEight");
+}
+
+static void
+test_rebase (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *a, *b, *c, *iter;
+  GError       *error;
+
+  /**
+   * Target: A B C   (change B, append D and remove C while txn open)
+   * Txn:    A' B X C
+   * Result: A' B' X D
+   */
+
+  a = dee_model_append (fix->model, "A", 0);
+  b = dee_model_append (fix->model, "B", 1);
+  c = dee_model_append (fix->model, "C", 2);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  dee_model_set (fix->txn, a, "A'", 0);
+  dee_model_insert_before (fix->txn, c, "X", 23);
+
+  dee_model_set (fix->model, b, "B'", 1);
+  dee_model_append (fix->model, "D", 3);
+  dee_model_remove (fix->model, c);
+
+  /* The transaction sees the concurrent changes */
+  g_assert_cmpint (dee_model_get_n_rows (fix->txn), ==, 4);
+  iter = dee_model_get_first_iter (fix->txn);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, iter, 0), ==, "A'");
+  iter = dee_model_next (fix->txn, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, iter, 0), ==, "B'");
+  iter = dee_model_next (fix->txn, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, iter, 0), ==, "X");
+  iter = dee_model_next (fix->txn, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, iter, 0), ==, "D");
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_assert_cmpint (dee_model_get_n_rows (fix->model), ==, 4);
+  iter = dee_model_get_first_iter (fix->model);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "A'");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "B'");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "X");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "D");
+}
+
+static void
+on_row_changed_count (DeeModel *model, DeeModelIter *iter, guint *count)
+{
+  (*count)++;
+}
+
+static void
+test_set_value_delta (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *a, *b;
+  GVariant     *val;
+  GError       *error;
+  guint         n_changed;
+
+  a = dee_model_append (fix->model, "A", 0);
+  b = dee_model_append (fix->model, "B", 1);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  /* Change one column twice and leave the other untouched */
+  val = g_variant_new_int32 (26);
+  dee_model_set_value (fix->txn, a, 1, val);
+  val = g_variant_new_int32 (27);
+  dee_model_set_value (fix->txn, a, 1, val);
+
+  g_assert_cmpstr (dee_model_get_string (fix->txn, a, 0), ==, "A");
+  g_assert_cmpint (dee_model_get_int32 (fix->txn, a, 1), ==, 27);
+
+  /* The target row is unchanged until commit */
+  g_assert_cmpint (dee_model_get_int32 (fix->model, a, 1), ==, 0);
+
+  /* Replacing the whole row supersedes the column changes */
+  dee_model_set_value (fix->txn, b, 1, g_variant_new_int32 (11));
+  dee_model_set (fix->txn, b, "B'", 12);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, b, 0), ==, "B'");
+  g_assert_cmpint (dee_model_get_int32 (fix->txn, b, 1), ==, 12);
+
+  n_changed = 0;
+  g_signal_connect (fix->model, "row-changed",
+                    G_CALLBACK (on_row_changed_count), &n_changed);
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  /* One row-changed per row, however many columns were set */
+  g_assert_cmpint (n_changed, ==, 2);
+
+  g_assert_cmpstr (dee_model_get_string (fix->model, a, 0), ==, "A");
+  g_assert_cmpint (dee_model_get_int32 (fix->model, a, 1), ==, 27);
+  g_assert_cmpstr (dee_model_get_string (fix->model, b, 0), ==, "B'");
+  g_assert_cmpint (dee_model_get_int32 (fix->model, b, 1), ==, 12);
+}
+
+/* Assert that the first column of the rows in model are the given strings */
+static void
+assert_rows (DeeModel *model, const gchar **rows)
+{
+  DeeModelIter *iter;
+  guint         i;
+
+  iter = dee_model_get_first_iter (model);
+  for (i = 0; rows[i] != NULL; i++)
+    {
+      g_assert (!dee_model_is_last (model, iter));
+      g_assert_cmpstr (dee_model_get_string (model, iter, 0), ==, rows[i]);
+      iter = dee_model_next (model, iter);
+    }
+
+  g_assert (dee_model_is_last (model, iter));
+  g_assert_cmpint (dee_model_get_n_rows (model), ==, i);
+}
+
+static void
+test_savepoint_rollback (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *a, *b, *c, *x;
+  GError       *error;
+  guint         sp;
+  const gchar  *before_rollback[] = { "X", "C'", "A'", NULL };
+  const gchar  *after_rollback[] = { "A'", "B", "C", NULL };
+  const gchar  *committed[] = { "A'", "B'", "C", NULL };
+
+  a = dee_model_append (fix->model, "A", 0);
+  b = dee_model_append (fix->model, "B", 1);
+  c = dee_model_append (fix->model, "C", 2);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  dee_model_set (fix->txn, a, "A'", 0);
+
+  sp = dee_transaction_savepoint (DEE_TRANSACTION (fix->txn));
+
+  /* Every kind of change, on rows both changed and untouched before */
+  dee_model_remove (fix->txn, b);
+  x = dee_model_insert_before (fix->txn, c, "X", 23);
+  dee_model_set_value (fix->txn, c, 0, g_variant_new_string ("C'"));
+  dee_model_move_before (fix->txn, a, dee_model_get_last_iter (fix->txn));
+  dee_model_set_value (fix->txn, x, 1, g_variant_new_int32 (24));
+  assert_rows (fix->txn, before_rollback);
+
+  dee_transaction_rollback_to (DEE_TRANSACTION (fix->txn), sp);
+  assert_rows (fix->txn, after_rollback);
+  g_assert_cmpint (dee_model_get_int32 (fix->txn, a, 1), ==, 0);
+
+  /* The savepoint is still there, and we can keep editing */
+  dee_model_set (fix->txn, b, "B'", 1);
+  dee_transaction_rollback_to (DEE_TRANSACTION (fix->txn), sp);
+  assert_rows (fix->txn, after_rollback);
+
+  dee_model_set (fix->txn, b, "B'", 1);
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  assert_rows (fix->model, committed);
+}
+
+static void
+test_savepoint_nested (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *a, *x, *y;
+  GError       *error;
+  guint         sp1, sp2, sp3;
+  const gchar  *outer[] = { "X", "A", NULL };
+  const gchar  *inner[] = { "A", "Y", NULL };
+  const gchar  *committed[] = { "X", "A", "Z", NULL };
+
+  a = dee_model_append (fix->model, "A", 0);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  sp1 = dee_transaction_savepoint (DEE_TRANSACTION (fix->txn));
+  x = dee_model_insert_before (fix->txn, a, "X", 1);
+
+  sp2 = dee_transaction_savepoint (DEE_TRANSACTION (fix->txn));
+  y = dee_model_append (fix->txn, "Y", 2);
+  y = dee_model_move_before (fix->txn, y, x);
+  dee_model_remove (fix->txn, x);
+  y = dee_model_move_before (fix->txn, y, dee_model_get_last_iter (fix->txn));
+
+  sp3 = dee_transaction_savepoint (DEE_TRANSACTION (fix->txn));
+  dee_model_remove (fix->txn, y);
+  dee_transaction_rollback_to (DEE_TRANSACTION (fix->txn), sp3);
+  assert_rows (fix->txn, inner);
+
+  /* Rolling back to sp2 also drops sp3 */
+  dee_transaction_rollback_to (DEE_TRANSACTION (fix->txn), sp2);
+  assert_rows (fix->txn, outer);
+  g_assert_cmpstr (dee_model_get_string (fix->txn, x, 0), ==, "X");
+
+  /* Keep the changes made after sp1 */
+  dee_model_append (fix->txn, "Z", 3);
+  dee_transaction_release_savepoint (DEE_TRANSACTION (fix->txn), sp1);
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  assert_rows (fix->model, committed);
 }
 
 static void
@@ -1186,6 +1483,133 @@ test_basic_types (Fixture *fix, gconstpointer data)
     }
 }
 
+typedef struct
+{
+  gint n_started;
+  gint n_finished;
+  gint n_added_inside;
+  gint n_added_outside;
+  gboolean inside;
+} ChangesetLog;
+
+static void
+changeset_log_started (ChangesetLog *log, DeeModel *model)
+{
+  log->n_started++;
+  log->inside = TRUE;
+}
+
+static void
+changeset_log_finished (ChangesetLog *log, DeeModel *model)
+{
+  log->n_finished++;
+  log->inside = FALSE;
+}
+
+static void
+changeset_log_row_added (ChangesetLog *log, DeeModelIter *iter)
+{
+  if (log->inside)
+    log->n_added_inside++;
+  else
+    log->n_added_outside++;
+}
+
+static void
+test_commit_changeset (Fixture *fix, gconstpointer data)
+{
+  ChangesetLog  log = { 0 };
+  DeeModelIter *iter;
+  GError       *error;
+
+  /**
+   * Target: X Z
+   * Txn:    X' A B C Z D
+   */
+
+  dee_model_append (fix->model, "X", 0);
+  iter = dee_model_append (fix->model, "Z", 26);
+
+  fix->txn = dee_transaction_new (fix->model);
+
+  dee_model_insert_before (fix->txn, iter, "A", 1);
+  dee_model_insert_before (fix->txn, iter, "B", 2);
+  dee_model_insert_before (fix->txn, iter, "C", 3);
+  dee_model_set (fix->txn, dee_model_get_first_iter (fix->txn), "X'", 0);
+  dee_model_append (fix->txn, "D", 4);
+
+  g_signal_connect_swapped (fix->model, "changeset-started",
+                            G_CALLBACK (changeset_log_started), &log);
+  g_signal_connect_swapped (fix->model, "changeset-finished",
+                            G_CALLBACK (changeset_log_finished), &log);
+  g_signal_connect_swapped (fix->model, "row-added",
+                            G_CALLBACK (changeset_log_row_added), &log);
+
+  /* COMMIT */
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_assert_cmpint (log.n_started, ==, 1);
+  g_assert_cmpint (log.n_finished, ==, 1);
+  g_assert_cmpint (log.n_added_inside, ==, 4);
+  g_assert_cmpint (log.n_added_outside, ==, 0);
+
+  g_assert_cmpint (dee_model_get_n_rows (fix->model), ==, 6);
+  iter = dee_model_get_first_iter (fix->model);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "X'");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "A");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "B");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "C");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "Z");
+  iter = dee_model_next (fix->model, iter);
+  g_assert_cmpstr (dee_model_get_string (fix->model, iter, 0), ==, "D");
+}
+
+static void
+test_commit_inside_changeset (Fixture *fix, gconstpointer data)
+{
+  ChangesetLog  log = { 0 };
+  GError       *error;
+
+  /* A changeset opened by the caller is not closed by commit() */
+
+  fix->txn = dee_transaction_new (fix->model);
+  dee_model_append (fix->txn, "A", 1);
+  dee_model_append (fix->txn, "B", 2);
+
+  g_signal_connect_swapped (fix->model, "changeset-started",
+                            G_CALLBACK (changeset_log_started), &log);
+  g_signal_connect_swapped (fix->model, "changeset-finished",
+                            G_CALLBACK (changeset_log_finished), &log);
+  g_signal_connect_swapped (fix->model, "row-added",
+                            G_CALLBACK (changeset_log_row_added), &log);
+
+  dee_model_begin_changeset (fix->model);
+
+  error = NULL;
+  if (!dee_transaction_commit (DEE_TRANSACTION (fix->txn), &error))
+    {
+      g_critical ("Transaction failed to commit: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_assert_cmpint (log.n_started, ==, 1);
+  g_assert_cmpint (log.n_finished, ==, 0);
+  g_assert_cmpint (log.n_added_inside, ==, 2);
+
+  dee_model_end_changeset (fix->model);
+  g_assert_cmpint (log.n_finished, ==, 1);
+  g_assert_cmpint (dee_model_get_n_rows (fix->model), ==, 2);
+}
+
 // FIXME tags
 
 void
@@ -1268,6 +1692,13 @@ test_transaction_create_suite (void)
   g_test_add (PROXY_DOMAIN"/Target2ChangeRemoveAppend", Fixture, 0,
               setup_proxy, test_target_2_change_remove_append, teardown);
   
+  g_test_add (DOMAIN"/Target3MoveChange", Fixture, 0,
+              setup, test_target_3_move_change, teardown);
+  g_test_add (PROXY_DOMAIN"/Target3MoveChange", Fixture, 0,
+              setup_proxy, test_target_3_move_change, teardown);
+  g_test_add (SHARED_DOMAIN"/Target3MoveChange", Fixture, 0,
+              setup_shared, test_target_3_move_change, teardown);
+
   g_test_add (DOMAIN"/SignalOrder", Fixture, 0,
               setup, test_signal_order, teardown);
   g_test_add (PROXY_DOMAIN"/SignalOrder", Fixture, 0,
@@ -1279,12 +1710,46 @@ test_transaction_create_suite (void)
               setup, test_concurrent_modification, teardown);
   g_test_add (PROXY_DOMAIN"/ConcurrentModification", Fixture, 0,
               setup_proxy, test_concurrent_modification, teardown);
+
+  g_test_add (DOMAIN"/Rebase", Fixture, 0,
+              setup, test_rebase, teardown);
+  g_test_add (PROXY_DOMAIN"/Rebase", Fixture, 0,
+              setup_proxy, test_rebase, teardown);
+  g_test_add (SHARED_DOMAIN"/Rebase", Fixture, 0,
+              setup_shared, test_rebase, teardown);
   
+  g_test_add (DOMAIN"/SetValueDelta", Fixture, 0,
+              setup, test_set_value_delta, teardown);
+  g_test_add (PROXY_DOMAIN"/SetValueDelta", Fixture, 0,
+              setup_proxy, test_set_value_delta, teardown);
+
+  g_test_add (DOMAIN"/SavepointRollback", Fixture, 0,
+              setup, test_savepoint_rollback, teardown);
+  g_test_add (PROXY_DOMAIN"/SavepointRollback", Fixture, 0,
+              setup_proxy, test_savepoint_rollback, teardown);
+  g_test_add (SHARED_DOMAIN"/SavepointRollback", Fixture, 0,
+              setup_shared, test_savepoint_rollback, teardown);
+
+  g_test_add (DOMAIN"/SavepointNested", Fixture, 0,
+              setup, test_savepoint_nested, teardown);
+  g_test_add (PROXY_DOMAIN"/SavepointNested", Fixture, 0,
+              setup_proxy, test_savepoint_nested, teardown);
+
   g_test_add (DOMAIN"/DoubleCommit", Fixture, 0,
               setup, test_double_commit, teardown);
   g_test_add (PROXY_DOMAIN"/DoubleCommit", Fixture, 0,
               setup_proxy, test_double_commit, teardown);
 
+  g_test_add (DOMAIN"/CommitChangeset", Fixture, 0,
+              setup, test_commit_changeset, teardown);
+  g_test_add (PROXY_DOMAIN"/CommitChangeset", Fixture, 0,
+              setup_proxy, test_commit_changeset, teardown);
+  g_test_add (SHARED_DOMAIN"/CommitChangeset", Fixture, 0,
+              setup_shared, test_commit_changeset, teardown);
+
+  g_test_add (DOMAIN"/CommitInsideChangeset", Fixture, 0,
+              setup, test_commit_inside_changeset, teardown);
+
   g_test_add (DOMAIN"/BasicTypes", Fixture, 0,
               setup_basic_types, test_basic_types, teardown);
 }
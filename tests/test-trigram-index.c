@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2011 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee.h>
+
+typedef struct
+{
+  DeeModel        *model;
+  DeeTrigramIndex *index;
+
+} Fixture;
+
+static void setup    (Fixture *fix, gconstpointer data);
+static void teardown (Fixture *fix, gconstpointer data);
+
+static void
+setup (Fixture *fix, gconstpointer data)
+{
+  fix->model = dee_sequence_model_new ();
+  dee_model_set_schema (fix->model, "s", "i", NULL);
+
+  dee_model_append (fix->model, "The Dark Knight", 0);
+  dee_model_append (fix->model, "Knight and Day", 1);
+  dee_model_append (fix->model, "Night of the Living Dead", 2);
+  dee_model_append (fix->model, "Dark City", 3);
+  dee_model_append (fix->model, "Up", 4);
+
+  fix->index = dee_trigram_index_new (fix->model, 0);
+}
+
+static void
+teardown (Fixture *fix, gconstpointer data)
+{
+  if (fix->index)
+    g_object_unref (fix->index);
+  g_object_unref (fix->model);
+  fix->index = NULL;
+  fix->model = NULL;
+}
+
+static guint
+count_candidates (DeeTrigramIndex *index, const gchar *text)
+{
+  DeeResultSet *results;
+  guint         n_rows;
+
+  results = dee_trigram_index_lookup (index, text);
+  g_assert (results != NULL);
+  n_rows = dee_result_set_get_n_rows (results);
+  g_object_unref (results);
+
+  return n_rows;
+}
+
+/* Runs filter over fix->model and checks that it includes the rows with
+ * the given int values, in order */
+static void
+assert_filter (Fixture *fix, DeeFilter *filter, const gint *expected,
+               guint n_expected)
+{
+  DeeModel     *m;
+  DeeModelIter *iter;
+  guint         i;
+
+  m = dee_filter_model_new (fix->model, filter);
+  g_assert_cmpuint (n_expected, ==, dee_model_get_n_rows (m));
+
+  iter = dee_model_get_first_iter (m);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert_cmpint (expected[i], ==, dee_model_get_int32 (m, iter, 1));
+      iter = dee_model_next (m, iter);
+    }
+
+  g_object_unref (m);
+}
+
+static void
+test_lookup (Fixture *fix, gconstpointer data)
+{
+  g_assert (dee_trigram_index_get_model (fix->index) == fix->model);
+  g_assert_cmpuint (dee_trigram_index_get_column (fix->index), ==, 0);
+  g_assert (dee_trigram_index_find (fix->model, 0) == fix->index);
+  g_assert (dee_trigram_index_find (fix->model, 1) == NULL);
+
+  /* Case is ignored */
+  g_assert_cmpuint (count_candidates (fix->index, "knight"), ==, 2);
+  g_assert_cmpuint (count_candidates (fix->index, "NIGHT"), ==, 3);
+  g_assert_cmpuint (count_candidates (fix->index, "dark"), ==, 2);
+  g_assert_cmpuint (count_candidates (fix->index, "zombie"), ==, 0);
+
+  /* Too short to have any trigrams */
+  g_assert (dee_trigram_index_lookup (fix->index, "Up") == NULL);
+
+  g_object_unref (fix->index);
+  fix->index = NULL;
+  g_assert (dee_trigram_index_find (fix->model, 0) == NULL);
+}
+
+static void
+test_updates (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+
+  iter = dee_model_append (fix->model, "Zombieland", 5);
+  g_assert_cmpuint (count_candidates (fix->index, "zombie"), ==, 1);
+
+  dee_model_set (fix->model, iter, "Shaun of the Dead", 5);
+  g_assert_cmpuint (count_candidates (fix->index, "zombie"), ==, 0);
+  g_assert_cmpuint (count_candidates (fix->index, "dead"), ==, 2);
+
+  dee_model_remove (fix->model, iter);
+  g_assert_cmpuint (count_candidates (fix->index, "dead"), ==, 1);
+
+  dee_model_clear (fix->model);
+  g_assert_cmpuint (dee_trigram_index_get_n_trigrams (fix->index), ==, 0);
+}
+
+static void
+test_substring_filter (Fixture *fix, gconstpointer data)
+{
+  DeeFilter filter;
+  gint      night[] = { 0, 1, 2 };
+  gint      dark[] = { 0, 3 };
+  gint      up[] = { 4 };
+
+  dee_filter_new_for_substring (0, "NIGHT", &filter);
+  assert_filter (fix, &filter, night, G_N_ELEMENTS (night));
+
+  dee_filter_new_for_substring (0, "dark", &filter);
+  assert_filter (fix, &filter, dark, G_N_ELEMENTS (dark));
+
+  /* Too short for the index, so this will do a full scan */
+  dee_filter_new_for_substring (0, "uP", &filter);
+  assert_filter (fix, &filter, up, G_N_ELEMENTS (up));
+
+  /* Without the index the results must be the same */
+  g_object_unref (fix->index);
+  fix->index = NULL;
+
+  dee_filter_new_for_substring (0, "NIGHT", &filter);
+  assert_filter (fix, &filter, night, G_N_ELEMENTS (night));
+}
+
+static void
+test_regex_filter (Fixture *fix, gconstpointer data)
+{
+  DeeFilter  filter;
+  GRegex    *regex;
+  gint       knight[] = { 0, 1 };
+  gint       dark[] = { 0, 3 };
+  gint       either[] = { 0, 1, 3 };
+
+  /* The trigram candidates for "Knight" are verified with the regex */
+  regex = g_regex_new ("Knight( and)?", 0, 0, NULL);
+  dee_filter_new_regex (0, regex, &filter);
+  assert_filter (fix, &filter, knight, G_N_ELEMENTS (knight));
+  g_regex_unref (regex);
+
+  /* Only the case of the literal is ignored by the index */
+  regex = g_regex_new ("^.*dark", G_REGEX_CASELESS, 0, NULL);
+  dee_filter_new_regex (0, regex, &filter);
+  assert_filter (fix, &filter, dark, G_N_ELEMENTS (dark));
+  g_regex_unref (regex);
+
+  /* Alternations can't use the index */
+  regex = g_regex_new ("Dark|Knight", 0, 0, NULL);
+  dee_filter_new_regex (0, regex, &filter);
+  assert_filter (fix, &filter, either, G_N_ELEMENTS (either));
+  g_regex_unref (regex);
+}
+
+/* The operands of escapes like \x41 must not be taken for literals */
+static void
+test_regex_escapes (Fixture *fix, gconstpointer data)
+{
+  DeeFilter    filter;
+  GRegex      *regex;
+  guint        i;
+  gint         upper[] = { 5 };
+  gint         face[] = { 6 };
+  gint         ctrl[] = { 7 };
+  struct {
+    const gchar *pattern;
+    const gint  *expected;
+    guint        n_expected;
+  } cases[] = {
+    { "\\x41abc", upper, G_N_ELEMENTS (upper) },
+    { "\\x{263a} face", face, G_N_ELEMENTS (face) },
+    { "\\p{Lu}abc", upper, G_N_ELEMENTS (upper) },
+    { "\\101abc", upper, G_N_ELEMENTS (upper) },
+    { "\\cAabc", ctrl, G_N_ELEMENTS (ctrl) },
+    { "\\Q\\E\\x41abc", upper, G_N_ELEMENTS (upper) }
+  };
+
+  dee_model_append (fix->model, "Aabc", 5);
+  dee_model_append (fix->model, "\xe2\x98\xba face", 6);
+  dee_model_append (fix->model, "\001abc", 7);
+
+  for (i = 0; i < G_N_ELEMENTS (cases); i++)
+    {
+      regex = g_regex_new (cases[i].pattern, 0, 0, NULL);
+      g_assert (regex != NULL);
+      dee_filter_new_regex (0, regex, &filter);
+      assert_filter (fix, &filter, cases[i].expected, cases[i].n_expected);
+      g_regex_unref (regex);
+    }
+}
+
+void
+test_trigram_index_create_suite (void)
+{
+#define DOMAIN "/Index/Trigram"
+
+  g_test_add (DOMAIN"/Lookup", Fixture, 0,
+              setup, test_lookup, teardown);
+  g_test_add (DOMAIN"/Updates", Fixture, 0,
+              setup, test_updates, teardown);
+  g_test_add (DOMAIN"/SubstringFilter", Fixture, 0,
+              setup, test_substring_filter, teardown);
+  g_test_add (DOMAIN"/RegexFilter", Fixture, 0,
+              setup, test_regex_filter, teardown);
+  g_test_add (DOMAIN"/RegexEscapes", Fixture, 0,
+              setup, test_regex_escapes, teardown);
+}
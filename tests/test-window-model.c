@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2011 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <dee.h>
+
+typedef struct
+{
+  DeeModel *model;
+  DeeModel *window;
+
+  guint     n_added;
+  guint     n_removed;
+  guint     n_changed;
+
+} Fixture;
+
+static void setup    (Fixture *fix, gconstpointer data);
+static void teardown (Fixture *fix, gconstpointer data);
+
+static void
+on_row_added (DeeModel *model, DeeModelIter *iter, Fixture *fix)
+{
+  fix->n_added++;
+}
+
+static void
+on_row_removed (DeeModel *model, DeeModelIter *iter, Fixture *fix)
+{
+  /* The row must still be in the window when it is removed */
+  g_assert (dee_model_get_position (model, iter) < dee_model_get_n_rows (model));
+  fix->n_removed++;
+}
+
+static void
+on_row_changed (DeeModel *model, DeeModelIter *iter, Fixture *fix)
+{
+  fix->n_changed++;
+}
+
+static void
+setup (Fixture *fix, gconstpointer data)
+{
+  gint i;
+
+  fix->model = dee_sequence_model_new ();
+  dee_model_set_schema (fix->model, "i", NULL);
+
+  for (i = 0; i < 10; i++)
+    dee_model_append (fix->model, i);
+
+  fix->window = dee_window_model_new (fix->model, 2, 3);
+  fix->n_added = 0;
+  fix->n_removed = 0;
+  fix->n_changed = 0;
+
+  g_signal_connect (fix->window, "row-added",
+                    G_CALLBACK (on_row_added), fix);
+  g_signal_connect (fix->window, "row-removed",
+                    G_CALLBACK (on_row_removed), fix);
+  g_signal_connect (fix->window, "row-changed",
+                    G_CALLBACK (on_row_changed), fix);
+}
+
+static void
+teardown (Fixture *fix, gconstpointer data)
+{
+  g_object_unref (fix->window);
+  g_object_unref (fix->model);
+  fix->window = NULL;
+  fix->model = NULL;
+}
+
+/* Check the rows of the window both by iterating and by position */
+static void
+assert_window (DeeModel *m, const gint *expected, guint n_expected)
+{
+  DeeModelIter *iter;
+  guint         i;
+
+  g_assert_cmpuint (n_expected, ==, dee_model_get_n_rows (m));
+
+  iter = dee_model_get_first_iter (m);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert (!dee_model_is_last (m, iter));
+      g_assert_cmpint (expected[i], ==, dee_model_get_int32 (m, iter, 0));
+      g_assert_cmpuint (i, ==, dee_model_get_position (m, iter));
+      g_assert (iter == dee_model_get_iter_at_row (m, i));
+      iter = dee_model_next (m, iter);
+    }
+
+  g_assert (dee_model_is_last (m, iter));
+  g_assert (iter == dee_model_get_last_iter (m));
+}
+
+static void
+test_basics (Fixture *fix, gconstpointer data)
+{
+  DeeModel *m;
+  gint      initial[] = { 2, 3, 4 };
+  gint      tail[] = { 8, 9 };
+
+  g_assert (DEE_IS_WINDOW_MODEL (fix->window));
+  assert_window (fix->window, initial, G_N_ELEMENTS (initial));
+  g_assert_cmpuint (2, ==,
+                    dee_window_model_get_offset (DEE_WINDOW_MODEL (fix->window)));
+  g_assert_cmpuint (3, ==,
+                    dee_window_model_get_limit (DEE_WINDOW_MODEL (fix->window)));
+
+  /* Windows reaching past the end are cut short */
+  m = dee_window_model_new (fix->model, 8, 5);
+  assert_window (m, tail, G_N_ELEMENTS (tail));
+  g_object_unref (m);
+
+  m = dee_window_model_new (fix->model, 20, 5);
+  assert_window (m, NULL, 0);
+  g_object_unref (m);
+}
+
+static void
+test_changes (Fixture *fix, gconstpointer data)
+{
+  DeeModelIter *iter;
+  gint          shifted[] = { 1, 2, 3 };
+  gint          inserted[] = { 2, 10, 3 };
+  gint          removed[] = { 2, 3, 4 };
+
+  /* Changes after the window are never signalled */
+  dee_model_append (fix->model, 10);
+  dee_model_remove (fix->model, dee_model_get_iter_at_row (fix->model, 8));
+  dee_model_set (fix->model, dee_model_get_iter_at_row (fix->model, 7), 70);
+  g_assert_cmpuint (0, ==, fix->n_added + fix->n_removed + fix->n_changed);
+
+  /* A row added before the window shifts a row in and one out */
+  dee_model_prepend (fix->model, -1);
+  assert_window (fix->window, shifted, G_N_ELEMENTS (shifted));
+  g_assert_cmpuint (1, ==, fix->n_added);
+  g_assert_cmpuint (1, ==, fix->n_removed);
+
+  dee_model_remove (fix->model, dee_model_get_first_iter (fix->model));
+  assert_window (fix->window, removed, G_N_ELEMENTS (removed));
+  g_assert_cmpuint (2, ==, fix->n_added);
+  g_assert_cmpuint (2, ==, fix->n_removed);
+
+  /* A row added inside the window pushes out the last row */
+  iter = dee_model_get_iter_at_row (fix->model, 3);
+  dee_model_insert_before (fix->model, iter, 10);
+  assert_window (fix->window, inserted, G_N_ELEMENTS (inserted));
+  g_assert_cmpuint (3, ==, fix->n_added);
+  g_assert_cmpuint (3, ==, fix->n_removed);
+
+  /* And removing it pulls the row after the window back in */
+  dee_model_remove (fix->model, dee_model_get_iter_at_row (fix->window, 1));
+  assert_window (fix->window, removed, G_N_ELEMENTS (removed));
+  g_assert_cmpuint (4, ==, fix->n_added);
+  g_assert_cmpuint (4, ==, fix->n_removed);
+
+  dee_model_set (fix->model, dee_model_get_iter_at_row (fix->window, 1), 30);
+  g_assert_cmpuint (1, ==, fix->n_changed);
+
+  dee_model_clear (fix->model);
+  assert_window (fix->window, NULL, 0);
+}
+
+static void
+test_set_window (Fixture *fix, gconstpointer data)
+{
+  gint overlap[] = { 3, 4, 5, 6 };
+  gint disjoint[] = { 8, 9 };
+  gint grown[] = { 6, 7, 8, 9 };
+
+  /* Only the rows entering and leaving the window are signalled */
+  dee_window_model_set_window (DEE_WINDOW_MODEL (fix->window), 3, 4);
+  assert_window (fix->window, overlap, G_N_ELEMENTS (overlap));
+  g_assert_cmpuint (2, ==, fix->n_added);
+  g_assert_cmpuint (1, ==, fix->n_removed);
+
+  dee_window_model_set_window (DEE_WINDOW_MODEL (fix->window), 8, 4);
+  assert_window (fix->window, disjoint, G_N_ELEMENTS (disjoint));
+  g_assert_cmpuint (4, ==, fix->n_added);
+  g_assert_cmpuint (5, ==, fix->n_removed);
+
+  g_object_set (fix->window, "offset", 6, NULL);
+  assert_window (fix->window, grown, G_N_ELEMENTS (grown));
+
+  dee_window_model_set_window (DEE_WINDOW_MODEL (fix->window), 6, 0);
+  assert_window (fix->window, NULL, 0);
+
+  /* Rows added to an empty window that now reaches them */
+  dee_window_model_set_window (DEE_WINDOW_MODEL (fix->window), 10, 2);
+  assert_window (fix->window, NULL, 0);
+  dee_model_append (fix->model, 10);
+  g_assert_cmpuint (1, ==, dee_model_get_n_rows (fix->window));
+}
+
+static void
+test_moves (Fixture *fix, gconstpointer data)
+{
+  DeeModel *m = fix->model;
+  gint      inside[] = { 4, 2, 3 };
+  gint      left[] = { 2, 3, 5 };
+  gint      entered[] = { 0, 3, 5 };
+  gint      back[] = { 2, 3, 5 };
+  gint      jumped[] = { 3, 5, 6 };
+  gint      first_slot[] = { 8, 3, 5 };
+  gint      middle[] = { 8, 9, 3 };
+  gint      shifted[] = { 1, 8, 9 };
+
+  /* A move inside the window is not a removal */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 4),
+                         dee_model_get_iter_at_row (m, 2));
+  assert_window (fix->window, inside, G_N_ELEMENTS (inside));
+  g_assert_cmpuint (0, ==, fix->n_added + fix->n_removed);
+
+  /* Moving a row out of the window pulls the next one in */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 2),
+                         dee_model_get_last_iter (m));
+  assert_window (fix->window, left, G_N_ELEMENTS (left));
+  g_assert_cmpuint (1, ==, fix->n_added);
+  g_assert_cmpuint (1, ==, fix->n_removed);
+
+  /* A row entering from before the window pushes its first row out */
+  dee_model_move_before (m, dee_model_get_first_iter (m),
+                         dee_model_get_iter_at_row (m, 3));
+  assert_window (fix->window, entered, G_N_ELEMENTS (entered));
+  g_assert_cmpuint (2, ==, fix->n_added);
+  g_assert_cmpuint (2, ==, fix->n_removed);
+
+  /* And leaving to the front brings it back */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 2),
+                         dee_model_get_first_iter (m));
+  assert_window (fix->window, back, G_N_ELEMENTS (back));
+  g_assert_cmpuint (3, ==, fix->n_added);
+  g_assert_cmpuint (3, ==, fix->n_removed);
+
+  /* Jumping over the window shifts it by one row */
+  dee_model_move_before (m, dee_model_get_first_iter (m),
+                         dee_model_get_last_iter (m));
+  assert_window (fix->window, jumped, G_N_ELEMENTS (jumped));
+  g_assert_cmpuint (4, ==, fix->n_added);
+  g_assert_cmpuint (4, ==, fix->n_removed);
+
+  /* Moves that stay on one side of the window are not signalled */
+  dee_model_move_before (m, dee_model_get_first_iter (m),
+                         dee_model_get_iter_at_row (m, 2));
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 8),
+                         dee_model_get_iter_at_row (m, 6));
+  assert_window (fix->window, jumped, G_N_ELEMENTS (jumped));
+  g_assert_cmpuint (4, ==, fix->n_added);
+  g_assert_cmpuint (4, ==, fix->n_removed);
+
+  /* A row from after the window can take its first slot */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 7),
+                         dee_model_get_iter_at_row (m, 2));
+  assert_window (fix->window, first_slot, G_N_ELEMENTS (first_slot));
+  g_assert_cmpuint (5, ==, fix->n_added);
+  g_assert_cmpuint (5, ==, fix->n_removed);
+
+  /* Or land in the middle of it */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 8),
+                         dee_model_get_iter_at_row (m, 3));
+  assert_window (fix->window, middle, G_N_ELEMENTS (middle));
+  g_assert_cmpuint (6, ==, fix->n_added);
+  g_assert_cmpuint (6, ==, fix->n_removed);
+
+  /* Jumping over the window backwards shifts it the other way */
+  dee_model_move_before (m, dee_model_get_iter_at_row (m, 9),
+                         dee_model_get_iter_at_row (m, 1));
+  assert_window (fix->window, shifted, G_N_ELEMENTS (shifted));
+  g_assert_cmpuint (7, ==, fix->n_added);
+  g_assert_cmpuint (7, ==, fix->n_removed);
+}
+
+static gint
+cmp_desc (GVariant **row1, GVariant **row2, gpointer user_data)
+{
+  return g_variant_get_int32 (row2[0]) - g_variant_get_int32 (row1[0]);
+}
+
+static void
+on_rows_reordered (DeeModel *model, const guint *new_order, guint *n_reordered)
+{
+  (*n_reordered)++;
+}
+
+static void
+test_reorder (Fixture *fix, gconstpointer data)
+{
+  guint n_reordered = 0;
+  guint swap[] = { 0, 1, 4, 3, 2, 5, 6, 7, 8, 9 };
+  gint  swapped[] = { 4, 3, 2 };
+  gint  sorted[] = { 7, 6, 5 };
+
+  g_signal_connect (fix->window, "rows-reordered",
+                    G_CALLBACK (on_rows_reordered), &n_reordered);
+
+  /* The window keeps its rows, so the reordering is passed on */
+  dee_model_reorder (fix->model, swap);
+  assert_window (fix->window, swapped, G_N_ELEMENTS (swapped));
+  g_assert_cmpuint (1, ==, n_reordered);
+  g_assert_cmpuint (0, ==, fix->n_added + fix->n_removed);
+
+  /* Otherwise the old rows are removed and the new ones added */
+  dee_model_sort (fix->model, cmp_desc, NULL);
+  assert_window (fix->window, sorted, G_N_ELEMENTS (sorted));
+  g_assert_cmpuint (1, ==, n_reordered);
+  g_assert_cmpuint (3, ==, fix->n_added);
+  g_assert_cmpuint (3, ==, fix->n_removed);
+}
+
+static gboolean
+collect_row (DeeModel *model, DeeModelIter *iter, GPtrArray *rows)
+{
+  g_ptr_array_add (rows, iter);
+  return FALSE;
+}
+
+/* Walking the window with dee_model_foreach_range() must visit the same
+ * rows as dee_model_next(), also while the window is being changed */
+static void
+on_row_removed_foreach (DeeModel *model, DeeModelIter *iter, guint *n_walks)
+{
+  GPtrArray    *rows;
+  DeeModelIter *i;
+  guint         n;
+
+  rows = g_ptr_array_new ();
+  dee_model_foreach_range (model, NULL, NULL, (DeeModelIterFunc) collect_row,
+                           rows);
+
+  g_assert_cmpuint (dee_model_get_n_rows (model), ==, rows->len);
+  i = dee_model_get_first_iter (model);
+  for (n = 0; n < rows->len; n++)
+    {
+      g_assert (i == g_ptr_array_index (rows, n));
+      i = dee_model_next (model, i);
+    }
+  g_assert (dee_model_is_last (model, i));
+
+  g_ptr_array_free (rows, TRUE);
+  (*n_walks)++;
+}
+
+static void
+test_foreach (Fixture *fix, gconstpointer data)
+{
+  GPtrArray *rows;
+  guint      n_walks = 0;
+
+  rows = g_ptr_array_new ();
+  dee_model_foreach_range (fix->window, NULL, NULL,
+                           (DeeModelIterFunc) collect_row, rows);
+  g_assert_cmpuint (3, ==, rows->len);
+  g_ptr_array_free (rows, TRUE);
+
+  g_signal_connect (fix->window, "row-removed",
+                    G_CALLBACK (on_row_removed_foreach), &n_walks);
+
+  /* Shifting a row out of the window, removing one inside it and moving
+   * the window each emit row-removed in a different state */
+  dee_model_prepend (fix->model, -1);
+  dee_model_remove (fix->model, dee_model_get_iter_at_row (fix->window, 1));
+  dee_window_model_set_window (DEE_WINDOW_MODEL (fix->window), 5, 2);
+  dee_model_clear (fix->model);
+
+  g_assert_cmpuint (fix->n_removed, ==, n_walks);
+  g_assert_cmpuint (0, <, n_walks);
+}
+
+void
+test_window_model_create_suite (void)
+{
+#define DOMAIN "/Model/Window"
+
+  g_test_add (DOMAIN"/Basics", Fixture, 0,
+              setup, test_basics, teardown);
+  g_test_add (DOMAIN"/Changes", Fixture, 0,
+              setup, test_changes, teardown);
+  g_test_add (DOMAIN"/SetWindow", Fixture, 0,
+              setup, test_set_window, teardown);
+  g_test_add (DOMAIN"/Moves", Fixture, 0,
+              setup, test_moves, teardown);
+  g_test_add (DOMAIN"/Reorder", Fixture, 0,
+              setup, test_reorder, teardown);
+  g_test_add (DOMAIN"/Foreach", Fixture, 0,
+              setup, test_foreach, teardown);
+}